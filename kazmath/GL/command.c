@@ -0,0 +1,303 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "command.h"
+#include "matrix.h"
+#include "../jobs.h"
+#include "../vec3.h"
+
+enum {
+    KM_GL_OP_PUSH,
+    KM_GL_OP_POP,
+    KM_GL_OP_LOAD_IDENTITY,
+    KM_GL_OP_LOAD_MATRIX,
+    KM_GL_OP_MULT_MATRIX,
+    KM_GL_OP_TRANSLATE,
+    KM_GL_OP_ROTATE,
+    KM_GL_OP_SCALE,
+    KM_GL_OP_EMIT
+};
+
+/* Evaluations no deeper than this don't allocate */
+#define LOCAL_STACK_SIZE 32
+
+typedef struct km_gl_command_job {
+    const kmGLCommandBuffer* buffers;
+    kmUint begin;
+    kmUint end;
+    const kmMat4* base;
+    kmMat4* out;
+} km_gl_command_job;
+
+static kmScalar* record(kmGLCommandBuffer* pBuffer, unsigned char op, kmUint arg_count) {
+    kmScalar* args;
+
+    if(pBuffer->op_count == pBuffer->op_capacity) {
+        pBuffer->op_capacity = pBuffer->op_capacity ? pBuffer->op_capacity * 2 : 64;
+        pBuffer->ops = (unsigned char*) realloc(pBuffer->ops, pBuffer->op_capacity);
+    }
+
+    if(pBuffer->arg_count + arg_count > pBuffer->arg_capacity) {
+        while(pBuffer->arg_count + arg_count > pBuffer->arg_capacity) {
+            pBuffer->arg_capacity = pBuffer->arg_capacity ? pBuffer->arg_capacity * 2 : 256;
+        }
+        pBuffer->args = (kmScalar*) realloc(pBuffer->args, sizeof(kmScalar) * pBuffer->arg_capacity);
+    }
+
+    pBuffer->ops[pBuffer->op_count++] = op;
+    args = pBuffer->args + pBuffer->arg_count;
+    pBuffer->arg_count += arg_count;
+    return args;
+}
+
+static void record3(kmGLCommandBuffer* pBuffer, unsigned char op, float x, float y, float z) {
+    kmScalar* args = record(pBuffer, op, 3);
+    args[0] = x;
+    args[1] = y;
+    args[2] = z;
+}
+
+kmGLCommandBuffer* kmGLCommandBufferInitialize(kmGLCommandBuffer* pBuffer) {
+    memset(pBuffer, 0, sizeof(kmGLCommandBuffer));
+    return pBuffer;
+}
+
+void kmGLCommandBufferFree(kmGLCommandBuffer* pBuffer) {
+    free(pBuffer->ops);
+    free(pBuffer->args);
+    memset(pBuffer, 0, sizeof(kmGLCommandBuffer));
+}
+
+void kmGLCommandBufferClear(kmGLCommandBuffer* pBuffer) {
+    pBuffer->op_count = 0;
+    pBuffer->arg_count = 0;
+    pBuffer->emit_count = 0;
+    pBuffer->depth = 0;
+    pBuffer->max_depth = 0;
+}
+
+void kmGLCommandBufferPushMatrix(kmGLCommandBuffer* pBuffer) {
+    record(pBuffer, KM_GL_OP_PUSH, 0);
+    if(++pBuffer->depth > pBuffer->max_depth) {
+        pBuffer->max_depth = pBuffer->depth;
+    }
+}
+
+void kmGLCommandBufferPopMatrix(kmGLCommandBuffer* pBuffer) {
+    assert(pBuffer->depth && "Cannot pop more matrices than were pushed");
+
+    /* Without asserts an unbalanced pop is dropped rather than recorded */
+    if(!pBuffer->depth) return;
+
+    record(pBuffer, KM_GL_OP_POP, 0);
+    --pBuffer->depth;
+}
+
+void kmGLCommandBufferLoadIdentity(kmGLCommandBuffer* pBuffer) {
+    record(pBuffer, KM_GL_OP_LOAD_IDENTITY, 0);
+}
+
+void kmGLCommandBufferLoadMatrix(kmGLCommandBuffer* pBuffer, const kmMat4* pIn) {
+    memcpy(record(pBuffer, KM_GL_OP_LOAD_MATRIX, 16), pIn->mat, sizeof(kmScalar) * 16);
+}
+
+void kmGLCommandBufferMultMatrix(kmGLCommandBuffer* pBuffer, const kmMat4* pIn) {
+    memcpy(record(pBuffer, KM_GL_OP_MULT_MATRIX, 16), pIn->mat, sizeof(kmScalar) * 16);
+}
+
+void kmGLCommandBufferTranslatef(kmGLCommandBuffer* pBuffer, float x, float y, float z) {
+    record3(pBuffer, KM_GL_OP_TRANSLATE, x, y, z);
+}
+
+void kmGLCommandBufferRotatef(kmGLCommandBuffer* pBuffer, float angle, float x, float y, float z) {
+    kmScalar* args = record(pBuffer, KM_GL_OP_ROTATE, 4);
+    args[0] = angle;
+    args[1] = x;
+    args[2] = y;
+    args[3] = z;
+}
+
+void kmGLCommandBufferScalef(kmGLCommandBuffer* pBuffer, float x, float y, float z) {
+    record3(pBuffer, KM_GL_OP_SCALE, x, y, z);
+}
+
+void kmGLCommandBufferEmit(kmGLCommandBuffer* pBuffer) {
+    record(pBuffer, KM_GL_OP_EMIT, 0);
+    ++pBuffer->emit_count;
+}
+
+void kmGLCommandBufferReplay(const kmGLCommandBuffer* pBuffer) {
+    const kmScalar* args = pBuffer->args;
+    kmMat4 matrix;
+    kmUint i;
+
+    for(i = 0; i < pBuffer->op_count; ++i) {
+        switch(pBuffer->ops[i]) {
+            case KM_GL_OP_PUSH:
+                kmGLPushMatrix();
+            break;
+            case KM_GL_OP_POP:
+                kmGLPopMatrix();
+            break;
+            case KM_GL_OP_LOAD_IDENTITY:
+                kmGLLoadIdentity();
+            break;
+            case KM_GL_OP_LOAD_MATRIX:
+                kmGLLoadMatrix(kmMat4Fill(&matrix, args));
+                args += 16;
+            break;
+            case KM_GL_OP_MULT_MATRIX:
+                kmGLMultMatrix(kmMat4Fill(&matrix, args));
+                args += 16;
+            break;
+            case KM_GL_OP_TRANSLATE:
+                kmGLTranslatef(args[0], args[1], args[2]);
+                args += 3;
+            break;
+            case KM_GL_OP_ROTATE:
+                kmGLRotatef(args[0], args[1], args[2], args[3]);
+                args += 4;
+            break;
+            case KM_GL_OP_SCALE:
+                kmGLScalef(args[0], args[1], args[2]);
+                args += 3;
+            break;
+            default:
+            break;
+        }
+    }
+}
+
+kmUint kmGLCommandBufferEvaluate(const kmGLCommandBuffer* pBuffer, const kmMat4* pBase, kmMat4* pOut) {
+    kmMat4 local[LOCAL_STACK_SIZE];
+    kmMat4* stack = local;
+    kmMat4* top;
+    kmMat4 matrix;
+    kmVec3 axis;
+    const kmScalar* args = pBuffer->args;
+    kmUint i, written = 0;
+
+    if(pBuffer->max_depth >= LOCAL_STACK_SIZE) {
+        stack = (kmMat4*) malloc(sizeof(kmMat4) * (pBuffer->max_depth + 1));
+    }
+
+    top = stack;
+    if(pBase) {
+        kmMat4Assign(top, pBase);
+    } else {
+        kmMat4Identity(top);
+    }
+
+    for(i = 0; i < pBuffer->op_count; ++i) {
+        switch(pBuffer->ops[i]) {
+            case KM_GL_OP_PUSH:
+                kmMat4Assign(top + 1, top);
+                ++top;
+            break;
+            case KM_GL_OP_POP:
+                if(top > stack) --top;
+            break;
+            case KM_GL_OP_LOAD_IDENTITY:
+                kmMat4Identity(top);
+            break;
+            case KM_GL_OP_LOAD_MATRIX:
+                kmMat4Fill(top, args);
+                args += 16;
+            break;
+            case KM_GL_OP_MULT_MATRIX:
+                kmMat4Multiply(top, top, kmMat4Fill(&matrix, args));
+                args += 16;
+            break;
+            case KM_GL_OP_TRANSLATE:
+                kmMat4Multiply(top, top, kmMat4Translation(&matrix, args[0], args[1], args[2]));
+                args += 3;
+            break;
+            case KM_GL_OP_ROTATE:
+                kmVec3Fill(&axis, args[1], args[2], args[3]);
+                kmMat4Multiply(top, top, kmMat4RotationAxisAngle(&matrix, &axis, kmDegreesToRadians(args[0])));
+                args += 4;
+            break;
+            case KM_GL_OP_SCALE:
+                kmMat4Multiply(top, top, kmMat4Scaling(&matrix, args[0], args[1], args[2]));
+                args += 3;
+            break;
+            case KM_GL_OP_EMIT:
+                kmMat4Assign(&pOut[written++], top);
+            break;
+            default:
+            break;
+        }
+    }
+
+    if(stack != local) {
+        free(stack);
+    }
+
+    return written;
+}
+
+static void* evaluate_job(void* arg) {
+    km_gl_command_job* job = (km_gl_command_job*) arg;
+    kmMat4* out = job->out;
+    kmUint i;
+
+    for(i = job->begin; i < job->end; ++i) {
+        out += kmGLCommandBufferEvaluate(&job->buffers[i], job->base, out);
+    }
+
+    return NULL;
+}
+
+kmUint kmGLCommandBufferEvaluateArray(const kmGLCommandBuffer* buffers, kmUint count, const kmMat4* pBase,
+                                      kmMat4* pOut, kmUint thread_count) {
+    km_gl_command_job jobs[64];
+    kmUint t, i = 0, total = 0;
+
+    if(thread_count < 1) thread_count = 1;
+    if(thread_count > 64) thread_count = 64;
+    if(thread_count > count) thread_count = count ? count : 1;
+
+    /* Contiguous runs of buffers per thread, each writing after the
+     * output of every buffer before it */
+    for(t = 0; t < thread_count; ++t) {
+        jobs[t].buffers = buffers;
+        jobs[t].begin = count * t / thread_count;
+        jobs[t].end = count * (t + 1) / thread_count;
+        jobs[t].base = pBase;
+        jobs[t].out = pOut + total;
+
+        for(i = jobs[t].begin; i < jobs[t].end; ++i) {
+            total += buffers[i].emit_count;
+        }
+    }
+
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, evaluate_job);
+
+    return total;
+}
@@ -0,0 +1,108 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KM_GL_COMMAND_H_INCLUDED
+#define KM_GL_COMMAND_H_INCLUDED
+
+#include "../mat4.h"
+#include "../utility.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A recorded list of matrix operations. Recording touches nothing but the
+ * buffer itself, so draw lists can be built on any thread and turned into
+ * matrices later, either by replaying them on the current kmGL context or
+ * by evaluating them against a private stack.
+ *
+ * Each command is one opcode plus its kmScalar arguments, stored in two
+ * flat arrays.
+ */
+typedef struct kmGLCommandBuffer {
+    unsigned char* ops;
+    kmUint op_count;
+    kmUint op_capacity;
+
+    kmScalar* args;
+    kmUint arg_count;
+    kmUint arg_capacity;
+
+    kmUint emit_count;          /** Matrices written by an evaluation */
+    kmUint depth;               /** Pushes not yet popped */
+    kmUint max_depth;
+} kmGLCommandBuffer;
+
+kmGLCommandBuffer* kmGLCommandBufferInitialize(kmGLCommandBuffer* pBuffer);
+void kmGLCommandBufferFree(kmGLCommandBuffer* pBuffer);
+
+/** Forgets the recorded commands but keeps the memory */
+void kmGLCommandBufferClear(kmGLCommandBuffer* pBuffer);
+
+void kmGLCommandBufferPushMatrix(kmGLCommandBuffer* pBuffer);
+
+/** Popping more than was pushed asserts, or is ignored if asserts are off */
+void kmGLCommandBufferPopMatrix(kmGLCommandBuffer* pBuffer);
+void kmGLCommandBufferLoadIdentity(kmGLCommandBuffer* pBuffer);
+void kmGLCommandBufferLoadMatrix(kmGLCommandBuffer* pBuffer, const kmMat4* pIn);
+void kmGLCommandBufferMultMatrix(kmGLCommandBuffer* pBuffer, const kmMat4* pIn);
+void kmGLCommandBufferTranslatef(kmGLCommandBuffer* pBuffer, float x, float y, float z);
+void kmGLCommandBufferRotatef(kmGLCommandBuffer* pBuffer, float angle, float x, float y, float z);
+void kmGLCommandBufferScalef(kmGLCommandBuffer* pBuffer, float x, float y, float z);
+
+/**
+ * Marks a draw: evaluating the buffer writes the current matrix to the
+ * next output slot.
+ */
+void kmGLCommandBufferEmit(kmGLCommandBuffer* pBuffer);
+
+/**
+ * Applies the recorded commands to the current stack of the current kmGL
+ * context, as if the matching kmGL functions had been called. Emits are
+ * ignored.
+ */
+void kmGLCommandBufferReplay(const kmGLCommandBuffer* pBuffer);
+
+/**
+ * Runs the commands on a private stack that starts with pBase (the
+ * identity if NULL), writing one matrix per emit to pOut. Returns the
+ * number of matrices written, which is pBuffer->emit_count.
+ */
+kmUint kmGLCommandBufferEvaluate(const kmGLCommandBuffer* pBuffer, const kmMat4* pBase, kmMat4* pOut);
+
+/**
+ * Evaluates count buffers, split between thread_count threads. The output
+ * of each buffer follows that of the one before it in pOut. Returns the
+ * total number of matrices written.
+ */
+kmUint kmGLCommandBufferEvaluateArray(const kmGLCommandBuffer* buffers, kmUint count, const kmMat4* pBase,
+                                      kmMat4* pOut, kmUint thread_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
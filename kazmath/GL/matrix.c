@@ -24,12 +24,23 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <assert.h>
 #include <string.h>
 #include <pthread.h>
+#ifdef KAZMATH_GL_STATS
+#include <time.h>
+#endif
 
 #include "matrix.h"
 #include "mat4stack.h"
+#include "../mat3.h"
+
+/* Bits of km_mat4_stack_context::dirty, one per cached derived matrix */
+#define KM_GL_DIRTY_MVP 1
+#define KM_GL_DIRTY_INVERSE_MODELVIEW 2
+#define KM_GL_DIRTY_NORMAL 4
+#define KM_GL_DIRTY_ALL 7
 
 /* ---
  * Begin additions by Tobias Lensing for icedcoffee-framework.org */
@@ -39,7 +50,14 @@ typedef struct km_mat4_stack_context {
     km_mat4_stack projection_matrix_stack;
     km_mat4_stack texture_matrix_stack;
     km_mat4_stack* current_stack;
+    kmMat4 modelview_projection;
+    kmMat4 inverse_modelview;
+    kmMat3 normal_matrix;
+    unsigned char dirty;
     unsigned char initialized;
+#ifdef KAZMATH_GL_STATS
+    kmGLContextStats stats;
+#endif
     void *contextRef;
     struct km_mat4_stack_context_list *entry;
 } km_mat4_stack_context;
@@ -122,9 +140,60 @@ km_mat4_stack_context *registerContext(void *contextRef)
     return existingContext;
 }
 
+#ifdef KAZMATH_GL_STATS
+static double secondsNow()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+static kmGLStackStats *stackStats(km_mat4_stack_context *context, km_mat4_stack *stack)
+{
+    if (stack == &context->projection_matrix_stack) {
+        return &context->stats.projection;
+    } else if (stack == &context->texture_matrix_stack) {
+        return &context->stats.texture;
+    }
+    return &context->stats.modelview;
+}
+
+/* Called after every push or pop on a context's stack. The stack grows
+ * during a push once it is full, which shows up as a change of capacity */
+static void recordStackChange(km_mat4_stack_context *context, km_mat4_stack *stack, int old_capacity, kmBool push)
+{
+    kmGLStackStats *stats = stackStats(context, stack);
+
+    stats->depth = stack->item_count;
+    if (push) {
+        stats->pushes++;
+        if (stats->depth > stats->high_water) {
+            stats->high_water = stats->depth;
+        }
+        if (stack->capacity != old_capacity) {
+            stats->reallocations++;
+            stats->reallocated_bytes += stack->capacity * sizeof(kmMat4);
+        }
+    } else {
+        stats->pops++;
+    }
+}
+
+#define RECORD_STACK_CHANGE(context, stack, old_capacity, push) recordStackChange(context, stack, old_capacity, push)
+#else
+#define RECORD_STACK_CHANGE(context, stack, old_capacity, push)
+#endif
+
 void kmGLSetCurrentContext(void *contextRef)
 {
+#ifdef KAZMATH_GL_STATS
+    double start = secondsNow();
+    km_mat4_stack_context *current_context = registerContext(contextRef);
+    current_context->stats.lookups++;
+    current_context->stats.lookup_seconds += secondsNow() - start;
+#else
     km_mat4_stack_context *current_context = registerContext(contextRef);
+#endif
     pthread_setspecific(current_context_key, current_context);
 }
 
@@ -193,6 +262,7 @@ km_mat4_stack_context *lazyInitializeCurrentContext()
 		km_mat4_stack_initialize(&current_context->texture_matrix_stack);
 
 		current_context->current_stack = &current_context->modelview_matrix_stack;
+		current_context->dirty = KM_GL_DIRTY_ALL;
 		current_context->initialized = 1;
 
 		kmMat4Identity(&identity);
@@ -201,11 +271,29 @@ km_mat4_stack_context *lazyInitializeCurrentContext()
 		km_mat4_stack_push(&current_context->modelview_matrix_stack, &identity);
 		km_mat4_stack_push(&current_context->projection_matrix_stack, &identity);
 		km_mat4_stack_push(&current_context->texture_matrix_stack, &identity);
+
+#ifdef KAZMATH_GL_STATS
+		/*The initial identities aren't counted as pushes*/
+		current_context->stats.modelview.depth = current_context->stats.modelview.high_water = 1;
+		current_context->stats.projection.depth = current_context->stats.projection.high_water = 1;
+		current_context->stats.texture.depth = current_context->stats.texture.high_water = 1;
+#endif
 	}
     
     return current_context;
 }
 
+/* Called after the top of the current stack changes. The texture stack
+ * feeds none of the cached matrices, the projection stack only the MVP */
+static void markCurrentStackDirty(km_mat4_stack_context *current_context)
+{
+	if (current_context->current_stack == &current_context->modelview_matrix_stack) {
+		current_context->dirty = KM_GL_DIRTY_ALL;
+	} else if (current_context->current_stack == &current_context->projection_matrix_stack) {
+		current_context->dirty |= KM_GL_DIRTY_MVP;
+	}
+}
+
 void kmGLMatrixMode(kmGLEnum mode)
 {
 	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
@@ -232,10 +320,13 @@ void kmGLPushMatrix(void)
 	kmMat4 top;
 
 	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
+	int old_capacity = current_context->current_stack->capacity;
 
 	/*Duplicate the top of the stack (i.e the current matrix)	*/
 	kmMat4Assign(&top, current_context->current_stack->top);
 	km_mat4_stack_push(current_context->current_stack, &top);
+	RECORD_STACK_CHANGE(current_context, current_context->current_stack, old_capacity, KM_TRUE);
+	(void) old_capacity;
 }
 
 void kmGLPopMatrix(void)
@@ -244,24 +335,29 @@ void kmGLPopMatrix(void)
     assert(current_context->initialized && "Cannot Pop empty matrix stack");
 	/*No need to lazy initialize, you shouldnt be popping first anyway!*/
 	km_mat4_stack_pop(current_context->current_stack, NULL);
+	RECORD_STACK_CHANGE(current_context, current_context->current_stack, 0, KM_FALSE);
+	markCurrentStackDirty(current_context);
 }
 
 void kmGLLoadIdentity()
 {
 	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
 	kmMat4Identity(current_context->current_stack->top); /*Replace the top matrix with the identity matrix*/
+	markCurrentStackDirty(current_context);
 }
 
 void kmGLMultMatrix(const kmMat4* pIn)
 {
 	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
 	kmMat4Multiply(current_context->current_stack->top, current_context->current_stack->top, pIn);
+	markCurrentStackDirty(current_context);
 }
 
 void kmGLLoadMatrix(const kmMat4* pIn)
 {
 	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
 	kmMat4Assign(current_context->current_stack->top, pIn);
+	markCurrentStackDirty(current_context);
 }
 
 void kmGLGetMatrix(kmGLEnum mode, kmMat4* pOut)
@@ -296,6 +392,7 @@ void kmGLTranslatef(float x, float y, float z)
 
 	/*Multiply the rotation matrix by the current matrix*/
 	kmMat4Multiply(current_context->current_stack->top, current_context->current_stack->top, &translation);
+	markCurrentStackDirty(current_context);
 }
 
 void kmGLRotatef(float angle, float x, float y, float z)
@@ -313,6 +410,7 @@ void kmGLRotatef(float angle, float x, float y, float z)
 
 	/*Multiply the rotation matrix by the current matrix*/
 	kmMat4Multiply(current_context->current_stack->top, current_context->current_stack->top, &rotation);
+	markCurrentStackDirty(current_context);
 }
 
 void kmGLScalef(float x, float y, float z)
@@ -322,4 +420,149 @@ void kmGLScalef(float x, float y, float z)
 	kmMat4 scaling;
 	kmMat4Scaling(&scaling, x, y, z);
 	kmMat4Multiply(current_context->current_stack->top, current_context->current_stack->top, &scaling);
+	markCurrentStackDirty(current_context);
+}
+
+const kmMat4* kmGLGetMatrixPointer(kmGLEnum mode)
+{
+	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
+
+	switch(mode)
+	{
+		case KM_GL_MODELVIEW:
+			return current_context->modelview_matrix_stack.top;
+		case KM_GL_PROJECTION:
+			return current_context->projection_matrix_stack.top;
+		case KM_GL_TEXTURE:
+			return current_context->texture_matrix_stack.top;
+		default:
+			assert(0 && "Invalid matrix mode specified");
+		break;
+	}
+
+	return NULL;
+}
+
+const kmMat4* kmGLGetModelviewProjection(void)
+{
+	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
+
+	if (current_context->dirty & KM_GL_DIRTY_MVP) {
+		kmMat4Multiply(&current_context->modelview_projection,
+		               current_context->projection_matrix_stack.top,
+		               current_context->modelview_matrix_stack.top);
+		current_context->dirty &= ~KM_GL_DIRTY_MVP;
+	}
+
+	return &current_context->modelview_projection;
+}
+
+const kmMat4* kmGLGetInverseModelview(void)
+{
+	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
+
+	if (current_context->dirty & KM_GL_DIRTY_INVERSE_MODELVIEW) {
+		/*A singular modelview has no inverse, fall back to the identity*/
+		if (!kmMat4Inverse(&current_context->inverse_modelview, current_context->modelview_matrix_stack.top)) {
+			kmMat4Identity(&current_context->inverse_modelview);
+		}
+		current_context->dirty &= ~KM_GL_DIRTY_INVERSE_MODELVIEW;
+	}
+
+	return &current_context->inverse_modelview;
+}
+
+const kmMat3* kmGLGetNormalMatrix(void)
+{
+	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
+
+	if (current_context->dirty & KM_GL_DIRTY_NORMAL) {
+		kmMat3 upper, inverse;
+
+		/*Inverse transpose of the upper 3x3, or the upper 3x3 itself if it is singular*/
+		kmMat4ExtractRotationMat3(current_context->modelview_matrix_stack.top, &upper);
+		if (kmMat3Inverse(&inverse, &upper)) {
+			kmMat3Transpose(&current_context->normal_matrix, &inverse);
+		} else {
+			kmMat3AssignMat3(&current_context->normal_matrix, &upper);
+		}
+		current_context->dirty &= ~KM_GL_DIRTY_NORMAL;
+	}
+
+	return &current_context->normal_matrix;
+}
+
+kmBool kmGLGetStats(kmGLContextStats* pOut)
+{
+	memset(pOut, 0, sizeof(kmGLContextStats));
+#ifdef KAZMATH_GL_STATS
+	{
+		km_mat4_stack_context *current_context = pthread_getspecific(current_context_key);
+		if (current_context) {
+			*pOut = current_context->stats;
+			return KM_TRUE;
+		}
+	}
+#endif
+	return KM_FALSE;
+}
+
+void kmGLResetStats(void)
+{
+#ifdef KAZMATH_GL_STATS
+	km_mat4_stack_context *current_context = pthread_getspecific(current_context_key);
+	kmGLStackStats *stacks[3];
+	int i;
+
+	if (!current_context) {
+		return;
+	}
+
+	stacks[0] = &current_context->stats.modelview;
+	stacks[1] = &current_context->stats.projection;
+	stacks[2] = &current_context->stats.texture;
+
+	/*Keep the depths, the high water marks restart from them*/
+	for (i = 0; i < 3; ++i) {
+		kmUint depth = stacks[i]->depth;
+		memset(stacks[i], 0, sizeof(kmGLStackStats));
+		stacks[i]->depth = stacks[i]->high_water = depth;
+	}
+
+	current_context->stats.lookups = 0;
+	current_context->stats.lookup_seconds = 0;
+#endif
+}
+
+static int writeStackJSON(char* buffer, size_t size, const char* name, const kmGLStackStats* stats)
+{
+	return snprintf(buffer, size,
+		"\"%s\":{\"depth\":%u,\"high_water\":%u,\"pushes\":%u,\"pops\":%u,"
+		"\"reallocations\":%u,\"reallocated_bytes\":%u},",
+		name, stats->depth, stats->high_water, stats->pushes, stats->pops,
+		stats->reallocations, stats->reallocated_bytes);
+}
+
+int kmGLStatsToJSON(const kmGLContextStats* pStats, char* buffer, size_t size)
+{
+	const kmGLStackStats *stacks[3];
+	const char *names[3] = { "modelview", "projection", "texture" };
+	int i, n, length;
+
+	stacks[0] = &pStats->modelview;
+	stacks[1] = &pStats->projection;
+	stacks[2] = &pStats->texture;
+
+	/*Like snprintf, keep counting once the buffer is full*/
+	length = snprintf(buffer, size, "{");
+	for (i = 0; i < 3; ++i) {
+		n = writeStackJSON((size_t) length < size ? buffer + length : NULL,
+		                   (size_t) length < size ? size - length : 0, names[i], stacks[i]);
+		length += n;
+	}
+	n = snprintf((size_t) length < size ? buffer + length : NULL,
+	             (size_t) length < size ? size - length : 0,
+	             "\"lookups\":%u,\"lookup_seconds\":%.9f}", pStats->lookups, pStats->lookup_seconds);
+
+	return length + n;
 }
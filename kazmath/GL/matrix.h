@@ -32,9 +32,30 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 typedef unsigned int kmGLEnum;
 
+#include <stddef.h>
+
+#include "../mat3.h"
 #include "../mat4.h"
 #include "../vec3.h"
 
+/* Usage counters of one matrix stack, see kmGLGetStats */
+typedef struct kmGLStackStats {
+    kmUint depth;
+    kmUint high_water;          /** Deepest the stack has been */
+    kmUint pushes;
+    kmUint pops;
+    kmUint reallocations;       /** Times the stack had to grow */
+    kmUint reallocated_bytes;   /** Total size of the grown stacks */
+} kmGLStackStats;
+
+typedef struct kmGLContextStats {
+    kmGLStackStats modelview;
+    kmGLStackStats projection;
+    kmGLStackStats texture;
+    kmUint lookups;             /** Calls to kmGLSetCurrentContext */
+    double lookup_seconds;      /** Time spent finding the context in them */
+} kmGLContextStats;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -56,6 +77,26 @@ void kmGLRotatef(float angle, float x, float y, float z);
 void kmGLScalef(float x, float y, float z);
 void kmGLGetMatrix(kmGLEnum mode, kmMat4* pOut);
 
+/* Pointer queries, these avoid the copy made by kmGLGetMatrix. The stack
+ * pointers are invalidated by the next push or pop. The derived matrices are
+ * cached per context and are only recomputed when the stack they depend on
+ * has changed, so query them again after modifying either matrix */
+const kmMat4* kmGLGetMatrixPointer(kmGLEnum mode);
+const kmMat4* kmGLGetModelviewProjection(void);
+const kmMat4* kmGLGetInverseModelview(void);
+const kmMat3* kmGLGetNormalMatrix(void);
+
+/* Statistics are only collected when built with KAZMATH_GL_STATS defined,
+ * otherwise they cost nothing and kmGLGetStats returns KM_FALSE with pOut
+ * zeroed. The stats belong to the current context. */
+kmBool kmGLGetStats(kmGLContextStats* pOut);
+void kmGLResetStats(void);
+
+/* Writes the stats as a JSON object. Returns the length of the whole
+ * object, like snprintf, so a return value of size or more means that it
+ * was truncated */
+int kmGLStatsToJSON(const kmGLContextStats* pStats, char* buffer, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
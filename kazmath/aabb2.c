@@ -134,6 +134,11 @@ kmEnum kmAABB2ContainsAABB(const kmAABB2* container, const kmAABB2* to_check) {
     }
 }
 
+kmBool kmAABB2IntersectsAABB(const kmAABB2* box, const kmAABB2* other) {
+    return box->min.x <= other->max.x && box->max.x >= other->min.x &&
+           box->min.y <= other->max.y && box->max.y >= other->min.y;
+}
+
 kmScalar kmAABB2DiameterX(const kmAABB2* aabb) {
     return aabb->max.x - aabb->min.x;
 }
@@ -86,6 +86,11 @@ kmAABB2* kmAABB2ScaleWithPivot( kmAABB2* pOut, const kmAABB2* pIn,
                                 const kmVec2 *pivot, kmScalar s );
 
 kmEnum kmAABB2ContainsAABB(const kmAABB2* container, const kmAABB2* to_check);
+
+/**
+ * Returns KM_TRUE if the boxes overlap (or touch)
+ */
+kmBool kmAABB2IntersectsAABB(const kmAABB2* box, const kmAABB2* other);
 kmScalar kmAABB2DiameterX(const kmAABB2* aabb);
 kmScalar kmAABB2DiameterY(const kmAABB2* aabb);
 kmVec2* kmAABB2Centre(const kmAABB2* aabb, kmVec2* pOut);
@@ -25,6 +25,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stdlib.h>
 #include "aabb3.h"
+#include "mat4.h"
 
 
 kmAABB3* kmAABB3Initialize(kmAABB3* pBox, const kmVec3* centre, const kmScalar width, const kmScalar height, const kmScalar depth) {
@@ -66,15 +67,159 @@ kmAABB3* kmAABB3Assign(kmAABB3* pOut, const kmAABB3* pIn)
 
 kmAABB3* kmAABB3Scale(kmAABB3* pOut, const kmAABB3* pIn, kmScalar s)
 {
-	assert(0 && "Not implemented");
+    kmVec3 a, b;
+
+    kmVec3Scale(&a, &pIn->min, s);
+    kmVec3Scale(&b, &pIn->max, s);
+
+    /* A negative scale flips the box, keep min <= max */
+    pOut->min.x = kmMin(a.x, b.x);
+    pOut->min.y = kmMin(a.y, b.y);
+    pOut->min.z = kmMin(a.z, b.z);
+    pOut->max.x = kmMax(a.x, b.x);
+    pOut->max.y = kmMax(a.y, b.y);
+    pOut->max.z = kmMax(a.z, b.z);
+
     return pOut;
 }
 
-kmBool kmAABB3IntersectsTriangle(kmAABB3* box, const kmVec3* p1, const kmVec3* p2, const kmVec3* p3) {
-    assert(0 && "Not implemented");
+/*
+ * A triangle prepared for repeated box tests: its edges, normal and the
+ * 9 edge/box-axis cross products used as separating axes.
+ */
+typedef struct {
+    kmVec3 v[3];
+    kmVec3 normal;
+    kmVec3 axes[9];
+} km_aabb3_triangle;
+
+static void prepare_triangle(km_aabb3_triangle* tri, const kmVec3* p1,
+                             const kmVec3* p2, const kmVec3* p3) {
+    kmVec3 edges[3];
+    int i;
+
+    tri->v[0] = *p1;
+    tri->v[1] = *p2;
+    tri->v[2] = *p3;
+
+    kmVec3Subtract(&edges[0], p2, p1);
+    kmVec3Subtract(&edges[1], p3, p2);
+    kmVec3Subtract(&edges[2], p1, p3);
+
+    kmVec3Cross(&tri->normal, &edges[0], &edges[1]);
+
+    /* Cross products of the unit box axes with each edge */
+    for(i = 0; i < 3; ++i) {
+        const kmVec3* e = &edges[i];
+        kmVec3Fill(&tri->axes[i * 3 + 0], 0, -e->z, e->y);
+        kmVec3Fill(&tri->axes[i * 3 + 1], e->z, 0, -e->x);
+        kmVec3Fill(&tri->axes[i * 3 + 2], -e->y, e->x, 0);
+    }
+}
+
+/*
+ * Returns KM_TRUE if axis separates the triangle (already translated so
+ * the box centre is at the origin) from a box with the given half extents.
+ */
+static kmBool axis_separates(const kmVec3* axis, const kmVec3* v0,
+                             const kmVec3* v1, const kmVec3* v2,
+                             const kmVec3* half) {
+    kmScalar p0 = kmVec3Dot(axis, v0);
+    kmScalar p1 = kmVec3Dot(axis, v1);
+    kmScalar p2 = kmVec3Dot(axis, v2);
+
+    kmScalar r = half->x * fabs(axis->x) +
+                 half->y * fabs(axis->y) +
+                 half->z * fabs(axis->z);
+
+    kmScalar lo = kmMin(p0, kmMin(p1, p2));
+    kmScalar hi = kmMax(p0, kmMax(p1, p2));
+
+    return lo > r || hi < -r;
+}
+
+static kmBool triangle_overlaps_box(const km_aabb3_triangle* tri,
+                                    const kmVec3* centre, const kmVec3* half) {
+    kmVec3 v0, v1, v2;
+    int i;
+
+    kmVec3Subtract(&v0, &tri->v[0], centre);
+    kmVec3Subtract(&v1, &tri->v[1], centre);
+    kmVec3Subtract(&v2, &tri->v[2], centre);
+
+    /* The box face normals, this is an AABB vs AABB test and rejects most */
+    if(kmMin(v0.x, kmMin(v1.x, v2.x)) > half->x || kmMax(v0.x, kmMax(v1.x, v2.x)) < -half->x) return KM_FALSE;
+    if(kmMin(v0.y, kmMin(v1.y, v2.y)) > half->y || kmMax(v0.y, kmMax(v1.y, v2.y)) < -half->y) return KM_FALSE;
+    if(kmMin(v0.z, kmMin(v1.z, v2.z)) > half->z || kmMax(v0.z, kmMax(v1.z, v2.z)) < -half->z) return KM_FALSE;
+
+    /* The triangle plane, all three vertices project to the same value */
+    if(fabs(kmVec3Dot(&tri->normal, &v0)) >
+       half->x * fabs(tri->normal.x) + half->y * fabs(tri->normal.y) + half->z * fabs(tri->normal.z)) {
+        return KM_FALSE;
+    }
+
+    for(i = 0; i < 9; ++i) {
+        if(axis_separates(&tri->axes[i], &v0, &v1, &v2, half)) {
+            return KM_FALSE;
+        }
+    }
+
     return KM_TRUE;
 }
 
+static void box_centre_half(const kmAABB3* box, kmVec3* centre, kmVec3* half) {
+    kmVec3Add(centre, &box->min, &box->max);
+    kmVec3Scale(centre, centre, 0.5);
+    kmVec3Subtract(half, &box->max, &box->min);
+    kmVec3Scale(half, half, 0.5);
+}
+
+kmBool kmAABB3IntersectsTriangle(kmAABB3* box, const kmVec3* p1, const kmVec3* p2, const kmVec3* p3) {
+    km_aabb3_triangle tri;
+    kmVec3 centre, half;
+
+    prepare_triangle(&tri, p1, p2, p3);
+    box_centre_half(box, &centre, &half);
+
+    return triangle_overlaps_box(&tri, &centre, &half);
+}
+
+kmUint kmAABB3IntersectsTriangles(const kmAABB3* box, const kmVec3* p1,
+                                  const kmVec3* p2, const kmVec3* p3,
+                                  kmUint count, kmBool* pResults) {
+    km_aabb3_triangle tri;
+    kmVec3 centre, half;
+    kmUint i, hits = 0;
+
+    box_centre_half(box, &centre, &half);
+
+    for(i = 0; i < count; ++i) {
+        prepare_triangle(&tri, &p1[i], &p2[i], &p3[i]);
+        pResults[i] = triangle_overlaps_box(&tri, &centre, &half);
+        hits += pResults[i] ? 1 : 0;
+    }
+
+    return hits;
+}
+
+kmUint kmAABB3IntersectsTriangleArray(const kmAABB3* boxes, kmUint count,
+                                      const kmVec3* p1, const kmVec3* p2,
+                                      const kmVec3* p3, kmBool* pResults) {
+    km_aabb3_triangle tri;
+    kmVec3 centre, half;
+    kmUint i, hits = 0;
+
+    prepare_triangle(&tri, p1, p2, p3);
+
+    for(i = 0; i < count; ++i) {
+        box_centre_half(&boxes[i], &centre, &half);
+        pResults[i] = triangle_overlaps_box(&tri, &centre, &half);
+        hits += pResults[i] ? 1 : 0;
+    }
+
+    return hits;
+}
+
 kmBool kmAABB3IntersectsAABB(const kmAABB3* box, const kmAABB3* other) {
     /* Probably should store center point and radius for things like this */
 
@@ -168,3 +313,105 @@ kmAABB3* kmAABB3ExpandToContain(kmAABB3* pOut, const kmAABB3* pIn, const kmAABB3
 
     return pOut;
 }
+
+kmAABB3* kmAABB3Transform(kmAABB3* pOut, const kmAABB3* pIn, const kmMat4* pM) {
+    const kmScalar* m = pM->mat;
+
+    kmScalar cx = (pIn->min.x + pIn->max.x) * 0.5;
+    kmScalar cy = (pIn->min.y + pIn->max.y) * 0.5;
+    kmScalar cz = (pIn->min.z + pIn->max.z) * 0.5;
+
+    kmScalar ex = (pIn->max.x - pIn->min.x) * 0.5;
+    kmScalar ey = (pIn->max.y - pIn->min.y) * 0.5;
+    kmScalar ez = (pIn->max.z - pIn->min.z) * 0.5;
+
+    kmScalar ncx = m[0] * cx + m[4] * cy + m[8] * cz + m[12];
+    kmScalar ncy = m[1] * cx + m[5] * cy + m[9] * cz + m[13];
+    kmScalar ncz = m[2] * cx + m[6] * cy + m[10] * cz + m[14];
+
+    kmScalar nex = fabs(m[0]) * ex + fabs(m[4]) * ey + fabs(m[8]) * ez;
+    kmScalar ney = fabs(m[1]) * ex + fabs(m[5]) * ey + fabs(m[9]) * ez;
+    kmScalar nez = fabs(m[2]) * ex + fabs(m[6]) * ey + fabs(m[10]) * ez;
+
+    pOut->min.x = ncx - nex;
+    pOut->min.y = ncy - ney;
+    pOut->min.z = ncz - nez;
+
+    pOut->max.x = ncx + nex;
+    pOut->max.y = ncy + ney;
+    pOut->max.z = ncz + nez;
+
+    return pOut;
+}
+
+kmAABB3* kmAABB3TransformArray(kmAABB3* pOut, const kmAABB3* pIn,
+                               const kmMat4* matrices, kmUint count) {
+    kmUint i;
+    for(i = 0; i < count; ++i) {
+        kmAABB3Transform(&pOut[i], &pIn[i], &matrices[i]);
+    }
+    return pOut;
+}
+
+kmBool kmAABB3SweepAABB3(const kmAABB3* box, const kmVec3* displacement,
+                         const kmAABB3* other, kmScalar* pTime, kmVec3* pNormal) {
+    const kmScalar* bmin = &box->min.x;
+    const kmScalar* bmax = &box->max.x;
+    const kmScalar* omin = &other->min.x;
+    const kmScalar* omax = &other->max.x;
+    const kmScalar* d = &displacement->x;
+    kmScalar enter = 0, leave = 1;
+    int i, axis = -1;
+
+    /*
+     * Slab test on the gap between the boxes along each axis, the box is
+     * touching other while every gap is closed.
+     */
+    for(i = 0; i < 3; ++i) {
+        kmScalar t0, t1;
+
+        if(d[i] == 0) {
+            if(bmax[i] < omin[i] || bmin[i] > omax[i]) return KM_FALSE;
+            continue;
+        }
+
+        if(d[i] > 0) {
+            t0 = (omin[i] - bmax[i]) / d[i];
+            t1 = (omax[i] - bmin[i]) / d[i];
+        } else {
+            t0 = (omax[i] - bmin[i]) / d[i];
+            t1 = (omin[i] - bmax[i]) / d[i];
+        }
+
+        if(t0 >= enter) {
+            enter = t0;
+            axis = i;
+        }
+        if(t1 < leave) leave = t1;
+        if(enter > leave) return KM_FALSE;
+    }
+
+    if(pTime) *pTime = enter;
+    if(pNormal) {
+        kmVec3Zero(pNormal);
+        if(axis >= 0) (&pNormal->x)[axis] = d[axis] > 0 ? -1 : 1;
+    }
+
+    return KM_TRUE;
+}
+
+kmUint kmAABB3SweepAABB3Array(const kmAABB3* boxes, kmUint count,
+                              const kmAABB3* moving, const kmVec3* displacement,
+                              kmBool* pResults, kmScalar* pTimes, kmVec3* pNormals) {
+    kmUint i, hits = 0;
+
+    for(i = 0; i < count; ++i) {
+        kmBool hit = kmAABB3SweepAABB3(moving, displacement, &boxes[i],
+                                       pTimes ? &pTimes[i] : NULL,
+                                       pNormals ? &pNormals[i] : NULL);
+        pResults[i] = hit;
+        hits += hit;
+    }
+
+    return hits;
+}
@@ -33,6 +33,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 extern "C" {
 #endif
 
+struct kmMat4;
+
 /**
  * A struture that represents an axis-aligned
  * bounding box.
@@ -66,8 +68,33 @@ kmAABB3* kmAABB3Assign(kmAABB3* pOut, const kmAABB3* pIn);
  * Scales pIn by s, stores the resulting AABB in pOut. Returns pOut
  */
 kmAABB3* kmAABB3Scale(kmAABB3* pOut, const kmAABB3* pIn, kmScalar s);
+
+/**
+ * Returns KM_TRUE if the triangle p1, p2, p3 overlaps the box. This is
+ * Akenine-Moller's separating axis test (box axes, triangle normal and
+ * the 9 edge cross products). Touching counts as overlapping.
+ */
 kmBool kmAABB3IntersectsTriangle(kmAABB3* box, const kmVec3* p1,
                                  const kmVec3* p2, const kmVec3* p3);
+
+/**
+ * Tests a single box against count triangles stored as three parallel
+ * vertex arrays (triangle i is p1[i], p2[i], p3[i]). Writes KM_TRUE or
+ * KM_FALSE per triangle into pResults and returns the number of hits.
+ */
+kmUint kmAABB3IntersectsTriangles(const kmAABB3* box, const kmVec3* p1,
+                                  const kmVec3* p2, const kmVec3* p3,
+                                  kmUint count, kmBool* pResults);
+
+/**
+ * Tests count boxes against a single triangle, the triangle's edges,
+ * normal and separating axes are only computed once. Writes KM_TRUE or
+ * KM_FALSE per box into pResults and returns the number of hits. Useful
+ * for voxelizing a triangle against the cells it covers.
+ */
+kmUint kmAABB3IntersectsTriangleArray(const kmAABB3* boxes, kmUint count,
+                                      const kmVec3* p1, const kmVec3* p2,
+                                      const kmVec3* p3, kmBool* pResults);
 kmBool kmAABB3IntersectsAABB(const kmAABB3* box, const kmAABB3* other);
 kmEnum kmAABB3ContainsAABB(const kmAABB3* container, const kmAABB3* to_check);
 kmScalar kmAABB3DiameterX(const kmAABB3* aabb);
@@ -84,6 +111,40 @@ kmVec3* kmAABB3Centre(const kmAABB3* aabb, kmVec3* pOut);
  */
 kmAABB3* kmAABB3ExpandToContain(kmAABB3* pOut, const kmAABB3* pIn, const kmAABB3* other);
 
+/**
+ * Transforms pIn by pM and stores the smallest AABB enclosing the result
+ * in pOut. Uses Arvo's method: the centre is transformed as a point and
+ * the half extents by the absolute values of the upper 3x3, which avoids
+ * transforming all 8 corners. pOut may equal pIn. Returns pOut.
+ */
+kmAABB3* kmAABB3Transform(kmAABB3* pOut, const kmAABB3* pIn, const struct kmMat4* pM);
+
+/**
+ * Batch version of kmAABB3Transform, pOut[i] = pIn[i] transformed by
+ * matrices[i]. pOut may equal pIn. Returns pOut.
+ */
+kmAABB3* kmAABB3TransformArray(kmAABB3* pOut, const kmAABB3* pIn,
+                               const struct kmMat4* matrices, kmUint count);
+
+/**
+ * Moves box by displacement and finds the first time it touches other.
+ * Returns KM_TRUE on contact, with the time as a fraction (0 to 1) of the
+ * displacement in pTime and the face normal of other that was hit in
+ * pNormal (either may be NULL). Boxes already overlapping give a time of
+ * 0 and a zero normal.
+ */
+kmBool kmAABB3SweepAABB3(const kmAABB3* box, const kmVec3* displacement,
+                         const kmAABB3* other, kmScalar* pTime, kmVec3* pNormal);
+
+/**
+ * Sweeps a single moving box against count static boxes. Writes KM_TRUE
+ * or KM_FALSE per box into pResults, the contact times and normals into
+ * pTimes and pNormals (which may be NULL) and returns the number of hits.
+ */
+kmUint kmAABB3SweepAABB3Array(const kmAABB3* boxes, kmUint count,
+                              const kmAABB3* moving, const kmVec3* displacement,
+                              kmBool* pResults, kmScalar* pTimes, kmVec3* pNormals);
+
 #ifdef __cplusplus
 }
 #endif
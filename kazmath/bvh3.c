@@ -0,0 +1,617 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bvh3.h"
+#include "jobs.h"
+#include "ray3.h"
+
+#define INVALID KM_BVH3_INVALID
+#define STACK_SIZE 256
+
+typedef struct km_bvh3_job {
+    kmBVH3* bvh;
+    const kmAABB3* bounds;
+    const kmAABB3* scene;
+    kmUint code_bits;
+    kmUint begin;
+    kmUint end;
+    kmUint shift;
+    kmUint histogram[256];      /** Digit counts, then write positions */
+} km_bvh3_job;
+
+static uint64_t expand_bits_10(uint64_t v) {
+    v &= 0x3ff;
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+static uint64_t expand_bits_21(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | (v << 32)) & 0x1f00000000ffffULL;
+    v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+    v = (v | (v << 8)) & 0x100f00f00f00f00fULL;
+    v = (v | (v << 4)) & 0x10c30c30c30c30c3ULL;
+    v = (v | (v << 2)) & 0x1249249249249249ULL;
+    return v;
+}
+
+static uint64_t quantize(kmScalar v, kmScalar lo, kmScalar hi, kmUint bits) {
+    kmScalar range = hi - lo;
+    kmScalar t = range > 0 ? (v - lo) / range : 0;
+    uint64_t max = (((uint64_t) 1) << bits) - 1;
+
+    if(t <= 0) return 0;
+    if(t >= 1) return max;
+    return (uint64_t) (t * max);
+}
+
+uint64_t kmBVH3MortonCode(const kmVec3* point, const kmAABB3* scene, kmUint code_bits) {
+    kmUint bits = code_bits == KM_BVH3_MORTON_63 ? 21 : 10;
+    uint64_t x = quantize(point->x, scene->min.x, scene->max.x, bits);
+    uint64_t y = quantize(point->y, scene->min.y, scene->max.y, bits);
+    uint64_t z = quantize(point->z, scene->min.z, scene->max.z, bits);
+
+    if(bits == 21) {
+        return (expand_bits_21(x) << 2) | (expand_bits_21(y) << 1) | expand_bits_21(z);
+    }
+
+    return (expand_bits_10(x) << 2) | (expand_bits_10(y) << 1) | expand_bits_10(z);
+}
+
+static void* codes_job(void* arg) {
+    km_bvh3_job* job = (km_bvh3_job*) arg;
+    kmBVH3* pBVH = job->bvh;
+    kmUint i;
+
+    for(i = job->begin; i < job->end; ++i) {
+        kmVec3 centre;
+        kmAABB3Centre(&job->bounds[i], &centre);
+        pBVH->codes[i] = kmBVH3MortonCode(&centre, job->scene, job->code_bits);
+        pBVH->ids[i] = i;
+    }
+
+    return NULL;
+}
+
+static void* count_job(void* arg) {
+    km_bvh3_job* job = (km_bvh3_job*) arg;
+    const uint64_t* codes = job->bvh->codes;
+    kmUint i;
+
+    memset(job->histogram, 0, sizeof(job->histogram));
+    for(i = job->begin; i < job->end; ++i) {
+        ++job->histogram[(codes[i] >> job->shift) & 0xff];
+    }
+
+    return NULL;
+}
+
+static void* scatter_job(void* arg) {
+    km_bvh3_job* job = (km_bvh3_job*) arg;
+    kmBVH3* pBVH = job->bvh;
+    kmUint i;
+
+    for(i = job->begin; i < job->end; ++i) {
+        uint64_t code = pBVH->codes[i];
+        kmUint pos = job->histogram[(code >> job->shift) & 0xff]++;
+        pBVH->codes_tmp[pos] = code;
+        pBVH->ids_tmp[pos] = pBVH->ids[i];
+    }
+
+    return NULL;
+}
+
+/*
+ * Parallel LSD radix sort of codes (carrying ids) 8 bits at a time. Each
+ * thread counts the digits in its chunk, then writes them after the same
+ * digit from earlier chunks so every pass is stable.
+ */
+static void radix_sort(kmBVH3* pBVH, km_bvh3_job* jobs, kmUint thread_count, kmUint code_bits) {
+    kmUint shift, d, t;
+
+    for(shift = 0; shift < code_bits; shift += 8) {
+        kmUint sum = 0;
+        uint64_t* swap_codes;
+        kmUint* swap_ids;
+
+        for(t = 0; t < thread_count; ++t) jobs[t].shift = shift;
+        km_run_jobs(jobs, sizeof(jobs[0]), thread_count, count_job);
+
+        for(d = 0; d < 256; ++d) {
+            for(t = 0; t < thread_count; ++t) {
+                kmUint n = jobs[t].histogram[d];
+                jobs[t].histogram[d] = sum;
+                sum += n;
+            }
+        }
+
+        km_run_jobs(jobs, sizeof(jobs[0]), thread_count, scatter_job);
+
+        swap_codes = pBVH->codes; pBVH->codes = pBVH->codes_tmp; pBVH->codes_tmp = swap_codes;
+        swap_ids = pBVH->ids; pBVH->ids = pBVH->ids_tmp; pBVH->ids_tmp = swap_ids;
+    }
+}
+
+static int clz64(uint64_t v) {
+#if defined(__GNUC__)
+    return v ? __builtin_clzll(v) : 64;
+#else
+    int n = 0;
+    if(!v) return 64;
+    while(!(v & 0x8000000000000000ULL)) {
+        v <<= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+/*
+ * Length of the common prefix of codes i and j, with the index breaking
+ * ties between duplicate codes. -1 if j is out of range.
+ */
+static int delta(const uint64_t* codes, kmUint n, kmInt i, kmInt j) {
+    if(j < 0 || j >= (kmInt) n) return -1;
+    if(codes[i] == codes[j]) return 64 + clz64((uint64_t) (i ^ j));
+    return clz64(codes[i] ^ codes[j]);
+}
+
+static void* hierarchy_job(void* arg) {
+    km_bvh3_job* job = (km_bvh3_job*) arg;
+    kmBVH3* pBVH = job->bvh;
+    const uint64_t* codes = pBVH->codes;
+    kmUint n = pBVH->leaf_count;
+    kmUint first_leaf = n - 1;
+    kmUint k;
+
+    for(k = job->begin; k < job->end; ++k) {
+        kmBVH3Node* leaf = &pBVH->nodes[first_leaf + k];
+        leaf->left = leaf->right = INVALID;
+        leaf->primitive = pBVH->ids[k];
+        kmAABB3Assign(&leaf->bounds, &job->bounds[leaf->primitive]);
+    }
+
+    for(k = job->begin; k < job->end && k < n - 1; ++k) {
+        kmInt i = (kmInt) k;
+        kmInt d = delta(codes, n, i, i + 1) - delta(codes, n, i, i - 1) > 0 ? 1 : -1;
+        int delta_min = delta(codes, n, i, i - d);
+        int delta_node;
+        kmInt l_max = 2, l = 0, t, s = 0, div = 2, j, gamma;
+        kmInt left, right;
+
+        /* Find the other end of the range covered by node i */
+        while(delta(codes, n, i, i + l_max * d) > delta_min) l_max *= 2;
+        for(t = l_max / 2; t >= 1; t /= 2) {
+            if(delta(codes, n, i, i + (l + t) * d) > delta_min) l += t;
+        }
+        j = i + l * d;
+
+        /* Binary search for where the range splits */
+        delta_node = delta(codes, n, i, j);
+        do {
+            t = (l + div - 1) / div;
+            if(delta(codes, n, i, i + (s + t) * d) > delta_node) s += t;
+            div *= 2;
+        } while(t > 1);
+        gamma = i + s * d + (d < 0 ? d : 0);
+
+        left = (i < j ? i : j) == gamma ? (kmInt) first_leaf + gamma : gamma;
+        right = (i > j ? i : j) == gamma + 1 ? (kmInt) first_leaf + gamma + 1 : gamma + 1;
+
+        pBVH->nodes[i].left = left;
+        pBVH->nodes[i].right = right;
+        pBVH->nodes[left].parent = i;
+        pBVH->nodes[right].parent = i;
+    }
+
+    return NULL;
+}
+
+/*
+ * Computes internal bounds bottom-up: walking up from every leaf, a node
+ * is merged on the second visit, once both children are done.
+ */
+static void refit(kmBVH3* pBVH, kmUint* visits) {
+    kmUint n = pBVH->leaf_count, k;
+
+    memset(visits, 0, sizeof(kmUint) * (n - 1));
+
+    for(k = n - 1; k < pBVH->node_count; ++k) {
+        kmInt node = pBVH->nodes[k].parent;
+
+        while(node != INVALID && visits[node]++ == 1) {
+            kmBVH3Node* p = &pBVH->nodes[node];
+            kmAABB3ExpandToContain(&p->bounds, &pBVH->nodes[p->left].bounds, &pBVH->nodes[p->right].bounds);
+            node = p->parent;
+        }
+    }
+}
+
+kmBVH3* kmBVH3Initialize(kmBVH3* pBVH) {
+    memset(pBVH, 0, sizeof(kmBVH3));
+    pBVH->root = INVALID;
+    return pBVH;
+}
+
+void kmBVH3Free(kmBVH3* pBVH) {
+    free(pBVH->nodes);
+    free(pBVH->codes);
+    free(pBVH->codes_tmp);
+    free(pBVH->ids);
+    free(pBVH->ids_tmp);
+    kmBVH3Initialize(pBVH);
+}
+
+void kmBVH3Build(kmBVH3* pBVH, const kmAABB3* bounds, kmUint count, const kmAABB3* scene,
+                 kmUint code_bits, kmUint thread_count) {
+    km_bvh3_job jobs[64];
+    kmAABB3 centroid_bounds;
+    kmUint t, i, chunk;
+
+    pBVH->leaf_count = count;
+    pBVH->node_count = count ? 2 * count - 1 : 0;
+    pBVH->root = count ? 0 : INVALID;
+    if(!count) return;
+
+    if(count > pBVH->capacity) {
+        pBVH->capacity = count;
+        pBVH->nodes = (kmBVH3Node*) realloc(pBVH->nodes, sizeof(kmBVH3Node) * (2 * count - 1));
+        pBVH->codes = (uint64_t*) realloc(pBVH->codes, sizeof(uint64_t) * count);
+        pBVH->codes_tmp = (uint64_t*) realloc(pBVH->codes_tmp, sizeof(uint64_t) * count);
+        pBVH->ids = (kmUint*) realloc(pBVH->ids, sizeof(kmUint) * count);
+        pBVH->ids_tmp = (kmUint*) realloc(pBVH->ids_tmp, sizeof(kmUint) * count);
+    }
+
+    if(!scene) {
+        kmAABB3Centre(&bounds[0], &centroid_bounds.min);
+        centroid_bounds.max = centroid_bounds.min;
+        for(i = 1; i < count; ++i) {
+            kmVec3 c;
+            kmAABB3Centre(&bounds[i], &c);
+            centroid_bounds.min.x = kmMin(centroid_bounds.min.x, c.x);
+            centroid_bounds.min.y = kmMin(centroid_bounds.min.y, c.y);
+            centroid_bounds.min.z = kmMin(centroid_bounds.min.z, c.z);
+            centroid_bounds.max.x = kmMax(centroid_bounds.max.x, c.x);
+            centroid_bounds.max.y = kmMax(centroid_bounds.max.y, c.y);
+            centroid_bounds.max.z = kmMax(centroid_bounds.max.z, c.z);
+        }
+        scene = &centroid_bounds;
+    }
+
+    if(code_bits != KM_BVH3_MORTON_63) code_bits = KM_BVH3_MORTON_30;
+    if(thread_count < 1) thread_count = 1;
+    if(thread_count > 64) thread_count = 64;
+    if(thread_count > count) thread_count = count;
+
+    chunk = (count + thread_count - 1) / thread_count;
+    for(t = 0; t < thread_count; ++t) {
+        jobs[t].bvh = pBVH;
+        jobs[t].bounds = bounds;
+        jobs[t].scene = scene;
+        jobs[t].code_bits = code_bits;
+        jobs[t].begin = t * chunk < count ? t * chunk : count;
+        jobs[t].end = (t + 1) * chunk < count ? (t + 1) * chunk : count;
+    }
+
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, codes_job);
+    radix_sort(pBVH, jobs, thread_count, code_bits);
+
+    pBVH->nodes[0].parent = INVALID;
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, hierarchy_job);
+
+    refit(pBVH, pBVH->ids_tmp);
+}
+
+static kmScalar surface_area(const kmAABB3* box) {
+    kmScalar x = box->max.x - box->min.x;
+    kmScalar y = box->max.y - box->min.y;
+    kmScalar z = box->max.z - box->min.z;
+    return 2 * (x * y + y * z + z * x);
+}
+
+static void merge_children(kmBVH3* pBVH, kmInt index) {
+    kmBVH3Node* node = &pBVH->nodes[index];
+    kmAABB3ExpandToContain(&node->bounds, &pBVH->nodes[node->left].bounds, &pBVH->nodes[node->right].bounds);
+}
+
+/*
+ * Tree rotations (Kopta et al. 2012). Swapping a child of the node with a
+ * grandchild under its sibling keeps the node's bounds but changes the
+ * sibling's, so pick the swap which shrinks the sibling the most. Swaps
+ * that would make the subtree taller are skipped so the depth stays
+ * within what the queries' traversal stacks were sized for.
+ */
+static void rotate_node(kmBVH3* pBVH, kmUint* heights, kmInt index) {
+    kmBVH3Node* node = &pBVH->nodes[index];
+    kmInt children[2];
+    kmInt best_child = INVALID, best_grandchild = INVALID;
+    kmUint best_height = 0;
+    kmScalar best_gain = 0;
+    int c, g;
+
+    children[0] = node->left;
+    children[1] = node->right;
+
+    for(c = 0; c < 2; ++c) {
+        kmInt child = children[c];
+        const kmBVH3Node* sibling = &pBVH->nodes[children[1 - c]];
+        kmScalar current;
+
+        if(sibling->left == INVALID) continue;
+        current = surface_area(&sibling->bounds);
+
+        for(g = 0; g < 2; ++g) {
+            kmInt up = g ? sibling->right : sibling->left;
+            kmInt stay = g ? sibling->left : sibling->right;
+            kmUint sibling_height, height;
+            kmAABB3 merged;
+            kmScalar gain;
+
+            sibling_height = 1 + (heights[child] > heights[stay] ? heights[child] : heights[stay]);
+            height = 1 + (sibling_height > heights[up] ? sibling_height : heights[up]);
+            if(height > heights[index]) continue;
+
+            kmAABB3ExpandToContain(&merged, &pBVH->nodes[child].bounds, &pBVH->nodes[stay].bounds);
+            gain = current - surface_area(&merged);
+            if(gain > best_gain) {
+                best_gain = gain;
+                best_child = child;
+                best_grandchild = up;
+                best_height = sibling_height;
+            }
+        }
+    }
+
+    if(best_child != INVALID) {
+        kmInt other = best_child == node->left ? node->right : node->left;
+        kmBVH3Node* sibling = &pBVH->nodes[other];
+
+        if(sibling->left == best_grandchild) sibling->left = best_child;
+        else sibling->right = best_child;
+
+        if(node->left == best_child) node->left = best_grandchild;
+        else node->right = best_grandchild;
+
+        pBVH->nodes[best_child].parent = other;
+        pBVH->nodes[best_grandchild].parent = index;
+        heights[other] = best_height;
+        merge_children(pBVH, other);
+    }
+}
+
+static void refit_node(kmBVH3* pBVH, kmUint* heights, kmInt index, kmBool rotate) {
+    const kmBVH3Node* node = &pBVH->nodes[index];
+    kmUint left = heights[node->left], right = heights[node->right];
+
+    merge_children(pBVH, index);
+    heights[index] = 1 + (left > right ? left : right);
+
+    if(rotate) rotate_node(pBVH, heights, index);
+}
+
+static void refit_subtree(kmBVH3* pBVH, const kmAABB3* bounds, kmUint* heights, kmInt index, kmBool rotate) {
+    kmBVH3Node* node = &pBVH->nodes[index];
+
+    if(node->left == INVALID) {
+        kmAABB3Assign(&node->bounds, &bounds[node->primitive]);
+        heights[index] = 0;
+        return;
+    }
+
+    refit_subtree(pBVH, bounds, heights, node->left, rotate);
+    refit_subtree(pBVH, bounds, heights, node->right, rotate);
+    refit_node(pBVH, heights, index, rotate);
+}
+
+typedef struct km_bvh3_refit_job {
+    kmBVH3* bvh;
+    const kmAABB3* bounds;
+    kmUint* heights;
+    const kmInt* roots;
+    kmUint begin;
+    kmUint end;
+    kmBool rotate;
+} km_bvh3_refit_job;
+
+static void* refit_job(void* arg) {
+    km_bvh3_refit_job* job = (km_bvh3_refit_job*) arg;
+    kmUint i;
+
+    for(i = job->begin; i < job->end; ++i) {
+        refit_subtree(job->bvh, job->bounds, job->heights, job->roots[i], job->rotate);
+    }
+
+    return NULL;
+}
+
+void kmBVH3Refit(kmBVH3* pBVH, const kmAABB3* bounds, kmUint thread_count, kmBool rotate) {
+    km_bvh3_refit_job jobs[64];
+    kmUint* heights;
+    kmInt* top;
+    kmInt* frontier;
+    kmInt* next;
+    kmUint top_count = 0, frontier_count = 1, i, t, chunk;
+
+    if(pBVH->root == INVALID) return;
+
+    if(thread_count < 1) thread_count = 1;
+    if(thread_count > 64) thread_count = 64;
+
+    heights = (kmUint*) malloc(sizeof(kmUint) * pBVH->node_count);
+    top = (kmInt*) malloc(sizeof(kmInt) * pBVH->node_count * 3);
+    frontier = top + pBVH->node_count;
+    next = frontier + pBVH->node_count;
+
+    /*
+     * Expand a frontier of independent subtrees breadth first until there
+     * are a few per thread. The nodes above it are refit afterwards on
+     * this thread, children before parents.
+     */
+    frontier[0] = pBVH->root;
+    while(thread_count > 1 && frontier_count < thread_count * 4) {
+        kmUint next_count = 0;
+        kmInt* swap;
+
+        for(i = 0; i < frontier_count; ++i) {
+            const kmBVH3Node* node = &pBVH->nodes[frontier[i]];
+            if(node->left == INVALID) {
+                next[next_count++] = frontier[i];
+            } else {
+                top[top_count++] = frontier[i];
+                next[next_count++] = node->left;
+                next[next_count++] = node->right;
+            }
+        }
+
+        if(next_count == frontier_count) break;  /* Only leaves left */
+
+        swap = frontier;
+        frontier = next;
+        next = swap;
+        frontier_count = next_count;
+    }
+
+    if(thread_count > frontier_count) thread_count = frontier_count;
+    chunk = (frontier_count + thread_count - 1) / thread_count;
+
+    for(t = 0; t < thread_count; ++t) {
+        jobs[t].bvh = pBVH;
+        jobs[t].bounds = bounds;
+        jobs[t].heights = heights;
+        jobs[t].roots = frontier;
+        jobs[t].begin = t * chunk < frontier_count ? t * chunk : frontier_count;
+        jobs[t].end = (t + 1) * chunk < frontier_count ? (t + 1) * chunk : frontier_count;
+        jobs[t].rotate = rotate;
+    }
+
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, refit_job);
+
+    for(i = top_count; i > 0; --i) {
+        refit_node(pBVH, heights, top[i - 1], rotate);
+    }
+
+    free(top);
+    free(heights);
+}
+
+static kmBool aabb_overlaps(const kmAABB3* a, const kmAABB3* b) {
+    return a->min.x <= b->max.x && a->max.x >= b->min.x &&
+           a->min.y <= b->max.y && a->max.y >= b->min.y &&
+           a->min.z <= b->max.z && a->max.z >= b->min.z;
+}
+
+kmUint kmBVH3QueryAABB3(const kmBVH3* pBVH, const kmAABB3* box, kmUint* pOut, kmUint max_out) {
+    kmInt stack[STACK_SIZE];
+    kmUint top = 0, found = 0;
+
+    if(pBVH->root == INVALID) return 0;
+
+    stack[top++] = pBVH->root;
+    while(top) {
+        const kmBVH3Node* node = &pBVH->nodes[stack[--top]];
+
+        if(!aabb_overlaps(&node->bounds, box)) continue;
+
+        if(node->left == INVALID) {
+            if(found < max_out) pOut[found] = node->primitive;
+            ++found;
+        } else {
+            stack[top++] = node->left;
+            stack[top++] = node->right;
+        }
+    }
+
+    return found;
+}
+
+kmUint kmBVH3QueryRay3(const kmBVH3* pBVH, const kmRay3* ray, kmUint* pOut, kmUint max_out) {
+    kmInt stack[STACK_SIZE];
+    kmUint top = 0, found = 0;
+    kmRay3Prepared prepared;
+
+    if(pBVH->root == INVALID) return 0;
+
+    kmRay3Prepare(&prepared, ray);
+
+    stack[top++] = pBVH->root;
+    while(top) {
+        const kmBVH3Node* node = &pBVH->nodes[stack[--top]];
+
+        if(!kmRay3PreparedIntersectAABB3(&prepared, &node->bounds, NULL, NULL)) continue;
+
+        if(node->left == INVALID) {
+            if(found < max_out) pOut[found] = node->primitive;
+            ++found;
+        } else {
+            stack[top++] = node->left;
+            stack[top++] = node->right;
+        }
+    }
+
+    return found;
+}
+
+kmUint kmBVH3QueryRay3Packet(const kmBVH3* pBVH, const kmRay3Packet* packet,
+                             kmUint* pOut, kmUint* pMasks, kmUint max_out) {
+    kmInt stack[STACK_SIZE];
+    kmUint masks[STACK_SIZE];
+    kmUint top = 0, found = 0;
+
+    if(pBVH->root == INVALID) return 0;
+
+    stack[top] = pBVH->root;
+    masks[top++] = kmRay3PacketMask(packet);
+
+    while(top) {
+        const kmBVH3Node* node;
+        kmUint mask;
+
+        --top;
+        node = &pBVH->nodes[stack[top]];
+        mask = kmRay3PacketIntersectAABB3(packet, masks[top], &node->bounds, NULL);
+        if(!mask) continue;
+
+        if(node->left == INVALID) {
+            if(found < max_out) {
+                pOut[found] = node->primitive;
+                if(pMasks) pMasks[found] = mask;
+            }
+            ++found;
+        } else {
+            stack[top] = node->left;
+            masks[top++] = mask;
+            stack[top] = node->right;
+            masks[top++] = mask;
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,120 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_BVH3_H_INCLUDED
+#define KAZMATH_BVH3_H_INCLUDED
+
+#include <stdint.h>
+
+#include "aabb3.h"
+#include "utility.h"
+
+struct kmRay3;
+struct kmRay3Packet;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KM_BVH3_INVALID -1
+
+/* Bits per Morton code, 10 or 21 per axis */
+#define KM_BVH3_MORTON_30 30
+#define KM_BVH3_MORTON_63 63
+
+/*
+ * A binary bounding volume hierarchy over kmAABB3 primitives, built as a
+ * linear BVH: primitives are sorted by the Morton code of their centroid
+ * and the hierarchy is read off the sorted codes (Karras 2012). This is far
+ * quicker to build than a SAH tree, so it can be rebuilt every frame.
+ *
+ * With n primitives the first n - 1 nodes are internal nodes (0 is the
+ * root) and the last n are leaves, one per primitive.
+ */
+typedef struct kmBVH3Node {
+    kmAABB3 bounds;
+    kmInt parent;
+    kmInt left;                 /** KM_BVH3_INVALID for leaves */
+    kmInt right;
+    kmUint primitive;           /** The primitive of a leaf */
+} kmBVH3Node;
+
+typedef struct kmBVH3 {
+    kmBVH3Node* nodes;
+    kmUint node_count;
+    kmUint leaf_count;
+    kmInt root;
+
+    /* Scratch space kept between builds */
+    uint64_t* codes;
+    uint64_t* codes_tmp;
+    kmUint* ids;
+    kmUint* ids_tmp;
+    kmUint capacity;
+} kmBVH3;
+
+kmBVH3* kmBVH3Initialize(kmBVH3* pBVH);
+void kmBVH3Free(kmBVH3* pBVH);
+
+/**
+ * Builds the hierarchy over count primitive bounds. Centroids are
+ * quantized inside scene (computed from the centroids if NULL) into codes
+ * of code_bits (KM_BVH3_MORTON_30 or KM_BVH3_MORTON_63) bits. 30 bit codes
+ * sort twice as fast, 63 bit codes separate primitives in large scenes
+ * better. The code generation, radix sort and hierarchy emission are split
+ * between thread_count threads.
+ */
+void kmBVH3Build(kmBVH3* pBVH, const kmAABB3* bounds, kmUint count, const kmAABB3* scene,
+                 kmUint code_bits, kmUint thread_count);
+
+/**
+ * Updates the bounds of every node bottom-up from new primitive bounds
+ * (same count and order as the last build), e.g. after a mesh deformed.
+ * Subtrees are refit in parallel by thread_count threads. If rotate is
+ * KM_TRUE each node also tries swapping a child with one of its
+ * grandchildren when that shrinks the surface area of the swapped
+ * subtree, which slows the drop in tree quality between rebuilds.
+ */
+void kmBVH3Refit(kmBVH3* pBVH, const kmAABB3* bounds, kmUint thread_count, kmBool rotate);
+
+/**
+ * Returns the Morton code of point quantized inside scene.
+ */
+uint64_t kmBVH3MortonCode(const kmVec3* point, const kmAABB3* scene, kmUint code_bits);
+
+/*
+ * As with kmOctree3, queries write up to max_out primitive indices to pOut
+ * and return the total number of matches.
+ */
+kmUint kmBVH3QueryAABB3(const kmBVH3* pBVH, const kmAABB3* box, kmUint* pOut, kmUint max_out);
+kmUint kmBVH3QueryRay3(const kmBVH3* pBVH, const struct kmRay3* ray, kmUint* pOut, kmUint max_out);
+kmUint kmBVH3QueryRay3Packet(const kmBVH3* pBVH, const struct kmRay3Packet* packet,
+                             kmUint* pOut, kmUint* pMasks, kmUint max_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
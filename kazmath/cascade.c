@@ -0,0 +1,130 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <math.h>
+
+#include "cascade.h"
+
+kmScalar* kmShadowCascadeSplits(kmScalar* pOut, kmScalar near_dist, kmScalar far_dist, kmUint count,
+                                kmScalar lambda) {
+    kmUint i;
+
+    for(i = 0; i <= count; ++i) {
+        kmScalar f = (kmScalar) i / count;
+        kmScalar log_split = near_dist * pow(far_dist / near_dist, f);
+        kmScalar uniform_split = near_dist + (far_dist - near_dist) * f;
+        pOut[i] = lambda * log_split + (1 - lambda) * uniform_split;
+    }
+
+    /* Exact ends rather than rounded ones */
+    pOut[0] = near_dist;
+    pOut[count] = far_dist;
+
+    return pOut;
+}
+
+kmShadowCascade* kmShadowCascadeCompute(kmShadowCascade* pOut, const kmMat4* pView, const kmMat4* pProjection,
+                                        const kmVec3* light_dir, const kmScalar* splits, kmUint count,
+                                        kmUint resolution) {
+    kmMat4 view_projection, inverse;
+    kmVec3 near_corners[4], far_corners[4], dir, up;
+    kmScalar near_depth[4], far_depth[4];
+    kmUint c;
+    int i;
+
+    kmMat4Multiply(&view_projection, pProjection, pView);
+    kmMat4Inverse(&inverse, &view_projection);
+
+    /* The frustum's edges in world space and the view depth at each end */
+    for(i = 0; i < 4; ++i) {
+        kmVec3 ndc, in_view;
+
+        kmVec3Fill(&ndc, (i & 1) ? 1 : -1, (i & 2) ? 1 : -1, -1);
+        kmVec3TransformCoord(&near_corners[i], &ndc, &inverse);
+        ndc.z = 1;
+        kmVec3TransformCoord(&far_corners[i], &ndc, &inverse);
+
+        kmVec3MultiplyMat4(&in_view, &near_corners[i], pView);
+        near_depth[i] = -in_view.z;
+        kmVec3MultiplyMat4(&in_view, &far_corners[i], pView);
+        far_depth[i] = -in_view.z;
+    }
+
+    kmVec3Normalize(&dir, light_dir);
+    kmVec3Fill(&up, 0, 1, 0);
+    if(fabs(dir.y) > 0.99) kmVec3Fill(&up, 1, 0, 0);
+
+    for(c = 0; c < count; ++c) {
+        kmShadowCascade* cascade = &pOut[c];
+        kmScalar radius = 0, texels = resolution * 0.5;
+        kmVec3 centre, eye, origin;
+
+        cascade->split_near = splits[c];
+        cascade->split_far = splits[c + 1];
+
+        /* View depth changes linearly along each edge, so interpolate to the split */
+        kmVec3Zero(&centre);
+        for(i = 0; i < 8; ++i) {
+            kmVec3* corner = &cascade->corners[i];
+            kmScalar depth = (i < 4) ? splits[c] : splits[c + 1];
+            kmScalar t = (depth - near_depth[i & 3]) / (far_depth[i & 3] - near_depth[i & 3]);
+
+            kmVec3Subtract(corner, &far_corners[i & 3], &near_corners[i & 3]);
+            kmVec3Scale(corner, corner, t);
+            kmVec3Add(corner, corner, &near_corners[i & 3]);
+            kmVec3Add(&centre, &centre, corner);
+        }
+        kmVec3Scale(&centre, &centre, 1.0 / 8);
+
+        for(i = 0; i < 8; ++i) {
+            kmVec3 offset;
+            kmScalar distance;
+
+            kmVec3Subtract(&offset, &cascade->corners[i], &centre);
+            distance = kmVec3Length(&offset);
+            if(distance > radius) radius = distance;
+        }
+
+        /* A slightly rounded radius keeps the size stable against float noise */
+        radius = ceil(radius * 16) / 16;
+        kmSphereFill(&cascade->bounds, &centre, radius);
+
+        kmVec3Scale(&eye, &dir, -radius);
+        kmVec3Add(&eye, &eye, &centre);
+        kmMat4LookAt(&cascade->view, &eye, &centre, &up);
+        kmMat4OrthographicProjection(&cascade->projection, -radius, radius, -radius, radius, 0, 2 * radius);
+
+        /* Shift the projection so the world origin lands on a whole texel */
+        kmMat4Multiply(&cascade->view_projection, &cascade->projection, &cascade->view);
+        kmVec3Zero(&origin);
+        kmVec3MultiplyMat4(&origin, &origin, &cascade->view_projection);
+        cascade->projection.mat[12] += (floor(origin.x * texels + 0.5) - origin.x * texels) / texels;
+        cascade->projection.mat[13] += (floor(origin.y * texels + 0.5) - origin.y * texels) / texels;
+
+        kmMat4Multiply(&cascade->view_projection, &cascade->projection, &cascade->view);
+    }
+
+    return pOut;
+}
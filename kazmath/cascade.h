@@ -0,0 +1,79 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_CASCADE_H_INCLUDED
+#define KAZMATH_CASCADE_H_INCLUDED
+
+#include "vec3.h"
+#include "mat4.h"
+#include "sphere.h"
+#include "utility.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cascaded shadow maps for a directional light. The camera's frustum is
+ * cut into slices at the split distances and each slice gets its own
+ * orthographic shadow matrix fitted around a bounding sphere of the
+ * slice. Fitting to a sphere keeps the matrix size fixed as the camera
+ * turns, and snapping it to whole shadow map texels keeps the edges of
+ * shadows from shimmering as the camera moves.
+ */
+typedef struct kmShadowCascade {
+    kmScalar split_near;        /** View space distances bounding the slice */
+    kmScalar split_far;
+    kmVec3 corners[8];          /** World space, the near face then the far face */
+    kmSphere bounds;            /** World space sphere around the corners */
+    kmMat4 view;                /** The light's view */
+    kmMat4 projection;          /** Orthographic, snapped to texels */
+    kmMat4 view_projection;
+} kmShadowCascade;
+
+/**
+ * Computes count + 1 split distances from near to far, blending a
+ * logarithmic split with a uniform one by lambda (1 is fully logarithmic,
+ * 0.5 to 0.9 are common). Returns pOut.
+ */
+kmScalar* kmShadowCascadeSplits(kmScalar* pOut, kmScalar near_dist, kmScalar far_dist, kmUint count,
+                                kmScalar lambda);
+
+/**
+ * Fills count cascades for a camera, given its view and projection
+ * matrices, the direction the light shines in (world space) and count + 1
+ * split distances in front of the camera (see kmShadowCascadeSplits).
+ * resolution is the size in texels of each cascade's shadow map. Returns
+ * pOut.
+ */
+kmShadowCascade* kmShadowCascadeCompute(kmShadowCascade* pOut, const kmMat4* pView, const kmMat4* pProjection,
+                                        const kmVec3* light_dir, const kmScalar* splits, kmUint count,
+                                        kmUint resolution);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,335 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "cluster.h"
+#include "jobs.h"
+
+typedef struct km_cluster_job {
+    kmClusterGrid* grid;
+    const kmSphere* lights;
+    const kmClusterCone* cones;
+    kmUint count;
+    kmUint slice_begin;
+    kmUint slice_end;
+    kmBool write;
+
+    /* Cluster, light and rank within the cluster's list of each hit */
+    kmUint* hits;
+    kmUint hit_count;
+    kmUint hit_capacity;
+} km_cluster_job;
+
+static kmUint cluster_count(const kmClusterGrid* pGrid) {
+    return pGrid->dim_x * pGrid->dim_y * pGrid->dim_z;
+}
+
+kmClusterGrid* kmClusterGridInitialize(kmClusterGrid* pGrid, kmUint dim_x, kmUint dim_y, kmUint dim_z) {
+    kmUint count;
+
+    memset(pGrid, 0, sizeof(kmClusterGrid));
+    pGrid->dim_x = dim_x ? dim_x : 1;
+    pGrid->dim_y = dim_y ? dim_y : 1;
+    pGrid->dim_z = dim_z ? dim_z : 1;
+
+    count = cluster_count(pGrid);
+    pGrid->bounds = (kmAABB3*) malloc(sizeof(kmAABB3) * count);
+    pGrid->spheres = (kmSphere*) malloc(sizeof(kmSphere) * count);
+    pGrid->offsets = (kmUint*) calloc(count + 1, sizeof(kmUint));
+
+    return pGrid;
+}
+
+void kmClusterGridFree(kmClusterGrid* pGrid) {
+    free(pGrid->bounds);
+    free(pGrid->spheres);
+    free(pGrid->offsets);
+    free(pGrid->indices);
+    memset(pGrid, 0, sizeof(kmClusterGrid));
+}
+
+static kmScalar slice_depth(const kmClusterGrid* pGrid, kmUint k) {
+    return pGrid->z_near * pow(pGrid->z_far / pGrid->z_near, (kmScalar) k / pGrid->dim_z);
+}
+
+kmUint kmClusterGridSlice(const kmClusterGrid* pGrid, kmScalar depth) {
+    kmScalar k;
+
+    if(depth <= pGrid->z_near) return 0;
+
+    k = log(depth / pGrid->z_near) / log(pGrid->z_far / pGrid->z_near) * pGrid->dim_z;
+    return k >= pGrid->dim_z ? pGrid->dim_z - 1 : (kmUint) k;
+}
+
+kmBool kmClusterGridSetProjection(kmClusterGrid* pGrid, const kmMat4* pProjection) {
+    const kmScalar* m = pProjection->mat;
+    kmVec3* rays;
+    kmMat4 inverse;
+    kmUint x, y, z, rx = pGrid->dim_x + 1, ry = pGrid->dim_y + 1;
+
+    if(pGrid->has_projection && kmMat4AreEqual(&pGrid->projection, pProjection)) return KM_FALSE;
+
+    kmMat4Assign(&pGrid->projection, pProjection);
+    pGrid->has_projection = KM_TRUE;
+    pGrid->z_near = m[14] / (m[10] - 1);
+    pGrid->z_far = m[14] / (m[10] + 1);
+
+    kmMat4Inverse(&inverse, pProjection);
+
+    /* The tile corners on the near plane, scaled by depth / z_near they give any slice */
+    rays = (kmVec3*) malloc(sizeof(kmVec3) * rx * ry);
+    for(y = 0; y < ry; ++y) {
+        for(x = 0; x < rx; ++x) {
+            kmVec3 ndc;
+            kmVec3Fill(&ndc, -1 + 2 * (kmScalar) x / pGrid->dim_x, -1 + 2 * (kmScalar) y / pGrid->dim_y, -1);
+            kmVec3TransformCoord(&rays[y * rx + x], &ndc, &inverse);
+        }
+    }
+
+    for(z = 0; z < pGrid->dim_z; ++z) {
+        kmScalar near_scale = slice_depth(pGrid, z) / pGrid->z_near;
+        kmScalar far_scale = slice_depth(pGrid, z + 1) / pGrid->z_near;
+
+        for(y = 0; y < pGrid->dim_y; ++y) {
+            for(x = 0; x < pGrid->dim_x; ++x) {
+                kmUint c = (z * pGrid->dim_y + y) * pGrid->dim_x + x;
+                kmAABB3* box = &pGrid->bounds[c];
+                kmVec3 corner_offset;
+                int i;
+
+                for(i = 0; i < 8; ++i) {
+                    const kmVec3* ray = &rays[(y + ((i >> 1) & 1)) * rx + x + (i & 1)];
+                    kmVec3 corner;
+
+                    kmVec3Scale(&corner, ray, (i & 4) ? far_scale : near_scale);
+                    if(!i) {
+                        box->min = box->max = corner;
+                    } else {
+                        if(corner.x < box->min.x) box->min.x = corner.x;
+                        if(corner.y < box->min.y) box->min.y = corner.y;
+                        if(corner.z < box->min.z) box->min.z = corner.z;
+                        if(corner.x > box->max.x) box->max.x = corner.x;
+                        if(corner.y > box->max.y) box->max.y = corner.y;
+                        if(corner.z > box->max.z) box->max.z = corner.z;
+                    }
+                }
+
+                kmAABB3Centre(box, &pGrid->spheres[c].centre);
+                kmVec3Subtract(&corner_offset, &box->max, &pGrid->spheres[c].centre);
+                pGrid->spheres[c].radius = kmVec3Length(&corner_offset);
+            }
+        }
+    }
+
+    free(rays);
+
+    return KM_TRUE;
+}
+
+/* Bart Wronski's cone against sphere test, KM_TRUE if they may overlap */
+static kmBool cone_touches(const kmSphere* light, const kmClusterCone* cone, const kmSphere* sphere) {
+    kmVec3 v;
+    kmScalar v_sq, along, closest;
+
+    kmVec3Subtract(&v, &sphere->centre, &light->centre);
+    v_sq = kmVec3LengthSq(&v);
+    along = kmVec3Dot(&v, &cone->direction);
+    closest = cos(cone->angle) * sqrt(fabs(v_sq - along * along)) - along * sin(cone->angle);
+
+    return !(closest > sphere->radius || along > sphere->radius + light->radius || along < -sphere->radius);
+}
+
+static void add_hit(km_cluster_job* job, kmUint cluster, kmUint light, kmUint rank) {
+    kmUint* hit;
+
+    if(job->hit_count == job->hit_capacity) {
+        job->hit_capacity = job->hit_capacity ? job->hit_capacity * 2 : 256;
+        job->hits = (kmUint*) realloc(job->hits, sizeof(kmUint) * 3 * job->hit_capacity);
+    }
+
+    hit = &job->hits[job->hit_count++ * 3];
+    hit[0] = cluster;
+    hit[1] = light;
+    hit[2] = rank;
+}
+
+/* The first and last of count [min, max] ranges which overlap [lo, hi], KM_FALSE if none do */
+static kmBool overlapping_range(const kmScalar* ranges, kmUint count, kmScalar lo, kmScalar hi,
+                                kmUint* pFirst, kmUint* pLast) {
+    kmUint i;
+    kmBool any = KM_FALSE;
+
+    for(i = 0; i < count; ++i) {
+        if(ranges[i * 2] > hi || ranges[i * 2 + 1] < lo) continue;
+        if(!any) *pFirst = i;
+        *pLast = i;
+        any = KM_TRUE;
+    }
+
+    return any;
+}
+
+static void* assign_job(void* arg) {
+    km_cluster_job* job = (km_cluster_job*) arg;
+    kmClusterGrid* pGrid = job->grid;
+    kmUint dim_x = pGrid->dim_x, dim_y = pGrid->dim_y;
+    kmScalar* columns;
+    kmScalar* rows;
+    kmUint x, y, z, c, i;
+
+    if(job->write) {
+        /* The hits were found by the counting pass, just place them */
+        for(i = 0; i < job->hit_count; ++i) {
+            const kmUint* hit = &job->hits[i * 3];
+            pGrid->indices[pGrid->offsets[hit[0]] + hit[2]] = hit[1];
+        }
+        return NULL;
+    }
+
+    columns = (kmScalar*) malloc(sizeof(kmScalar) * 2 * (dim_x + dim_y));
+    rows = columns + 2 * dim_x;
+
+    for(z = job->slice_begin; z < job->slice_end; ++z) {
+        kmScalar slice_near = slice_depth(pGrid, z), slice_far = slice_depth(pGrid, z + 1);
+        kmUint first = z * dim_x * dim_y;
+
+        /* The x extent of each column and y extent of each row across the slice */
+        for(x = 0; x < dim_x; ++x) {
+            columns[x * 2] = pGrid->bounds[first + x].min.x;
+            columns[x * 2 + 1] = pGrid->bounds[first + x].max.x;
+        }
+        for(y = 0; y < dim_y; ++y) {
+            rows[y * 2] = pGrid->bounds[first + y * dim_x].min.y;
+            rows[y * 2 + 1] = pGrid->bounds[first + y * dim_x].max.y;
+        }
+        for(y = 0; y < dim_y; ++y) {
+            for(x = 0; x < dim_x; ++x) {
+                const kmAABB3* box = &pGrid->bounds[first + y * dim_x + x];
+                columns[x * 2] = kmMin(columns[x * 2], box->min.x);
+                columns[x * 2 + 1] = kmMax(columns[x * 2 + 1], box->max.x);
+                rows[y * 2] = kmMin(rows[y * 2], box->min.y);
+                rows[y * 2 + 1] = kmMax(rows[y * 2 + 1], box->max.y);
+            }
+        }
+
+        for(c = first; c < first + dim_x * dim_y; ++c) {
+            pGrid->offsets[c + 1] = 0;
+        }
+
+        for(i = 0; i < job->count; ++i) {
+            const kmSphere* light = &job->lights[i];
+            const kmVec3* p = &light->centre;
+            kmScalar depth = -p->z, radius_sq = light->radius * light->radius;
+            kmUint x0, x1, y0, y1;
+
+            /* Only visit the clusters of the slice the light's bounds reach */
+            if(depth + light->radius < slice_near || depth - light->radius > slice_far) continue;
+            if(!overlapping_range(columns, dim_x, p->x - light->radius, p->x + light->radius, &x0, &x1) ||
+               !overlapping_range(rows, dim_y, p->y - light->radius, p->y + light->radius, &y0, &y1)) continue;
+
+            for(y = y0; y <= y1; ++y) {
+                for(x = x0; x <= x1; ++x) {
+                    const kmAABB3* box;
+                    kmScalar dx, dy, dz;
+
+                    c = first + y * dim_x + x;
+                    box = &pGrid->bounds[c];
+                    dx = kmMax(kmMax(box->min.x - p->x, p->x - box->max.x), 0);
+                    dy = kmMax(kmMax(box->min.y - p->y, p->y - box->max.y), 0);
+                    dz = kmMax(kmMax(box->min.z - p->z, p->z - box->max.z), 0);
+
+                    if(dx * dx + dy * dy + dz * dz > radius_sq) continue;
+                    if(job->cones && job->cones[i].angle < kmPI &&
+                       !cone_touches(light, &job->cones[i], &pGrid->spheres[c])) continue;
+
+                    add_hit(job, c, i, pGrid->offsets[c + 1]++);
+                }
+            }
+        }
+    }
+
+    free(columns);
+
+    return NULL;
+}
+
+kmUint kmClusterGridAssignLights(kmClusterGrid* pGrid, const kmSphere* lights, const kmClusterCone* cones,
+                                 kmUint count, kmUint thread_count) {
+    km_cluster_job jobs[64];
+    kmUint t, c, clusters = cluster_count(pGrid), total;
+
+    assert(pGrid->has_projection && "Call kmClusterGridSetProjection first");
+
+    if(thread_count < 1) thread_count = 1;
+    if(thread_count > 64) thread_count = 64;
+    if(thread_count > pGrid->dim_z) thread_count = pGrid->dim_z;
+
+    memset(jobs, 0, sizeof(km_cluster_job) * thread_count);
+    for(t = 0; t < thread_count; ++t) {
+        jobs[t].grid = pGrid;
+        jobs[t].lights = lights;
+        jobs[t].cones = cones;
+        jobs[t].count = count;
+        jobs[t].slice_begin = pGrid->dim_z * t / thread_count;
+        jobs[t].slice_end = pGrid->dim_z * (t + 1) / thread_count;
+        jobs[t].write = KM_FALSE;
+    }
+
+    /* Find and count the hits per cluster, turn the counts into offsets, then place the hits */
+    pGrid->offsets[0] = 0;
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, assign_job);
+
+    for(c = 0; c < clusters; ++c) {
+        pGrid->offsets[c + 1] += pGrid->offsets[c];
+    }
+
+    total = pGrid->offsets[clusters];
+    if(total > pGrid->index_capacity) {
+        pGrid->index_capacity = total;
+        pGrid->indices = (kmUint*) realloc(pGrid->indices, sizeof(kmUint) * total);
+    }
+
+    for(t = 0; t < thread_count; ++t) {
+        jobs[t].write = KM_TRUE;
+    }
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, assign_job);
+
+    for(t = 0; t < thread_count; ++t) {
+        free(jobs[t].hits);
+    }
+
+    return total;
+}
+
+const kmUint* kmClusterGridLights(const kmClusterGrid* pGrid, kmUint x, kmUint y, kmUint z, kmUint* pCount) {
+    kmUint c = (z * pGrid->dim_y + y) * pGrid->dim_x + x;
+
+    *pCount = pGrid->offsets[c + 1] - pGrid->offsets[c];
+    return pGrid->indices + pGrid->offsets[c];
+}
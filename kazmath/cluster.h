@@ -0,0 +1,114 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_CLUSTER_H_INCLUDED
+#define KAZMATH_CLUSTER_H_INCLUDED
+
+#include "vec3.h"
+#include "mat4.h"
+#include "aabb3.h"
+#include "sphere.h"
+#include "utility.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Light assignment for clustered shading. The view frustum is split into
+ * dim_x * dim_y screen tiles and dim_z depth slices (exponentially spaced
+ * between the near and far planes), each cluster bounded by a view space
+ * kmAABB3. Lights are then tested against the clusters and the result
+ * stored as one compact list of light indices per cluster.
+ *
+ * Clusters are numbered (z * dim_y + y) * dim_x + x, with x and y
+ * counting from the bottom left of the screen and z from the near plane.
+ */
+typedef struct kmClusterGrid {
+    kmUint dim_x;
+    kmUint dim_y;
+    kmUint dim_z;
+
+    kmMat4 projection;          /** The projection the bounds were built for */
+    kmBool has_projection;
+    kmScalar z_near;
+    kmScalar z_far;
+
+    kmAABB3* bounds;            /** View space bounds of each cluster */
+    kmSphere* spheres;          /** Spheres around bounds, for the cone test */
+
+    kmUint* offsets;            /** Cluster count + 1 offsets into indices */
+    kmUint* indices;            /** Light indices, grouped by cluster */
+    kmUint index_capacity;
+} kmClusterGrid;
+
+/**
+ * The direction (unit length, view space) and half angle in radians of a
+ * spot light's cone, see kmClusterGridAssignLights.
+ */
+typedef struct kmClusterCone {
+    kmVec3 direction;
+    kmScalar angle;
+} kmClusterCone;
+
+kmClusterGrid* kmClusterGridInitialize(kmClusterGrid* pGrid, kmUint dim_x, kmUint dim_y, kmUint dim_z);
+void kmClusterGridFree(kmClusterGrid* pGrid);
+
+/**
+ * Builds the cluster bounds for a perspective projection (as made by
+ * kmMat4PerspectiveProjection), reading the near and far planes from it.
+ * Nothing is rebuilt if the projection hasn't changed since the last
+ * call. Returns KM_TRUE if the bounds were rebuilt.
+ */
+kmBool kmClusterGridSetProjection(kmClusterGrid* pGrid, const kmMat4* pProjection);
+
+/**
+ * The depth slice containing a view space distance in front of the camera
+ * (a positive number), clamped to the grid.
+ */
+kmUint kmClusterGridSlice(const kmClusterGrid* pGrid, kmScalar depth);
+
+/**
+ * Assigns count lights to the clusters their view space bounding spheres
+ * touch. If cones is not NULL, lights with a cone angle below kmPI are
+ * spot lights whose cone starts at the sphere's centre and is as long as
+ * its radius, and clusters outside the cone are skipped. The slices are
+ * split between thread_count threads. Returns the total number of light
+ * indices written. kmClusterGridSetProjection must have been called.
+ */
+kmUint kmClusterGridAssignLights(kmClusterGrid* pGrid, const kmSphere* lights, const kmClusterCone* cones,
+                                 kmUint count, kmUint thread_count);
+
+/**
+ * The lights assigned to cluster x, y, z. The number of them is stored in
+ * pCount.
+ */
+const kmUint* kmClusterGridLights(const kmClusterGrid* pGrid, kmUint x, kmUint y, kmUint z, kmUint* pCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,611 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string.h>
+
+#include "gjk3.h"
+#include "aabb3.h"
+#include "sphere.h"
+#include "obb3.h"
+
+#define GJK_MAX_ITERATIONS 64
+#define GJK_TOLERANCE (kmEpsilon * 100)
+
+#define EPA_MAX_ITERATIONS 64
+#define EPA_MAX_VERTICES 64
+#define EPA_MAX_FACES 128
+#define EPA_MAX_EDGES 128
+#define EPA_TOLERANCE (kmEpsilon * 1000)
+
+/* Points of the Minkowski difference a - b with the support points that made them */
+typedef struct km_gjk3_simplex {
+    kmVec3 w[4];
+    kmVec3 a[4];
+    kmVec3 b[4];
+    kmScalar weight[4];
+    int count;
+} km_gjk3_simplex;
+
+typedef struct km_epa3_face {
+    int v[3];
+    kmVec3 normal;
+    kmScalar distance;
+} km_epa3_face;
+
+kmConvex3* kmConvex3Fill(kmConvex3* pOut, kmSupport3Func support, const void* shape) {
+    pOut->support = support;
+    pOut->shape = shape;
+    return pOut;
+}
+
+void kmSupport3AABB3(kmVec3* pOut, const void* shape, const kmVec3* direction) {
+    const kmAABB3* box = (const kmAABB3*) shape;
+    pOut->x = direction->x >= 0 ? box->max.x : box->min.x;
+    pOut->y = direction->y >= 0 ? box->max.y : box->min.y;
+    pOut->z = direction->z >= 0 ? box->max.z : box->min.z;
+}
+
+void kmSupport3Sphere(kmVec3* pOut, const void* shape, const kmVec3* direction) {
+    const kmSphere* sphere = (const kmSphere*) shape;
+    kmScalar length = kmVec3Length(direction);
+
+    if(length > 0) {
+        kmVec3Scale(pOut, direction, sphere->radius / length);
+        kmVec3Add(pOut, pOut, &sphere->centre);
+    } else {
+        kmVec3Assign(pOut, &sphere->centre);
+    }
+}
+
+void kmSupport3OBB3(kmVec3* pOut, const void* shape, const kmVec3* direction) {
+    const kmOBB3* box = (const kmOBB3*) shape;
+    const kmScalar* axes = box->axes.mat;
+    const kmScalar* extents = &box->extents.x;
+    int i;
+
+    kmVec3Assign(pOut, &box->centre);
+    for(i = 0; i < 3; ++i) {
+        const kmScalar* axis = &axes[i * 3];
+        kmScalar e = direction->x * axis[0] + direction->y * axis[1] + direction->z * axis[2] >= 0 ?
+                     extents[i] : -extents[i];
+        pOut->x += axis[0] * e;
+        pOut->y += axis[1] * e;
+        pOut->z += axis[2] * e;
+    }
+}
+
+void kmSupport3Hull(kmVec3* pOut, const void* shape, const kmVec3* direction) {
+    const kmConvexHull3* hull = (const kmConvexHull3*) shape;
+    kmScalar best;
+    kmUint i, best_index = 0;
+
+    if(!hull->count) {
+        kmVec3Zero(pOut);
+        return;
+    }
+
+    best = kmVec3Dot(&hull->points[0], direction);
+    for(i = 1; i < hull->count; ++i) {
+        kmScalar d = kmVec3Dot(&hull->points[i], direction);
+        if(d > best) {
+            best = d;
+            best_index = i;
+        }
+    }
+
+    kmVec3Assign(pOut, &hull->points[best_index]);
+}
+
+static void support(const kmConvex3* a, const kmConvex3* b, const kmVec3* direction,
+                    kmVec3* pW, kmVec3* pA, kmVec3* pB) {
+    kmVec3 negated;
+
+    kmVec3Scale(&negated, direction, -1);
+    a->support(pA, a->shape, direction);
+    b->support(pB, b->shape, &negated);
+    kmVec3Subtract(pW, pA, pB);
+}
+
+/*
+ * Closest point to the origin on the triangle (p, q, r), as weights of the
+ * three vertices (Ericson, Real-Time Collision Detection 5.1.5).
+ */
+static void closest_on_triangle(const kmVec3* p, const kmVec3* q, const kmVec3* r, kmScalar* weights) {
+    kmVec3 pq, pr, neg;
+    kmScalar d1, d2, d3, d4, d5, d6, va, vb, vc, v, w, denom;
+
+    kmVec3Subtract(&pq, q, p);
+    kmVec3Subtract(&pr, r, p);
+
+    kmVec3Scale(&neg, p, -1);
+    d1 = kmVec3Dot(&pq, &neg);
+    d2 = kmVec3Dot(&pr, &neg);
+    if(d1 <= 0 && d2 <= 0) {
+        weights[0] = 1; weights[1] = 0; weights[2] = 0;
+        return;
+    }
+
+    kmVec3Scale(&neg, q, -1);
+    d3 = kmVec3Dot(&pq, &neg);
+    d4 = kmVec3Dot(&pr, &neg);
+    if(d3 >= 0 && d4 <= d3) {
+        weights[0] = 0; weights[1] = 1; weights[2] = 0;
+        return;
+    }
+
+    vc = d1 * d4 - d3 * d2;
+    if(vc <= 0 && d1 >= 0 && d3 <= 0) {
+        v = d1 / (d1 - d3);
+        weights[0] = 1 - v; weights[1] = v; weights[2] = 0;
+        return;
+    }
+
+    kmVec3Scale(&neg, r, -1);
+    d5 = kmVec3Dot(&pq, &neg);
+    d6 = kmVec3Dot(&pr, &neg);
+    if(d6 >= 0 && d5 <= d6) {
+        weights[0] = 0; weights[1] = 0; weights[2] = 1;
+        return;
+    }
+
+    vb = d5 * d2 - d1 * d6;
+    if(vb <= 0 && d2 >= 0 && d6 <= 0) {
+        w = d2 / (d2 - d6);
+        weights[0] = 1 - w; weights[1] = 0; weights[2] = w;
+        return;
+    }
+
+    va = d3 * d6 - d5 * d4;
+    if(va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+        w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        weights[0] = 0; weights[1] = 1 - w; weights[2] = w;
+        return;
+    }
+
+    denom = 1 / (va + vb + vc);
+    v = vb * denom;
+    w = vc * denom;
+    weights[0] = 1 - v - w; weights[1] = v; weights[2] = w;
+}
+
+static void weighted_sum(kmVec3* pOut, const kmVec3* points, const kmScalar* weights, int count) {
+    int i;
+
+    kmVec3Zero(pOut);
+    for(i = 0; i < count; ++i) {
+        pOut->x += points[i].x * weights[i];
+        pOut->y += points[i].y * weights[i];
+        pOut->z += points[i].z * weights[i];
+    }
+}
+
+/*
+ * Finds the point of the simplex closest to the origin, stores it in pV
+ * and drops the vertices that don't contribute to it. Returns KM_TRUE if
+ * the simplex is a tetrahedron containing the origin.
+ */
+static kmBool reduce_simplex(km_gjk3_simplex* s, kmVec3* pV) {
+    static const int faces[4][4] = { {0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 3, 1}, {1, 2, 3, 0} };
+    kmScalar* weight = s->weight;
+    int i, j, count = 0;
+
+    if(s->count == 1) {
+        weight[0] = 1;
+    } else if(s->count == 2) {
+        kmVec3 ab;
+        kmScalar length_sq, t;
+
+        kmVec3Subtract(&ab, &s->w[1], &s->w[0]);
+        length_sq = kmVec3LengthSq(&ab);
+        t = length_sq > 0 ? -kmVec3Dot(&s->w[0], &ab) / length_sq : 0;
+        t = t < 0 ? 0 : (t > 1 ? 1 : t);
+        weight[0] = 1 - t;
+        weight[1] = t;
+    } else if(s->count == 3) {
+        closest_on_triangle(&s->w[0], &s->w[1], &s->w[2], weight);
+    } else {
+        kmScalar best = -1;
+        kmBool outside = KM_FALSE;
+
+        /* Check each face the origin is on the far side of (from the remaining vertex) */
+        for(i = 0; i < 4; ++i) {
+            const int* f = faces[i];
+            kmVec3 e1, e2, n, to_opposite, closest;
+            kmScalar face_weights[3], d;
+
+            kmVec3Subtract(&e1, &s->w[f[1]], &s->w[f[0]]);
+            kmVec3Subtract(&e2, &s->w[f[2]], &s->w[f[0]]);
+            kmVec3Cross(&n, &e1, &e2);
+            kmVec3Subtract(&to_opposite, &s->w[f[3]], &s->w[f[0]]);
+
+            /* Flat tetrahedra count as outside every face */
+            if(-kmVec3Dot(&n, &s->w[f[0]]) * kmVec3Dot(&n, &to_opposite) > 0) continue;
+            outside = KM_TRUE;
+
+            closest_on_triangle(&s->w[f[0]], &s->w[f[1]], &s->w[f[2]], face_weights);
+            closest.x = s->w[f[0]].x * face_weights[0] + s->w[f[1]].x * face_weights[1] + s->w[f[2]].x * face_weights[2];
+            closest.y = s->w[f[0]].y * face_weights[0] + s->w[f[1]].y * face_weights[1] + s->w[f[2]].y * face_weights[2];
+            closest.z = s->w[f[0]].z * face_weights[0] + s->w[f[1]].z * face_weights[1] + s->w[f[2]].z * face_weights[2];
+            d = kmVec3LengthSq(&closest);
+
+            if(best < 0 || d < best) {
+                best = d;
+                weight[f[0]] = face_weights[0];
+                weight[f[1]] = face_weights[1];
+                weight[f[2]] = face_weights[2];
+                weight[f[3]] = 0;
+            }
+        }
+
+        if(!outside) {
+            for(i = 0; i < 4; ++i) weight[i] = 0.25;
+            kmVec3Zero(pV);
+            return KM_TRUE;
+        }
+    }
+
+    for(i = 0; i < s->count; ++i) {
+        if(weight[i] <= 0) continue;
+        j = count++;
+        s->w[j] = s->w[i];
+        s->a[j] = s->a[i];
+        s->b[j] = s->b[i];
+        weight[j] = weight[i];
+    }
+    s->count = count;
+
+    weighted_sum(pV, s->w, weight, count);
+
+    return KM_FALSE;
+}
+
+/*
+ * Runs GJK, leaving the final simplex in s and the closest point of the
+ * Minkowski difference to the origin in pV. If early_out is set it stops
+ * as soon as a separating direction is seen. Returns KM_TRUE on overlap.
+ */
+static kmBool gjk(const kmConvex3* a, const kmConvex3* b, km_gjk3_simplex* s, kmVec3* pV, kmBool early_out) {
+    kmVec3 direction;
+    int iteration, i;
+
+    kmVec3Fill(&direction, 1, 0, 0);
+    support(a, b, &direction, &s->w[0], &s->a[0], &s->b[0]);
+    s->weight[0] = 1;
+    s->count = 1;
+    kmVec3Assign(pV, &s->w[0]);
+
+    for(iteration = 0; iteration < GJK_MAX_ITERATIONS; ++iteration) {
+        kmScalar v_sq = kmVec3LengthSq(pV);
+        kmScalar scale = 0, progress;
+        kmVec3 w, pa, pb;
+        kmBool duplicate = KM_FALSE;
+
+        for(i = 0; i < s->count; ++i) {
+            kmScalar length_sq = kmVec3LengthSq(&s->w[i]);
+            if(length_sq > scale) scale = length_sq;
+        }
+        if(v_sq <= GJK_TOLERANCE * GJK_TOLERANCE * scale) return KM_TRUE;
+
+        kmVec3Scale(&direction, pV, -1);
+        support(a, b, &direction, &w, &pa, &pb);
+
+        progress = v_sq - kmVec3Dot(pV, &w);
+        if(early_out && kmVec3Dot(pV, &w) > 0) return KM_FALSE;
+        if(progress <= GJK_TOLERANCE * v_sq) return KM_FALSE;
+
+        for(i = 0; i < s->count; ++i) {
+            kmVec3 diff;
+            kmVec3Subtract(&diff, &w, &s->w[i]);
+            if(kmVec3LengthSq(&diff) <= GJK_TOLERANCE * GJK_TOLERANCE * v_sq) duplicate = KM_TRUE;
+        }
+        if(duplicate) return KM_FALSE;
+
+        s->w[s->count] = w;
+        s->a[s->count] = pa;
+        s->b[s->count] = pb;
+        ++s->count;
+
+        if(reduce_simplex(s, pV)) return KM_TRUE;
+
+        /* No progress, v is as close as this precision allows */
+        if(kmVec3LengthSq(pV) >= v_sq) return KM_FALSE;
+    }
+
+    return KM_FALSE;
+}
+
+/* Adds a face wound so that its normal points away from the inside point */
+static kmBool add_face(km_epa3_face* faces, int* face_count, const kmVec3* w, int i, int j, int k, const kmVec3* inside) {
+    km_epa3_face* face;
+    kmVec3 e1, e2, to_inside;
+    kmScalar length;
+
+    if(*face_count >= EPA_MAX_FACES) return KM_FALSE;
+    face = &faces[(*face_count)++];
+
+    kmVec3Subtract(&e1, &w[j], &w[i]);
+    kmVec3Subtract(&e2, &w[k], &w[i]);
+    kmVec3Cross(&face->normal, &e1, &e2);
+
+    face->v[0] = i;
+    face->v[1] = j;
+    face->v[2] = k;
+
+    if(inside) {
+        kmVec3Subtract(&to_inside, inside, &w[i]);
+        if(kmVec3Dot(&face->normal, &to_inside) > 0) {
+            face->v[1] = k;
+            face->v[2] = j;
+            kmVec3Scale(&face->normal, &face->normal, -1);
+        }
+    }
+
+    length = kmVec3Length(&face->normal);
+    if(length > 0) {
+        kmVec3Scale(&face->normal, &face->normal, 1 / length);
+        face->distance = kmVec3Dot(&face->normal, &w[i]);
+    } else {
+        /* Degenerate, never the closest face and never visible */
+        face->distance = 1e30f;
+    }
+
+    return KM_TRUE;
+}
+
+/* Horizon edges, an edge seen twice (once each way) is interior and cancels out */
+static void add_edge(int* edges, int* edge_count, int i, int j) {
+    int e;
+
+    for(e = 0; e < *edge_count; ++e) {
+        if(edges[e * 2] == j && edges[e * 2 + 1] == i) {
+            --(*edge_count);
+            edges[e * 2] = edges[*edge_count * 2];
+            edges[e * 2 + 1] = edges[*edge_count * 2 + 1];
+            return;
+        }
+    }
+
+    if(*edge_count < EPA_MAX_EDGES) {
+        edges[*edge_count * 2] = i;
+        edges[*edge_count * 2 + 1] = j;
+        ++(*edge_count);
+    }
+}
+
+/* Grows a simplex containing the origin into a tetrahedron */
+static kmBool blow_up_simplex(const kmConvex3* a, const kmConvex3* b, km_gjk3_simplex* s) {
+    static const kmScalar axes[6][3] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+    kmVec3 direction, w, pa, pb, diff;
+    kmScalar scale = 0;
+    int i;
+
+    for(i = 0; i < s->count; ++i) {
+        kmScalar length_sq = kmVec3LengthSq(&s->w[i]);
+        if(length_sq > scale) scale = length_sq;
+    }
+    scale = (scale > 1 ? scale : 1) * GJK_TOLERANCE;
+
+    while(s->count < 4) {
+        kmBool added = KM_FALSE;
+
+        for(i = 0; i < 6 && !added; ++i) {
+            kmVec3 e1, e2, n;
+            kmScalar extent;
+
+            if(s->count == 3 && i > 1) break;  /* Only the two normal directions */
+
+            if(s->count == 1) {
+                kmVec3Fill(&direction, axes[i][0], axes[i][1], axes[i][2]);
+            } else if(s->count == 2) {
+                kmVec3Subtract(&e1, &s->w[1], &s->w[0]);
+                kmVec3Fill(&e2, axes[i][0], axes[i][1], axes[i][2]);
+                kmVec3Cross(&direction, &e1, &e2);
+            } else {
+                kmVec3Subtract(&e1, &s->w[1], &s->w[0]);
+                kmVec3Subtract(&e2, &s->w[2], &s->w[0]);
+                kmVec3Cross(&direction, &e1, &e2);
+                if(i & 1) kmVec3Scale(&direction, &direction, -1);
+            }
+
+            if(kmVec3LengthSq(&direction) <= 0) continue;
+            support(a, b, &direction, &w, &pa, &pb);
+
+            /* The new point must not lie on the current point, line or plane */
+            kmVec3Subtract(&diff, &w, &s->w[0]);
+            if(s->count == 1) {
+                extent = kmVec3LengthSq(&diff);
+            } else if(s->count == 2) {
+                kmVec3Subtract(&e1, &s->w[1], &s->w[0]);
+                kmVec3Cross(&n, &e1, &diff);
+                extent = kmVec3LengthSq(&n) / kmVec3LengthSq(&e1);
+            } else {
+                kmVec3Normalize(&n, &direction);
+                extent = kmVec3Dot(&n, &diff);
+                extent *= extent;
+            }
+
+            if(extent > scale * scale) {
+                s->w[s->count] = w;
+                s->a[s->count] = pa;
+                s->b[s->count] = pb;
+                ++s->count;
+                added = KM_TRUE;
+            }
+        }
+
+        if(!added) return KM_FALSE;
+    }
+
+    return KM_TRUE;
+}
+
+static void epa(kmGJK3Result* pOut, const kmConvex3* a, const kmConvex3* b, km_gjk3_simplex* s) {
+    kmVec3 w[EPA_MAX_VERTICES], pa[EPA_MAX_VERTICES], pb[EPA_MAX_VERTICES];
+    km_epa3_face faces[EPA_MAX_FACES];
+    int edges[EPA_MAX_EDGES * 2];
+    int vertex_count, face_count = 0, iteration, i, closest;
+    kmVec3 inside;
+    kmScalar weights[3];
+
+    if(!blow_up_simplex(a, b, s)) return;  /* Just touching */
+
+    for(i = 0; i < 4; ++i) {
+        w[i] = s->w[i];
+        pa[i] = s->a[i];
+        pb[i] = s->b[i];
+    }
+    vertex_count = 4;
+
+    /* The centroid stays inside as the polytope grows, orient faces away from it */
+    kmVec3Zero(&inside);
+    for(i = 0; i < 4; ++i) kmVec3Add(&inside, &inside, &w[i]);
+    kmVec3Scale(&inside, &inside, 0.25);
+
+    add_face(faces, &face_count, w, 0, 1, 2, &inside);
+    add_face(faces, &face_count, w, 0, 3, 1, &inside);
+    add_face(faces, &face_count, w, 0, 2, 3, &inside);
+    add_face(faces, &face_count, w, 1, 3, 2, &inside);
+
+    for(iteration = 0; iteration < EPA_MAX_ITERATIONS; ++iteration) {
+        int edge_count = 0, new_index;
+        kmVec3 new_w, new_a, new_b;
+
+        closest = 0;
+        for(i = 1; i < face_count; ++i) {
+            if(faces[i].distance < faces[closest].distance) closest = i;
+        }
+
+        support(a, b, &faces[closest].normal, &new_w, &new_a, &new_b);
+        if(kmVec3Dot(&new_w, &faces[closest].normal) - faces[closest].distance <=
+           EPA_TOLERANCE * (faces[closest].distance > 1 ? faces[closest].distance : 1)) break;
+        if(vertex_count == EPA_MAX_VERTICES) break;
+
+        new_index = vertex_count++;
+        w[new_index] = new_w;
+        pa[new_index] = new_a;
+        pb[new_index] = new_b;
+
+        /* Remove every face the new point can see, keeping their outline */
+        for(i = 0; i < face_count;) {
+            kmVec3 diff;
+            kmVec3Subtract(&diff, &new_w, &w[faces[i].v[0]]);
+            if(faces[i].distance < 1e30f && kmVec3Dot(&faces[i].normal, &diff) > 0) {
+                add_edge(edges, &edge_count, faces[i].v[0], faces[i].v[1]);
+                add_edge(edges, &edge_count, faces[i].v[1], faces[i].v[2]);
+                add_edge(edges, &edge_count, faces[i].v[2], faces[i].v[0]);
+                faces[i] = faces[--face_count];
+            } else {
+                ++i;
+            }
+        }
+
+        /* The outline keeps the winding of the removed faces */
+        for(i = 0; i < edge_count; ++i) {
+            if(!add_face(faces, &face_count, w, edges[i * 2], edges[i * 2 + 1], new_index, NULL)) break;
+        }
+
+        if(!face_count) return;
+    }
+
+    closest = 0;
+    for(i = 1; i < face_count; ++i) {
+        if(faces[i].distance < faces[closest].distance) closest = i;
+    }
+
+    {
+        const km_epa3_face* face = &faces[closest];
+        kmVec3 projected, tri[3], local[3];
+
+        kmVec3Scale(&projected, &face->normal, face->distance);
+        for(i = 0; i < 3; ++i) {
+            tri[i] = w[face->v[i]];
+            kmVec3Subtract(&local[i], &tri[i], &projected);
+        }
+
+        /* The origin projected onto the face, as weights of its vertices */
+        closest_on_triangle(&local[0], &local[1], &local[2], weights);
+
+        pOut->depth = face->distance;
+        pOut->normal = face->normal;
+        kmVec3Zero(&pOut->point_a);
+        kmVec3Zero(&pOut->point_b);
+        for(i = 0; i < 3; ++i) {
+            kmVec3 scaled;
+            kmVec3Scale(&scaled, &pa[face->v[i]], weights[i]);
+            kmVec3Add(&pOut->point_a, &pOut->point_a, &scaled);
+            kmVec3Scale(&scaled, &pb[face->v[i]], weights[i]);
+            kmVec3Add(&pOut->point_b, &pOut->point_b, &scaled);
+        }
+    }
+}
+
+kmBool kmGJK3Intersects(const kmConvex3* a, const kmConvex3* b) {
+    km_gjk3_simplex s;
+    kmVec3 v;
+    return gjk(a, b, &s, &v, KM_TRUE);
+}
+
+kmScalar kmGJK3Distance(const kmConvex3* a, const kmConvex3* b, kmVec3* pPointA, kmVec3* pPointB) {
+    km_gjk3_simplex s;
+    kmVec3 v;
+    kmBool overlap = gjk(a, b, &s, &v, KM_FALSE);
+
+    if(pPointA) weighted_sum(pPointA, s.a, s.weight, s.count);
+    if(pPointB) weighted_sum(pPointB, s.b, s.weight, s.count);
+
+    return overlap ? 0 : kmVec3Length(&v);
+}
+
+kmBool kmGJK3Collide(kmGJK3Result* pOut, const kmConvex3* a, const kmConvex3* b) {
+    km_gjk3_simplex s;
+    kmVec3 v;
+
+    memset(pOut, 0, sizeof(kmGJK3Result));
+
+    if(!gjk(a, b, &s, &v, KM_FALSE)) {
+        pOut->distance = kmVec3Length(&v);
+        weighted_sum(&pOut->point_a, s.a, s.weight, s.count);
+        weighted_sum(&pOut->point_b, s.b, s.weight, s.count);
+        if(pOut->distance > 0) kmVec3Scale(&pOut->normal, &v, -1 / pOut->distance);
+        return KM_FALSE;
+    }
+
+    pOut->intersecting = KM_TRUE;
+    weighted_sum(&pOut->point_a, s.a, s.weight, s.count);
+    weighted_sum(&pOut->point_b, s.b, s.weight, s.count);
+    epa(pOut, a, b, &s);
+
+    return KM_TRUE;
+}
+
+kmUint kmGJK3CollidePairs(const kmConvex3* shapes, const kmUint* pairs, kmUint pair_count, kmGJK3Result* pResults) {
+    kmUint i, hits = 0;
+
+    for(i = 0; i < pair_count; ++i) {
+        if(kmGJK3Collide(&pResults[i], &shapes[pairs[i * 2]], &shapes[pairs[i * 2 + 1]])) ++hits;
+    }
+
+    return hits;
+}
@@ -0,0 +1,110 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_GJK3_H_INCLUDED
+#define KAZMATH_GJK3_H_INCLUDED
+
+#include "vec3.h"
+#include "utility.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Distance and penetration between convex shapes using GJK and EPA. A
+ * shape is anything that can report its furthest point along a direction,
+ * so kmConvex3 pairs a support function with the shape's data. Supports
+ * for the kazmath primitives are provided below.
+ *
+ * Nothing here allocates, the simplex and the EPA polytope live on the
+ * stack with fixed limits.
+ */
+typedef void (*kmSupport3Func)(kmVec3* pOut, const void* shape, const kmVec3* direction);
+
+typedef struct kmConvex3 {
+    kmSupport3Func support;
+    const void* shape;
+} kmConvex3;
+
+/**
+ * A convex hull given by its points, for kmSupport3Hull. The points are
+ * not copied.
+ */
+typedef struct kmConvexHull3 {
+    const kmVec3* points;
+    kmUint count;
+} kmConvexHull3;
+
+typedef struct kmGJK3Result {
+    kmBool intersecting;
+    kmScalar distance;      /** Separation, 0 when intersecting */
+    kmScalar depth;         /** Penetration depth, 0 when separated */
+    kmVec3 normal;          /** Unit length, pointing from a towards b */
+    kmVec3 point_a;         /** Closest (or deepest) point on a */
+    kmVec3 point_b;         /** Closest (or deepest) point on b */
+} kmGJK3Result;
+
+kmConvex3* kmConvex3Fill(kmConvex3* pOut, kmSupport3Func support, const void* shape);
+
+/* Support functions, shape is a kmAABB3, kmSphere, kmOBB3 or kmConvexHull3 */
+void kmSupport3AABB3(kmVec3* pOut, const void* shape, const kmVec3* direction);
+void kmSupport3Sphere(kmVec3* pOut, const void* shape, const kmVec3* direction);
+void kmSupport3OBB3(kmVec3* pOut, const void* shape, const kmVec3* direction);
+void kmSupport3Hull(kmVec3* pOut, const void* shape, const kmVec3* direction);
+
+/**
+ * Returns KM_TRUE if the shapes overlap. Cheaper than kmGJK3Collide as it
+ * stops as soon as a separating direction is found.
+ */
+kmBool kmGJK3Intersects(const kmConvex3* a, const kmConvex3* b);
+
+/**
+ * Returns the distance between the shapes, or 0 if they overlap. The
+ * closest points are written to pPointA and pPointB if they are not NULL.
+ */
+kmScalar kmGJK3Distance(const kmConvex3* a, const kmConvex3* b, kmVec3* pPointA, kmVec3* pPointB);
+
+/**
+ * Runs GJK and, if the shapes overlap, EPA to find the penetration depth
+ * and normal: moving b by normal * depth separates them. Shapes that only
+ * touch give a depth of 0 and may leave the normal zero. Returns
+ * pOut->intersecting.
+ */
+kmBool kmGJK3Collide(kmGJK3Result* pOut, const kmConvex3* a, const kmConvex3* b);
+
+/**
+ * Runs kmGJK3Collide for pair_count pairs of indices into shapes, stored
+ * as two consecutive entries per pair (the layout the broadphase pair
+ * queries produce). Writes one result per pair and returns the number of
+ * intersecting pairs.
+ */
+kmUint kmGJK3CollidePairs(const kmConvex3* shapes, const kmUint* pairs, kmUint pair_count, kmGJK3Result* pResults);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,386 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid2.h"
+#include "ray2.h"
+
+#define INVALID KM_GRID2_INVALID
+
+static kmUint bucket_index(const kmGrid2* pGrid, kmInt x, kmInt y) {
+    return (((kmUint) x * 73856093u) ^ ((kmUint) y * 19349663u)) & (pGrid->bucket_count - 1);
+}
+
+static kmInt cell_coord(const kmGrid2* pGrid, kmScalar v) {
+    return (kmInt) floor(v * pGrid->inv_cell_size);
+}
+
+static kmInt alloc_entry(kmGrid2* pGrid) {
+    kmInt index;
+
+    if(pGrid->free_entry != INVALID) {
+        index = pGrid->free_entry;
+        pGrid->free_entry = pGrid->entries[index].next;
+        return index;
+    }
+
+    if(pGrid->entry_count == pGrid->entry_capacity) {
+        pGrid->entry_capacity = pGrid->entry_capacity ? pGrid->entry_capacity * 2 : 64;
+        pGrid->entries = (kmGrid2Entry*) realloc(pGrid->entries, sizeof(kmGrid2Entry) * pGrid->entry_capacity);
+    }
+
+    return (kmInt) pGrid->entry_count++;
+}
+
+static kmInt alloc_object(kmGrid2* pGrid) {
+    kmInt index;
+
+    if(pGrid->free_object != INVALID) {
+        index = pGrid->free_object;
+        pGrid->free_object = pGrid->objects[index].next_free;
+        return index;
+    }
+
+    if(pGrid->object_count == pGrid->object_capacity) {
+        pGrid->object_capacity = pGrid->object_capacity ? pGrid->object_capacity * 2 : 16;
+        pGrid->objects = (kmGrid2Object*) realloc(pGrid->objects, sizeof(kmGrid2Object) * pGrid->object_capacity);
+    }
+
+    return (kmInt) pGrid->object_count++;
+}
+
+static void add_entries(kmGrid2* pGrid, kmInt handle) {
+    kmInt x, y;
+    kmGrid2Object* obj = &pGrid->objects[handle];
+
+    obj->first_entry = INVALID;
+
+    for(y = obj->min_y; y <= obj->max_y; ++y) {
+        for(x = obj->min_x; x <= obj->max_x; ++x) {
+            kmInt index = alloc_entry(pGrid);
+            kmGrid2Entry* entry = &pGrid->entries[index];
+            kmUint bucket = bucket_index(pGrid, x, y);
+
+            /* alloc_entry never moves the object pool */
+            entry->cell_x = x;
+            entry->cell_y = y;
+            entry->object = handle;
+            entry->prev = INVALID;
+            entry->next = pGrid->buckets[bucket];
+            if(entry->next != INVALID) {
+                pGrid->entries[entry->next].prev = index;
+            }
+            pGrid->buckets[bucket] = index;
+
+            entry->next_in_object = obj->first_entry;
+            obj->first_entry = index;
+        }
+    }
+
+    if(pGrid->min_x > pGrid->max_x) {
+        pGrid->min_x = obj->min_x;
+        pGrid->min_y = obj->min_y;
+        pGrid->max_x = obj->max_x;
+        pGrid->max_y = obj->max_y;
+    } else {
+        if(obj->min_x < pGrid->min_x) pGrid->min_x = obj->min_x;
+        if(obj->min_y < pGrid->min_y) pGrid->min_y = obj->min_y;
+        if(obj->max_x > pGrid->max_x) pGrid->max_x = obj->max_x;
+        if(obj->max_y > pGrid->max_y) pGrid->max_y = obj->max_y;
+    }
+}
+
+static void remove_entries(kmGrid2* pGrid, kmInt handle) {
+    kmInt index = pGrid->objects[handle].first_entry;
+
+    while(index != INVALID) {
+        kmGrid2Entry* entry = &pGrid->entries[index];
+        kmInt next_in_object = entry->next_in_object;
+
+        if(entry->prev != INVALID) {
+            pGrid->entries[entry->prev].next = entry->next;
+        } else {
+            pGrid->buckets[bucket_index(pGrid, entry->cell_x, entry->cell_y)] = entry->next;
+        }
+        if(entry->next != INVALID) {
+            pGrid->entries[entry->next].prev = entry->prev;
+        }
+
+        entry->next = pGrid->free_entry;
+        pGrid->free_entry = index;
+
+        index = next_in_object;
+    }
+
+    pGrid->objects[handle].first_entry = INVALID;
+}
+
+static void cell_range(const kmGrid2* pGrid, const kmAABB2* box, kmInt* min_x, kmInt* min_y, kmInt* max_x, kmInt* max_y) {
+    *min_x = cell_coord(pGrid, box->min.x);
+    *min_y = cell_coord(pGrid, box->min.y);
+    *max_x = cell_coord(pGrid, box->max.x);
+    *max_y = cell_coord(pGrid, box->max.y);
+}
+
+kmGrid2* kmGrid2Initialize(kmGrid2* pGrid, kmScalar cell_size, kmUint bucket_count) {
+    kmUint i, count = 1;
+
+    while(count < bucket_count) count <<= 1;
+
+    memset(pGrid, 0, sizeof(kmGrid2));
+    pGrid->cell_size = cell_size;
+    pGrid->inv_cell_size = 1.0 / cell_size;
+    pGrid->bucket_count = count;
+    pGrid->buckets = (kmInt*) malloc(sizeof(kmInt) * count);
+    for(i = 0; i < count; ++i) {
+        pGrid->buckets[i] = INVALID;
+    }
+
+    pGrid->free_entry = INVALID;
+    pGrid->free_object = INVALID;
+
+    /* An empty range */
+    pGrid->min_x = pGrid->min_y = 0;
+    pGrid->max_x = pGrid->max_y = -1;
+
+    return pGrid;
+}
+
+void kmGrid2Free(kmGrid2* pGrid) {
+    free(pGrid->buckets);
+    free(pGrid->entries);
+    free(pGrid->objects);
+    memset(pGrid, 0, sizeof(kmGrid2));
+}
+
+kmUint kmGrid2Insert(kmGrid2* pGrid, const kmAABB2* bounds) {
+    kmInt handle = alloc_object(pGrid);
+    kmGrid2Object* obj = &pGrid->objects[handle];
+
+    kmAABB2Assign(&obj->bounds, bounds);
+    cell_range(pGrid, bounds, &obj->min_x, &obj->min_y, &obj->max_x, &obj->max_y);
+    add_entries(pGrid, handle);
+
+    return (kmUint) handle;
+}
+
+void kmGrid2Update(kmGrid2* pGrid, kmUint handle, const kmAABB2* bounds) {
+    kmGrid2Object* obj = &pGrid->objects[handle];
+    kmInt min_x, min_y, max_x, max_y;
+
+    kmAABB2Assign(&obj->bounds, bounds);
+    cell_range(pGrid, bounds, &min_x, &min_y, &max_x, &max_y);
+
+    if(min_x == obj->min_x && min_y == obj->min_y && max_x == obj->max_x && max_y == obj->max_y) {
+        return;
+    }
+
+    remove_entries(pGrid, (kmInt) handle);
+    obj->min_x = min_x;
+    obj->min_y = min_y;
+    obj->max_x = max_x;
+    obj->max_y = max_y;
+    add_entries(pGrid, (kmInt) handle);
+}
+
+void kmGrid2Remove(kmGrid2* pGrid, kmUint handle) {
+    remove_entries(pGrid, (kmInt) handle);
+    pGrid->objects[handle].next_free = pGrid->free_object;
+    pGrid->free_object = (kmInt) handle;
+}
+
+/*
+ * Collects the objects overlapping box. An object is reported from the
+ * first cell (lowest x and y) that both it and the query cover, so that
+ * it is only reported once. If self is a valid handle only objects with a
+ * larger handle are reported, as (self, other) pairs.
+ */
+static kmUint query_box(const kmGrid2* pGrid, const kmAABB2* box, kmInt self,
+                        kmUint* pOut, kmUint max_out, kmUint found) {
+    kmInt min_x, min_y, max_x, max_y, x, y;
+
+    cell_range(pGrid, box, &min_x, &min_y, &max_x, &max_y);
+
+    for(y = min_y; y <= max_y; ++y) {
+        for(x = min_x; x <= max_x; ++x) {
+            kmInt index = pGrid->buckets[bucket_index(pGrid, x, y)];
+
+            for(; index != INVALID; index = pGrid->entries[index].next) {
+                const kmGrid2Entry* entry = &pGrid->entries[index];
+                const kmGrid2Object* obj;
+
+                if(entry->cell_x != x || entry->cell_y != y || entry->object <= self) continue;
+
+                obj = &pGrid->objects[entry->object];
+                if(x != (obj->min_x > min_x ? obj->min_x : min_x) ||
+                   y != (obj->min_y > min_y ? obj->min_y : min_y)) {
+                    continue;
+                }
+
+                if(!kmAABB2IntersectsAABB(&obj->bounds, box)) continue;
+
+                if(found < max_out) {
+                    if(self == INVALID) {
+                        pOut[found] = (kmUint) entry->object;
+                    } else {
+                        pOut[found * 2] = (kmUint) self;
+                        pOut[found * 2 + 1] = (kmUint) entry->object;
+                    }
+                }
+                ++found;
+            }
+        }
+    }
+
+    return found;
+}
+
+kmUint kmGrid2QueryAABB2(const kmGrid2* pGrid, const kmAABB2* box, kmUint* pOut, kmUint max_out) {
+    return query_box(pGrid, box, INVALID, pOut, max_out, 0);
+}
+
+kmUint kmGrid2QueryAABB2Array(const kmGrid2* pGrid, const kmAABB2* queries, kmUint count,
+                              kmUint* pOffsets, kmUint* pOut, kmUint max_out) {
+    kmUint i, found = 0;
+
+    for(i = 0; i < count; ++i) {
+        pOffsets[i] = found;
+        found += query_box(pGrid, &queries[i], INVALID, pOut + (found < max_out ? found : max_out),
+                           found < max_out ? max_out - found : 0, 0);
+    }
+    pOffsets[count] = found;
+
+    return found;
+}
+
+kmUint kmGrid2QueryPairs(const kmGrid2* pGrid, kmUint* pOut, kmUint max_pairs) {
+    kmUint i, found = 0;
+
+    for(i = 0; i < pGrid->object_count; ++i) {
+        const kmGrid2Object* obj = &pGrid->objects[i];
+        if(obj->first_entry == INVALID) continue;
+        found = query_box(pGrid, &obj->bounds, (kmInt) i, pOut, max_pairs, found);
+    }
+
+    return found;
+}
+
+static kmBool in_range(const kmGrid2Object* obj, kmInt x, kmInt y) {
+    return x >= obj->min_x && x <= obj->max_x && y >= obj->min_y && y <= obj->max_y;
+}
+
+static kmBool clip_slab(kmScalar start, kmScalar dir, kmScalar lo, kmScalar hi, kmScalar* t_enter, kmScalar* t_exit) {
+    kmScalar t1, t2;
+
+    if(dir == 0) {
+        /* Parallel to the slab, either inside it for every t or never */
+        *t_enter = -INFINITY;
+        *t_exit = INFINITY;
+        return start >= lo && start <= hi;
+    }
+
+    t1 = (lo - start) / dir;
+    t2 = (hi - start) / dir;
+    *t_enter = kmMin(t1, t2);
+    *t_exit = kmMax(t1, t2);
+    return KM_TRUE;
+}
+
+kmUint kmGrid2QueryRay2(const kmGrid2* pGrid, const kmRay2* ray, kmUint* pOut, kmUint max_out) {
+    kmScalar cs = pGrid->cell_size;
+    kmScalar t1, t2, t3, t4, tmin, tmax;
+    kmScalar t_next_x, t_next_y, t_delta_x, t_delta_y;
+    kmInt x, y, step_x, step_y, prev_x = 0, prev_y = 0;
+    kmBool first = KM_TRUE;
+    kmUint found = 0;
+
+    if(pGrid->min_x > pGrid->max_x || (ray->dir.x == 0 && ray->dir.y == 0)) {
+        return 0;
+    }
+
+    /* Clip the ray to the occupied range */
+    if(!clip_slab(ray->start.x, ray->dir.x, pGrid->min_x * cs, (pGrid->max_x + 1) * cs, &t1, &t2) ||
+       !clip_slab(ray->start.y, ray->dir.y, pGrid->min_y * cs, (pGrid->max_y + 1) * cs, &t3, &t4)) {
+        return 0;
+    }
+
+    tmin = kmMax(kmMax(t1, t3), 0);
+    tmax = kmMin(t2, t4);
+    if(tmin > tmax) {
+        return 0;
+    }
+
+    x = cell_coord(pGrid, ray->start.x + ray->dir.x * tmin);
+    y = cell_coord(pGrid, ray->start.y + ray->dir.y * tmin);
+    x = x < pGrid->min_x ? pGrid->min_x : (x > pGrid->max_x ? pGrid->max_x : x);
+    y = y < pGrid->min_y ? pGrid->min_y : (y > pGrid->max_y ? pGrid->max_y : y);
+
+    /* Amanatides & Woo grid traversal */
+    step_x = ray->dir.x > 0 ? 1 : (ray->dir.x < 0 ? -1 : 0);
+    step_y = ray->dir.y > 0 ? 1 : (ray->dir.y < 0 ? -1 : 0);
+    t_next_x = step_x ? ((x + (step_x > 0)) * cs - ray->start.x) / ray->dir.x : INFINITY;
+    t_next_y = step_y ? ((y + (step_y > 0)) * cs - ray->start.y) / ray->dir.y : INFINITY;
+    t_delta_x = step_x ? cs / fabs(ray->dir.x) : INFINITY;
+    t_delta_y = step_y ? cs / fabs(ray->dir.y) : INFINITY;
+
+    while(x >= pGrid->min_x && x <= pGrid->max_x && y >= pGrid->min_y && y <= pGrid->max_y) {
+        kmInt index = pGrid->buckets[bucket_index(pGrid, x, y)];
+
+        for(; index != INVALID; index = pGrid->entries[index].next) {
+            const kmGrid2Entry* entry = &pGrid->entries[index];
+            const kmGrid2Object* obj;
+
+            if(entry->cell_x != x || entry->cell_y != y) continue;
+
+            /*
+             * The cells visited inside an object's range are consecutive, so
+             * only test it on the first of them.
+             */
+            obj = &pGrid->objects[entry->object];
+            if(!first && in_range(obj, prev_x, prev_y)) continue;
+
+            if(kmRay2IntersectAABB2(ray, &obj->bounds, NULL, NULL)) {
+                if(found < max_out) pOut[found] = (kmUint) entry->object;
+                ++found;
+            }
+        }
+
+        first = KM_FALSE;
+        prev_x = x;
+        prev_y = y;
+
+        if(t_next_x < t_next_y) {
+            x += step_x;
+            t_next_x += t_delta_x;
+        } else {
+            y += step_y;
+            t_next_y += t_delta_y;
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_GRID2_H_INCLUDED
+#define KAZMATH_GRID2_H_INCLUDED
+
+#include "vec2.h"
+#include "aabb2.h"
+#include "utility.h"
+
+struct kmRay2;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KM_GRID2_INVALID -1
+
+/*
+ * An unbounded uniform grid of square cells, hashed into a fixed number of
+ * buckets. Each object is entered into every cell its kmAABB2 overlaps, so
+ * the cell size should be around the size of a typical object.
+ *
+ * Cell entries and objects live in flat pools with free lists and are
+ * linked by index; object handles are indices into the object pool. Moving
+ * an object only touches the grid when the range of cells it covers
+ * changes.
+ */
+typedef struct kmGrid2Entry {
+    kmInt cell_x, cell_y;
+    kmInt object;
+    kmInt prev, next;           /** Chain of entries in the same bucket */
+    kmInt next_in_object;       /** Chain of entries of the same object */
+} kmGrid2Entry;
+
+typedef struct kmGrid2Object {
+    kmAABB2 bounds;
+    kmInt min_x, min_y;         /** The range of cells covered */
+    kmInt max_x, max_y;
+    kmInt first_entry;          /** KM_GRID2_INVALID if the slot is free */
+    kmInt next_free;
+} kmGrid2Object;
+
+typedef struct kmGrid2 {
+    kmScalar cell_size;
+    kmScalar inv_cell_size;
+
+    kmInt* buckets;
+    kmUint bucket_count;
+
+    kmGrid2Entry* entries;
+    kmUint entry_count;
+    kmUint entry_capacity;
+    kmInt free_entry;
+
+    kmGrid2Object* objects;
+    kmUint object_count;        /** Slots in use, including freed ones */
+    kmUint object_capacity;
+    kmInt free_object;
+
+    /* The range of cells that have ever been occupied, bounds ray queries */
+    kmInt min_x, min_y;
+    kmInt max_x, max_y;
+} kmGrid2;
+
+/**
+ * Initializes an empty grid. bucket_count is rounded up to a power of two.
+ * Returns pGrid.
+ */
+kmGrid2* kmGrid2Initialize(kmGrid2* pGrid, kmScalar cell_size, kmUint bucket_count);
+void kmGrid2Free(kmGrid2* pGrid);
+
+kmUint kmGrid2Insert(kmGrid2* pGrid, const kmAABB2* bounds);
+void kmGrid2Update(kmGrid2* pGrid, kmUint handle, const kmAABB2* bounds);
+void kmGrid2Remove(kmGrid2* pGrid, kmUint handle);
+
+/*
+ * The queries behave like their kmQuadtree2 counterparts (see
+ * quadtree2.h). Every object is reported once, however many cells it
+ * covers.
+ */
+kmUint kmGrid2QueryAABB2(const kmGrid2* pGrid, const kmAABB2* box, kmUint* pOut, kmUint max_out);
+kmUint kmGrid2QueryAABB2Array(const kmGrid2* pGrid, const kmAABB2* queries, kmUint count,
+                              kmUint* pOffsets, kmUint* pOut, kmUint max_out);
+kmUint kmGrid2QueryPairs(const kmGrid2* pGrid, kmUint* pOut, kmUint max_pairs);
+
+/**
+ * Walks the cells along the ray (stopping once it leaves the occupied
+ * range) and reports the objects kmRay2IntersectBox says it hits.
+ */
+kmUint kmGrid2QueryRay2(const kmGrid2* pGrid, const struct kmRay2* ray, kmUint* pOut, kmUint max_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,279 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashgrid3.h"
+#include "jobs.h"
+
+static kmUint hash_cell(const kmHashGrid3* pGrid, kmInt x, kmInt y, kmInt z) {
+    return (((kmUint) x * 73856093u) ^ ((kmUint) y * 19349663u) ^ ((kmUint) z * 83492791u)) &
+           (pGrid->table_size - 1);
+}
+
+static kmUint point_bucket(const kmHashGrid3* pGrid, const kmVec3* p) {
+    kmInt x, y, z;
+    kmHashGrid3CellOf(pGrid, p, &x, &y, &z);
+    return hash_cell(pGrid, x, y, z);
+}
+
+static void reserve(kmHashGrid3* pGrid, kmUint count) {
+    if(count > pGrid->capacity) {
+        pGrid->capacity = count;
+        pGrid->indices = (kmUint*) realloc(pGrid->indices, sizeof(kmUint) * count);
+        pGrid->point_bucket = (kmUint*) realloc(pGrid->point_bucket, sizeof(kmUint) * count);
+    }
+}
+
+kmHashGrid3* kmHashGrid3Initialize(kmHashGrid3* pGrid, kmScalar cell_size, kmUint table_size) {
+    kmUint size = 1;
+
+    while(size < table_size) size <<= 1;
+
+    memset(pGrid, 0, sizeof(kmHashGrid3));
+    pGrid->cell_size = cell_size;
+    pGrid->inv_cell_size = 1.0 / cell_size;
+    pGrid->table_size = size;
+    pGrid->cell_start = (kmUint*) calloc(size + 1, sizeof(kmUint));
+
+    return pGrid;
+}
+
+void kmHashGrid3Free(kmHashGrid3* pGrid) {
+    free(pGrid->cell_start);
+    free(pGrid->indices);
+    free(pGrid->point_bucket);
+    memset(pGrid, 0, sizeof(kmHashGrid3));
+}
+
+void kmHashGrid3Build(kmHashGrid3* pGrid, const kmVec3* points, kmUint count) {
+    kmUint* start = pGrid->cell_start;
+    kmUint i, sum = 0;
+
+    reserve(pGrid, count);
+    pGrid->points = points;
+    pGrid->point_count = count;
+
+    memset(start, 0, sizeof(kmUint) * (pGrid->table_size + 1));
+
+    for(i = 0; i < count; ++i) {
+        kmUint b = point_bucket(pGrid, &points[i]);
+        pGrid->point_bucket[i] = b;
+        ++start[b];
+    }
+
+    /* Turn the counts into the end of each bucket's range... */
+    for(i = 0; i < pGrid->table_size; ++i) {
+        sum += start[i];
+        start[i] = sum;
+    }
+    start[pGrid->table_size] = count;
+
+    /* ...and scatter backwards, leaving each entry at its bucket's start */
+    for(i = count; i > 0; --i) {
+        kmUint b = pGrid->point_bucket[i - 1];
+        pGrid->indices[--start[b]] = i - 1;
+    }
+}
+
+typedef struct {
+    kmHashGrid3* grid;
+    kmUint begin;
+    kmUint end;
+    kmUint* offsets;            /** table_size counts, then write positions */
+} km_hashgrid3_job;
+
+static void* count_job(void* arg) {
+    km_hashgrid3_job* job = (km_hashgrid3_job*) arg;
+    kmHashGrid3* pGrid = job->grid;
+    kmUint i;
+
+    for(i = job->begin; i < job->end; ++i) {
+        kmUint b = point_bucket(pGrid, &pGrid->points[i]);
+        pGrid->point_bucket[i] = b;
+        ++job->offsets[b];
+    }
+
+    return NULL;
+}
+
+static void* scatter_job(void* arg) {
+    km_hashgrid3_job* job = (km_hashgrid3_job*) arg;
+    kmHashGrid3* pGrid = job->grid;
+    kmUint i;
+
+    for(i = job->begin; i < job->end; ++i) {
+        pGrid->indices[job->offsets[pGrid->point_bucket[i]]++] = i;
+    }
+
+    return NULL;
+}
+
+void kmHashGrid3BuildParallel(kmHashGrid3* pGrid, const kmVec3* points, kmUint count, kmUint thread_count) {
+    km_hashgrid3_job* jobs;
+    kmUint* offsets;
+    kmUint t, b, sum = 0, chunk;
+
+    if(thread_count < 2 || count < thread_count) {
+        kmHashGrid3Build(pGrid, points, count);
+        return;
+    }
+
+    reserve(pGrid, count);
+    pGrid->points = points;
+    pGrid->point_count = count;
+
+    jobs = (km_hashgrid3_job*) malloc(sizeof(km_hashgrid3_job) * thread_count);
+    offsets = (kmUint*) calloc((size_t) thread_count * pGrid->table_size, sizeof(kmUint));
+
+    chunk = (count + thread_count - 1) / thread_count;
+    for(t = 0; t < thread_count; ++t) {
+        jobs[t].grid = pGrid;
+        jobs[t].begin = t * chunk < count ? t * chunk : count;
+        jobs[t].end = (t + 1) * chunk < count ? (t + 1) * chunk : count;
+        jobs[t].offsets = offsets + (size_t) t * pGrid->table_size;
+    }
+
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, count_job);
+
+    /*
+     * Each thread writes its part of a bucket after the parts of the
+     * threads before it, which gives the same order as the serial build.
+     */
+    for(b = 0; b < pGrid->table_size; ++b) {
+        pGrid->cell_start[b] = sum;
+        for(t = 0; t < thread_count; ++t) {
+            kmUint n = jobs[t].offsets[b];
+            jobs[t].offsets[b] = sum;
+            sum += n;
+        }
+    }
+    pGrid->cell_start[pGrid->table_size] = count;
+
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, scatter_job);
+
+    free(offsets);
+    free(jobs);
+}
+
+void kmHashGrid3CellOf(const kmHashGrid3* pGrid, const kmVec3* point, kmInt* x, kmInt* y, kmInt* z) {
+    *x = (kmInt) floor(point->x * pGrid->inv_cell_size);
+    *y = (kmInt) floor(point->y * pGrid->inv_cell_size);
+    *z = (kmInt) floor(point->z * pGrid->inv_cell_size);
+}
+
+const kmUint* kmHashGrid3Bucket(const kmHashGrid3* pGrid, kmInt x, kmInt y, kmInt z, kmUint* pCount) {
+    kmUint b = hash_cell(pGrid, x, y, z);
+    *pCount = pGrid->cell_start[b + 1] - pGrid->cell_start[b];
+    return pGrid->indices + pGrid->cell_start[b];
+}
+
+static void iterator_enter_cell(kmHashGrid3Iterator* it) {
+    kmUint b = hash_cell(it->grid, it->cell[0], it->cell[1], it->cell[2]);
+    it->pos = it->grid->cell_start[b];
+    it->end = it->grid->cell_start[b + 1];
+}
+
+kmHashGrid3Iterator* kmHashGrid3IteratorBegin(kmHashGrid3Iterator* it, const kmHashGrid3* pGrid,
+                                              const kmVec3* centre, kmScalar radius) {
+    kmVec3 lo, hi;
+
+    it->grid = pGrid;
+    it->centre = *centre;
+    it->radius_sq = radius * radius;
+
+    kmVec3Fill(&lo, centre->x - radius, centre->y - radius, centre->z - radius);
+    kmVec3Fill(&hi, centre->x + radius, centre->y + radius, centre->z + radius);
+    kmHashGrid3CellOf(pGrid, &lo, &it->min[0], &it->min[1], &it->min[2]);
+    kmHashGrid3CellOf(pGrid, &hi, &it->max[0], &it->max[1], &it->max[2]);
+
+    it->cell[0] = it->min[0];
+    it->cell[1] = it->min[1];
+    it->cell[2] = it->min[2];
+    iterator_enter_cell(it);
+
+    return it;
+}
+
+kmBool kmHashGrid3IteratorNext(kmHashGrid3Iterator* it, kmUint* pIndex, kmScalar* pDistanceSq) {
+    const kmHashGrid3* pGrid = it->grid;
+
+    for(;;) {
+        while(it->pos < it->end) {
+            kmUint index = pGrid->indices[it->pos++];
+            const kmVec3* p = &pGrid->points[index];
+            kmScalar dx = p->x - it->centre.x;
+            kmScalar dy = p->y - it->centre.y;
+            kmScalar dz = p->z - it->centre.z;
+            kmScalar d2 = dx * dx + dy * dy + dz * dz;
+            kmInt x, y, z;
+
+            if(d2 > it->radius_sq) continue;
+
+            /*
+             * Two cells in range may share a bucket, only report the point
+             * from the cell it is really in.
+             */
+            kmHashGrid3CellOf(pGrid, p, &x, &y, &z);
+            if(x != it->cell[0] || y != it->cell[1] || z != it->cell[2]) continue;
+
+            *pIndex = index;
+            if(pDistanceSq) *pDistanceSq = d2;
+            return KM_TRUE;
+        }
+
+        if(++it->cell[0] > it->max[0]) {
+            it->cell[0] = it->min[0];
+            if(++it->cell[1] > it->max[1]) {
+                it->cell[1] = it->min[1];
+                if(++it->cell[2] > it->max[2]) {
+                    /* Stay exhausted if called again */
+                    it->cell[2] = it->max[2] + 1;
+                    it->cell[0] = it->max[0];
+                    it->cell[1] = it->max[1];
+                    it->pos = it->end = 0;
+                    return KM_FALSE;
+                }
+            }
+        }
+
+        iterator_enter_cell(it);
+    }
+}
+
+kmUint kmHashGrid3QueryRadius(const kmHashGrid3* pGrid, const kmVec3* centre, kmScalar radius,
+                              kmUint* pOut, kmUint max_out) {
+    kmHashGrid3Iterator it;
+    kmUint index, found = 0;
+
+    kmHashGrid3IteratorBegin(&it, pGrid, centre, radius);
+    while(kmHashGrid3IteratorNext(&it, &index, NULL)) {
+        if(found < max_out) pOut[found] = index;
+        ++found;
+    }
+
+    return found;
+}
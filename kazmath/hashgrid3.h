@@ -0,0 +1,132 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_HASHGRID3_H_INCLUDED
+#define KAZMATH_HASHGRID3_H_INCLUDED
+
+#include "vec3.h"
+#include "utility.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A spatial hash of points for fixed radius neighbour queries, e.g. SPH
+ * particles. Space is split into cubic cells which are hashed into
+ * table_size buckets. Building counting-sorts the point indices by bucket
+ * in O(n), so the grid is meant to be rebuilt every step rather than
+ * updated.
+ *
+ * The grid keeps a pointer to the points it was built from, they must stay
+ * alive (and unchanged) until the next build.
+ */
+typedef struct kmHashGrid3 {
+    kmScalar cell_size;
+    kmScalar inv_cell_size;
+
+    kmUint table_size;
+    kmUint* cell_start;         /** table_size + 1 offsets into indices, one range per bucket */
+    kmUint* indices;            /** Point indices grouped by bucket */
+    kmUint* point_bucket;       /** The bucket of each point */
+    kmUint capacity;
+
+    const kmVec3* points;
+    kmUint point_count;
+} kmHashGrid3;
+
+/**
+ * Initializes an empty grid. The cell size should be the query radius so
+ * that a query visits at most 27 cells. table_size is rounded up to a
+ * power of two, around the number of points is a good choice.
+ */
+kmHashGrid3* kmHashGrid3Initialize(kmHashGrid3* pGrid, kmScalar cell_size, kmUint table_size);
+void kmHashGrid3Free(kmHashGrid3* pGrid);
+
+/**
+ * Rebuilds the grid from count points.
+ */
+void kmHashGrid3Build(kmHashGrid3* pGrid, const kmVec3* points, kmUint count);
+
+/**
+ * As kmHashGrid3Build, but splits the hashing and scattering between
+ * thread_count threads. The result is identical to kmHashGrid3Build.
+ */
+void kmHashGrid3BuildParallel(kmHashGrid3* pGrid, const kmVec3* points, kmUint count, kmUint thread_count);
+
+/**
+ * Computes the integer coordinates of the cell containing point.
+ */
+void kmHashGrid3CellOf(const kmHashGrid3* pGrid, const kmVec3* point, kmInt* x, kmInt* y, kmInt* z);
+
+/**
+ * Returns the indices of the points in the bucket of cell (x, y, z) and
+ * stores how many there are in pCount. Other cells may hash to the same
+ * bucket, so callers should filter the points (e.g. by distance).
+ */
+const kmUint* kmHashGrid3Bucket(const kmHashGrid3* pGrid, kmInt x, kmInt y, kmInt z, kmUint* pCount);
+
+/*
+ * Streams the points within radius of centre without allocating:
+ *
+ *     kmHashGrid3Iterator it;
+ *     kmUint index;
+ *     kmScalar dist_sq;
+ *     kmHashGrid3IteratorBegin(&it, &grid, &p, h);
+ *     while(kmHashGrid3IteratorNext(&it, &index, &dist_sq)) { ... }
+ */
+typedef struct kmHashGrid3Iterator {
+    const kmHashGrid3* grid;
+    kmVec3 centre;
+    kmScalar radius_sq;
+    kmInt min[3];
+    kmInt max[3];
+    kmInt cell[3];
+    kmUint pos;
+    kmUint end;
+} kmHashGrid3Iterator;
+
+kmHashGrid3Iterator* kmHashGrid3IteratorBegin(kmHashGrid3Iterator* it, const kmHashGrid3* pGrid,
+                                              const kmVec3* centre, kmScalar radius);
+
+/**
+ * Moves to the next point within the radius, storing its index and squared
+ * distance (pDistanceSq may be NULL). Returns KM_FALSE when there are no
+ * more points.
+ */
+kmBool kmHashGrid3IteratorNext(kmHashGrid3Iterator* it, kmUint* pIndex, kmScalar* pDistanceSq);
+
+/**
+ * Writes the indices of up to max_out points within radius of centre to
+ * pOut and returns the total number of such points.
+ */
+kmUint kmHashGrid3QueryRadius(const kmHashGrid3* pGrid, const kmVec3* centre, kmScalar radius,
+                              kmUint* pOut, kmUint max_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
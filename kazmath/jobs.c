@@ -0,0 +1,133 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <pthread.h>
+
+#include "jobs.h"
+
+/* The pool never holds more than this many threads, extra jobs queue up */
+#define MAX_WORKERS 63
+
+/*
+ * Workers are started on first use and then kept, sleeping on work_ready
+ * between batches, so per frame callers don't pay for a thread create
+ * and join on every pass. One batch runs at a time; dispatch_lock is
+ * held by the thread that submitted it.
+ */
+static pthread_mutex_t dispatch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t state_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+
+static kmUint worker_count = 0;
+static char* batch_jobs = NULL;
+static size_t batch_job_size = 0;
+static kmUint batch_count = 0;
+static kmUint next_job = 0;
+static kmUint unfinished = 0;
+static void* (*batch_func)(void*) = NULL;
+
+/* Runs jobs from the current batch until none are left to claim, state_lock must be held */
+static void run_claimed_jobs(void) {
+    while(next_job < batch_count) {
+        void* job = batch_jobs + next_job++ * batch_job_size;
+        void* (*func)(void*) = batch_func;
+
+        pthread_mutex_unlock(&state_lock);
+        func(job);
+        pthread_mutex_lock(&state_lock);
+
+        if(--unfinished == 0) {
+            pthread_cond_signal(&work_done);
+        }
+    }
+}
+
+static void* worker_main(void* arg) {
+    (void) arg;
+
+    pthread_mutex_lock(&state_lock);
+    for(;;) {
+        while(next_job >= batch_count) {
+            pthread_cond_wait(&work_ready, &state_lock);
+        }
+        run_claimed_jobs();
+    }
+
+    return NULL;
+}
+
+static void grow_workers(kmUint wanted) {
+    pthread_attr_t attr;
+
+    if(wanted > MAX_WORKERS) wanted = MAX_WORKERS;
+    if(worker_count >= wanted) return;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    while(worker_count < wanted) {
+        pthread_t thread;
+
+        /* Whatever couldn't be started, the calling thread makes up for */
+        if(pthread_create(&thread, &attr, worker_main, NULL) != 0) break;
+        ++worker_count;
+    }
+    pthread_attr_destroy(&attr);
+}
+
+void km_run_jobs(void* jobs, size_t job_size, kmUint job_count, void* (*func)(void*)) {
+    kmUint t;
+
+    /*
+     * A single job, a job which submits jobs of its own, or another
+     * thread already using the pool: just run everything here.
+     */
+    if(job_count < 2 || pthread_mutex_trylock(&dispatch_lock) != 0) {
+        for(t = 0; t < job_count; ++t) func((char*) jobs + t * job_size);
+        return;
+    }
+
+    pthread_mutex_lock(&state_lock);
+    grow_workers(job_count - 1);
+
+    batch_jobs = (char*) jobs;
+    batch_job_size = job_size;
+    batch_func = func;
+    batch_count = job_count;
+    unfinished = job_count;
+    next_job = 0;
+    pthread_cond_broadcast(&work_ready);
+
+    /* The calling thread claims the first job, and helps until none are left */
+    run_claimed_jobs();
+    while(unfinished) {
+        pthread_cond_wait(&work_done, &state_lock);
+    }
+
+    batch_count = 0;
+    next_job = 0;
+    pthread_mutex_unlock(&state_lock);
+    pthread_mutex_unlock(&dispatch_lock);
+}
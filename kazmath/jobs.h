@@ -0,0 +1,49 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Private to the library, not installed. Runs the fork/join pattern the
+ * parallel builders and queries share.
+ */
+
+#ifndef KAZMATH_JOBS_H_INCLUDED
+#define KAZMATH_JOBS_H_INCLUDED
+
+#include <stddef.h>
+
+#include "utility.h"
+
+/**
+ * Calls func once for each of the job_count jobs, each job_size bytes
+ * apart in jobs, and returns when all of them have finished. The calling
+ * thread runs the first job and works alongside a pool of up to 63
+ * threads which are created on first use and then kept, so a batch
+ * costs a wake up rather than a thread create and join. If a pool thread
+ * can't be created, or the pool is busy with another thread's batch, the
+ * calling thread runs the jobs itself.
+ */
+void km_run_jobs(void* jobs, size_t job_size, kmUint job_count, void* (*func)(void*));
+
+#endif /* KAZMATH_JOBS_H_INCLUDED */
@@ -36,6 +36,19 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "plane.h"
 #include "aabb2.h"
 #include "aabb3.h"
+#include "sphere.h"
+#include "obb3.h"
+#include "octree3.h"
+#include "quadtree2.h"
+#include "grid2.h"
+#include "hashgrid3.h"
+#include "bvh3.h"
+#include "kdtree3.h"
+#include "gjk3.h"
+#include "occlusion.h"
+#include "cluster.h"
+#include "cascade.h"
+#include "profile.h"
 #include "ray2.h"
 #include "ray3.h"
 
@@ -0,0 +1,440 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "kdtree3.h"
+#include "jobs.h"
+
+#define STACK_SIZE 128
+
+typedef struct km_kdtree3_job {
+    kmKDTree3* tree;
+    const kmKDTree3* const_tree;
+    const kmVec3* source;
+
+    /* Build: the subtree ranges, as [lo, hi) pairs */
+    const kmUint* ranges;
+    kmUint range_begin;
+    kmUint range_end;
+
+    /* Queries */
+    const kmVec3* queries;
+    kmUint begin;
+    kmUint end;
+    kmUint k;
+    kmScalar radius;
+    kmUint* out;
+    kmScalar* distances;
+    kmUint* offsets;
+    kmUint max_out;
+} km_kdtree3_job;
+
+static kmScalar coord(const kmVec3* p, unsigned char axis) {
+    return axis == 0 ? p->x : (axis == 1 ? p->y : p->z);
+}
+
+kmKDTree3* kmKDTree3Initialize(kmKDTree3* pTree) {
+    memset(pTree, 0, sizeof(kmKDTree3));
+    return pTree;
+}
+
+void kmKDTree3Free(kmKDTree3* pTree) {
+    free(pTree->points);
+    free(pTree->indices);
+    free(pTree->axes);
+    memset(pTree, 0, sizeof(kmKDTree3));
+}
+
+static unsigned char widest_axis(const kmVec3* source, const kmUint* indices, kmUint lo, kmUint hi) {
+    kmVec3 min, max;
+    kmUint i;
+
+    min = max = source[indices[lo]];
+    for(i = lo + 1; i < hi; ++i) {
+        const kmVec3* p = &source[indices[i]];
+        if(p->x < min.x) min.x = p->x;
+        if(p->y < min.y) min.y = p->y;
+        if(p->z < min.z) min.z = p->z;
+        if(p->x > max.x) max.x = p->x;
+        if(p->y > max.y) max.y = p->y;
+        if(p->z > max.z) max.z = p->z;
+    }
+
+    max.x -= min.x;
+    max.y -= min.y;
+    max.z -= min.z;
+
+    if(max.x >= max.y && max.x >= max.z) return 0;
+    return max.y >= max.z ? 1 : 2;
+}
+
+/* Quickselect, leaves the median of [lo, hi) along axis at its centre */
+static void select_median(const kmVec3* source, kmUint* indices, kmUint lo, kmUint hi, unsigned char axis) {
+    kmUint mid = lo + (hi - lo) / 2;
+    kmUint left = lo, right = hi - 1;
+
+    while(right > left) {
+        kmScalar pivot = coord(&source[indices[left + (right - left) / 2]], axis);
+        kmUint i = left, j = right, tmp;
+
+        while(i <= j) {
+            while(coord(&source[indices[i]], axis) < pivot) ++i;
+            while(coord(&source[indices[j]], axis) > pivot) --j;
+            if(i <= j) {
+                tmp = indices[i];
+                indices[i] = indices[j];
+                indices[j] = tmp;
+                ++i;
+                if(j == 0) break;
+                --j;
+            }
+        }
+
+        if(mid <= j) right = j;
+        else if(mid >= i) left = i;
+        else break;
+    }
+}
+
+/* Splits one node, returns KM_FALSE for an empty range */
+static kmBool split_node(kmKDTree3* pTree, const kmVec3* source, kmUint lo, kmUint hi) {
+    unsigned char axis;
+
+    if(lo >= hi) return KM_FALSE;
+
+    axis = widest_axis(source, pTree->indices, lo, hi);
+    select_median(source, pTree->indices, lo, hi, axis);
+    pTree->axes[lo + (hi - lo) / 2] = axis;
+
+    return KM_TRUE;
+}
+
+static void build_subtree(kmKDTree3* pTree, const kmVec3* source, kmUint lo, kmUint hi) {
+    while(split_node(pTree, source, lo, hi)) {
+        kmUint mid = lo + (hi - lo) / 2;
+        build_subtree(pTree, source, lo, mid);
+        lo = mid + 1;
+    }
+}
+
+static void* build_job(void* arg) {
+    km_kdtree3_job* job = (km_kdtree3_job*) arg;
+    kmUint r, i;
+
+    for(r = job->range_begin; r < job->range_end; ++r) {
+        kmUint lo = job->ranges[r * 2], hi = job->ranges[r * 2 + 1];
+
+        build_subtree(job->tree, job->source, lo, hi);
+        for(i = lo; i < hi; ++i) {
+            job->tree->points[i] = job->source[job->tree->indices[i]];
+        }
+    }
+
+    return NULL;
+}
+
+void kmKDTree3Build(kmKDTree3* pTree, const kmVec3* points, kmUint count, kmUint thread_count) {
+    km_kdtree3_job jobs[64];
+    kmUint* ranges;
+    kmUint range_count = 1, i, t, chunk;
+
+    if(count > pTree->capacity) {
+        pTree->capacity = count;
+        pTree->points = (kmVec3*) realloc(pTree->points, sizeof(kmVec3) * count);
+        pTree->indices = (kmUint*) realloc(pTree->indices, sizeof(kmUint) * count);
+        pTree->axes = (unsigned char*) realloc(pTree->axes, count);
+    }
+
+    pTree->count = count;
+    if(!count) return;
+
+    for(i = 0; i < count; ++i) {
+        pTree->indices[i] = i;
+    }
+
+    if(thread_count < 1) thread_count = 1;
+    if(thread_count > 64) thread_count = 64;
+
+    /*
+     * Split the top levels here until there are a few subtrees per thread,
+     * the median nodes above them are already in their final place.
+     */
+    ranges = (kmUint*) malloc(sizeof(kmUint) * thread_count * 16);
+    ranges[0] = 0;
+    ranges[1] = count;
+
+    while(thread_count > 1 && range_count < thread_count * 4 && count / range_count > 1024) {
+        /* Back to front so each range is read before its slot is reused */
+        for(i = range_count; i > 0; --i) {
+            kmUint lo = ranges[(i - 1) * 2], hi = ranges[(i - 1) * 2 + 1];
+            kmUint mid = lo + (hi - lo) / 2;
+
+            split_node(pTree, points, lo, hi);
+            pTree->points[mid] = points[pTree->indices[mid]];
+
+            ranges[(i - 1) * 4] = lo;
+            ranges[(i - 1) * 4 + 1] = mid;
+            ranges[(i - 1) * 4 + 2] = mid + 1;
+            ranges[(i - 1) * 4 + 3] = hi;
+        }
+
+        range_count *= 2;
+    }
+
+    if(thread_count > range_count) thread_count = range_count;
+    chunk = (range_count + thread_count - 1) / thread_count;
+
+    for(t = 0; t < thread_count; ++t) {
+        jobs[t].tree = pTree;
+        jobs[t].source = points;
+        jobs[t].ranges = ranges;
+        jobs[t].range_begin = t * chunk < range_count ? t * chunk : range_count;
+        jobs[t].range_end = (t + 1) * chunk < range_count ? (t + 1) * chunk : range_count;
+    }
+
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, build_job);
+
+    free(ranges);
+}
+
+static kmScalar distance_sq(const kmVec3* a, const kmVec3* b) {
+    kmScalar x = a->x - b->x, y = a->y - b->y, z = a->z - b->z;
+    return x * x + y * y + z * z;
+}
+
+static kmUint nearest(const kmKDTree3* pTree, const kmVec3* point, kmUint k, kmUint* pOut, kmScalar* best) {
+    kmUint lo_stack[STACK_SIZE], hi_stack[STACK_SIZE];
+    kmScalar plane_stack[STACK_SIZE];
+    kmUint top = 0, found = 0;
+
+    if(!k || !pTree->count) return 0;
+
+    lo_stack[top] = 0;
+    hi_stack[top] = pTree->count;
+    plane_stack[top++] = 0;
+
+    while(top) {
+        kmUint lo, hi, mid, i;
+        unsigned char axis;
+        kmScalar d, diff;
+
+        --top;
+        if(found == k && plane_stack[top] > best[k - 1]) continue;
+
+        lo = lo_stack[top];
+        hi = hi_stack[top];
+        mid = lo + (hi - lo) / 2;
+
+        d = distance_sq(&pTree->points[mid], point);
+        if(found < k || d < best[k - 1]) {
+            /* Insertion into the sorted list of the best k so far */
+            i = found < k ? found++ : k - 1;
+            while(i > 0 && best[i - 1] > d) {
+                best[i] = best[i - 1];
+                pOut[i] = pOut[i - 1];
+                --i;
+            }
+            best[i] = d;
+            pOut[i] = pTree->indices[mid];
+        }
+
+        axis = pTree->axes[mid];
+        diff = coord(point, axis) - coord(&pTree->points[mid], axis);
+
+        /* Push the far side first so the near side is visited next */
+        if(diff < 0) {
+            if(mid + 1 < hi) { lo_stack[top] = mid + 1; hi_stack[top] = hi; plane_stack[top++] = diff * diff; }
+            if(lo < mid) { lo_stack[top] = lo; hi_stack[top] = mid; plane_stack[top++] = 0; }
+        } else {
+            if(lo < mid) { lo_stack[top] = lo; hi_stack[top] = mid; plane_stack[top++] = diff * diff; }
+            if(mid + 1 < hi) { lo_stack[top] = mid + 1; hi_stack[top] = hi; plane_stack[top++] = 0; }
+        }
+    }
+
+    return found;
+}
+
+kmUint kmKDTree3QueryNearest(const kmKDTree3* pTree, const kmVec3* point, kmUint k, kmUint* pOut, kmScalar* pDistancesSq) {
+    kmScalar* best;
+    kmUint found;
+
+    if(!k) return 0;
+
+    best = pDistancesSq ? pDistancesSq : (kmScalar*) malloc(sizeof(kmScalar) * k);
+    found = nearest(pTree, point, k, pOut, best);
+    if(best != pDistancesSq) free(best);
+
+    return found;
+}
+
+kmUint kmKDTree3QueryRadius(const kmKDTree3* pTree, const kmVec3* centre, kmScalar radius, kmUint* pOut, kmUint max_out) {
+    kmUint lo_stack[STACK_SIZE], hi_stack[STACK_SIZE];
+    kmScalar radius_sq = radius * radius;
+    kmUint top = 0, found = 0;
+
+    if(!pTree->count) return 0;
+
+    lo_stack[top] = 0;
+    hi_stack[top++] = pTree->count;
+
+    while(top) {
+        kmUint lo, hi, mid;
+        unsigned char axis;
+        kmScalar diff;
+
+        --top;
+        lo = lo_stack[top];
+        hi = hi_stack[top];
+        mid = lo + (hi - lo) / 2;
+
+        if(distance_sq(&pTree->points[mid], centre) <= radius_sq) {
+            if(found < max_out) pOut[found] = pTree->indices[mid];
+            ++found;
+        }
+
+        axis = pTree->axes[mid];
+        diff = coord(centre, axis) - coord(&pTree->points[mid], axis);
+
+        if(lo < mid && diff <= radius) {
+            lo_stack[top] = lo;
+            hi_stack[top++] = mid;
+        }
+        if(mid + 1 < hi && diff >= -radius) {
+            lo_stack[top] = mid + 1;
+            hi_stack[top++] = hi;
+        }
+    }
+
+    return found;
+}
+
+static void split_queries(km_kdtree3_job* jobs, const kmKDTree3* pTree, const kmVec3* queries,
+                          kmUint count, kmUint thread_count) {
+    kmUint t, chunk = (count + thread_count - 1) / thread_count;
+
+    for(t = 0; t < thread_count; ++t) {
+        memset(&jobs[t], 0, sizeof(km_kdtree3_job));
+        jobs[t].const_tree = pTree;
+        jobs[t].queries = queries;
+        jobs[t].begin = t * chunk < count ? t * chunk : count;
+        jobs[t].end = (t + 1) * chunk < count ? (t + 1) * chunk : count;
+    }
+}
+
+static kmUint clamp_threads(kmUint thread_count, kmUint count) {
+    if(thread_count > 64) thread_count = 64;
+    if(thread_count > count) thread_count = count;
+    return thread_count ? thread_count : 1;
+}
+
+static void* nearest_job(void* arg) {
+    km_kdtree3_job* job = (km_kdtree3_job*) arg;
+    kmScalar* best = job->distances ? NULL : (kmScalar*) malloc(sizeof(kmScalar) * job->k);
+    kmUint i;
+
+    for(i = job->begin; i < job->end; ++i) {
+        nearest(job->const_tree, &job->queries[i], job->k, job->out + (size_t) i * job->k,
+                best ? best : job->distances + (size_t) i * job->k);
+    }
+
+    free(best);
+    return NULL;
+}
+
+kmUint kmKDTree3QueryNearestArray(const kmKDTree3* pTree, const kmVec3* points, kmUint count, kmUint k,
+                                  kmUint* pOut, kmScalar* pDistancesSq, kmUint thread_count) {
+    km_kdtree3_job jobs[64];
+    kmUint t;
+
+    if(!k || !count) return 0;
+
+    thread_count = clamp_threads(thread_count, count);
+    split_queries(jobs, pTree, points, count, thread_count);
+    for(t = 0; t < thread_count; ++t) {
+        jobs[t].k = k;
+        jobs[t].out = pOut;
+        jobs[t].distances = pDistancesSq;
+    }
+
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, nearest_job);
+
+    return k < pTree->count ? k : pTree->count;
+}
+
+static void* count_radius_job(void* arg) {
+    km_kdtree3_job* job = (km_kdtree3_job*) arg;
+    kmUint i;
+
+    for(i = job->begin; i < job->end; ++i) {
+        job->offsets[i + 1] = kmKDTree3QueryRadius(job->const_tree, &job->queries[i], job->radius, NULL, 0);
+    }
+
+    return NULL;
+}
+
+static void* radius_job(void* arg) {
+    km_kdtree3_job* job = (km_kdtree3_job*) arg;
+    kmUint i;
+
+    for(i = job->begin; i < job->end; ++i) {
+        kmUint start = job->offsets[i];
+        if(start >= job->max_out) break;
+        kmKDTree3QueryRadius(job->const_tree, &job->queries[i], job->radius, job->out + start, job->max_out - start);
+    }
+
+    return NULL;
+}
+
+kmUint kmKDTree3QueryRadiusArray(const kmKDTree3* pTree, const kmVec3* centres, kmUint count, kmScalar radius,
+                                 kmUint* pOffsets, kmUint* pOut, kmUint max_out, kmUint thread_count) {
+    km_kdtree3_job jobs[64];
+    kmUint t, i;
+
+    pOffsets[0] = 0;
+    if(!count) return 0;
+
+    thread_count = clamp_threads(thread_count, count);
+    split_queries(jobs, pTree, centres, count, thread_count);
+    for(t = 0; t < thread_count; ++t) {
+        jobs[t].radius = radius;
+        jobs[t].offsets = pOffsets;
+        jobs[t].out = pOut;
+        jobs[t].max_out = max_out;
+    }
+
+    /*
+     * Each query's matches go at a fixed offset, so count them all first
+     * and then run the queries again to write them out.
+     */
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, count_radius_job);
+    for(i = 0; i < count; ++i) {
+        pOffsets[i + 1] += pOffsets[i];
+    }
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, radius_job);
+
+    return pOffsets[count];
+}
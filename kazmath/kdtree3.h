@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_KDTREE3_H_INCLUDED
+#define KAZMATH_KDTREE3_H_INCLUDED
+
+#include "vec3.h"
+#include "utility.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A static KD-tree over a point cloud for nearest neighbour and radius
+ * queries. The tree is implicit: the points are reordered so that the node
+ * covering positions [lo, hi) is the median at lo + (hi - lo) / 2 with its
+ * children covering the two halves either side, so no child pointers are
+ * stored. Each node splits along the widest axis of its points.
+ *
+ * The tree copies the points, rebuild it when they change.
+ */
+typedef struct kmKDTree3 {
+    kmVec3* points;             /** The points in tree order */
+    kmUint* indices;            /** The caller's index of each point in tree order */
+    unsigned char* axes;        /** The split axis of the node at each position */
+    kmUint count;
+    kmUint capacity;
+} kmKDTree3;
+
+kmKDTree3* kmKDTree3Initialize(kmKDTree3* pTree);
+void kmKDTree3Free(kmKDTree3* pTree);
+
+/**
+ * Builds the tree from count points. Once the top levels have been split
+ * the remaining subtrees are built by thread_count threads.
+ */
+void kmKDTree3Build(kmKDTree3* pTree, const kmVec3* points, kmUint count, kmUint thread_count);
+
+/**
+ * The indices of the k points closest to point, nearest first. Their
+ * squared distances are written to pDistancesSq if it is not NULL. Returns
+ * the number found, which is less than k only if the tree holds fewer
+ * points.
+ */
+kmUint kmKDTree3QueryNearest(const kmKDTree3* pTree, const kmVec3* point, kmUint k, kmUint* pOut, kmScalar* pDistancesSq);
+
+/**
+ * Writes the indices of up to max_out points within radius of centre to
+ * pOut and returns the total number of such points.
+ */
+kmUint kmKDTree3QueryRadius(const kmKDTree3* pTree, const kmVec3* centre, kmScalar radius, kmUint* pOut, kmUint max_out);
+
+/**
+ * Runs kmKDTree3QueryNearest for count points split between thread_count
+ * threads. The neighbours of points[i] are written to pOut[i * k] onwards
+ * (and their squared distances to pDistancesSq[i * k], which may be NULL).
+ * Returns the number found per query.
+ */
+kmUint kmKDTree3QueryNearestArray(const kmKDTree3* pTree, const kmVec3* points, kmUint count, kmUint k,
+                                  kmUint* pOut, kmScalar* pDistancesSq, kmUint thread_count);
+
+/**
+ * Runs count radius queries split between thread_count threads. The
+ * matches for centres[i] are written to pOut[pOffsets[i]] ..
+ * pOut[pOffsets[i + 1] - 1], so pOffsets must hold count + 1 entries.
+ * Returns the total number of matches; if that is more than max_out the
+ * offsets are still correct but pOut is truncated.
+ */
+kmUint kmKDTree3QueryRadiusArray(const kmKDTree3* pTree, const kmVec3* centres, kmUint count, kmScalar radius,
+                                 kmUint* pOffsets, kmUint* pOut, kmUint max_out, kmUint thread_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -243,8 +243,8 @@ kmMat3* kmMat3FromRotationQuaternion(kmMat3* pOut, const kmQuaternion* pIn)
 kmMat3* kmMat3FromRotationAxisAngle(kmMat3* pOut, const struct kmVec3* axis,
                                     kmScalar radians)
 {
-    kmScalar rcos = cosf(radians);
-    kmScalar rsin = sinf(radians);
+    kmScalar rcos, rsin;
+    kmSinCos(radians, &rsin, &rcos);
 
     pOut->mat[0] = rcos + axis->x * axis->x * (1 - rcos);
     pOut->mat[1] = axis->z * rsin + axis->y * axis->x * (1 - rcos);
@@ -282,17 +282,20 @@ kmMat3* kmMat3FromRotationX(kmMat3* pOut, const kmScalar radians)
 
 	*/
 
+	kmScalar s, c;
+	kmSinCos(radians, &s, &c);
+
 	pOut->mat[0] = 1.0f;
 	pOut->mat[1] = 0.0f;
 	pOut->mat[2] = 0.0f;
 
 	pOut->mat[3] = 0.0f;
-	pOut->mat[4] = cosf(radians);
-	pOut->mat[5] = sinf(radians);
+	pOut->mat[4] = c;
+	pOut->mat[5] = s;
 
 	pOut->mat[6] = 0.0f;
-	pOut->mat[7] = -sinf(radians);
-	pOut->mat[8] = cosf(radians);
+	pOut->mat[7] = -s;
+	pOut->mat[8] = c;
 
 	return pOut;
 }
@@ -305,17 +308,20 @@ kmMat3* kmMat3FromRotationY(kmMat3* pOut, const kmScalar radians)
 	     | -sin(A)  0   cos(A) |
 	*/
 
-	pOut->mat[0] = cosf(radians);
+	kmScalar s, c;
+	kmSinCos(radians, &s, &c);
+
+	pOut->mat[0] = c;
 	pOut->mat[1] = 0.0f;
-	pOut->mat[2] = -sinf(radians);
+	pOut->mat[2] = -s;
 
 	pOut->mat[3] = 0.0f;
 	pOut->mat[4] = 1.0f;
 	pOut->mat[5] = 0.0f;
 
-	pOut->mat[6] = sinf(radians);
+	pOut->mat[6] = s;
 	pOut->mat[7] = 0.0f;
-	pOut->mat[8] = cosf(radians);
+	pOut->mat[8] = c;
 
 	return pOut;
 }
@@ -328,12 +334,15 @@ kmMat3* kmMat3FromRotationZ(kmMat3* pOut, const kmScalar radians)
 	     |  0        0        1  |
 	*/
 
-	pOut->mat[0] = cosf(radians);
-	pOut->mat[1] =-sinf(radians);
+	kmScalar s, c;
+	kmSinCos(radians, &s, &c);
+
+	pOut->mat[0] = c;
+	pOut->mat[1] =-s;
 	pOut->mat[2] = 0.0f;
 
-	pOut->mat[3] = sinf(radians);
-	pOut->mat[4] = cosf(radians);
+	pOut->mat[3] = s;
+	pOut->mat[4] = c;
 	pOut->mat[5] = 0.0f;
 
 	pOut->mat[6] = 0.0f;
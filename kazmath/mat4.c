@@ -36,6 +36,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mat3.h"
 #include "quaternion.h"
 #include "plane.h"
+#include "profile.h"
 
 kmMat4* kmMat4Fill(kmMat4* pOut, const kmScalar* pMat)
 {
@@ -55,6 +56,8 @@ kmMat4* kmMat4Inverse(kmMat4* pOut, const kmMat4* pM) {
     kmScalar det;
     int i;
 
+    KM_PROFILE_BEGIN(KM_PROFILE_MAT4_INVERSE);
+
     tmp.mat[0] = pM->mat[5]  * pM->mat[10] * pM->mat[15] -
              pM->mat[5]  * pM->mat[11] * pM->mat[14] -
              pM->mat[9]  * pM->mat[6]  * pM->mat[15] +
@@ -170,6 +173,7 @@ kmMat4* kmMat4Inverse(kmMat4* pOut, const kmMat4* pM) {
     det = pM->mat[0] * tmp.mat[0] + pM->mat[1] * tmp.mat[4] + pM->mat[2] * tmp.mat[8] + pM->mat[3] * tmp.mat[12];
 
     if (det == 0) {
+        KM_PROFILE_END(KM_PROFILE_MAT4_INVERSE);
         return NULL;
     }
 
@@ -179,6 +183,7 @@ kmMat4* kmMat4Inverse(kmMat4* pOut, const kmMat4* pM) {
         pOut->mat[i] = tmp.mat[i] * det;
     }
 
+    KM_PROFILE_END(KM_PROFILE_MAT4_INVERSE);
     return pOut;
 }
 
@@ -212,6 +217,8 @@ kmMat4* kmMat4Multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2)
 
 	const kmScalar *m1 = pM1->mat, *m2 = pM2->mat;
 
+	KM_PROFILE_BEGIN(KM_PROFILE_MAT4_MULTIPLY);
+
 	mat[0] = m1[0] * m2[0] + m1[4] * m2[1] + m1[8] * m2[2] + m1[12] * m2[3];
 	mat[1] = m1[1] * m2[0] + m1[5] * m2[1] + m1[9] * m2[2] + m1[13] * m2[3];
 	mat[2] = m1[2] * m2[0] + m1[6] * m2[1] + m1[10] * m2[2] + m1[14] * m2[3];
@@ -235,6 +242,7 @@ kmMat4* kmMat4Multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2)
 
 	memcpy(pOut->mat, mat, sizeof(kmScalar)*16);
 
+	KM_PROFILE_END(KM_PROFILE_MAT4_MULTIPLY);
 	return pOut;
 }
 
@@ -303,19 +311,22 @@ kmMat4* kmMat4RotationX(kmMat4* pOut, const kmScalar radians)
 
 	*/
 
+	kmScalar s, c;
+	kmSinCos(radians, &s, &c);
+
 	pOut->mat[0] = 1.0f;
 	pOut->mat[1] = 0.0f;
 	pOut->mat[2] = 0.0f;
 	pOut->mat[3] = 0.0f;
 
 	pOut->mat[4] = 0.0f;
-	pOut->mat[5] = cosf(radians);
-	pOut->mat[6] = sinf(radians);
+	pOut->mat[5] = c;
+	pOut->mat[6] = s;
 	pOut->mat[7] = 0.0f;
 
 	pOut->mat[8] = 0.0f;
-	pOut->mat[9] = -sinf(radians);
-	pOut->mat[10] = cosf(radians);
+	pOut->mat[9] = -s;
+	pOut->mat[10] = c;
 	pOut->mat[11] = 0.0f;
 
 	pOut->mat[12] = 0.0f;
@@ -335,9 +346,12 @@ kmMat4* kmMat4RotationY(kmMat4* pOut, const kmScalar radians)
 	     |  0       0   0       1 |
 	*/
 
-	pOut->mat[0] = cosf(radians);
+	kmScalar s, c;
+	kmSinCos(radians, &s, &c);
+
+	pOut->mat[0] = c;
 	pOut->mat[1] = 0.0f;
-	pOut->mat[2] = -sinf(radians);
+	pOut->mat[2] = -s;
 	pOut->mat[3] = 0.0f;
 
 	pOut->mat[4] = 0.0f;
@@ -345,9 +359,9 @@ kmMat4* kmMat4RotationY(kmMat4* pOut, const kmScalar radians)
 	pOut->mat[6] = 0.0f;
 	pOut->mat[7] = 0.0f;
 
-	pOut->mat[8] = sinf(radians);
+	pOut->mat[8] = s;
 	pOut->mat[9] = 0.0f;
-	pOut->mat[10] = cosf(radians);
+	pOut->mat[10] = c;
 	pOut->mat[11] = 0.0f;
 
 	pOut->mat[12] = 0.0f;
@@ -367,13 +381,16 @@ kmMat4* kmMat4RotationZ(kmMat4* pOut, const kmScalar radians)
 	     |  0        0        0   1 |
 	*/
 
-	pOut->mat[0] = cosf(radians);
-	pOut->mat[1] = sinf(radians);
+	kmScalar s, c;
+	kmSinCos(radians, &s, &c);
+
+	pOut->mat[0] = c;
+	pOut->mat[1] = s;
 	pOut->mat[2] = 0.0f;
 	pOut->mat[3] = 0.0f;
 
-	pOut->mat[4] = -sinf(radians);
-	pOut->mat[5] = cosf(radians);
+	pOut->mat[4] = -s;
+	pOut->mat[5] = c;
 	pOut->mat[6] = 0.0f;
 	pOut->mat[7] = 0.0f;
 
@@ -392,19 +409,35 @@ kmMat4* kmMat4RotationZ(kmMat4* pOut, const kmScalar radians)
 
 kmMat4* kmMat4RotationYawPitchRoll(kmMat4* pOut, const kmScalar pitch, const kmScalar yaw, const kmScalar roll)
 {
+    /*
+     * Expanded form of RotationY(yaw) * RotationX(pitch) * RotationZ(roll)
+     * so that we only need one sincos per angle and no matrix multiplies
+     */
+    kmScalar sp, cp, sy, cy, sr, cr;
+
+    kmSinCos(pitch, &sp, &cp);
+    kmSinCos(yaw, &sy, &cy);
+    kmSinCos(roll, &sr, &cr);
+
+    pOut->mat[0] = cy * cr + sy * sp * sr;
+    pOut->mat[1] = cp * sr;
+    pOut->mat[2] = -sy * cr + cy * sp * sr;
+    pOut->mat[3] = 0.0f;
 
-    kmMat4 yaw_matrix;
-    kmMat4 roll_matrix;
-    kmMat4 pitch_matrix;
-
-    kmMat4RotationY(&yaw_matrix, yaw);
-
-    kmMat4RotationX(&pitch_matrix, pitch);
+    pOut->mat[4] = -cy * sr + sy * sp * cr;
+    pOut->mat[5] = cp * cr;
+    pOut->mat[6] = sy * sr + cy * sp * cr;
+    pOut->mat[7] = 0.0f;
 
-    kmMat4RotationZ(&roll_matrix, roll);
+    pOut->mat[8] = sy * cp;
+    pOut->mat[9] = -sp;
+    pOut->mat[10] = cy * cp;
+    pOut->mat[11] = 0.0f;
 
-    kmMat4Multiply(pOut, &pitch_matrix, &roll_matrix);
-    kmMat4Multiply(pOut, &yaw_matrix, pOut);
+    pOut->mat[12] = 0.0f;
+    pOut->mat[13] = 0.0f;
+    pOut->mat[14] = 0.0f;
+    pOut->mat[15] = 1.0f;
 
     return pOut;
 }
@@ -558,6 +591,8 @@ kmMat4* kmMat4LookAt(kmMat4* pOut, const kmVec3* pEye,
     kmVec3 s;
     kmVec3 u;
 
+    KM_PROFILE_BEGIN(KM_PROFILE_MAT4_LOOK_AT);
+
     kmVec3Subtract(&f, pCenter, pEye);
     kmVec3Normalize(&f, &f);
 
@@ -586,6 +621,7 @@ kmMat4* kmMat4LookAt(kmMat4* pOut, const kmVec3* pEye,
     pOut->mat[14] = kmVec3Dot(&f, pEye);
     pOut->mat[15] = 1.0;
 
+    KM_PROFILE_END(KM_PROFILE_MAT4_LOOK_AT);
     return pOut;
 }
 
@@ -687,7 +723,7 @@ kmPlane* kmMat4ExtractPlane(kmPlane* pOut, const kmMat4* pIn, const kmEnum plane
             assert(0 && "Invalid plane index");
     }
 
-    t = sqrtf(pOut->a * pOut->a +
+    t = kmSqrt(pOut->a * pOut->a +
                     pOut->b * pOut->b +
                     pOut->c * pOut->c);
     pOut->a /= t;
@@ -0,0 +1,396 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "obb3.h"
+#include "mat4.h"
+#include "plane.h"
+#include "aabb3.h"
+
+/* Column c, row r of a kmMat3 */
+#define AXIS(m, c, r) ((m)->mat[(c) * 3 + (r)])
+
+kmOBB3* kmOBB3Fill(kmOBB3* pOut, const kmVec3* centre, const kmMat3* axes, const kmVec3* extents) {
+    kmVec3Assign(&pOut->centre, centre);
+    kmMat3AssignMat3(&pOut->axes, axes);
+    kmVec3Assign(&pOut->extents, extents);
+    return pOut;
+}
+
+kmOBB3* kmOBB3Assign(kmOBB3* pOut, const kmOBB3* pIn) {
+    if(pOut == pIn) {
+        return pOut;
+    }
+
+    return kmOBB3Fill(pOut, &pIn->centre, &pIn->axes, &pIn->extents);
+}
+
+kmBool kmOBB3ContainsPoint(const kmOBB3* pBox, const kmVec3* pPoint) {
+    kmVec3 d;
+    const kmScalar* e = &pBox->extents.x;
+    int i;
+
+    kmVec3Subtract(&d, pPoint, &pBox->centre);
+
+    for(i = 0; i < 3; ++i) {
+        kmScalar dist = d.x * AXIS(&pBox->axes, i, 0) +
+                        d.y * AXIS(&pBox->axes, i, 1) +
+                        d.z * AXIS(&pBox->axes, i, 2);
+        if(fabs(dist) > e[i]) {
+            return KM_FALSE;
+        }
+    }
+
+    return KM_TRUE;
+}
+
+kmBool kmOBB3IntersectsOBB3(const kmOBB3* a, const kmOBB3* b) {
+    /* Gottschalk's SAT, as laid out in Ericson's Real-Time Collision Detection */
+    const kmScalar* ae = &a->extents.x;
+    const kmScalar* be = &b->extents.x;
+    kmScalar R[3][3], AbsR[3][3], t[3];
+    kmScalar ra, rb;
+    kmVec3 d;
+    int i, j;
+
+    for(i = 0; i < 3; ++i) {
+        for(j = 0; j < 3; ++j) {
+            R[i][j] = AXIS(&a->axes, i, 0) * AXIS(&b->axes, j, 0) +
+                      AXIS(&a->axes, i, 1) * AXIS(&b->axes, j, 1) +
+                      AXIS(&a->axes, i, 2) * AXIS(&b->axes, j, 2);
+
+            /* The epsilon stops parallel edges producing a null cross product axis */
+            AbsR[i][j] = fabs(R[i][j]) + kmEpsilon;
+        }
+    }
+
+    kmVec3Subtract(&d, &b->centre, &a->centre);
+    for(i = 0; i < 3; ++i) {
+        t[i] = d.x * AXIS(&a->axes, i, 0) + d.y * AXIS(&a->axes, i, 1) + d.z * AXIS(&a->axes, i, 2);
+    }
+
+    /* Face axes of a */
+    for(i = 0; i < 3; ++i) {
+        ra = ae[i];
+        rb = be[0] * AbsR[i][0] + be[1] * AbsR[i][1] + be[2] * AbsR[i][2];
+        if(fabs(t[i]) > ra + rb) return KM_FALSE;
+    }
+
+    /* Face axes of b */
+    for(j = 0; j < 3; ++j) {
+        ra = ae[0] * AbsR[0][j] + ae[1] * AbsR[1][j] + ae[2] * AbsR[2][j];
+        rb = be[j];
+        if(fabs(t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j]) > ra + rb) return KM_FALSE;
+    }
+
+    /* A0 x B0, B1, B2 */
+    ra = ae[1] * AbsR[2][0] + ae[2] * AbsR[1][0];
+    rb = be[1] * AbsR[0][2] + be[2] * AbsR[0][1];
+    if(fabs(t[2] * R[1][0] - t[1] * R[2][0]) > ra + rb) return KM_FALSE;
+
+    ra = ae[1] * AbsR[2][1] + ae[2] * AbsR[1][1];
+    rb = be[0] * AbsR[0][2] + be[2] * AbsR[0][0];
+    if(fabs(t[2] * R[1][1] - t[1] * R[2][1]) > ra + rb) return KM_FALSE;
+
+    ra = ae[1] * AbsR[2][2] + ae[2] * AbsR[1][2];
+    rb = be[0] * AbsR[0][1] + be[1] * AbsR[0][0];
+    if(fabs(t[2] * R[1][2] - t[1] * R[2][2]) > ra + rb) return KM_FALSE;
+
+    /* A1 x B0, B1, B2 */
+    ra = ae[0] * AbsR[2][0] + ae[2] * AbsR[0][0];
+    rb = be[1] * AbsR[1][2] + be[2] * AbsR[1][1];
+    if(fabs(t[0] * R[2][0] - t[2] * R[0][0]) > ra + rb) return KM_FALSE;
+
+    ra = ae[0] * AbsR[2][1] + ae[2] * AbsR[0][1];
+    rb = be[0] * AbsR[1][2] + be[2] * AbsR[1][0];
+    if(fabs(t[0] * R[2][1] - t[2] * R[0][1]) > ra + rb) return KM_FALSE;
+
+    ra = ae[0] * AbsR[2][2] + ae[2] * AbsR[0][2];
+    rb = be[0] * AbsR[1][1] + be[1] * AbsR[1][0];
+    if(fabs(t[0] * R[2][2] - t[2] * R[0][2]) > ra + rb) return KM_FALSE;
+
+    /* A2 x B0, B1, B2 */
+    ra = ae[0] * AbsR[1][0] + ae[1] * AbsR[0][0];
+    rb = be[1] * AbsR[2][2] + be[2] * AbsR[2][1];
+    if(fabs(t[1] * R[0][0] - t[0] * R[1][0]) > ra + rb) return KM_FALSE;
+
+    ra = ae[0] * AbsR[1][1] + ae[1] * AbsR[0][1];
+    rb = be[0] * AbsR[2][2] + be[2] * AbsR[2][0];
+    if(fabs(t[1] * R[0][1] - t[0] * R[1][1]) > ra + rb) return KM_FALSE;
+
+    ra = ae[0] * AbsR[1][2] + ae[1] * AbsR[0][2];
+    rb = be[0] * AbsR[2][1] + be[1] * AbsR[2][0];
+    if(fabs(t[1] * R[0][2] - t[0] * R[1][2]) > ra + rb) return KM_FALSE;
+
+    return KM_TRUE;
+}
+
+kmOBB3* kmOBB3FromAABB3(kmOBB3* pOut, const kmAABB3* pAABB, const kmMat4* pM) {
+    kmVec3 centre;
+    kmScalar* e = &pOut->extents.x;
+    int i;
+
+    kmAABB3Centre(pAABB, &centre);
+    kmVec3Subtract(&pOut->extents, &pAABB->max, &pAABB->min);
+    kmVec3Scale(&pOut->extents, &pOut->extents, 0.5f);
+
+    if(!pM) {
+        kmVec3Assign(&pOut->centre, &centre);
+        kmMat3Identity(&pOut->axes);
+        return pOut;
+    }
+
+    kmVec3MultiplyMat4(&pOut->centre, &centre, pM);
+
+    /* Move any scale out of the axes and into the extents */
+    for(i = 0; i < 3; ++i) {
+        kmScalar x = pM->mat[i * 4], y = pM->mat[i * 4 + 1], z = pM->mat[i * 4 + 2];
+        kmScalar len = sqrt(x * x + y * y + z * z);
+        kmScalar inv = (len > kmEpsilon) ? 1.0f / len : 0.0f;
+
+        AXIS(&pOut->axes, i, 0) = x * inv;
+        AXIS(&pOut->axes, i, 1) = y * inv;
+        AXIS(&pOut->axes, i, 2) = z * inv;
+        e[i] *= len;
+    }
+
+    return pOut;
+}
+
+kmAABB3* kmAABB3FromOBB3(kmAABB3* pOut, const kmOBB3* pBox, const kmMat4* pM) {
+    kmScalar m[3][3]; /* Box axes scaled by the extents, in world space */
+    kmVec3 centre, half;
+    const kmScalar* e = &pBox->extents.x;
+    int i;
+
+    for(i = 0; i < 3; ++i) {
+        kmScalar x = AXIS(&pBox->axes, i, 0) * e[i];
+        kmScalar y = AXIS(&pBox->axes, i, 1) * e[i];
+        kmScalar z = AXIS(&pBox->axes, i, 2) * e[i];
+
+        if(pM) {
+            m[i][0] = pM->mat[0] * x + pM->mat[4] * y + pM->mat[8] * z;
+            m[i][1] = pM->mat[1] * x + pM->mat[5] * y + pM->mat[9] * z;
+            m[i][2] = pM->mat[2] * x + pM->mat[6] * y + pM->mat[10] * z;
+        } else {
+            m[i][0] = x;
+            m[i][1] = y;
+            m[i][2] = z;
+        }
+    }
+
+    if(pM) {
+        kmVec3MultiplyMat4(&centre, &pBox->centre, pM);
+    } else {
+        kmVec3Assign(&centre, &pBox->centre);
+    }
+
+    half.x = fabs(m[0][0]) + fabs(m[1][0]) + fabs(m[2][0]);
+    half.y = fabs(m[0][1]) + fabs(m[1][1]) + fabs(m[2][1]);
+    half.z = fabs(m[0][2]) + fabs(m[1][2]) + fabs(m[2][2]);
+
+    kmVec3Subtract(&pOut->min, &centre, &half);
+    kmVec3Add(&pOut->max, &centre, &half);
+
+    return pOut;
+}
+
+static void jacobi_eigenvectors(kmScalar a[3][3], kmScalar v[3][3]) {
+    /* Cyclic Jacobi rotations on a symmetric matrix, eigenvectors end up in the columns of v */
+    int sweep, p, q, k;
+
+    for(p = 0; p < 3; ++p) {
+        for(q = 0; q < 3; ++q) {
+            v[p][q] = (p == q) ? 1.0f : 0.0f;
+        }
+    }
+
+    for(sweep = 0; sweep < 32; ++sweep) {
+        kmScalar off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        kmScalar diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+
+        if(off <= diag * kmEpsilon * kmEpsilon || off == 0) {
+            break;
+        }
+
+        for(p = 0; p < 2; ++p) {
+            for(q = p + 1; q < 3; ++q) {
+                kmScalar theta, t, c, s;
+
+                if(a[p][q] == 0) {
+                    continue;
+                }
+
+                theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+                t = 1.0f / (fabs(theta) + sqrt(theta * theta + 1));
+                if(theta < 0) t = -t;
+                c = 1.0f / sqrt(t * t + 1);
+                s = t * c;
+
+                for(k = 0; k < 3; ++k) {
+                    kmScalar akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+
+                for(k = 0; k < 3; ++k) {
+                    kmScalar apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+
+                for(k = 0; k < 3; ++k) {
+                    kmScalar vkp = v[k][p], vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+kmOBB3* kmOBB3FromPointsPCA(kmOBB3* pOut, const kmVec3* points, kmUint count) {
+    kmScalar cov[3][3] = { { 0 } };
+    kmScalar v[3][3];
+    kmScalar min[3], max[3];
+    kmVec3 mean, axis[3], cross;
+    kmUint i;
+    int k;
+
+    kmVec3Zero(&mean);
+
+    if(!count) {
+        kmVec3Zero(&pOut->centre);
+        kmVec3Zero(&pOut->extents);
+        kmMat3Identity(&pOut->axes);
+        return pOut;
+    }
+
+    for(i = 0; i < count; ++i) {
+        kmVec3Add(&mean, &mean, &points[i]);
+    }
+    kmVec3Scale(&mean, &mean, 1.0f / count);
+
+    for(i = 0; i < count; ++i) {
+        kmScalar x = points[i].x - mean.x;
+        kmScalar y = points[i].y - mean.y;
+        kmScalar z = points[i].z - mean.z;
+
+        cov[0][0] += x * x;
+        cov[0][1] += x * y;
+        cov[0][2] += x * z;
+        cov[1][1] += y * y;
+        cov[1][2] += y * z;
+        cov[2][2] += z * z;
+    }
+
+    cov[1][0] = cov[0][1];
+    cov[2][0] = cov[0][2];
+    cov[2][1] = cov[1][2];
+
+    jacobi_eigenvectors(cov, v);
+
+    for(k = 0; k < 3; ++k) {
+        kmVec3Fill(&axis[k], v[0][k], v[1][k], v[2][k]);
+        kmVec3Normalize(&axis[k], &axis[k]);
+    }
+
+    /* Keep the basis right handed */
+    kmVec3Cross(&cross, &axis[0], &axis[1]);
+    if(kmVec3Dot(&cross, &axis[2]) < 0) {
+        kmVec3Scale(&axis[2], &axis[2], -1);
+    }
+
+    for(k = 0; k < 3; ++k) {
+        min[k] = max[k] = kmVec3Dot(&points[0], &axis[k]);
+    }
+
+    for(i = 1; i < count; ++i) {
+        for(k = 0; k < 3; ++k) {
+            kmScalar proj = kmVec3Dot(&points[i], &axis[k]);
+            if(proj < min[k]) min[k] = proj;
+            if(proj > max[k]) max[k] = proj;
+        }
+    }
+
+    kmVec3Zero(&pOut->centre);
+    for(k = 0; k < 3; ++k) {
+        kmVec3 offset;
+        kmVec3Scale(&offset, &axis[k], (min[k] + max[k]) * 0.5f);
+        kmVec3Add(&pOut->centre, &pOut->centre, &offset);
+
+        AXIS(&pOut->axes, k, 0) = axis[k].x;
+        AXIS(&pOut->axes, k, 1) = axis[k].y;
+        AXIS(&pOut->axes, k, 2) = axis[k].z;
+    }
+
+    kmVec3Fill(&pOut->extents,
+        (max[0] - min[0]) * 0.5f,
+        (max[1] - min[1]) * 0.5f,
+        (max[2] - min[2]) * 0.5f
+    );
+
+    return pOut;
+}
+
+static kmBool obb3_intersects_planes(const kmOBB3* pBox, const kmPlane* planes, kmUint plane_count) {
+    const kmMat3* m = &pBox->axes;
+    kmUint i;
+
+    for(i = 0; i < plane_count; ++i) {
+        const kmPlane* p = &planes[i];
+
+        /* Projected radius of the box onto the plane normal */
+        kmScalar r = pBox->extents.x * fabs(p->a * m->mat[0] + p->b * m->mat[1] + p->c * m->mat[2]) +
+                     pBox->extents.y * fabs(p->a * m->mat[3] + p->b * m->mat[4] + p->c * m->mat[5]) +
+                     pBox->extents.z * fabs(p->a * m->mat[6] + p->b * m->mat[7] + p->c * m->mat[8]);
+
+        kmScalar d = p->a * pBox->centre.x + p->b * pBox->centre.y + p->c * pBox->centre.z + p->d;
+
+        if(d < -r) {
+            return KM_FALSE;
+        }
+    }
+
+    return KM_TRUE;
+}
+
+kmBool kmOBB3IntersectsPlanes(const kmOBB3* pBox, const kmPlane* planes, kmUint plane_count) {
+    return obb3_intersects_planes(pBox, planes, plane_count);
+}
+
+kmUint kmOBB3IntersectsPlanesArray(const kmOBB3* boxes, kmUint count, const kmPlane* planes, kmUint plane_count, kmBool* pResults) {
+    kmUint i, hits = 0;
+
+    for(i = 0; i < count; ++i) {
+        kmBool hit = obb3_intersects_planes(&boxes[i], planes, plane_count);
+        pResults[i] = hit;
+        hits += hit;
+    }
+
+    return hits;
+}
@@ -0,0 +1,109 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_OBB3_H_INCLUDED
+#define KAZMATH_OBB3_H_INCLUDED
+
+#include "vec3.h"
+#include "mat3.h"
+#include "utility.h"
+
+struct kmMat4;
+struct kmPlane;
+struct kmAABB3;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A structure that represents an oriented bounding box. The columns
+ * of axes are the (unit length) local x, y and z axes of the box.
+ */
+typedef struct kmOBB3 {
+    kmVec3 centre;
+    kmMat3 axes;
+    kmVec3 extents; /** The half-extents along each axis */
+} kmOBB3;
+
+kmOBB3* kmOBB3Fill(kmOBB3* pOut, const kmVec3* centre, const kmMat3* axes,
+                   const kmVec3* extents);
+kmOBB3* kmOBB3Assign(kmOBB3* pOut, const kmOBB3* pIn);
+
+/**
+ * Returns KM_TRUE if the point lies inside (or on) the box
+ */
+kmBool kmOBB3ContainsPoint(const kmOBB3* pBox, const kmVec3* pPoint);
+
+/**
+ * Separating axis test between two boxes (the 3 + 3 face axes and the
+ * 9 edge cross products). Returns KM_TRUE if they overlap.
+ */
+kmBool kmOBB3IntersectsOBB3(const kmOBB3* a, const kmOBB3* b);
+
+/**
+ * Builds the box that pAABB becomes when transformed by pM. pM may
+ * contain rotation, translation and non-uniform scale but no shear.
+ * If pM is NULL the identity is used.
+ */
+kmOBB3* kmOBB3FromAABB3(kmOBB3* pOut, const struct kmAABB3* pAABB,
+                        const struct kmMat4* pM);
+
+/**
+ * Stores the axis-aligned box that encloses pBox after it is
+ * transformed by pM (or as is if pM is NULL). Returns pOut.
+ */
+struct kmAABB3* kmAABB3FromOBB3(struct kmAABB3* pOut, const kmOBB3* pBox,
+                                const struct kmMat4* pM);
+
+/**
+ * Fits a box around count points. The axes are the eigenvectors of the
+ * covariance matrix of the points (principal component analysis) and
+ * the extents are the point spread along each of them.
+ */
+kmOBB3* kmOBB3FromPointsPCA(kmOBB3* pOut, const kmVec3* points, kmUint count);
+
+/**
+ * Tests the box against plane_count planes whose normals point inwards,
+ * e.g. the 6 frustum planes from kmMat4ExtractPlane. Returns KM_FALSE if
+ * the box is entirely behind any of them.
+ */
+kmBool kmOBB3IntersectsPlanes(const kmOBB3* pBox, const struct kmPlane* planes,
+                              kmUint plane_count);
+
+/**
+ * Batch form of kmOBB3IntersectsPlanes (e.g. frustum culling). Writes
+ * KM_TRUE/KM_FALSE per box into pResults and returns the number of boxes
+ * which were not culled.
+ */
+kmUint kmOBB3IntersectsPlanesArray(const kmOBB3* boxes, kmUint count,
+                                   const struct kmPlane* planes,
+                                   kmUint plane_count, kmBool* pResults);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
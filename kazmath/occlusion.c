@@ -0,0 +1,460 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "occlusion.h"
+#include "jobs.h"
+#include "mat4.h"
+#include "aabb3.h"
+
+#define TILE KM_OCCLUSION_TILE_SIZE
+
+typedef struct km_occlusion_job {
+    kmOcclusionBuffer* buffer;
+    const kmOcclusionBuffer* const_buffer;
+    const kmMat4* matrix;
+
+    /* Rasterizing: vertices to transform, triangles to set up, then the band of tile rows to fill */
+    const kmVec3* vertices;
+    kmUint vertex_begin;
+    kmUint vertex_end;
+    const kmUint* indices;
+    kmUint triangle_begin;
+    kmUint triangle_end;
+    kmUint triangle_count;
+    kmUint row_begin;
+    kmUint row_end;
+
+    /* Testing */
+    const kmAABB3* boxes;
+    kmUint box_begin;
+    kmUint box_end;
+    kmBool* results;
+    kmUint visible;
+} km_occlusion_job;
+
+static kmUint pixel_index(const kmOcclusionBuffer* pBuffer, kmUint x, kmUint y) {
+    return ((y / TILE) * pBuffer->tiles_x + x / TILE) * TILE * TILE + (y % TILE) * TILE + (x % TILE);
+}
+
+kmOcclusionBuffer* kmOcclusionBufferInitialize(kmOcclusionBuffer* pBuffer, kmUint width, kmUint height) {
+    memset(pBuffer, 0, sizeof(kmOcclusionBuffer));
+
+    pBuffer->tiles_x = (width + TILE - 1) / TILE;
+    pBuffer->tiles_y = (height + TILE - 1) / TILE;
+    pBuffer->width = pBuffer->tiles_x * TILE;
+    pBuffer->height = pBuffer->tiles_y * TILE;
+    pBuffer->depth = (kmScalar*) malloc(sizeof(kmScalar) * pBuffer->width * pBuffer->height);
+    pBuffer->tile_max = (kmScalar*) malloc(sizeof(kmScalar) * pBuffer->tiles_x * pBuffer->tiles_y);
+
+    kmOcclusionBufferClear(pBuffer);
+
+    return pBuffer;
+}
+
+void kmOcclusionBufferFree(kmOcclusionBuffer* pBuffer) {
+    free(pBuffer->depth);
+    free(pBuffer->tile_max);
+    free(pBuffer->clip);
+    free(pBuffer->screen);
+    memset(pBuffer, 0, sizeof(kmOcclusionBuffer));
+}
+
+void kmOcclusionBufferClear(kmOcclusionBuffer* pBuffer) {
+    kmUint i, pixels = pBuffer->width * pBuffer->height;
+
+    for(i = 0; i < pixels; ++i) pBuffer->depth[i] = 1;
+    for(i = 0; i < pBuffer->tiles_x * pBuffer->tiles_y; ++i) pBuffer->tile_max[i] = 1;
+}
+
+kmScalar kmOcclusionBufferDepth(const kmOcclusionBuffer* pBuffer, kmUint x, kmUint y) {
+    return pBuffer->depth[pixel_index(pBuffer, x, y)];
+}
+
+static void transform(kmVec4* pOut, const kmMat4* pM, const kmVec3* p) {
+    const kmScalar* m = pM->mat;
+    pOut->x = m[0] * p->x + m[4] * p->y + m[8] * p->z + m[12];
+    pOut->y = m[1] * p->x + m[5] * p->y + m[9] * p->z + m[13];
+    pOut->z = m[2] * p->x + m[6] * p->y + m[10] * p->z + m[14];
+    pOut->w = m[3] * p->x + m[7] * p->y + m[11] * p->z + m[15];
+}
+
+/* Screen position and window depth of a clip space vertex in front of the near plane */
+static void to_screen(const kmOcclusionBuffer* pBuffer, const kmVec4* c, kmScalar* pOut) {
+    kmScalar inv_w = 1 / c->w;
+    pOut[0] = (c->x * inv_w * 0.5 + 0.5) * pBuffer->width;
+    pOut[1] = (c->y * inv_w * 0.5 + 0.5) * pBuffer->height;
+    pOut[2] = c->z * inv_w * 0.5 + 0.5;
+}
+
+/* Fills the pixels of one screen space triangle that fall in rows [y_begin, y_end) */
+static void fill_triangle(kmOcclusionBuffer* pBuffer, const kmScalar* v0, const kmScalar* v1, const kmScalar* v2,
+                          kmInt y_begin, kmInt y_end) {
+    const kmScalar* tmp;
+    kmScalar area, dzdx, dzdy, min_x, max_x, min_y, max_y;
+    kmInt x0, x1, y0, y1, x, y;
+
+    area = (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v2[0] - v0[0]) * (v1[1] - v0[1]);
+    if(area == 0) return;
+    if(area < 0) {
+        /* Counter clockwise so the inside is where every edge function is positive */
+        tmp = v1;
+        v1 = v2;
+        v2 = tmp;
+        area = -area;
+    }
+
+    min_x = v0[0] < v1[0] ? (v0[0] < v2[0] ? v0[0] : v2[0]) : (v1[0] < v2[0] ? v1[0] : v2[0]);
+    max_x = v0[0] > v1[0] ? (v0[0] > v2[0] ? v0[0] : v2[0]) : (v1[0] > v2[0] ? v1[0] : v2[0]);
+    min_y = v0[1] < v1[1] ? (v0[1] < v2[1] ? v0[1] : v2[1]) : (v1[1] < v2[1] ? v1[1] : v2[1]);
+    max_y = v0[1] > v1[1] ? (v0[1] > v2[1] ? v0[1] : v2[1]) : (v1[1] > v2[1] ? v1[1] : v2[1]);
+
+    /* Pixels whose centres can be inside */
+    x0 = (kmInt) floor(min_x - 0.5) + 1;
+    x1 = (kmInt) floor(max_x - 0.5);
+    y0 = (kmInt) floor(min_y - 0.5) + 1;
+    y1 = (kmInt) floor(max_y - 0.5);
+    if(x0 < 0) x0 = 0;
+    if(x1 >= (kmInt) pBuffer->width) x1 = pBuffer->width - 1;
+    if(y0 < y_begin) y0 = y_begin;
+    if(y1 >= y_end) y1 = y_end - 1;
+    if(x0 > x1 || y0 > y1) return;
+
+    /* Depth is affine in screen space */
+    dzdx = ((v1[2] - v0[2]) * (v2[1] - v0[1]) - (v2[2] - v0[2]) * (v1[1] - v0[1])) / area;
+    dzdy = ((v2[2] - v0[2]) * (v1[0] - v0[0]) - (v1[2] - v0[2]) * (v2[0] - v0[0])) / area;
+
+    for(y = y0; y <= y1; ++y) {
+        kmScalar py = y + 0.5, px = x0 + 0.5;
+
+        /* Edge functions at the first pixel of the row, stepped along x */
+        kmScalar e0 = (v2[0] - v1[0]) * (py - v1[1]) - (v2[1] - v1[1]) * (px - v1[0]);
+        kmScalar e1 = (v0[0] - v2[0]) * (py - v2[1]) - (v0[1] - v2[1]) * (px - v2[0]);
+        kmScalar e2 = (v1[0] - v0[0]) * (py - v0[1]) - (v1[1] - v0[1]) * (px - v0[0]);
+        kmScalar z = v0[2] + dzdx * (px - v0[0]) + dzdy * (py - v0[1]);
+        kmScalar step0 = -(v2[1] - v1[1]), step1 = -(v0[1] - v2[1]), step2 = -(v1[1] - v0[1]);
+
+        for(x = x0; x <= x1; ++x) {
+            if(e0 >= 0 && e1 >= 0 && e2 >= 0 && z >= 0) {
+                kmScalar* d = &pBuffer->depth[pixel_index(pBuffer, x, y)];
+                if(z < *d) *d = z;
+            }
+            e0 += step0;
+            e1 += step1;
+            e2 += step2;
+            z += dzdx;
+        }
+    }
+}
+
+/* Clips a clip space triangle to the near plane (z >= -w), giving up to 4 vertices */
+static kmUint clip_near(const kmVec4* in, kmVec4* out) {
+    kmUint i, count = 0;
+
+    for(i = 0; i < 3; ++i) {
+        const kmVec4* a = &in[i];
+        const kmVec4* b = &in[(i + 1) % 3];
+        kmScalar da = a->z + a->w, db = b->z + b->w;
+
+        if(da >= 0) out[count++] = *a;
+        if((da >= 0) != (db >= 0)) {
+            kmScalar t = da / (da - db);
+            out[count].x = a->x + (b->x - a->x) * t;
+            out[count].y = a->y + (b->y - a->y) * t;
+            out[count].z = a->z + (b->z - a->z) * t;
+            out[count].w = a->w + (b->w - a->w) * t;
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+static void* transform_job(void* arg) {
+    km_occlusion_job* job = (km_occlusion_job*) arg;
+    kmUint i;
+
+    for(i = job->vertex_begin; i < job->vertex_end; ++i) {
+        transform(&job->buffer->clip[i], job->matrix, &job->vertices[i]);
+    }
+
+    return NULL;
+}
+
+/*
+ * Each input triangle owns two slots of KM_SCREEN_STRIDE scalars: the
+ * screen vertices of up to two triangles left after near clipping, then
+ * the lowest and highest y. An unused slot has min y above max y.
+ */
+#define KM_SCREEN_STRIDE 11
+
+static void* setup_job(void* arg) {
+    km_occlusion_job* job = (km_occlusion_job*) arg;
+    kmOcclusionBuffer* pBuffer = job->buffer;
+    kmUint i, j, k;
+
+    for(i = job->triangle_begin; i < job->triangle_end; ++i) {
+        kmScalar* slots = &pBuffer->screen[i * 2 * KM_SCREEN_STRIDE];
+        kmVec4 tri[3], polygon[4];
+        kmScalar screen[4][3];
+        kmUint count;
+
+        slots[9] = slots[KM_SCREEN_STRIDE + 9] = 1;
+        slots[10] = slots[KM_SCREEN_STRIDE + 10] = 0;
+
+        for(j = 0; j < 3; ++j) {
+            tri[j] = pBuffer->clip[job->indices ? job->indices[i * 3 + j] : i * 3 + j];
+        }
+
+        /* Entirely outside one side of the frustum */
+        if((tri[0].x < -tri[0].w && tri[1].x < -tri[1].w && tri[2].x < -tri[2].w) ||
+           (tri[0].x > tri[0].w && tri[1].x > tri[1].w && tri[2].x > tri[2].w) ||
+           (tri[0].y < -tri[0].w && tri[1].y < -tri[1].w && tri[2].y < -tri[2].w) ||
+           (tri[0].y > tri[0].w && tri[1].y > tri[1].w && tri[2].y > tri[2].w) ||
+           (tri[0].z > tri[0].w && tri[1].z > tri[1].w && tri[2].z > tri[2].w)) continue;
+
+        count = clip_near(tri, polygon);
+        if(count < 3) continue;
+
+        for(j = 0; j < count; ++j) {
+            to_screen(pBuffer, &polygon[j], screen[j]);
+        }
+
+        /* Fan from the first vertex */
+        for(j = 2; j < count; ++j) {
+            kmScalar* slot = &slots[(j - 2) * KM_SCREEN_STRIDE];
+            const kmScalar* v[3];
+
+            v[0] = screen[0];
+            v[1] = screen[j - 1];
+            v[2] = screen[j];
+            for(k = 0; k < 3; ++k) {
+                slot[k * 3] = v[k][0];
+                slot[k * 3 + 1] = v[k][1];
+                slot[k * 3 + 2] = v[k][2];
+            }
+
+            slot[9] = kmMin(v[0][1], kmMin(v[1][1], v[2][1]));
+            slot[10] = kmMax(v[0][1], kmMax(v[1][1], v[2][1]));
+        }
+    }
+
+    return NULL;
+}
+
+static void* raster_job(void* arg) {
+    km_occlusion_job* job = (km_occlusion_job*) arg;
+    kmOcclusionBuffer* pBuffer = job->buffer;
+    kmInt y_begin = job->row_begin * TILE, y_end = job->row_end * TILE;
+    kmUint i, j, k;
+
+    for(i = 0; i < job->triangle_count * 2; ++i) {
+        const kmScalar* slot = &pBuffer->screen[i * KM_SCREEN_STRIDE];
+
+        /* Unused, or no pixel centre of the band can be inside */
+        if(slot[9] > slot[10] || slot[10] < y_begin || slot[9] > y_end) continue;
+
+        fill_triangle(pBuffer, &slot[0], &slot[3], &slot[6], y_begin, y_end);
+    }
+
+    /* Refresh the furthest depth of the tiles in the band */
+    for(i = job->row_begin; i < job->row_end; ++i) {
+        for(j = 0; j < pBuffer->tiles_x; ++j) {
+            kmUint tile = i * pBuffer->tiles_x + j;
+            const kmScalar* d = &pBuffer->depth[tile * TILE * TILE];
+            kmScalar furthest = d[0];
+
+            for(k = 1; k < TILE * TILE; ++k) {
+                furthest = d[k] > furthest ? d[k] : furthest;
+            }
+            pBuffer->tile_max[tile] = furthest;
+        }
+    }
+
+    return NULL;
+}
+
+void kmOcclusionBufferRasterize(kmOcclusionBuffer* pBuffer, const kmMat4* pViewProjection,
+                                const kmVec3* vertices, kmUint vertex_count,
+                                const kmUint* indices, kmUint triangle_count,
+                                kmUint thread_count) {
+    km_occlusion_job jobs[64];
+    kmUint t, chunk, triangle_chunk;
+
+    if(!pBuffer->tiles_x || !pBuffer->tiles_y) {
+        return;
+    }
+
+    if(vertex_count > pBuffer->clip_capacity) {
+        pBuffer->clip_capacity = vertex_count;
+        pBuffer->clip = (kmVec4*) realloc(pBuffer->clip, sizeof(kmVec4) * vertex_count);
+    }
+
+    if(triangle_count > pBuffer->screen_capacity) {
+        pBuffer->screen_capacity = triangle_count;
+        pBuffer->screen = (kmScalar*) realloc(pBuffer->screen, sizeof(kmScalar) * 2 * KM_SCREEN_STRIDE * triangle_count);
+    }
+
+    if(thread_count > 64) thread_count = 64;
+    if(thread_count > pBuffer->tiles_y) thread_count = pBuffer->tiles_y;
+    if(thread_count < 1) thread_count = 1;
+
+    memset(jobs, 0, sizeof(km_occlusion_job) * thread_count);
+
+    chunk = (vertex_count + thread_count - 1) / thread_count;
+    triangle_chunk = (triangle_count + thread_count - 1) / thread_count;
+    for(t = 0; t < thread_count; ++t) {
+        jobs[t].buffer = pBuffer;
+        jobs[t].matrix = pViewProjection;
+        jobs[t].vertices = vertices;
+        jobs[t].vertex_begin = t * chunk < vertex_count ? t * chunk : vertex_count;
+        jobs[t].vertex_end = (t + 1) * chunk < vertex_count ? (t + 1) * chunk : vertex_count;
+        jobs[t].indices = indices;
+        jobs[t].triangle_begin = t * triangle_chunk < triangle_count ? t * triangle_chunk : triangle_count;
+        jobs[t].triangle_end = (t + 1) * triangle_chunk < triangle_count ? (t + 1) * triangle_chunk : triangle_count;
+        jobs[t].triangle_count = triangle_count;
+        jobs[t].row_begin = pBuffer->tiles_y * t / thread_count;
+        jobs[t].row_end = pBuffer->tiles_y * (t + 1) / thread_count;
+    }
+
+    /* Triangles are clipped and set up once, then each band skips those which miss it */
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, transform_job);
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, setup_job);
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, raster_job);
+}
+
+kmBool kmOcclusionBufferTestAABB3(const kmOcclusionBuffer* pBuffer, const kmMat4* pViewProjection,
+                                  const kmAABB3* pBox) {
+    kmScalar min_x = 0, max_x = 0, min_y = 0, max_y = 0, nearest = 0;
+    kmInt x0, x1, y0, y1, tx, ty, x, y;
+    kmVec4 clip[8];
+    int i, behind = 0;
+
+    if(!pBuffer->tiles_x || !pBuffer->tiles_y) return KM_FALSE;
+
+    for(i = 0; i < 8; ++i) {
+        kmVec3 corner;
+
+        corner.x = (i & 1) ? pBox->max.x : pBox->min.x;
+        corner.y = (i & 2) ? pBox->max.y : pBox->min.y;
+        corner.z = (i & 4) ? pBox->max.z : pBox->min.z;
+        transform(&clip[i], pViewProjection, &corner);
+        behind += clip[i].z < -clip[i].w;
+    }
+
+    /* Entirely behind the near plane can't be seen, crossing it assume it can */
+    if(behind == 8) return KM_FALSE;
+    if(behind) return KM_TRUE;
+
+    for(i = 0; i < 8; ++i) {
+        kmScalar screen[3];
+
+        to_screen(pBuffer, &clip[i], screen);
+        if(!i || screen[0] < min_x) min_x = screen[0];
+        if(!i || screen[0] > max_x) max_x = screen[0];
+        if(!i || screen[1] < min_y) min_y = screen[1];
+        if(!i || screen[1] > max_y) max_y = screen[1];
+        if(!i || screen[2] < nearest) nearest = screen[2];
+    }
+
+    if(nearest > 1 || max_x < 0 || max_y < 0 ||
+       min_x >= pBuffer->width || min_y >= pBuffer->height) return KM_FALSE;
+
+    x0 = min_x < 0 ? 0 : (kmInt) min_x;
+    y0 = min_y < 0 ? 0 : (kmInt) min_y;
+    x1 = max_x >= pBuffer->width ? (kmInt) pBuffer->width - 1 : (kmInt) max_x;
+    y1 = max_y >= pBuffer->height ? (kmInt) pBuffer->height - 1 : (kmInt) max_y;
+
+    for(ty = y0 / TILE; ty <= y1 / TILE; ++ty) {
+        for(tx = x0 / TILE; tx <= x1 / TILE; ++tx) {
+            kmInt px0, px1, py0, py1;
+
+            /* The whole tile is nearer than the box */
+            if(nearest > pBuffer->tile_max[ty * pBuffer->tiles_x + tx]) continue;
+
+            px0 = tx * TILE > x0 ? tx * TILE : x0;
+            px1 = tx * TILE + TILE - 1 < x1 ? tx * TILE + TILE - 1 : x1;
+            py0 = ty * TILE > y0 ? ty * TILE : y0;
+            py1 = ty * TILE + TILE - 1 < y1 ? ty * TILE + TILE - 1 : y1;
+
+            for(y = py0; y <= py1; ++y) {
+                for(x = px0; x <= px1; ++x) {
+                    if(nearest <= pBuffer->depth[pixel_index(pBuffer, x, y)]) return KM_TRUE;
+                }
+            }
+        }
+    }
+
+    return KM_FALSE;
+}
+
+static void* test_job(void* arg) {
+    km_occlusion_job* job = (km_occlusion_job*) arg;
+    kmUint i;
+
+    for(i = job->box_begin; i < job->box_end; ++i) {
+        kmBool visible = kmOcclusionBufferTestAABB3(job->const_buffer, job->matrix, &job->boxes[i]);
+        job->results[i] = visible;
+        job->visible += visible;
+    }
+
+    return NULL;
+}
+
+kmUint kmOcclusionBufferTestAABB3Array(const kmOcclusionBuffer* pBuffer, const kmMat4* pViewProjection,
+                                       const kmAABB3* boxes, kmUint count, kmBool* pResults,
+                                       kmUint thread_count) {
+    km_occlusion_job jobs[64];
+    kmUint t, chunk, visible = 0;
+
+    if(!count) return 0;
+
+    if(thread_count < 1) thread_count = 1;
+    if(thread_count > 64) thread_count = 64;
+    if(thread_count > count) thread_count = count;
+
+    memset(jobs, 0, sizeof(km_occlusion_job) * thread_count);
+
+    chunk = (count + thread_count - 1) / thread_count;
+    for(t = 0; t < thread_count; ++t) {
+        jobs[t].const_buffer = pBuffer;
+        jobs[t].matrix = pViewProjection;
+        jobs[t].boxes = boxes;
+        jobs[t].box_begin = t * chunk < count ? t * chunk : count;
+        jobs[t].box_end = (t + 1) * chunk < count ? (t + 1) * chunk : count;
+        jobs[t].results = pResults;
+    }
+
+    km_run_jobs(jobs, sizeof(jobs[0]), thread_count, test_job);
+
+    for(t = 0; t < thread_count; ++t) {
+        visible += jobs[t].visible;
+    }
+
+    return visible;
+}
@@ -0,0 +1,115 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_OCCLUSION_H_INCLUDED
+#define KAZMATH_OCCLUSION_H_INCLUDED
+
+#include "vec3.h"
+#include "vec4.h"
+#include "utility.h"
+
+struct kmMat4;
+struct kmAABB3;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KM_OCCLUSION_TILE_SIZE 8
+
+/*
+ * A low resolution software depth buffer for occlusion culling. Occluder
+ * triangles are transformed by a view-projection matrix (e.g. from
+ * kmMat4PerspectiveProjection) and rasterized, then object bounds are
+ * tested against the result to find the ones hidden behind them.
+ *
+ * Depth is stored as window depth (0 near, 1 far) in 8x8 pixel tiles,
+ * each tile contiguous in memory. Every tile also keeps the furthest
+ * depth it holds, so most tests reject a whole tile without touching its
+ * pixels.
+ */
+typedef struct kmOcclusionBuffer {
+    kmUint width;               /** Rounded up to a multiple of the tile size */
+    kmUint height;
+    kmUint tiles_x;
+    kmUint tiles_y;
+    kmScalar* depth;            /** width * height, tile by tile */
+    kmScalar* tile_max;         /** The furthest depth in each tile */
+
+    kmVec4* clip;               /** Scratch for transformed vertices */
+    kmUint clip_capacity;
+    kmScalar* screen;           /** Scratch for set up screen space triangles */
+    kmUint screen_capacity;
+} kmOcclusionBuffer;
+
+kmOcclusionBuffer* kmOcclusionBufferInitialize(kmOcclusionBuffer* pBuffer, kmUint width, kmUint height);
+void kmOcclusionBufferFree(kmOcclusionBuffer* pBuffer);
+
+/**
+ * Resets every pixel to the far plane.
+ */
+void kmOcclusionBufferClear(kmOcclusionBuffer* pBuffer);
+
+/**
+ * Rasterizes triangle_count occluder triangles. Triangle i uses
+ * vertices[indices[i * 3]] .. vertices[indices[i * 3 + 2]], or if indices
+ * is NULL vertices[i * 3] onwards. Triangles are clipped to the near
+ * plane and are not backface culled. The vertices are transformed and
+ * the triangles set up by thread_count threads, then each thread
+ * rasterizes a band of tile rows. An empty buffer is left untouched.
+ */
+void kmOcclusionBufferRasterize(kmOcclusionBuffer* pBuffer, const struct kmMat4* pViewProjection,
+                                const kmVec3* vertices, kmUint vertex_count,
+                                const kmUint* indices, kmUint triangle_count,
+                                kmUint thread_count);
+
+/**
+ * Returns the depth stored at pixel x, y (y counts up from the bottom)
+ */
+kmScalar kmOcclusionBufferDepth(const kmOcclusionBuffer* pBuffer, kmUint x, kmUint y);
+
+/**
+ * Returns KM_TRUE if any part of the box's screen rectangle could be
+ * visible, i.e. its nearest depth is in front of the stored depth
+ * somewhere. Boxes that cross the near plane are always visible, boxes
+ * entirely off screen or behind the camera never are.
+ */
+kmBool kmOcclusionBufferTestAABB3(const kmOcclusionBuffer* pBuffer, const struct kmMat4* pViewProjection,
+                                  const struct kmAABB3* pBox);
+
+/**
+ * Tests count boxes split between thread_count threads. Writes KM_TRUE
+ * (visible) or KM_FALSE per box into pResults and returns the number of
+ * visible boxes.
+ */
+kmUint kmOcclusionBufferTestAABB3Array(const kmOcclusionBuffer* pBuffer, const struct kmMat4* pViewProjection,
+                                       const struct kmAABB3* boxes, kmUint count, kmBool* pResults,
+                                       kmUint thread_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
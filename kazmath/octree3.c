@@ -0,0 +1,566 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "octree3.h"
+#include "plane.h"
+#include "ray3.h"
+
+#define INVALID KM_OCTREE3_INVALID
+#define STACK_SIZE (7 * KM_OCTREE3_MAX_DEPTH + 8)
+
+static kmInt alloc_node(kmOctree3* pTree, kmInt parent, const kmVec3* centre, kmScalar half, kmUint depth) {
+    kmInt index;
+    kmOctree3Node* node;
+    int i;
+
+    if(pTree->free_node != INVALID) {
+        index = pTree->free_node;
+        pTree->free_node = pTree->nodes[index].parent;
+    } else {
+        if(pTree->node_count == pTree->node_capacity) {
+            pTree->node_capacity = pTree->node_capacity ? pTree->node_capacity * 2 : 16;
+            pTree->nodes = (kmOctree3Node*) realloc(pTree->nodes, sizeof(kmOctree3Node) * pTree->node_capacity);
+        }
+        index = (kmInt) pTree->node_count++;
+    }
+
+    node = &pTree->nodes[index];
+    node->centre = *centre;
+    node->half = half;
+    node->depth = depth;
+    node->parent = parent;
+    node->first_object = INVALID;
+    for(i = 0; i < 8; ++i) {
+        node->children[i] = INVALID;
+    }
+
+    return index;
+}
+
+static kmInt alloc_object(kmOctree3* pTree) {
+    kmInt index;
+
+    if(pTree->free_object != INVALID) {
+        index = pTree->free_object;
+        pTree->free_object = pTree->objects[index].next;
+        return index;
+    }
+
+    if(pTree->object_count == pTree->object_capacity) {
+        pTree->object_capacity = pTree->object_capacity ? pTree->object_capacity * 2 : 16;
+        pTree->objects = (kmOctree3Object*) realloc(pTree->objects, sizeof(kmOctree3Object) * pTree->object_capacity);
+    }
+
+    return (kmInt) pTree->object_count++;
+}
+
+static kmScalar max_half_extent(const kmAABB3* box) {
+    kmScalar x = box->max.x - box->min.x;
+    kmScalar y = box->max.y - box->min.y;
+    kmScalar z = box->max.z - box->min.z;
+    return kmMax(x, kmMax(y, z)) * 0.5;
+}
+
+static kmBool cell_contains(const kmOctree3Node* node, const kmVec3* p) {
+    return fabs(p->x - node->centre.x) <= node->half &&
+           fabs(p->y - node->centre.y) <= node->half &&
+           fabs(p->z - node->centre.z) <= node->half;
+}
+
+static int child_slot(const kmOctree3Node* node, const kmVec3* p) {
+    return (p->x >= node->centre.x ? 1 : 0) |
+           (p->y >= node->centre.y ? 2 : 0) |
+           (p->z >= node->centre.z ? 4 : 0);
+}
+
+/* The loose bounds of a node, twice the size of its cell */
+static void loose_bounds(const kmOctree3Node* node, kmAABB3* pOut) {
+    kmScalar h = node->half * 2;
+    kmVec3Fill(&pOut->min, node->centre.x - h, node->centre.y - h, node->centre.z - h);
+    kmVec3Fill(&pOut->max, node->centre.x + h, node->centre.y + h, node->centre.z + h);
+}
+
+/*
+ * Returns KM_TRUE if an object with the given centre and half size belongs
+ * in node, i.e. it could not go any deeper.
+ */
+static kmBool fits_node(const kmOctree3* pTree, const kmOctree3Node* node, const kmVec3* centre, kmScalar size) {
+    if(!cell_contains(node, centre)) {
+        /* Only the root holds objects outside of its cell */
+        return node->parent == INVALID;
+    }
+
+    if(size > node->half) {
+        return node->parent == INVALID;
+    }
+
+    return node->depth == pTree->max_depth || size > node->half * 0.5;
+}
+
+/* Finds (creating it if necessary) the node an object belongs in */
+static kmInt target_node(kmOctree3* pTree, const kmAABB3* bounds) {
+    kmVec3 centre;
+    kmScalar size = max_half_extent(bounds);
+    kmInt index = 0;
+
+    kmAABB3Centre(bounds, &centre);
+
+    while(!fits_node(pTree, &pTree->nodes[index], &centre, size)) {
+        const kmOctree3Node* node = &pTree->nodes[index];
+        int slot = child_slot(node, &centre);
+        kmInt child = node->children[slot];
+
+        if(child == INVALID) {
+            kmScalar h = node->half * 0.5;
+            kmVec3 c;
+            kmVec3Fill(&c,
+                node->centre.x + ((slot & 1) ? h : -h),
+                node->centre.y + ((slot & 2) ? h : -h),
+                node->centre.z + ((slot & 4) ? h : -h));
+
+            child = alloc_node(pTree, index, &c, h, node->depth + 1);
+            /* alloc_node may have moved the pool */
+            pTree->nodes[index].children[slot] = child;
+        }
+
+        index = child;
+    }
+
+    return index;
+}
+
+static void link_object(kmOctree3* pTree, kmInt handle, kmInt node) {
+    kmOctree3Object* obj = &pTree->objects[handle];
+    kmInt head = pTree->nodes[node].first_object;
+
+    obj->node = node;
+    obj->prev = INVALID;
+    obj->next = head;
+    if(head != INVALID) {
+        pTree->objects[head].prev = handle;
+    }
+    pTree->nodes[node].first_object = handle;
+}
+
+static void unlink_object(kmOctree3* pTree, kmInt handle) {
+    kmOctree3Object* obj = &pTree->objects[handle];
+
+    if(obj->prev != INVALID) {
+        pTree->objects[obj->prev].next = obj->next;
+    } else {
+        pTree->nodes[obj->node].first_object = obj->next;
+    }
+
+    if(obj->next != INVALID) {
+        pTree->objects[obj->next].prev = obj->prev;
+    }
+}
+
+/* Returns empty leaves to the pool, walking up towards the root */
+static void prune(kmOctree3* pTree, kmInt index) {
+    while(index != 0) {
+        kmOctree3Node* node = &pTree->nodes[index];
+        kmInt parent = node->parent;
+        int i;
+
+        if(node->first_object != INVALID) return;
+        for(i = 0; i < 8; ++i) {
+            if(node->children[i] != INVALID) return;
+        }
+
+        for(i = 0; i < 8; ++i) {
+            if(pTree->nodes[parent].children[i] == index) {
+                pTree->nodes[parent].children[i] = INVALID;
+            }
+        }
+
+        node->parent = pTree->free_node;
+        pTree->free_node = index;
+        index = parent;
+    }
+}
+
+kmOctree3* kmOctree3Initialize(kmOctree3* pTree, const kmAABB3* bounds, kmUint max_depth) {
+    kmVec3 centre;
+
+    memset(pTree, 0, sizeof(kmOctree3));
+    pTree->free_node = INVALID;
+    pTree->free_object = INVALID;
+    pTree->max_depth = max_depth > KM_OCTREE3_MAX_DEPTH ? KM_OCTREE3_MAX_DEPTH : max_depth;
+
+    kmAABB3Centre(bounds, &centre);
+    alloc_node(pTree, INVALID, &centre, max_half_extent(bounds), 0);
+
+    return pTree;
+}
+
+void kmOctree3Free(kmOctree3* pTree) {
+    free(pTree->nodes);
+    free(pTree->objects);
+    memset(pTree, 0, sizeof(kmOctree3));
+    pTree->free_node = INVALID;
+    pTree->free_object = INVALID;
+}
+
+void kmOctree3Reserve(kmOctree3* pTree, kmUint object_capacity) {
+    if(object_capacity > pTree->object_capacity) {
+        pTree->object_capacity = object_capacity;
+        pTree->objects = (kmOctree3Object*) realloc(pTree->objects, sizeof(kmOctree3Object) * object_capacity);
+    }
+
+    /* Most objects share nodes, one node per object is plenty */
+    if(object_capacity + 1 > pTree->node_capacity) {
+        pTree->node_capacity = object_capacity + 1;
+        pTree->nodes = (kmOctree3Node*) realloc(pTree->nodes, sizeof(kmOctree3Node) * pTree->node_capacity);
+    }
+}
+
+kmUint kmOctree3Insert(kmOctree3* pTree, const kmAABB3* bounds) {
+    kmInt handle = alloc_object(pTree);
+
+    kmAABB3Assign(&pTree->objects[handle].bounds, bounds);
+    link_object(pTree, handle, target_node(pTree, bounds));
+
+    return (kmUint) handle;
+}
+
+void kmOctree3BulkLoad(kmOctree3* pTree, const kmAABB3* bounds, kmUint count, kmUint* pHandles) {
+    kmUint i;
+
+    kmOctree3Reserve(pTree, pTree->object_count + count);
+
+    for(i = 0; i < count; ++i) {
+        kmUint handle = kmOctree3Insert(pTree, &bounds[i]);
+        if(pHandles) pHandles[i] = handle;
+    }
+}
+
+void kmOctree3Update(kmOctree3* pTree, kmUint handle, const kmAABB3* bounds) {
+    kmOctree3Object* obj = &pTree->objects[handle];
+    kmInt old_node = obj->node;
+    kmVec3 centre;
+
+    kmAABB3Assign(&obj->bounds, bounds);
+    kmAABB3Centre(bounds, &centre);
+
+    if(fits_node(pTree, &pTree->nodes[old_node], &centre, max_half_extent(bounds))) {
+        return;
+    }
+
+    unlink_object(pTree, (kmInt) handle);
+    link_object(pTree, (kmInt) handle, target_node(pTree, bounds));
+    prune(pTree, old_node);
+}
+
+void kmOctree3Remove(kmOctree3* pTree, kmUint handle) {
+    kmOctree3Object* obj = &pTree->objects[handle];
+    kmInt node = obj->node;
+
+    unlink_object(pTree, (kmInt) handle);
+
+    obj->node = INVALID;
+    obj->next = pTree->free_object;
+    pTree->free_object = (kmInt) handle;
+
+    prune(pTree, node);
+}
+
+static kmBool aabb_overlaps(const kmAABB3* a, const kmAABB3* b) {
+    return a->min.x <= b->max.x && a->max.x >= b->min.x &&
+           a->min.y <= b->max.y && a->max.y >= b->min.y &&
+           a->min.z <= b->max.z && a->max.z >= b->min.z;
+}
+
+static kmUint emit(kmUint* pOut, kmUint max_out, kmUint found, kmUint handle) {
+    if(found < max_out) pOut[found] = handle;
+    return found + 1;
+}
+
+kmUint kmOctree3QueryAABB3(const kmOctree3* pTree, const kmAABB3* box, kmUint* pOut, kmUint max_out) {
+    kmInt stack[STACK_SIZE];
+    kmUint top = 0, found = 0;
+    kmAABB3 loose;
+
+    stack[top++] = 0;
+    while(top) {
+        const kmOctree3Node* node = &pTree->nodes[stack[--top]];
+        kmInt obj;
+        int i;
+
+        if(node->parent != INVALID) {
+            loose_bounds(node, &loose);
+            if(!aabb_overlaps(&loose, box)) continue;
+        }
+
+        for(obj = node->first_object; obj != INVALID; obj = pTree->objects[obj].next) {
+            if(aabb_overlaps(&pTree->objects[obj].bounds, box)) {
+                found = emit(pOut, max_out, found, (kmUint) obj);
+            }
+        }
+
+        for(i = 0; i < 8; ++i) {
+            if(node->children[i] != INVALID) stack[top++] = node->children[i];
+        }
+    }
+
+    return found;
+}
+
+/*
+ * Tests box against the planes whose bits are set in mask. Returns KM_FALSE
+ * if it is entirely behind one of them, otherwise clears the bits of the
+ * planes it is entirely in front of.
+ */
+static kmBool aabb_planes(const kmAABB3* box, const kmPlane* planes, kmUint plane_count, kmUint* mask) {
+    kmUint i;
+
+    for(i = 0; i < plane_count; ++i) {
+        const kmPlane* p = &planes[i];
+        kmScalar far_d, near_d;
+
+        if(!(*mask & (1u << i))) continue;
+
+        /* The corners furthest along and against the normal */
+        far_d = p->a * (p->a >= 0 ? box->max.x : box->min.x) +
+                p->b * (p->b >= 0 ? box->max.y : box->min.y) +
+                p->c * (p->c >= 0 ? box->max.z : box->min.z) + p->d;
+        if(far_d < 0) return KM_FALSE;
+
+        near_d = p->a * (p->a >= 0 ? box->min.x : box->max.x) +
+                 p->b * (p->b >= 0 ? box->min.y : box->max.y) +
+                 p->c * (p->c >= 0 ? box->min.z : box->max.z) + p->d;
+        if(near_d >= 0) *mask &= ~(1u << i);
+    }
+
+    return KM_TRUE;
+}
+
+kmUint kmOctree3QueryPlanes(const kmOctree3* pTree, const kmPlane* planes, kmUint plane_count, kmUint* pOut, kmUint max_out) {
+    kmInt stack[STACK_SIZE];
+    kmUint masks[STACK_SIZE];
+    kmUint top = 0, found = 0;
+    kmAABB3 loose;
+
+    if(plane_count > 32) plane_count = 32;
+
+    stack[top] = 0;
+    masks[top++] = plane_count == 32 ? 0xFFFFFFFFu : (1u << plane_count) - 1u;
+
+    while(top) {
+        const kmOctree3Node* node;
+        kmUint mask;
+        kmInt obj;
+        int i;
+
+        --top;
+        node = &pTree->nodes[stack[top]];
+        mask = masks[top];
+
+        /* Once a node is inside every plane so is everything below it */
+        if(node->parent != INVALID && mask) {
+            loose_bounds(node, &loose);
+            if(!aabb_planes(&loose, planes, plane_count, &mask)) continue;
+        }
+
+        for(obj = node->first_object; obj != INVALID; obj = pTree->objects[obj].next) {
+            kmUint obj_mask = mask;
+            if(aabb_planes(&pTree->objects[obj].bounds, planes, plane_count, &obj_mask)) {
+                found = emit(pOut, max_out, found, (kmUint) obj);
+            }
+        }
+
+        for(i = 0; i < 8; ++i) {
+            if(node->children[i] != INVALID) {
+                stack[top] = node->children[i];
+                masks[top++] = mask;
+            }
+        }
+    }
+
+    return found;
+}
+
+kmUint kmOctree3QueryRay3(const kmOctree3* pTree, const kmRay3* ray, kmUint* pOut, kmUint max_out) {
+    kmInt stack[STACK_SIZE];
+    kmUint top = 0, found = 0;
+    kmRay3Prepared prepared;
+    kmAABB3 loose;
+
+    kmRay3Prepare(&prepared, ray);
+
+    stack[top++] = 0;
+    while(top) {
+        const kmOctree3Node* node = &pTree->nodes[stack[--top]];
+        kmInt obj;
+        int i;
+
+        if(node->parent != INVALID) {
+            loose_bounds(node, &loose);
+            if(!kmRay3PreparedIntersectAABB3(&prepared, &loose, NULL, NULL)) continue;
+        }
+
+        for(obj = node->first_object; obj != INVALID; obj = pTree->objects[obj].next) {
+            if(kmRay3PreparedIntersectAABB3(&prepared, &pTree->objects[obj].bounds, NULL, NULL)) {
+                found = emit(pOut, max_out, found, (kmUint) obj);
+            }
+        }
+
+        for(i = 0; i < 8; ++i) {
+            if(node->children[i] != INVALID) stack[top++] = node->children[i];
+        }
+    }
+
+    return found;
+}
+
+kmUint kmOctree3QueryRay3Packet(const kmOctree3* pTree, const kmRay3Packet* packet, kmUint* pOut, kmUint* pMasks, kmUint max_out) {
+    kmInt stack[STACK_SIZE];
+    kmUint masks[STACK_SIZE];
+    kmUint top = 0, found = 0;
+    kmAABB3 loose;
+
+    stack[top] = 0;
+    masks[top++] = kmRay3PacketMask(packet);
+
+    while(top) {
+        const kmOctree3Node* node;
+        kmUint mask;
+        kmInt obj;
+        int i;
+
+        --top;
+        node = &pTree->nodes[stack[top]];
+        mask = masks[top];
+
+        if(node->parent != INVALID) {
+            loose_bounds(node, &loose);
+            mask = kmRay3PacketIntersectAABB3(packet, mask, &loose, NULL);
+            if(!mask) continue;
+        }
+
+        for(obj = node->first_object; obj != INVALID; obj = pTree->objects[obj].next) {
+            kmUint hits = kmRay3PacketIntersectAABB3(packet, mask, &pTree->objects[obj].bounds, NULL);
+            if(hits) {
+                if(pMasks && found < max_out) pMasks[found] = hits;
+                found = emit(pOut, max_out, found, (kmUint) obj);
+            }
+        }
+
+        for(i = 0; i < 8; ++i) {
+            if(node->children[i] != INVALID) {
+                stack[top] = node->children[i];
+                masks[top++] = mask;
+            }
+        }
+    }
+
+    return found;
+}
+
+static kmScalar aabb_distance_sq(const kmAABB3* box, const kmVec3* p) {
+    kmScalar dist = 0, v;
+
+    v = p->x < box->min.x ? box->min.x - p->x : (p->x > box->max.x ? p->x - box->max.x : 0);
+    dist += v * v;
+    v = p->y < box->min.y ? box->min.y - p->y : (p->y > box->max.y ? p->y - box->max.y : 0);
+    dist += v * v;
+    v = p->z < box->min.z ? box->min.z - p->z : (p->z > box->max.z ? p->z - box->max.z : 0);
+    dist += v * v;
+
+    return dist;
+}
+
+kmUint kmOctree3QueryNearest(const kmOctree3* pTree, const kmVec3* point, kmUint k, kmUint* pOut, kmScalar* pDistancesSq) {
+    kmInt stack[STACK_SIZE];
+    kmScalar stack_dist[STACK_SIZE];
+    kmUint top = 0, found = 0;
+    kmScalar* best;
+    kmAABB3 loose;
+
+    if(!k) return 0;
+    best = pDistancesSq ? pDistancesSq : (kmScalar*) malloc(sizeof(kmScalar) * k);
+
+    stack[top] = 0;
+    stack_dist[top++] = 0;
+
+    while(top) {
+        const kmOctree3Node* node;
+        kmInt children[8];
+        kmScalar child_dist[8];
+        kmUint child_count = 0, i, j;
+        kmInt obj;
+
+        --top;
+        if(found == k && stack_dist[top] > best[k - 1]) continue;
+        node = &pTree->nodes[stack[top]];
+
+        for(obj = node->first_object; obj != INVALID; obj = pTree->objects[obj].next) {
+            kmScalar d = aabb_distance_sq(&pTree->objects[obj].bounds, point);
+
+            if(found == k && d >= best[k - 1]) continue;
+
+            /* Insertion into the sorted list of the best k so far */
+            i = found < k ? found++ : k - 1;
+            while(i > 0 && best[i - 1] > d) {
+                best[i] = best[i - 1];
+                pOut[i] = pOut[i - 1];
+                --i;
+            }
+            best[i] = d;
+            pOut[i] = (kmUint) obj;
+        }
+
+        /* Push the children furthest first so the nearest is visited next */
+        for(i = 0; i < 8; ++i) {
+            kmScalar d;
+            if(node->children[i] == INVALID) continue;
+
+            loose_bounds(&pTree->nodes[node->children[i]], &loose);
+            d = aabb_distance_sq(&loose, point);
+            if(found == k && d > best[k - 1]) continue;
+
+            j = child_count++;
+            while(j > 0 && child_dist[j - 1] < d) {
+                children[j] = children[j - 1];
+                child_dist[j] = child_dist[j - 1];
+                --j;
+            }
+            children[j] = node->children[i];
+            child_dist[j] = d;
+        }
+
+        for(i = 0; i < child_count; ++i) {
+            stack[top] = children[i];
+            stack_dist[top++] = child_dist[i];
+        }
+    }
+
+    if(best != pDistancesSq) free(best);
+
+    return found;
+}
@@ -0,0 +1,171 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_OCTREE3_H_INCLUDED
+#define KAZMATH_OCTREE3_H_INCLUDED
+
+#include "vec3.h"
+#include "aabb3.h"
+#include "utility.h"
+
+struct kmPlane;
+struct kmRay3;
+struct kmRay3Packet;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KM_OCTREE3_MAX_DEPTH 16
+#define KM_OCTREE3_INVALID -1
+
+/*
+ * A loose octree of kmAABB3s. Every node's bounds are twice the size of
+ * its cell, so an object is stored in exactly one node: the deepest one
+ * whose cell is at least as large as the object and contains its centre.
+ * Objects never straddle nodes and moving one rarely changes its node.
+ *
+ * Nodes and objects live in two contiguous pools which grow as needed and
+ * recycle freed slots. Nodes refer to each other, and objects are chained
+ * together, by index into those pools. Objects are identified by a handle
+ * (their pool index) which stays valid until they are removed.
+ *
+ * Objects outside the root cell are kept in the root, which is treated as
+ * unbounded by the queries.
+ */
+typedef struct kmOctree3Node {
+    kmVec3 centre;
+    kmScalar half;              /** Half the width of the (tight) cell */
+    kmUint depth;
+    kmInt parent;
+    kmInt children[8];          /** Indexed by (x >= centre) | (y >= centre) << 1 | (z >= centre) << 2 */
+    kmInt first_object;
+} kmOctree3Node;
+
+typedef struct kmOctree3Object {
+    kmAABB3 bounds;
+    kmInt node;                 /** KM_OCTREE3_INVALID if the slot is free */
+    kmInt prev;
+    kmInt next;
+} kmOctree3Object;
+
+typedef struct kmOctree3 {
+    kmOctree3Node* nodes;
+    kmUint node_count;
+    kmUint node_capacity;
+    kmInt free_node;
+
+    kmOctree3Object* objects;
+    kmUint object_count;        /** Slots in use, including freed ones */
+    kmUint object_capacity;
+    kmInt free_object;
+
+    kmUint max_depth;
+} kmOctree3;
+
+/**
+ * Initializes an empty tree whose root cell is the cube enclosing bounds.
+ * max_depth is clamped to KM_OCTREE3_MAX_DEPTH. Returns pTree.
+ */
+kmOctree3* kmOctree3Initialize(kmOctree3* pTree, const kmAABB3* bounds, kmUint max_depth);
+
+/**
+ * Releases the memory owned by the tree.
+ */
+void kmOctree3Free(kmOctree3* pTree);
+
+/**
+ * Makes sure there is room for object_capacity objects (and a matching
+ * number of nodes) so that inserting them does not reallocate.
+ */
+void kmOctree3Reserve(kmOctree3* pTree, kmUint object_capacity);
+
+/**
+ * Inserts an object and returns its handle.
+ */
+kmUint kmOctree3Insert(kmOctree3* pTree, const kmAABB3* bounds);
+
+/**
+ * Inserts count objects at once, reserving the memory up front. The
+ * handle for bounds[i] is written to pHandles[i] if pHandles is not NULL.
+ */
+void kmOctree3BulkLoad(kmOctree3* pTree, const kmAABB3* bounds, kmUint count, kmUint* pHandles);
+
+/**
+ * Changes the bounds of an object, it only moves to a different node if
+ * it no longer fits the one it is in.
+ */
+void kmOctree3Update(kmOctree3* pTree, kmUint handle, const kmAABB3* bounds);
+
+/**
+ * Removes an object, its handle may be reused by a later insert. Nodes
+ * left empty are returned to the pool.
+ */
+void kmOctree3Remove(kmOctree3* pTree, kmUint handle);
+
+/*
+ * Queries write the handles of matching objects to pOut (at most max_out
+ * of them, in no particular order) and return the total number of matches,
+ * which may be larger than max_out.
+ */
+
+/**
+ * Objects whose bounds overlap box.
+ */
+kmUint kmOctree3QueryAABB3(const kmOctree3* pTree, const kmAABB3* box, kmUint* pOut, kmUint max_out);
+
+/**
+ * Objects whose bounds are not entirely behind any of plane_count (at most
+ * 32) planes with inward facing normals, e.g. the 6 frustum planes from
+ * kmMat4ExtractPlane.
+ */
+kmUint kmOctree3QueryPlanes(const kmOctree3* pTree, const struct kmPlane* planes, kmUint plane_count, kmUint* pOut, kmUint max_out);
+
+/**
+ * Objects whose bounds are hit by the ray.
+ */
+kmUint kmOctree3QueryRay3(const kmOctree3* pTree, const struct kmRay3* ray, kmUint* pOut, kmUint max_out);
+
+/**
+ * Objects whose bounds are hit by any ray of the packet. The lanes which
+ * hit each object are written to pMasks (which may be NULL) alongside
+ * pOut. All rays share the traversal, a node is only skipped once every
+ * lane has missed it.
+ */
+kmUint kmOctree3QueryRay3Packet(const kmOctree3* pTree, const struct kmRay3Packet* packet, kmUint* pOut, kmUint* pMasks, kmUint max_out);
+
+/**
+ * The k objects whose bounds are closest to point, nearest first. Their
+ * squared distances are written to pDistancesSq if it is not NULL. Returns
+ * the number found, which is less than k only if the tree holds fewer
+ * objects.
+ */
+kmUint kmOctree3QueryNearest(const kmOctree3* pTree, const kmVec3* point, kmUint k, kmUint* pOut, kmScalar* pDistancesSq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -195,6 +195,142 @@ KM_POINT_CLASSIFICATION kmPlaneClassifyPoint(const kmPlane* pIn, const kmVec3* p
    return POINT_ON_PLANE;
 }
 
+kmScalar* kmPlaneDotCoordArray(const kmPlane* pP, const kmVec3* points, kmUint count, kmScalar* pDistances) {
+    const kmScalar a = pP->a, b = pP->b, c = pP->c, d = pP->d;
+    kmUint i;
+
+    for(i = 0; i < count; ++i) {
+        pDistances[i] = a * points[i].x + b * points[i].y + c * points[i].z + d;
+    }
+
+    return pDistances;
+}
+
+kmUint kmPlaneClassifyPointArray(const kmPlane* pP, const kmVec3* points, kmUint count, unsigned char* pMasks) {
+    const kmScalar a = pP->a, b = pP->b, c = pP->c, d = pP->d;
+    kmUint i, combined = 0;
+
+    /* Branch free so the loop vectorizes */
+    for(i = 0; i < count; ++i) {
+        kmScalar distance = a * points[i].x + b * points[i].y + c * points[i].z + d;
+        kmUint mask = (distance > kmEpsilon) * KM_PLANE_MASK_FRONT |
+                      (distance < -kmEpsilon) * KM_PLANE_MASK_BEHIND;
+        if(pMasks) pMasks[i] = (unsigned char) mask;
+        combined |= mask;
+    }
+
+    return combined;
+}
+
+kmUint kmPlaneOutcodeArray(const kmPlane* planes, kmUint plane_count, const kmVec3* points,
+                           kmUint count, kmUint* pOutcodes) {
+    kmUint i, j, combined = ~0u;
+
+    if(plane_count > 32) plane_count = 32;
+    if(!count) return 0;
+
+    for(i = 0; i < count; ++i) {
+        const kmVec3* p = &points[i];
+        kmUint code = 0;
+
+        for(j = 0; j < plane_count; ++j) {
+            const kmPlane* plane = &planes[j];
+            code |= (kmUint) (plane->a * p->x + plane->b * p->y + plane->c * p->z + plane->d < 0) << j;
+        }
+
+        if(pOutcodes) pOutcodes[i] = code;
+        combined &= code;
+    }
+
+    return combined;
+}
+
+kmUint kmPlaneClipPolygon(const kmPlane* pP, const kmVec3* in, kmUint count, kmVec3* pOut) {
+    kmUint i, written = 0;
+    const kmVec3* prev;
+    kmScalar prev_dist;
+
+    if(!count) return 0;
+
+    prev = &in[count - 1];
+    prev_dist = kmPlaneDotCoord(pP, prev);
+
+    for(i = 0; i < count; ++i) {
+        const kmVec3* cur = &in[i];
+        kmScalar dist = kmPlaneDotCoord(pP, cur);
+
+        /*
+         * Emit the crossing point only when an edge strictly changes side,
+         * a vertex lying on the plane is kept once below instead
+         */
+        if((prev_dist > 0 && dist < 0) || (prev_dist < 0 && dist > 0)) {
+            kmScalar t = prev_dist / (prev_dist - dist);
+            kmVec3* crossing = &pOut[written++];
+            crossing->x = prev->x + (cur->x - prev->x) * t;
+            crossing->y = prev->y + (cur->y - prev->y) * t;
+            crossing->z = prev->z + (cur->z - prev->z) * t;
+        }
+
+        if(dist >= 0) pOut[written++] = *cur;
+
+        prev = cur;
+        prev_dist = dist;
+    }
+
+    return written;
+}
+
+kmUint kmPlaneClipPolygonPlanes(const kmPlane* planes, kmUint plane_count, const kmVec3* in,
+                                kmUint count, kmVec3* pOut, kmVec3* pScratch) {
+    kmVec3* buffers[2];
+    kmUint i;
+
+    if(!plane_count) {
+        for(i = 0; i < count; ++i) pOut[i] = in[i];
+        return count;
+    }
+
+    /* Alternate between the buffers so the last plane writes to pOut */
+    buffers[0] = (plane_count & 1) ? pOut : pScratch;
+    buffers[1] = (plane_count & 1) ? pScratch : pOut;
+
+    for(i = 0; i < plane_count && count; ++i) {
+        kmVec3* target = buffers[i & 1];
+        count = kmPlaneClipPolygon(&planes[i], in, count, target);
+        in = target;
+    }
+
+    if(in != pOut) {
+        for(i = 0; i < count; ++i) pOut[i] = in[i];
+    }
+
+    return count < 3 ? 0 : count;
+}
+
+kmUint kmPlaneClipTriangle(const kmPlane* pP, const kmVec3* p1, const kmVec3* p2,
+                           const kmVec3* p3, kmVec3* pOut) {
+    kmVec3 triangle[3], polygon[4];
+    kmUint count;
+
+    triangle[0] = *p1;
+    triangle[1] = *p2;
+    triangle[2] = *p3;
+
+    count = kmPlaneClipPolygon(pP, triangle, 3, polygon);
+    if(count < 3) return 0;
+
+    pOut[0] = polygon[0];
+    pOut[1] = polygon[1];
+    pOut[2] = polygon[2];
+    if(count == 3) return 1;
+
+    /* A quad, fan it from the first vertex */
+    pOut[3] = polygon[0];
+    pOut[4] = polygon[2];
+    pOut[5] = polygon[3];
+    return 2;
+}
+
 kmPlane* kmPlaneExtractFromMat4(kmPlane* pOut, const struct kmMat4* pIn, kmInt row) {
     int scale = (row < 0) ? -1 : 1;
 	row = abs(row) - 1;
@@ -83,6 +83,66 @@ kmPlane* kmPlaneScale(kmPlane* pOut, const kmPlane* pP, kmScalar s);
 KM_POINT_CLASSIFICATION kmPlaneClassifyPoint(const kmPlane* pIn,
                                              const struct kmVec3* pP);
 
+/* Bits of the masks written by kmPlaneClassifyPointArray */
+#define KM_PLANE_MASK_FRONT 1
+#define KM_PLANE_MASK_BEHIND 2
+
+/**
+ * Stores the signed distance of each point from the (normalized) plane
+ * in pDistances. Returns pDistances.
+ */
+kmScalar* kmPlaneDotCoordArray(const kmPlane* pP, const struct kmVec3* points,
+                               kmUint count, kmScalar* pDistances);
+
+/**
+ * Classifies count points like kmPlaneClassifyPoint, writing
+ * KM_PLANE_MASK_FRONT, KM_PLANE_MASK_BEHIND or 0 (on the plane) per point
+ * into pMasks, which may be NULL. Returns the masks of all the points
+ * ORed together, so KM_PLANE_MASK_FRONT | KM_PLANE_MASK_BEHIND means the
+ * points straddle the plane.
+ */
+kmUint kmPlaneClassifyPointArray(const kmPlane* pP, const struct kmVec3* points,
+                                 kmUint count, unsigned char* pMasks);
+
+/**
+ * Tests count points against up to 32 planes. Bit i of a point's outcode
+ * is set if it is behind planes[i]; pOutcodes may be NULL. Returns the
+ * outcodes ANDed together, which is non-zero if every point is behind the
+ * same plane (e.g. a polygon outside a portal's frustum).
+ */
+kmUint kmPlaneOutcodeArray(const kmPlane* planes, kmUint plane_count,
+                           const struct kmVec3* points, kmUint count,
+                           kmUint* pOutcodes);
+
+/**
+ * Clips the convex polygon in (count vertices) to the front of the plane
+ * (Sutherland-Hodgman). pOut must have room for count + 1 vertices and
+ * must not overlap in. Returns the number of vertices written, less than
+ * 3 means the polygon was clipped away.
+ */
+kmUint kmPlaneClipPolygon(const kmPlane* pP, const struct kmVec3* in,
+                          kmUint count, struct kmVec3* pOut);
+
+/**
+ * Clips the convex polygon in (count vertices) to the front of every
+ * plane. pOut and pScratch must each have room for count + plane_count
+ * vertices. Returns the number of vertices written to pOut, or 0 if the
+ * polygon was clipped away.
+ */
+kmUint kmPlaneClipPolygonPlanes(const kmPlane* planes, kmUint plane_count,
+                                const struct kmVec3* in, kmUint count,
+                                struct kmVec3* pOut, struct kmVec3* pScratch);
+
+/**
+ * Clips the triangle p1, p2, p3 to the front of the plane and writes the
+ * result as triangles (three vertices each, with the original winding)
+ * to pOut, which needs room for 6 vertices. Returns the number of
+ * triangles, 0 to 2.
+ */
+kmUint kmPlaneClipTriangle(const kmPlane* pP, const struct kmVec3* p1,
+                           const struct kmVec3* p2, const struct kmVec3* p3,
+                           struct kmVec3* pOut);
+
 kmPlane* kmPlaneExtractFromMat4(kmPlane* pOut, const struct kmMat4* pIn,
                                 kmInt row);
 struct kmVec3* kmPlaneGetIntersection(struct kmVec3* pOut, const kmPlane* p1,
@@ -0,0 +1,243 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "profile.h"
+
+static const char* function_names[KM_PROFILE_FUNCTION_COUNT] = {
+    "kmMat4Multiply",
+    "kmMat4Inverse",
+    "kmMat4LookAt",
+    "kmQuaternionMultiply",
+    "kmQuaternionNormalize",
+    "kmQuaternionSlerp",
+    "kmVec3Normalize",
+    "kmVec3TransformCoord"
+};
+
+#ifdef KAZMATH_PROFILE
+
+typedef struct km_profile_event {
+    unsigned long long start;
+    unsigned long long duration;
+    kmProfileFunction function;
+} km_profile_event;
+
+typedef struct km_profile_thread {
+    kmUint calls[KM_PROFILE_FUNCTION_COUNT];
+    unsigned long long nanoseconds[KM_PROFILE_FUNCTION_COUNT];
+    km_profile_event* events;
+    kmUint event_count;
+    kmUint dropped_events;
+    kmUint id;
+    kmBool in_use;
+    struct km_profile_thread* next;
+} km_profile_thread;
+
+static pthread_once_t profile_once = PTHREAD_ONCE_INIT;
+static pthread_key_t profile_key;
+static pthread_mutex_t profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+static km_profile_thread* profile_threads = NULL;
+static kmUint profile_thread_count = 0;
+static unsigned long long profile_epoch = 0;
+static volatile kmBool timers_enabled = KM_FALSE;
+
+static unsigned long long now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + (unsigned long long) ts.tv_nsec;
+}
+
+/* Buffers outlive their threads so that their counts still show up in
+ * snapshots; a finished thread's buffer is handed to the next new one */
+static void release_thread(void* arg) {
+    pthread_mutex_lock(&profile_mutex);
+    ((km_profile_thread*) arg)->in_use = KM_FALSE;
+    pthread_mutex_unlock(&profile_mutex);
+}
+
+static void create_key(void) {
+    pthread_key_create(&profile_key, release_thread);
+    profile_epoch = now();
+}
+
+static km_profile_thread* current_thread() {
+    km_profile_thread* thread;
+
+    pthread_once(&profile_once, create_key);
+    thread = (km_profile_thread*) pthread_getspecific(profile_key);
+    if(thread) return thread;
+
+    pthread_mutex_lock(&profile_mutex);
+    for(thread = profile_threads; thread; thread = thread->next) {
+        if(!thread->in_use) break;
+    }
+
+    if(!thread) {
+        thread = (km_profile_thread*) calloc(1, sizeof(km_profile_thread));
+        thread->events = (km_profile_event*) malloc(sizeof(km_profile_event) * KM_PROFILE_EVENT_CAPACITY);
+        thread->id = profile_thread_count++;
+        thread->next = profile_threads;
+        profile_threads = thread;
+    }
+    thread->in_use = KM_TRUE;
+    pthread_mutex_unlock(&profile_mutex);
+
+    pthread_setspecific(profile_key, thread);
+    return thread;
+}
+
+unsigned long long kmProfileBegin(kmProfileFunction function) {
+    current_thread()->calls[function]++;
+    return timers_enabled ? now() : 0;
+}
+
+void kmProfileEnd(kmProfileFunction function, unsigned long long start) {
+    km_profile_thread* thread;
+    unsigned long long duration;
+
+    if(!start) return;
+
+    duration = now() - start;
+    thread = current_thread();
+    thread->nanoseconds[function] += duration;
+
+    if(thread->event_count < KM_PROFILE_EVENT_CAPACITY) {
+        km_profile_event* event = &thread->events[thread->event_count++];
+        event->start = start;
+        event->duration = duration;
+        event->function = function;
+    } else {
+        thread->dropped_events++;
+    }
+}
+
+#endif
+
+void kmProfileSetTimersEnabled(kmBool enabled) {
+#ifdef KAZMATH_PROFILE
+    timers_enabled = enabled;
+#else
+    (void) enabled;
+#endif
+}
+
+kmBool kmProfileTakeSnapshot(kmProfileSnapshot* pOut) {
+    kmUint i;
+
+    memset(pOut, 0, sizeof(kmProfileSnapshot));
+    for(i = 0; i < KM_PROFILE_FUNCTION_COUNT; ++i) {
+        pOut->functions[i].name = function_names[i];
+    }
+
+#ifdef KAZMATH_PROFILE
+    {
+        km_profile_thread* thread;
+
+        pthread_mutex_lock(&profile_mutex);
+        for(thread = profile_threads; thread; thread = thread->next) {
+            for(i = 0; i < KM_PROFILE_FUNCTION_COUNT; ++i) {
+                pOut->functions[i].calls += thread->calls[i];
+                pOut->functions[i].seconds += (double) thread->nanoseconds[i] * 1e-9;
+            }
+            pOut->dropped_events += thread->dropped_events;
+            pOut->threads++;
+        }
+        pthread_mutex_unlock(&profile_mutex);
+    }
+    return KM_TRUE;
+#else
+    return KM_FALSE;
+#endif
+}
+
+void kmProfileReset(void) {
+#ifdef KAZMATH_PROFILE
+    km_profile_thread* thread;
+
+    pthread_mutex_lock(&profile_mutex);
+    for(thread = profile_threads; thread; thread = thread->next) {
+        memset(thread->calls, 0, sizeof(thread->calls));
+        memset(thread->nanoseconds, 0, sizeof(thread->nanoseconds));
+        thread->event_count = 0;
+        thread->dropped_events = 0;
+    }
+    pthread_mutex_unlock(&profile_mutex);
+#endif
+}
+
+int kmProfileSnapshotToJSON(const kmProfileSnapshot* pSnapshot, char* buffer, size_t size) {
+    int length;
+    kmUint i;
+
+    /* Like snprintf, keep counting once the buffer is full */
+#define REMAINING buffer + ((size_t) length < size ? length : 0), (size_t) length < size ? size - length : 0
+    length = snprintf(buffer, size, "{\"threads\":%u,\"dropped_events\":%u,\"functions\":{",
+                      pSnapshot->threads, pSnapshot->dropped_events);
+    for(i = 0; i < KM_PROFILE_FUNCTION_COUNT; ++i) {
+        length += snprintf(REMAINING, "%s\"%s\":{\"calls\":%u,\"seconds\":%.9f}", i ? "," : "",
+                           pSnapshot->functions[i].name, pSnapshot->functions[i].calls,
+                           pSnapshot->functions[i].seconds);
+    }
+    length += snprintf(REMAINING, "}}");
+#undef REMAINING
+
+    return length;
+}
+
+kmUint kmProfileWriteChromeTrace(FILE* file) {
+    kmUint written = 0;
+
+    fprintf(file, "{\"traceEvents\":[");
+
+#ifdef KAZMATH_PROFILE
+    {
+        km_profile_thread* thread;
+        kmUint i;
+
+        pthread_mutex_lock(&profile_mutex);
+        for(thread = profile_threads; thread; thread = thread->next) {
+            for(i = 0; i < thread->event_count; ++i) {
+                const km_profile_event* event = &thread->events[i];
+
+                /* Timestamps are in microseconds */
+                fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                        written ? "," : "", function_names[event->function],
+                        (double) (event->start - profile_epoch) * 1e-3, (double) event->duration * 1e-3,
+                        thread->id);
+                ++written;
+            }
+        }
+        pthread_mutex_unlock(&profile_mutex);
+    }
+#endif
+
+    fprintf(file, "\n]}\n");
+    return written;
+}
@@ -0,0 +1,117 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_PROFILE_H_INCLUDED
+#define KAZMATH_PROFILE_H_INCLUDED
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "utility.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Call counting for the hottest kazmath functions. Everything here is only
+ * compiled in when KAZMATH_PROFILE is defined (the CMake option of the
+ * same name); otherwise the hooks in the instrumented functions expand to
+ * nothing and the functions below report no data.
+ *
+ * Each thread counts into its own buffer, the buffers are summed when a
+ * snapshot is taken. Snapshots and resets don't stop other threads, so
+ * they are only exact while no instrumented calls are running.
+ */
+typedef enum kmProfileFunction {
+    KM_PROFILE_MAT4_MULTIPLY,
+    KM_PROFILE_MAT4_INVERSE,
+    KM_PROFILE_MAT4_LOOK_AT,
+    KM_PROFILE_QUATERNION_MULTIPLY,
+    KM_PROFILE_QUATERNION_NORMALIZE,
+    KM_PROFILE_QUATERNION_SLERP,
+    KM_PROFILE_VEC3_NORMALIZE,
+    KM_PROFILE_VEC3_TRANSFORM_COORD,
+    KM_PROFILE_FUNCTION_COUNT
+} kmProfileFunction;
+
+/** The most timed calls kept per thread for kmProfileWriteChromeTrace */
+#define KM_PROFILE_EVENT_CAPACITY 4096
+
+typedef struct kmProfileEntry {
+    const char* name;
+    kmUint calls;
+    double seconds;             /** Zero unless timers were enabled */
+} kmProfileEntry;
+
+typedef struct kmProfileSnapshot {
+    kmProfileEntry functions[KM_PROFILE_FUNCTION_COUNT];
+    kmUint threads;             /** Threads that made instrumented calls */
+    kmUint dropped_events;      /** Timed calls that didn't fit in the trace */
+} kmProfileSnapshot;
+
+/**
+ * Timing reads the clock twice per call and records an event for the
+ * trace, so it is off until enabled here. Counting is always on.
+ */
+void kmProfileSetTimersEnabled(kmBool enabled);
+
+/**
+ * Sums the buffers of every thread into pOut. Returns KM_FALSE if
+ * profiling wasn't compiled in, leaving only the names filled in.
+ */
+kmBool kmProfileTakeSnapshot(kmProfileSnapshot* pOut);
+void kmProfileReset(void);
+
+/**
+ * Writes a snapshot as a JSON object. Returns the length of the whole
+ * object, like snprintf, so a return value of size or more means that it
+ * was truncated.
+ */
+int kmProfileSnapshotToJSON(const kmProfileSnapshot* pSnapshot, char* buffer, size_t size);
+
+/**
+ * Writes the recorded timed calls in the Chrome trace event format, one
+ * complete ("X") event per call with the thread as tid. Returns the
+ * number of events written.
+ */
+kmUint kmProfileWriteChromeTrace(FILE* file);
+
+#ifdef KAZMATH_PROFILE
+unsigned long long kmProfileBegin(kmProfileFunction function);
+void kmProfileEnd(kmProfileFunction function, unsigned long long start);
+
+#define KM_PROFILE_BEGIN(function) unsigned long long km_profile_start = kmProfileBegin(function)
+#define KM_PROFILE_END(function) kmProfileEnd(function, km_profile_start)
+#else
+#define KM_PROFILE_BEGIN(function)
+#define KM_PROFILE_END(function)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
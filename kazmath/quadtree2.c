@@ -0,0 +1,393 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "quadtree2.h"
+#include "ray2.h"
+
+#define INVALID KM_QUADTREE2_INVALID
+#define STACK_SIZE (3 * KM_QUADTREE2_MAX_DEPTH + 4)
+
+static kmInt alloc_node(kmQuadtree2* pTree, kmInt parent, const kmVec2* centre, kmScalar half, kmUint depth) {
+    kmInt index;
+    kmQuadtree2Node* node;
+    int i;
+
+    if(pTree->free_node != INVALID) {
+        index = pTree->free_node;
+        pTree->free_node = pTree->nodes[index].parent;
+    } else {
+        if(pTree->node_count == pTree->node_capacity) {
+            pTree->node_capacity = pTree->node_capacity ? pTree->node_capacity * 2 : 16;
+            pTree->nodes = (kmQuadtree2Node*) realloc(pTree->nodes, sizeof(kmQuadtree2Node) * pTree->node_capacity);
+        }
+        index = (kmInt) pTree->node_count++;
+    }
+
+    node = &pTree->nodes[index];
+    node->centre = *centre;
+    node->half = half;
+    node->depth = depth;
+    node->parent = parent;
+    node->first_object = INVALID;
+    for(i = 0; i < 4; ++i) {
+        node->children[i] = INVALID;
+    }
+
+    return index;
+}
+
+static kmInt alloc_object(kmQuadtree2* pTree) {
+    kmInt index;
+
+    if(pTree->free_object != INVALID) {
+        index = pTree->free_object;
+        pTree->free_object = pTree->objects[index].next;
+        return index;
+    }
+
+    if(pTree->object_count == pTree->object_capacity) {
+        pTree->object_capacity = pTree->object_capacity ? pTree->object_capacity * 2 : 16;
+        pTree->objects = (kmQuadtree2Object*) realloc(pTree->objects, sizeof(kmQuadtree2Object) * pTree->object_capacity);
+    }
+
+    return (kmInt) pTree->object_count++;
+}
+
+static kmScalar max_half_extent(const kmAABB2* box) {
+    return kmMax(box->max.x - box->min.x, box->max.y - box->min.y) * 0.5;
+}
+
+static kmBool cell_contains(const kmQuadtree2Node* node, const kmVec2* p) {
+    return fabs(p->x - node->centre.x) <= node->half &&
+           fabs(p->y - node->centre.y) <= node->half;
+}
+
+static int child_slot(const kmQuadtree2Node* node, const kmVec2* p) {
+    return (p->x >= node->centre.x ? 1 : 0) |
+           (p->y >= node->centre.y ? 2 : 0);
+}
+
+static void loose_bounds(const kmQuadtree2Node* node, kmAABB2* pOut) {
+    kmScalar h = node->half * 2;
+    kmVec2Fill(&pOut->min, node->centre.x - h, node->centre.y - h);
+    kmVec2Fill(&pOut->max, node->centre.x + h, node->centre.y + h);
+}
+
+static kmBool fits_node(const kmQuadtree2* pTree, const kmQuadtree2Node* node, const kmVec2* centre, kmScalar size) {
+    if(!cell_contains(node, centre) || size > node->half) {
+        /* Only the root holds objects too big or outside of its cell */
+        return node->parent == INVALID;
+    }
+
+    return node->depth == pTree->max_depth || size > node->half * 0.5;
+}
+
+static kmInt target_node(kmQuadtree2* pTree, const kmAABB2* bounds) {
+    kmVec2 centre;
+    kmScalar size = max_half_extent(bounds);
+    kmInt index = 0;
+
+    kmAABB2Centre(bounds, &centre);
+
+    while(!fits_node(pTree, &pTree->nodes[index], &centre, size)) {
+        const kmQuadtree2Node* node = &pTree->nodes[index];
+        int slot = child_slot(node, &centre);
+        kmInt child = node->children[slot];
+
+        if(child == INVALID) {
+            kmScalar h = node->half * 0.5;
+            kmVec2 c;
+            kmVec2Fill(&c,
+                node->centre.x + ((slot & 1) ? h : -h),
+                node->centre.y + ((slot & 2) ? h : -h));
+
+            child = alloc_node(pTree, index, &c, h, node->depth + 1);
+            pTree->nodes[index].children[slot] = child;
+        }
+
+        index = child;
+    }
+
+    return index;
+}
+
+static void link_object(kmQuadtree2* pTree, kmInt handle, kmInt node) {
+    kmQuadtree2Object* obj = &pTree->objects[handle];
+    kmInt head = pTree->nodes[node].first_object;
+
+    obj->node = node;
+    obj->prev = INVALID;
+    obj->next = head;
+    if(head != INVALID) {
+        pTree->objects[head].prev = handle;
+    }
+    pTree->nodes[node].first_object = handle;
+}
+
+static void unlink_object(kmQuadtree2* pTree, kmInt handle) {
+    kmQuadtree2Object* obj = &pTree->objects[handle];
+
+    if(obj->prev != INVALID) {
+        pTree->objects[obj->prev].next = obj->next;
+    } else {
+        pTree->nodes[obj->node].first_object = obj->next;
+    }
+
+    if(obj->next != INVALID) {
+        pTree->objects[obj->next].prev = obj->prev;
+    }
+}
+
+static void prune(kmQuadtree2* pTree, kmInt index) {
+    while(index != 0) {
+        kmQuadtree2Node* node = &pTree->nodes[index];
+        kmInt parent = node->parent;
+        int i;
+
+        if(node->first_object != INVALID) return;
+        for(i = 0; i < 4; ++i) {
+            if(node->children[i] != INVALID) return;
+        }
+
+        for(i = 0; i < 4; ++i) {
+            if(pTree->nodes[parent].children[i] == index) {
+                pTree->nodes[parent].children[i] = INVALID;
+            }
+        }
+
+        node->parent = pTree->free_node;
+        pTree->free_node = index;
+        index = parent;
+    }
+}
+
+kmQuadtree2* kmQuadtree2Initialize(kmQuadtree2* pTree, const kmAABB2* bounds, kmUint max_depth) {
+    kmVec2 centre;
+
+    memset(pTree, 0, sizeof(kmQuadtree2));
+    pTree->free_node = INVALID;
+    pTree->free_object = INVALID;
+    pTree->max_depth = max_depth > KM_QUADTREE2_MAX_DEPTH ? KM_QUADTREE2_MAX_DEPTH : max_depth;
+
+    kmAABB2Centre(bounds, &centre);
+    alloc_node(pTree, INVALID, &centre, max_half_extent(bounds), 0);
+
+    return pTree;
+}
+
+void kmQuadtree2Free(kmQuadtree2* pTree) {
+    free(pTree->nodes);
+    free(pTree->objects);
+    memset(pTree, 0, sizeof(kmQuadtree2));
+    pTree->free_node = INVALID;
+    pTree->free_object = INVALID;
+}
+
+void kmQuadtree2Reserve(kmQuadtree2* pTree, kmUint object_capacity) {
+    if(object_capacity > pTree->object_capacity) {
+        pTree->object_capacity = object_capacity;
+        pTree->objects = (kmQuadtree2Object*) realloc(pTree->objects, sizeof(kmQuadtree2Object) * object_capacity);
+    }
+
+    if(object_capacity + 1 > pTree->node_capacity) {
+        pTree->node_capacity = object_capacity + 1;
+        pTree->nodes = (kmQuadtree2Node*) realloc(pTree->nodes, sizeof(kmQuadtree2Node) * pTree->node_capacity);
+    }
+}
+
+kmUint kmQuadtree2Insert(kmQuadtree2* pTree, const kmAABB2* bounds) {
+    kmInt handle = alloc_object(pTree);
+
+    kmAABB2Assign(&pTree->objects[handle].bounds, bounds);
+    link_object(pTree, handle, target_node(pTree, bounds));
+
+    return (kmUint) handle;
+}
+
+void kmQuadtree2BulkLoad(kmQuadtree2* pTree, const kmAABB2* bounds, kmUint count, kmUint* pHandles) {
+    kmUint i;
+
+    kmQuadtree2Reserve(pTree, pTree->object_count + count);
+
+    for(i = 0; i < count; ++i) {
+        kmUint handle = kmQuadtree2Insert(pTree, &bounds[i]);
+        if(pHandles) pHandles[i] = handle;
+    }
+}
+
+void kmQuadtree2Update(kmQuadtree2* pTree, kmUint handle, const kmAABB2* bounds) {
+    kmQuadtree2Object* obj = &pTree->objects[handle];
+    kmInt old_node = obj->node;
+    kmVec2 centre;
+
+    kmAABB2Assign(&obj->bounds, bounds);
+    kmAABB2Centre(bounds, &centre);
+
+    if(fits_node(pTree, &pTree->nodes[old_node], &centre, max_half_extent(bounds))) {
+        return;
+    }
+
+    unlink_object(pTree, (kmInt) handle);
+    link_object(pTree, (kmInt) handle, target_node(pTree, bounds));
+    prune(pTree, old_node);
+}
+
+void kmQuadtree2Remove(kmQuadtree2* pTree, kmUint handle) {
+    kmQuadtree2Object* obj = &pTree->objects[handle];
+    kmInt node = obj->node;
+
+    unlink_object(pTree, (kmInt) handle);
+
+    obj->node = INVALID;
+    obj->next = pTree->free_object;
+    pTree->free_object = (kmInt) handle;
+
+    prune(pTree, node);
+}
+
+/*
+ * Collects the objects overlapping box. If self is a valid handle only
+ * objects with a larger handle are reported, as (self, other) pairs.
+ */
+static kmUint query_box(const kmQuadtree2* pTree, const kmAABB2* box, kmInt self,
+                        kmUint* pOut, kmUint max_out, kmUint found) {
+    kmInt stack[STACK_SIZE];
+    kmUint top = 0;
+    kmAABB2 loose;
+
+    stack[top++] = 0;
+    while(top) {
+        const kmQuadtree2Node* node = &pTree->nodes[stack[--top]];
+        kmInt obj;
+        int i;
+
+        if(node->parent != INVALID) {
+            loose_bounds(node, &loose);
+            if(!kmAABB2IntersectsAABB(&loose, box)) continue;
+        }
+
+        for(obj = node->first_object; obj != INVALID; obj = pTree->objects[obj].next) {
+            if(obj <= self || !kmAABB2IntersectsAABB(&pTree->objects[obj].bounds, box)) continue;
+
+            if(found < max_out) {
+                if(self == INVALID) {
+                    pOut[found] = (kmUint) obj;
+                } else {
+                    pOut[found * 2] = (kmUint) self;
+                    pOut[found * 2 + 1] = (kmUint) obj;
+                }
+            }
+            ++found;
+        }
+
+        for(i = 0; i < 4; ++i) {
+            if(node->children[i] != INVALID) stack[top++] = node->children[i];
+        }
+    }
+
+    return found;
+}
+
+kmUint kmQuadtree2QueryAABB2(const kmQuadtree2* pTree, const kmAABB2* box, kmUint* pOut, kmUint max_out) {
+    return query_box(pTree, box, INVALID, pOut, max_out, 0);
+}
+
+kmUint kmQuadtree2QueryAABB2Array(const kmQuadtree2* pTree, const kmAABB2* queries, kmUint count,
+                                  kmUint* pOffsets, kmUint* pOut, kmUint max_out) {
+    kmUint i, found = 0;
+
+    for(i = 0; i < count; ++i) {
+        pOffsets[i] = found;
+        /* Shifting the output keeps each query's matches contiguous */
+        found += query_box(pTree, &queries[i], INVALID, pOut + (found < max_out ? found : max_out),
+                           found < max_out ? max_out - found : 0, 0);
+    }
+    pOffsets[count] = found;
+
+    return found;
+}
+
+kmUint kmQuadtree2QueryPairs(const kmQuadtree2* pTree, kmUint* pOut, kmUint max_pairs) {
+    kmUint i, found = 0;
+
+    for(i = 0; i < pTree->object_count; ++i) {
+        const kmQuadtree2Object* obj = &pTree->objects[i];
+        if(obj->node == INVALID) continue;
+        found = query_box(pTree, &obj->bounds, (kmInt) i, pOut, max_pairs, found);
+    }
+
+    return found;
+}
+
+/* Slab test of an unbounded ray against a box */
+static kmBool ray_hits_box(const kmVec2* start, const kmVec2* inv_dir, const kmAABB2* box) {
+    kmScalar t1 = (box->min.x - start->x) * inv_dir->x;
+    kmScalar t2 = (box->max.x - start->x) * inv_dir->x;
+    kmScalar t3 = (box->min.y - start->y) * inv_dir->y;
+    kmScalar t4 = (box->max.y - start->y) * inv_dir->y;
+
+    kmScalar tmin = kmMax(kmMin(t1, t2), kmMin(t3, t4));
+    kmScalar tmax = kmMin(kmMax(t1, t2), kmMax(t3, t4));
+
+    return tmax >= 0 && tmin <= tmax;
+}
+
+kmUint kmQuadtree2QueryRay2(const kmQuadtree2* pTree, const kmRay2* ray, kmUint* pOut, kmUint max_out) {
+    kmInt stack[STACK_SIZE];
+    kmUint top = 0, found = 0;
+    kmAABB2 loose;
+    kmVec2 inv_dir;
+
+    kmVec2Fill(&inv_dir, 1.0 / ray->dir.x, 1.0 / ray->dir.y);
+
+    stack[top++] = 0;
+    while(top) {
+        const kmQuadtree2Node* node = &pTree->nodes[stack[--top]];
+        kmInt obj;
+        int i;
+
+        if(node->parent != INVALID) {
+            loose_bounds(node, &loose);
+            if(!ray_hits_box(&ray->start, &inv_dir, &loose)) continue;
+        }
+
+        for(obj = node->first_object; obj != INVALID; obj = pTree->objects[obj].next) {
+            const kmAABB2* bounds = &pTree->objects[obj].bounds;
+            if(ray_hits_box(&ray->start, &inv_dir, bounds) && kmRay2IntersectAABB2(ray, bounds, NULL, NULL)) {
+                if(found < max_out) pOut[found] = (kmUint) obj;
+                ++found;
+            }
+        }
+
+        for(i = 0; i < 4; ++i) {
+            if(node->children[i] != INVALID) stack[top++] = node->children[i];
+        }
+    }
+
+    return found;
+}
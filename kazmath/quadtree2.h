@@ -0,0 +1,118 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_QUADTREE2_H_INCLUDED
+#define KAZMATH_QUADTREE2_H_INCLUDED
+
+#include "vec2.h"
+#include "aabb2.h"
+#include "utility.h"
+
+struct kmRay2;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KM_QUADTREE2_MAX_DEPTH 16
+#define KM_QUADTREE2_INVALID -1
+
+/*
+ * A loose quadtree of kmAABB2s, the 2D counterpart of kmOctree3 (see
+ * octree3.h). Nodes and objects are kept in two flat pools and linked by
+ * index; object handles are indices into the object pool.
+ */
+typedef struct kmQuadtree2Node {
+    kmVec2 centre;
+    kmScalar half;              /** Half the width of the (tight) cell */
+    kmUint depth;
+    kmInt parent;
+    kmInt children[4];          /** Indexed by (x >= centre) | (y >= centre) << 1 */
+    kmInt first_object;
+} kmQuadtree2Node;
+
+typedef struct kmQuadtree2Object {
+    kmAABB2 bounds;
+    kmInt node;                 /** KM_QUADTREE2_INVALID if the slot is free */
+    kmInt prev;
+    kmInt next;
+} kmQuadtree2Object;
+
+typedef struct kmQuadtree2 {
+    kmQuadtree2Node* nodes;
+    kmUint node_count;
+    kmUint node_capacity;
+    kmInt free_node;
+
+    kmQuadtree2Object* objects;
+    kmUint object_count;        /** Slots in use, including freed ones */
+    kmUint object_capacity;
+    kmInt free_object;
+
+    kmUint max_depth;
+} kmQuadtree2;
+
+kmQuadtree2* kmQuadtree2Initialize(kmQuadtree2* pTree, const kmAABB2* bounds, kmUint max_depth);
+void kmQuadtree2Free(kmQuadtree2* pTree);
+void kmQuadtree2Reserve(kmQuadtree2* pTree, kmUint object_capacity);
+
+kmUint kmQuadtree2Insert(kmQuadtree2* pTree, const kmAABB2* bounds);
+void kmQuadtree2BulkLoad(kmQuadtree2* pTree, const kmAABB2* bounds, kmUint count, kmUint* pHandles);
+void kmQuadtree2Update(kmQuadtree2* pTree, kmUint handle, const kmAABB2* bounds);
+void kmQuadtree2Remove(kmQuadtree2* pTree, kmUint handle);
+
+/*
+ * As with kmOctree3, queries write up to max_out handles to pOut and
+ * return the total number of matches.
+ */
+kmUint kmQuadtree2QueryAABB2(const kmQuadtree2* pTree, const kmAABB2* box, kmUint* pOut, kmUint max_out);
+
+/**
+ * Runs count box queries. The matches for queries[i] are written to
+ * pOut[pOffsets[i]] .. pOut[pOffsets[i + 1] - 1], so pOffsets must hold
+ * count + 1 entries. Returns the total number of matches; if that is more
+ * than max_out the offsets are still correct but pOut is truncated.
+ */
+kmUint kmQuadtree2QueryAABB2Array(const kmQuadtree2* pTree, const kmAABB2* queries, kmUint count,
+                                  kmUint* pOffsets, kmUint* pOut, kmUint max_out);
+
+/**
+ * Objects the ray hits, as decided by kmRay2IntersectBox (which only
+ * reports boxes hit from the outside).
+ */
+kmUint kmQuadtree2QueryRay2(const kmQuadtree2* pTree, const struct kmRay2* ray, kmUint* pOut, kmUint max_out);
+
+/**
+ * Finds every pair of overlapping objects. Each pair is written once, as
+ * two consecutive handles with the smaller first, so pOut must hold
+ * 2 * max_pairs entries. Returns the total number of pairs.
+ */
+kmUint kmQuadtree2QueryPairs(const kmQuadtree2* pTree, kmUint* pOut, kmUint max_pairs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
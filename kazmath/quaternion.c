@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mat3.h"
 #include "vec3.h"
 #include "quaternion.h"
+#include "profile.h"
 
 int kmQuaternionAreEqual(const kmQuaternion* p1, const kmQuaternion* p2) {
     if((!kmAlmostEqual(p1->x, p2->x)) || (!kmAlmostEqual(p1->y, p2->y)) || (!kmAlmostEqual(p1->z, p2->z)) || (!kmAlmostEqual(p1->w, p2->w))) {
@@ -136,6 +137,8 @@ kmQuaternion* kmQuaternionMultiply(kmQuaternion* pOut,
     kmQuaternion* q1 = NULL;
     kmQuaternion* q2 = NULL;
     kmQuaternion tmp1, tmp2;
+    KM_PROFILE_BEGIN(KM_PROFILE_QUATERNION_MULTIPLY);
+
     kmQuaternionAssign(&tmp1, qu1);
     kmQuaternionAssign(&tmp2, qu2);
 
@@ -148,13 +151,17 @@ kmQuaternion* kmQuaternionMultiply(kmQuaternion* pOut,
 	pOut->z = q1->w * q2->z + q1->z * q2->w + q1->x * q2->y - q1->y * q2->x;
     pOut->w = q1->w * q2->w - q1->x * q2->x - q1->y * q2->y - q1->z * q2->z;
 
+	KM_PROFILE_END(KM_PROFILE_QUATERNION_MULTIPLY);
 	return pOut;
 }
 
 kmQuaternion* kmQuaternionNormalize(kmQuaternion* pOut,
                                     const kmQuaternion* pIn)
 {
-	kmScalar length = kmQuaternionLength(pIn);
+	kmScalar length;
+    KM_PROFILE_BEGIN(KM_PROFILE_QUATERNION_NORMALIZE);
+
+	length = kmQuaternionLength(pIn);
 
     if (fabs(length) < kmEpsilon)
     {
@@ -163,6 +170,7 @@ kmQuaternion* kmQuaternionNormalize(kmQuaternion* pOut,
         pOut->z = 0.0;
         pOut->w = 0.0;
 
+        KM_PROFILE_END(KM_PROFILE_QUATERNION_NORMALIZE);
         return pOut;
     }
 
@@ -173,6 +181,7 @@ kmQuaternion* kmQuaternionNormalize(kmQuaternion* pOut,
         pIn->w / length
     );
 
+	KM_PROFILE_END(KM_PROFILE_QUATERNION_NORMALIZE);
 	return pOut;
 }
 
@@ -180,13 +189,13 @@ kmQuaternion* kmQuaternionRotationAxisAngle(kmQuaternion* pOut,
                                             const kmVec3* pV,
                                             kmScalar angle)
 {
-	kmScalar rad = angle * 0.5f;
-	kmScalar scale	= sinf(rad);
+	kmScalar scale, c;
+	kmSinCos(angle * 0.5f, &scale, &c);
 
 	pOut->x = pV->x * scale;
 	pOut->y = pV->y * scale;
 	pOut->z = pV->z * scale;
-	pOut->w = cosf(rad);
+	pOut->w = c;
 
 	kmQuaternionNormalize(pOut, pOut);
 
@@ -317,23 +326,20 @@ kmQuaternion* kmQuaternionRotationPitchYawRoll(kmQuaternion* pOut,
                                                 kmScalar yaw,
 												kmScalar roll)
 {
-    float sY;
-    float cY;
-    float sZ;
-    float cZ;
-    float sX;
-    float cX;
+    kmScalar sY;
+    kmScalar cY;
+    kmScalar sZ;
+    kmScalar cZ;
+    kmScalar sX;
+    kmScalar cX;
     assert(pitch <= 2*kmPI);
     assert(yaw <= 2*kmPI);
     assert(roll <= 2*kmPI);
 
     /* Finds the Sin and Cosin for each half angles.*/
-    sY = sinf(yaw * 0.5);
-    cY = cosf(yaw * 0.5);
-    sZ = sinf(roll * 0.5);
-    cZ = cosf(roll * 0.5);
-    sX = sinf(pitch * 0.5);
-    cX = cosf(pitch * 0.5);
+    kmSinCos(yaw * 0.5, &sY, &cY);
+    kmSinCos(roll * 0.5, &sZ, &cZ);
+    kmSinCos(pitch * 0.5, &sX, &cX);
 
     /* Formula to construct a new Quaternion based on Euler Angles.*/
     pOut->w = cY * cZ * cX - sY * sZ * sX;
@@ -358,6 +364,8 @@ kmQuaternion* kmQuaternionSlerp(kmQuaternion* pOut,
     kmScalar dot = kmQuaternionDot(q1, q2);
     const double DOT_THRESHOLD = 0.9995;
 
+    KM_PROFILE_BEGIN(KM_PROFILE_QUATERNION_SLERP);
+
     if (dot > DOT_THRESHOLD) {
         kmQuaternion diff;
         kmQuaternionSubtract(&diff, q2, q1);
@@ -365,6 +373,7 @@ kmQuaternion* kmQuaternionSlerp(kmQuaternion* pOut,
 
         kmQuaternionAdd(pOut, q1, &diff);
         kmQuaternionNormalize(pOut, pOut);
+        KM_PROFILE_END(KM_PROFILE_QUATERNION_SLERP);
         return pOut;
     }
 
@@ -382,6 +391,7 @@ kmQuaternion* kmQuaternionSlerp(kmQuaternion* pOut,
 
     kmQuaternionAdd(pOut, &t1, &t2);
 
+	KM_PROFILE_END(KM_PROFILE_QUATERNION_SLERP);
 	return pOut;
 }
 
@@ -396,8 +406,8 @@ void kmQuaternionToAxisAngle(const kmQuaternion* pIn, kmVec3* pAxis, kmScalar* p
 		kmQuaternionAssign(&tmp, pIn);
 	}
 
-	*pAngle = 2.0 * acosf(tmp.w);
-	scale = sqrtf(1.0 - kmSQR(tmp.w));
+	*pAngle = 2.0 * kmAcos(tmp.w);
+	scale = kmSqrt(1.0 - kmSQR(tmp.w));
 
 	if (scale < kmEpsilon) {	/* angle is 0 or 360 so just simply set axis to 0,0,1 with angle 0*/
 		pAxis->x = 0.0f;
@@ -497,7 +507,7 @@ kmQuaternion* kmQuaternionRotationBetweenVec3(kmQuaternion* pOut,
             kmQuaternionRotationAxisAngle(pOut, &axis, kmPI);
 		}
 	} else {
-		kmScalar s = sqrtf((1+a) * 2);
+		kmScalar s = kmSqrt((1+a) * 2);
 		kmScalar invs = 1 / s;
 
 		kmVec3 c;
@@ -604,7 +614,7 @@ kmQuaternion* kmQuaternionBetweenVec3(kmQuaternion* pOut, const kmVec3* u, const
         return pOut;
     }
 
-    len = sqrtf(kmVec3LengthSq(u) * kmVec3LengthSq(v));
+    len = kmSqrt(kmVec3LengthSq(u) * kmVec3LengthSq(v));
     kmVec3Cross(&w, u, v);
 
     kmQuaternionFill(&q, w.x, w.y, w.z, kmVec3Dot(u, v) + len);
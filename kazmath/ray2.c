@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include "ray2.h"
+#include "aabb2.h"
 
 void kmRay2Fill(kmRay2* ray, kmScalar px, kmScalar py, kmScalar vx, kmScalar vy) {
     ray->start.x = px;
@@ -257,6 +258,20 @@ kmVec2* intersection, kmVec2* normal_out) {
     return intersected;    
 }
 
+kmBool kmRay2IntersectAABB2(const kmRay2* ray, const kmAABB2* box, kmVec2* intersection, kmVec2* normal_out) {
+    kmVec2 p2, p4, hit;
+
+    kmVec2Fill(&p2, box->max.x, box->min.y);
+    kmVec2Fill(&p4, box->min.x, box->max.y);
+
+    if(!kmRay2IntersectBox(ray, &box->min, &p2, &box->max, &p4, &hit, normal_out)) {
+        return KM_FALSE;
+    }
+
+    if(intersection) *intersection = hit;
+    return KM_TRUE;
+}
+
 kmBool kmRay2IntersectCircle(const kmRay2* ray, const kmVec2 centre, const kmScalar radius, kmVec2* intersection) {
     assert(0 && "Not implemented");
     return KM_TRUE;
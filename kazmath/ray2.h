@@ -33,6 +33,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 extern "C" {
 #endif
 
+struct kmAABB2;
+
 typedef struct kmRay2 {
     kmVec2 start;
     kmVec2 dir;
@@ -68,6 +70,12 @@ kmBool kmRay2IntersectBox(const kmRay2* ray, const kmVec2* p1,
                           const kmVec2* p4, kmVec2* intersection,
                           kmVec2* normal_out);
 
+/**
+ * kmRay2IntersectBox for an axis aligned box. normal_out may be NULL.
+ */
+kmBool kmRay2IntersectAABB2(const kmRay2* ray, const struct kmAABB2* box,
+                            kmVec2* intersection, kmVec2* normal_out);
+
 kmBool kmRay2IntersectCircle(const kmRay2* ray, const kmVec2 centre,
                              const kmScalar radius, kmVec2* intersection);
 
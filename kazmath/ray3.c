@@ -1,6 +1,8 @@
 #include "plane.h"
 #include "ray3.h"
 #include "aabb3.h"
+#include "sphere.h"
+#include "obb3.h"
 
 kmRay3* kmRay3Fill(kmRay3* ray, kmScalar px, kmScalar py, kmScalar pz, kmScalar vx, kmScalar vy, kmScalar vz) {
     ray->start.x = px;
@@ -20,32 +22,129 @@ kmRay3* kmRay3FromPointAndDirection(kmRay3* ray, const kmVec3* point, const kmVe
     return ray;
 }
 
-kmBool kmRay3IntersectAABB3(const kmRay3* ray, const kmAABB3* aabb, kmVec3* intersection, kmScalar* distance) {
+kmRay3Prepared* kmRay3Prepare(kmRay3Prepared* pOut, const kmRay3* ray) {
+    pOut->start = ray->start;
+    pOut->length_sq = kmVec3LengthSq(&ray->dir);
+    kmVec3Normalize(&pOut->dir, &ray->dir);
+
+    // Axis aligned rays give +/-INFINITY which the slab test handles
+    kmVec3Fill(&pOut->inv_dir, 1.0 / pOut->dir.x, 1.0 / pOut->dir.y, 1.0 / pOut->dir.z);
+
+    pOut->sign[0] = pOut->inv_dir.x < 0;
+    pOut->sign[1] = pOut->inv_dir.y < 0;
+    pOut->sign[2] = pOut->inv_dir.z < 0;
+
+    return pOut;
+}
+
+static kmBool prepared_slab(const kmRay3Prepared* ray, const kmAABB3* aabb, kmScalar* tnear) {
     //http://gamedev.stackexchange.com/a/18459/15125
-    kmVec3 rdir, dirfrac, diff;
-    kmVec3Normalize(&rdir, &ray->dir);
-    kmVec3Fill(&dirfrac, 1.0 / rdir.x, 1.0 / rdir.y, 1.0 / rdir.z);
+    const kmVec3* bounds[2];
+    kmScalar tmin, tmax, tymin, tymax, tzmin, tzmax;
+
+    bounds[0] = &aabb->min;
+    bounds[1] = &aabb->max;
+
+    tmin = (bounds[ray->sign[0]]->x - ray->start.x) * ray->inv_dir.x;
+    tmax = (bounds[1 - ray->sign[0]]->x - ray->start.x) * ray->inv_dir.x;
+    tymin = (bounds[ray->sign[1]]->y - ray->start.y) * ray->inv_dir.y;
+    tymax = (bounds[1 - ray->sign[1]]->y - ray->start.y) * ray->inv_dir.y;
+
+    if(tmin > tymax || tymin > tmax) {
+        return KM_FALSE;
+    }
 
-    kmScalar t1 = (aabb->min.x - ray->start.x) * dirfrac.x;
-    kmScalar t2 = (aabb->max.x - ray->start.x) * dirfrac.x;
-    kmScalar t3 = (aabb->min.y - ray->start.y) * dirfrac.y;
-    kmScalar t4 = (aabb->max.y - ray->start.y) * dirfrac.y;
-    kmScalar t5 = (aabb->min.z - ray->start.z) * dirfrac.z;
-    kmScalar t6 = (aabb->max.z - ray->start.z) * dirfrac.z;
+    if(tymin > tmin) tmin = tymin;
+    if(tymax < tmax) tmax = tymax;
 
-    kmScalar tmin = kmMax(kmMax(kmMin(t1, t2), kmMin(t3, t4)), kmMin(t5, t6));
-    kmScalar tmax = kmMin(kmMin(kmMax(t1, t2), kmMax(t3, t4)), kmMax(t5, t6));
+    tzmin = (bounds[ray->sign[2]]->z - ray->start.z) * ray->inv_dir.z;
+    tzmax = (bounds[1 - ray->sign[2]]->z - ray->start.z) * ray->inv_dir.z;
+
+    if(tmin > tzmax || tzmin > tmax) {
+        return KM_FALSE;
+    }
+
+    if(tzmin > tmin) tmin = tzmin;
+    if(tzmax < tmax) tmax = tzmax;
 
     // if tmax < 0, ray (line) is intersecting AABB, but whole AABB is behind us
     if(tmax < 0) {
         return KM_FALSE;
     }
 
-    // if tmin > tmax, ray doesn't intersect AABB
-    if (tmin > tmax) {
+    *tnear = tmin;
+    return KM_TRUE;
+}
+
+kmBool kmRay3PreparedIntersectAABB3(const kmRay3Prepared* ray, const kmAABB3* aabb, kmVec3* intersection, kmScalar* distance) {
+    kmVec3 diff;
+    kmScalar tmin;
+
+    if(!prepared_slab(ray, aabb, &tmin)) {
+        return KM_FALSE;
+    }
+
+    if(distance) *distance = tmin;
+    if(intersection) {
+        kmVec3Scale(&diff, &ray->dir, tmin);
+        kmVec3Add(intersection, &ray->start, &diff);
+    }
+    return KM_TRUE;
+}
+
+kmUint kmRay3PreparedIntersectAABB3Array(const kmRay3Prepared* ray, const kmAABB3* boxes, kmUint count, kmBool* pResults, kmScalar* pDistances) {
+    kmUint i, hits = 0;
+    kmScalar tmin;
+
+    for(i = 0; i < count; ++i) {
+        pResults[i] = prepared_slab(ray, &boxes[i], &tmin);
+        if(pResults[i]) {
+            ++hits;
+            if(pDistances) pDistances[i] = tmin;
+        }
+    }
+
+    return hits;
+}
+
+kmBool kmRay3IntersectAABB3(const kmRay3* ray, const kmAABB3* aabb, kmVec3* intersection, kmScalar* distance) {
+    kmRay3Prepared prepared;
+    return kmRay3PreparedIntersectAABB3(kmRay3Prepare(&prepared, ray), aabb, intersection, distance);
+}
+
+kmBool kmRay3IntersectOBB3(const kmRay3* ray, const kmOBB3* obb, kmVec3* intersection, kmScalar* distance) {
+    // Slab test in the local space of the box
+    kmVec3 rdir, diff;
+    const kmScalar* extents = &obb->extents.x;
+    kmScalar tmin = -INFINITY, tmax = INFINITY;
+    int i;
+
+    kmVec3Normalize(&rdir, &ray->dir);
+    kmVec3Subtract(&diff, &obb->centre, &ray->start);
+
+    for(i = 0; i < 3; ++i) {
+        const kmScalar* axis = &obb->axes.mat[i * 3];
+        kmScalar e = axis[0] * diff.x + axis[1] * diff.y + axis[2] * diff.z;
+        kmScalar f = axis[0] * rdir.x + axis[1] * rdir.y + axis[2] * rdir.z;
+
+        if(fabs(f) > kmEpsilon) {
+            kmScalar t1 = (e + extents[i]) / f;
+            kmScalar t2 = (e - extents[i]) / f;
+            tmin = kmMax(tmin, kmMin(t1, t2));
+            tmax = kmMin(tmax, kmMax(t1, t2));
+        } else if(-e - extents[i] > 0 || -e + extents[i] < 0) {
+            // Parallel to this slab and outside of it
+            return KM_FALSE;
+        }
+    }
+
+    if(tmax < 0 || tmin > tmax) {
         return KM_FALSE;
     }
 
+    // A ray starting inside the box hits at distance 0
+    if(tmin < 0) tmin = 0;
+
     if(distance) *distance = tmin;
     if(intersection) {
         kmVec3Scale(&diff, &rdir, tmin);
@@ -54,6 +153,42 @@ kmBool kmRay3IntersectAABB3(const kmRay3* ray, const kmAABB3* aabb, kmVec3* inte
     return KM_TRUE;
 }
 
+kmBool kmRay3IntersectSphere(const kmRay3* ray, const kmSphere* sphere, kmVec3* intersection, kmScalar* distance) {
+    kmVec3 rdir, m, diff;
+    kmScalar b, c, disc, t;
+
+    if(sphere->radius < 0) {
+        return KM_FALSE;
+    }
+
+    kmVec3Normalize(&rdir, &ray->dir);
+    kmVec3Subtract(&m, &ray->start, &sphere->centre);
+
+    b = kmVec3Dot(&m, &rdir);
+    c = kmVec3LengthSq(&m) - kmSQR(sphere->radius);
+
+    // Starting outside the sphere and pointing away from it
+    if(c > 0 && b > 0) {
+        return KM_FALSE;
+    }
+
+    disc = b * b - c;
+    if(disc < 0) {
+        return KM_FALSE;
+    }
+
+    // A ray starting inside the sphere hits at distance 0
+    t = -b - sqrt(disc);
+    if(t < 0) t = 0;
+
+    if(distance) *distance = t;
+    if(intersection) {
+        kmVec3Scale(&diff, &rdir, t);
+        kmVec3Add(intersection, &ray->start, &diff);
+    }
+    return KM_TRUE;
+}
+
 kmBool kmRay3IntersectPlane(kmVec3* pOut, const kmRay3* ray, const kmPlane* plane) {
     /*t = - (A*org.x + B*org.y + C*org.z + D) / (A*dir.x + B*dir.y + C*dir.z )*/
 
@@ -83,16 +218,14 @@ kmBool kmRay3IntersectPlane(kmVec3* pOut, const kmRay3* ray, const kmPlane* plan
 }
 
 
-kmBool kmRay3IntersectTriangle(const kmRay3* ray, const kmVec3* v0, const kmVec3* v1, const kmVec3* v2, kmVec3* intersection, kmVec3* normal, kmScalar* distance) {
-    kmVec3 e1, e2, pvec, tvec, qvec, dir;
+kmBool kmRay3PreparedIntersectTriangle(const kmRay3Prepared* ray, const kmVec3* v0, const kmVec3* v1, const kmVec3* v2, kmVec3* intersection, kmVec3* normal, kmScalar* distance) {
+    kmVec3 e1, e2, pvec, tvec, qvec;
     kmScalar det, inv_det, u, v, t;
 
-    kmVec3Normalize(&dir, &ray->dir);
-
     kmVec3Subtract(&e1, v1, v0);
     kmVec3Subtract(&e2, v2, v0);
 
-    kmVec3Cross(&pvec, &dir, &e2);
+    kmVec3Cross(&pvec, &ray->dir, &e2);
     det = kmVec3Dot(&e1, &pvec);
 
     /* Backfacing, discard. */
@@ -114,22 +247,108 @@ kmBool kmRay3IntersectTriangle(const kmRay3* ray, const kmVec3* v0, const kmVec3
     }
 
     kmVec3Cross(&qvec, &tvec, &e1);
-    v = inv_det * kmVec3Dot(&dir, &qvec);
+    v = inv_det * kmVec3Dot(&ray->dir, &qvec);
     if(v < 0.0 || (u + v) > 1.0) {
         return KM_FALSE;
     }
 
     t = inv_det * kmVec3Dot(&e2, &qvec);
-    if(t > kmEpsilon && (t*t) <= kmVec3LengthSq(&ray->dir)) {
+    if(t > kmEpsilon && (t*t) <= ray->length_sq) {
         kmVec3 scaled;
         *distance = t; /* Distance */
         kmVec3Cross(normal, &e1, &e2); /* Surface normal of collision */
         kmVec3Normalize(normal, normal);
-        kmVec3Normalize(&scaled, &dir);
-        kmVec3Scale(&scaled, &scaled, *distance);
+        kmVec3Scale(&scaled, &ray->dir, *distance);
         kmVec3Add(intersection, &ray->start, &scaled);
         return KM_TRUE;
     }
 
     return KM_FALSE;
 }
+
+kmBool kmRay3IntersectTriangle(const kmRay3* ray, const kmVec3* v0, const kmVec3* v1, const kmVec3* v2, kmVec3* intersection, kmVec3* normal, kmScalar* distance) {
+    kmRay3Prepared prepared;
+    return kmRay3PreparedIntersectTriangle(kmRay3Prepare(&prepared, ray), v0, v1, v2, intersection, normal, distance);
+}
+
+kmRay3Packet* kmRay3PacketFill(kmRay3Packet* packet, const kmRay3* rays, kmUint count) {
+    kmUint i;
+    kmRay3 dummy;
+
+    if(count > KM_RAY3_PACKET_SIZE) count = KM_RAY3_PACKET_SIZE;
+    packet->count = count;
+
+    /* An empty packet has no first ray to repeat, and rays may be NULL */
+    if(!count) {
+        kmRay3Fill(&dummy, 0, 0, 0, 0, 0, 1);
+        rays = &dummy;
+    }
+
+    for(i = 0; i < KM_RAY3_PACKET_SIZE; ++i) {
+        const kmRay3* ray = &rays[i < count ? i : 0];
+        kmVec3 dir;
+        kmVec3Normalize(&dir, &ray->dir);
+
+        packet->ox[i] = ray->start.x;
+        packet->oy[i] = ray->start.y;
+        packet->oz[i] = ray->start.z;
+
+        packet->dx[i] = dir.x;
+        packet->dy[i] = dir.y;
+        packet->dz[i] = dir.z;
+
+        /* Axis aligned rays give +/-INFINITY which the slab test handles */
+        packet->inv_dx[i] = 1.0 / dir.x;
+        packet->inv_dy[i] = 1.0 / dir.y;
+        packet->inv_dz[i] = 1.0 / dir.z;
+
+        packet->tmax[i] = INFINITY;
+    }
+
+    return packet;
+}
+
+kmUint kmRay3PacketMask(const kmRay3Packet* packet) {
+    return (1u << packet->count) - 1u;
+}
+
+kmUint kmRay3PacketIntersectAABB3(const kmRay3Packet* packet, kmUint mask,
+                                  const kmAABB3* aabb, kmScalar* distances) {
+    kmScalar t_in[KM_RAY3_PACKET_SIZE];
+    kmScalar t_out[KM_RAY3_PACKET_SIZE];
+    kmUint i, hits = 0;
+
+    /* Branch free so the compiler can run all lanes at once */
+    for(i = 0; i < KM_RAY3_PACKET_SIZE; ++i) {
+        kmScalar t1 = (aabb->min.x - packet->ox[i]) * packet->inv_dx[i];
+        kmScalar t2 = (aabb->max.x - packet->ox[i]) * packet->inv_dx[i];
+        kmScalar t3 = (aabb->min.y - packet->oy[i]) * packet->inv_dy[i];
+        kmScalar t4 = (aabb->max.y - packet->oy[i]) * packet->inv_dy[i];
+        kmScalar t5 = (aabb->min.z - packet->oz[i]) * packet->inv_dz[i];
+        kmScalar t6 = (aabb->max.z - packet->oz[i]) * packet->inv_dz[i];
+
+        kmScalar lo_x = t1 < t2 ? t1 : t2, hi_x = t1 < t2 ? t2 : t1;
+        kmScalar lo_y = t3 < t4 ? t3 : t4, hi_y = t3 < t4 ? t4 : t3;
+        kmScalar lo_z = t5 < t6 ? t5 : t6, hi_z = t5 < t6 ? t6 : t5;
+
+        kmScalar tmin = lo_x > lo_y ? lo_x : lo_y;
+        kmScalar tmax = hi_x < hi_y ? hi_x : hi_y;
+        tmin = tmin > lo_z ? tmin : lo_z;
+        tmax = tmax < hi_z ? tmax : hi_z;
+
+        t_in[i] = tmin > 0 ? tmin : 0;
+        t_out[i] = tmax < packet->tmax[i] ? tmax : packet->tmax[i];
+    }
+
+    for(i = 0; i < KM_RAY3_PACKET_SIZE; ++i) {
+        hits |= (t_in[i] <= t_out[i]) ? (1u << i) : 0u;
+    }
+
+    if(distances) {
+        for(i = 0; i < KM_RAY3_PACKET_SIZE; ++i) {
+            distances[i] = t_in[i];
+        }
+    }
+
+    return hits & mask;
+}
@@ -15,12 +15,93 @@ typedef struct kmRay3 {
 
 struct kmPlane;
 struct kmAABB3;
+struct kmSphere;
+struct kmOBB3;
 
 kmRay3* kmRay3Fill(kmRay3* ray, kmScalar px, kmScalar py, kmScalar pz, kmScalar vx, kmScalar vy, kmScalar vz);
 kmRay3* kmRay3FromPointAndDirection(kmRay3* ray, const kmVec3* point, const kmVec3* direction);
 kmBool kmRay3IntersectPlane(kmVec3* pOut, const kmRay3* ray, const struct kmPlane* plane);
 kmBool kmRay3IntersectTriangle(const kmRay3* ray, const kmVec3* v0, const kmVec3* v1, const kmVec3* v2, kmVec3* intersection, kmVec3* normal, kmScalar* distance);
 kmBool kmRay3IntersectAABB3(const kmRay3* ray, const struct kmAABB3* aabb, kmVec3* intersection, kmScalar* distance);
+kmBool kmRay3IntersectOBB3(const kmRay3* ray, const struct kmOBB3* obb, kmVec3* intersection, kmScalar* distance);
+kmBool kmRay3IntersectSphere(const kmRay3* ray, const struct kmSphere* sphere, kmVec3* intersection, kmScalar* distance);
+
+/*
+ * A ray with its per-ray setup done once: the normalized direction, its
+ * reciprocal and the sign of each reciprocal component (1 if negative),
+ * which selects the near and far slab of a box without comparisons. Use it
+ * when one ray is tested against many primitives.
+ */
+typedef struct kmRay3Prepared {
+    kmVec3 start;
+    kmVec3 dir;
+    kmVec3 inv_dir;
+    kmUint sign[3];
+    kmScalar length_sq; /* Squared length of the original direction */
+} kmRay3Prepared;
+
+kmRay3Prepared* kmRay3Prepare(kmRay3Prepared* pOut, const kmRay3* ray);
+
+/*
+ * Same results as kmRay3IntersectAABB3 and kmRay3IntersectTriangle (which
+ * are implemented on top of these), without the per call normalize and
+ * reciprocals.
+ */
+kmBool kmRay3PreparedIntersectAABB3(const kmRay3Prepared* ray, const struct kmAABB3* aabb, kmVec3* intersection, kmScalar* distance);
+kmBool kmRay3PreparedIntersectTriangle(const kmRay3Prepared* ray, const kmVec3* v0, const kmVec3* v1, const kmVec3* v2, kmVec3* intersection, kmVec3* normal, kmScalar* distance);
+
+/**
+ * Tests one ray against count boxes. Writes KM_TRUE/KM_FALSE per box into
+ * pResults and, if pDistances is not NULL, the distance to each box hit
+ * (as kmRay3IntersectAABB3, negative when the ray starts inside). Returns
+ * the number of hits.
+ */
+kmUint kmRay3PreparedIntersectAABB3Array(const kmRay3Prepared* ray, const struct kmAABB3* boxes, kmUint count, kmBool* pResults, kmScalar* pDistances);
+
+/*
+ * A bundle of up to KM_RAY3_PACKET_SIZE coherent rays stored one component
+ * per array (structure of arrays) so the per-lane loops vectorize. Directions
+ * are normalized and their reciprocals precomputed once when the packet is
+ * filled. Lanes are addressed with a bit mask, bit i being ray i.
+ *
+ * tmax limits how far each ray is tested, it is INFINITY after filling and
+ * can be shrunk by a traversal as closer hits are found.
+ */
+#define KM_RAY3_PACKET_SIZE 8
+
+typedef struct kmRay3Packet {
+    kmScalar ox[KM_RAY3_PACKET_SIZE], oy[KM_RAY3_PACKET_SIZE], oz[KM_RAY3_PACKET_SIZE];
+    kmScalar dx[KM_RAY3_PACKET_SIZE], dy[KM_RAY3_PACKET_SIZE], dz[KM_RAY3_PACKET_SIZE];
+    kmScalar inv_dx[KM_RAY3_PACKET_SIZE], inv_dy[KM_RAY3_PACKET_SIZE], inv_dz[KM_RAY3_PACKET_SIZE];
+    kmScalar tmax[KM_RAY3_PACKET_SIZE];
+    kmUint count;
+} kmRay3Packet;
+
+/**
+ * Fills the packet from count rays (at most KM_RAY3_PACKET_SIZE, 4 and 8 are
+ * the usual widths). Unused lanes repeat the first ray so they never produce
+ * NaNs, but they are excluded from kmRay3PacketMask. With a count of zero
+ * rays is not read and every lane is unused. Returns packet.
+ */
+kmRay3Packet* kmRay3PacketFill(kmRay3Packet* packet, const kmRay3* rays, kmUint count);
+
+/**
+ * Returns the lane mask with one bit set for each ray in the packet.
+ */
+kmUint kmRay3PacketMask(const kmRay3Packet* packet);
+
+/**
+ * Slab test of the rays selected by mask against aabb. Returns the mask of
+ * lanes that hit within their tmax. If distances is not NULL, it receives
+ * KM_RAY3_PACKET_SIZE entry distances (0 for rays starting inside the box);
+ * lanes that missed are undefined.
+ *
+ * A spatial structure can traverse a whole packet by testing each node's
+ * bounds with the mask of lanes that reached it and descending only while
+ * the returned mask is non-zero, so all rays share each node fetch.
+ */
+kmUint kmRay3PacketIntersectAABB3(const kmRay3Packet* packet, kmUint mask,
+                                  const struct kmAABB3* aabb, kmScalar* distances);
 
 #ifdef __cplusplus
 }
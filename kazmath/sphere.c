@@ -0,0 +1,719 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "sphere.h"
+#include "mat4.h"
+#include "plane.h"
+#include "aabb3.h"
+#include "ray3.h"
+
+/* Slack used when deciding if a point is already inside a sphere */
+#define SPHERE_TOLERANCE 1.0e-5f
+
+kmSphere* kmSphereFill(kmSphere* pOut, const kmVec3* centre, kmScalar radius) {
+    kmVec3Assign(&pOut->centre, centre);
+    pOut->radius = radius;
+    return pOut;
+}
+
+kmSphere* kmSphereAssign(kmSphere* pOut, const kmSphere* pIn) {
+    if(pOut == pIn) {
+        return pOut;
+    }
+
+    kmVec3Assign(&pOut->centre, &pIn->centre);
+    pOut->radius = pIn->radius;
+    return pOut;
+}
+
+kmBool kmSphereContainsPoint(const kmSphere* pSphere, const kmVec3* pPoint) {
+    kmVec3 diff;
+    if(pSphere->radius < 0) {
+        /* Negative radius marks an empty sphere, squaring would hide that */
+        return KM_FALSE;
+    }
+
+    kmVec3Subtract(&diff, pPoint, &pSphere->centre);
+    return kmVec3LengthSq(&diff) <= kmSQR(pSphere->radius);
+}
+
+kmSphere* kmSphereExpandToContainPoint(kmSphere* pOut, const kmSphere* pIn, const kmVec3* point) {
+    kmVec3 diff;
+    kmScalar dist_sq, dist, new_radius;
+
+    kmSphereAssign(pOut, pIn);
+
+    if(pOut->radius < 0) {
+        kmVec3Assign(&pOut->centre, point);
+        pOut->radius = 0;
+        return pOut;
+    }
+
+    kmVec3Subtract(&diff, point, &pOut->centre);
+    dist_sq = kmVec3LengthSq(&diff);
+
+    if(dist_sq <= kmSQR(pOut->radius)) {
+        return pOut;
+    }
+
+    dist = sqrt(dist_sq);
+    new_radius = (pOut->radius + dist) * 0.5f;
+
+    /* Slide the centre towards the point so the far side stays put */
+    kmVec3Scale(&diff, &diff, (new_radius - pOut->radius) / dist);
+    kmVec3Add(&pOut->centre, &pOut->centre, &diff);
+    pOut->radius = new_radius;
+
+    return pOut;
+}
+
+static void sphere_grow(kmSphere* pSphere, const kmVec3* points, kmUint count) {
+    kmUint i;
+    for(i = 0; i < count; ++i) {
+        kmSphereExpandToContainPoint(pSphere, pSphere, &points[i]);
+    }
+}
+
+static void sphere_from_pair(kmSphere* pOut, const kmVec3* a, const kmVec3* b) {
+    kmVec3 diff;
+    kmVec3Add(&pOut->centre, a, b);
+    kmVec3Scale(&pOut->centre, &pOut->centre, 0.5f);
+    kmVec3Subtract(&diff, b, a);
+    pOut->radius = kmVec3Length(&diff) * 0.5f;
+}
+
+kmSphere* kmSphereFromPointsRitter(kmSphere* pOut, const kmVec3* points, kmUint count) {
+    kmUint i;
+    kmUint min_x = 0, max_x = 0, min_y = 0, max_y = 0, min_z = 0, max_z = 0;
+    kmVec3 dx, dy, dz;
+    kmScalar dist_x, dist_y, dist_z;
+
+    if(!count) {
+        kmVec3Zero(&pOut->centre);
+        pOut->radius = 0;
+        return pOut;
+    }
+
+    for(i = 1; i < count; ++i) {
+        if(points[i].x < points[min_x].x) min_x = i;
+        if(points[i].x > points[max_x].x) max_x = i;
+        if(points[i].y < points[min_y].y) min_y = i;
+        if(points[i].y > points[max_y].y) max_y = i;
+        if(points[i].z < points[min_z].z) min_z = i;
+        if(points[i].z > points[max_z].z) max_z = i;
+    }
+
+    dist_x = kmVec3LengthSq(kmVec3Subtract(&dx, &points[max_x], &points[min_x]));
+    dist_y = kmVec3LengthSq(kmVec3Subtract(&dy, &points[max_y], &points[min_y]));
+    dist_z = kmVec3LengthSq(kmVec3Subtract(&dz, &points[max_z], &points[min_z]));
+
+    if(dist_x >= dist_y && dist_x >= dist_z) {
+        sphere_from_pair(pOut, &points[min_x], &points[max_x]);
+    } else if(dist_y >= dist_z) {
+        sphere_from_pair(pOut, &points[min_y], &points[max_y]);
+    } else {
+        sphere_from_pair(pOut, &points[min_z], &points[max_z]);
+    }
+
+    sphere_grow(pOut, points, count);
+    return pOut;
+}
+
+static kmBool sphere_from_three(kmSphere* pOut, const kmVec3* a, const kmVec3* b, const kmVec3* c) {
+    /* Circumcircle of a triangle, returns KM_FALSE if the points are collinear */
+    kmVec3 ab, ac, n, t1, t2, offset;
+    kmScalar denom;
+
+    kmVec3Subtract(&ab, b, a);
+    kmVec3Subtract(&ac, c, a);
+    kmVec3Cross(&n, &ab, &ac);
+
+    denom = 2.0f * kmVec3LengthSq(&n);
+    if(denom < kmEpsilon) {
+        return KM_FALSE;
+    }
+
+    kmVec3Cross(&t1, &n, &ab);
+    kmVec3Scale(&t1, &t1, kmVec3LengthSq(&ac));
+    kmVec3Cross(&t2, &ac, &n);
+    kmVec3Scale(&t2, &t2, kmVec3LengthSq(&ab));
+    kmVec3Add(&offset, &t1, &t2);
+    kmVec3Scale(&offset, &offset, 1.0f / denom);
+
+    kmVec3Add(&pOut->centre, a, &offset);
+    pOut->radius = kmVec3Length(&offset);
+    return KM_TRUE;
+}
+
+static kmBool sphere_from_four(kmSphere* pOut, const kmVec3* a, const kmVec3* b, const kmVec3* c, const kmVec3* d) {
+    /* Circumsphere of a tetrahedron, returns KM_FALSE if the points are coplanar */
+    kmVec3 ab, ac, ad, t1, t2, t3, offset;
+    kmScalar denom;
+
+    kmVec3Subtract(&ab, b, a);
+    kmVec3Subtract(&ac, c, a);
+    kmVec3Subtract(&ad, d, a);
+
+    kmVec3Cross(&t1, &ac, &ad);
+    denom = 2.0f * kmVec3Dot(&ab, &t1);
+    if(fabs(denom) < kmEpsilon) {
+        return KM_FALSE;
+    }
+
+    kmVec3Scale(&t1, &t1, kmVec3LengthSq(&ab));
+    kmVec3Cross(&t2, &ad, &ab);
+    kmVec3Scale(&t2, &t2, kmVec3LengthSq(&ac));
+    kmVec3Cross(&t3, &ab, &ac);
+    kmVec3Scale(&t3, &t3, kmVec3LengthSq(&ad));
+
+    kmVec3Add(&offset, &t1, &t2);
+    kmVec3Add(&offset, &offset, &t3);
+    kmVec3Scale(&offset, &offset, 1.0f / denom);
+
+    kmVec3Add(&pOut->centre, a, &offset);
+    pOut->radius = kmVec3Length(&offset);
+    return KM_TRUE;
+}
+
+static kmBool sphere_contains_loose(const kmSphere* pSphere, const kmVec3* pPoint) {
+    kmVec3 diff;
+    kmVec3Subtract(&diff, pPoint, &pSphere->centre);
+    return kmVec3Length(&diff) <= pSphere->radius * (1.0f + SPHERE_TOLERANCE) + SPHERE_TOLERANCE;
+}
+
+static void sphere_from_support(kmSphere* pOut, const kmVec3* support, kmUint count) {
+    kmUint i, j;
+
+    switch(count) {
+        case 0:
+            kmVec3Zero(&pOut->centre);
+            pOut->radius = -1; /* Contains nothing */
+        break;
+        case 1:
+            kmVec3Assign(&pOut->centre, &support[0]);
+            pOut->radius = 0;
+        break;
+        case 2:
+            sphere_from_pair(pOut, &support[0], &support[1]);
+        break;
+        case 3:
+            if(!sphere_from_three(pOut, &support[0], &support[1], &support[2])) {
+                /* Collinear, the outermost pair decides */
+                kmSphere best, tmp;
+                best.radius = -1;
+                for(i = 0; i < 3; ++i) {
+                    for(j = i + 1; j < 3; ++j) {
+                        sphere_from_pair(&tmp, &support[i], &support[j]);
+                        if(tmp.radius > best.radius) best = tmp;
+                    }
+                }
+                *pOut = best;
+            }
+        break;
+        default:
+            if(!sphere_from_four(pOut, &support[0], &support[1], &support[2], &support[3])) {
+                /* Coplanar, the smallest circumcircle which holds the 4th point wins */
+                kmSphere best, tmp;
+                best.radius = -1;
+                for(i = 0; i < 4; ++i) {
+                    kmVec3 tri[3];
+                    kmUint n = 0;
+                    for(j = 0; j < 4; ++j) {
+                        if(j != i) tri[n++] = support[j];
+                    }
+                    sphere_from_support(&tmp, tri, 3);
+                    if(sphere_contains_loose(&tmp, &support[i]) &&
+                       (best.radius < 0 || tmp.radius < best.radius)) {
+                        best = tmp;
+                    }
+                }
+                *pOut = best;
+            }
+        break;
+    }
+}
+
+static void sphere_welzl(kmSphere* pOut, const kmVec3* points, kmUint count, kmVec3* support, kmUint support_count) {
+    /* Welzl's minimum enclosing sphere. Only used on the small EPOS extreme point set */
+    if(!count || support_count == 4) {
+        sphere_from_support(pOut, support, support_count);
+        return;
+    }
+
+    sphere_welzl(pOut, points, count - 1, support, support_count);
+    if(pOut->radius >= 0 && sphere_contains_loose(pOut, &points[count - 1])) {
+        return;
+    }
+
+    support[support_count] = points[count - 1];
+    sphere_welzl(pOut, points, count - 1, support, support_count + 1);
+}
+
+kmSphere* kmSphereFromPointsEPOS(kmSphere* pOut, const kmVec3* points, kmUint count) {
+    static const kmScalar directions[7][3] = {
+        { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 },
+        { 1, 1, 1 }, { 1, 1, -1 }, { 1, -1, 1 }, { 1, -1, -1 }
+    };
+
+    kmUint min_index[7] = { 0 }, max_index[7] = { 0 };
+    kmScalar min_proj[7], max_proj[7];
+    kmVec3 extremes[14];
+    kmVec3 support[4];
+    kmUint i, d;
+
+    if(!count) {
+        kmVec3Zero(&pOut->centre);
+        pOut->radius = 0;
+        return pOut;
+    }
+
+    for(d = 0; d < 7; ++d) {
+        min_proj[d] = max_proj[d] = points[0].x * directions[d][0] +
+                                    points[0].y * directions[d][1] +
+                                    points[0].z * directions[d][2];
+    }
+
+    for(i = 1; i < count; ++i) {
+        for(d = 0; d < 7; ++d) {
+            kmScalar proj = points[i].x * directions[d][0] +
+                            points[i].y * directions[d][1] +
+                            points[i].z * directions[d][2];
+            if(proj < min_proj[d]) { min_proj[d] = proj; min_index[d] = i; }
+            if(proj > max_proj[d]) { max_proj[d] = proj; max_index[d] = i; }
+        }
+    }
+
+    for(d = 0; d < 7; ++d) {
+        extremes[d * 2] = points[min_index[d]];
+        extremes[d * 2 + 1] = points[max_index[d]];
+    }
+
+    sphere_welzl(pOut, extremes, 14, support, 0);
+    sphere_grow(pOut, points, count);
+    return pOut;
+}
+
+kmSphere* kmSphereMerge(kmSphere* pOut, const kmSphere* s1, const kmSphere* s2) {
+    kmVec3 diff;
+    kmScalar dist, radius;
+
+    /* Merging with an empty sphere changes nothing */
+    if(s2->radius < 0) return kmSphereAssign(pOut, s1);
+    if(s1->radius < 0) return kmSphereAssign(pOut, s2);
+
+    kmVec3Subtract(&diff, &s2->centre, &s1->centre);
+    dist = kmVec3Length(&diff);
+
+    if(dist + s2->radius <= s1->radius) {
+        return kmSphereAssign(pOut, s1);
+    }
+
+    if(dist + s1->radius <= s2->radius) {
+        return kmSphereAssign(pOut, s2);
+    }
+
+    radius = (dist + s1->radius + s2->radius) * 0.5f;
+    kmVec3Scale(&diff, &diff, (radius - s1->radius) / dist);
+    kmVec3Add(&pOut->centre, &s1->centre, &diff);
+    pOut->radius = radius;
+
+    return pOut;
+}
+
+kmSphere* kmSphereTransform(kmSphere* pOut, const kmSphere* pIn, const kmMat4* pM) {
+    const kmScalar* m = pM->mat;
+    kmScalar sx = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+    kmScalar sy = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+    kmScalar sz = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+
+    kmVec3MultiplyMat4(&pOut->centre, &pIn->centre, pM);
+    pOut->radius = pIn->radius * sqrt(kmMax(sx, kmMax(sy, sz)));
+
+    return pOut;
+}
+
+kmBool kmSphereIntersectsSphere(const kmSphere* s1, const kmSphere* s2) {
+    kmVec3 diff;
+
+    if(s1->radius < 0 || s2->radius < 0) return KM_FALSE;
+
+    kmVec3Subtract(&diff, &s2->centre, &s1->centre);
+    return kmVec3LengthSq(&diff) <= kmSQR(s1->radius + s2->radius);
+}
+
+static kmScalar aabb3_distance_sq(const kmAABB3* pBox, const kmVec3* p) {
+    kmScalar dist = 0, v;
+
+    v = p->x < pBox->min.x ? pBox->min.x - p->x : (p->x > pBox->max.x ? p->x - pBox->max.x : 0);
+    dist += v * v;
+    v = p->y < pBox->min.y ? pBox->min.y - p->y : (p->y > pBox->max.y ? p->y - pBox->max.y : 0);
+    dist += v * v;
+    v = p->z < pBox->min.z ? pBox->min.z - p->z : (p->z > pBox->max.z ? p->z - pBox->max.z : 0);
+    dist += v * v;
+
+    return dist;
+}
+
+kmBool kmSphereIntersectsAABB3(const kmSphere* pSphere, const kmAABB3* pBox) {
+    return pSphere->radius >= 0 && aabb3_distance_sq(pBox, &pSphere->centre) <= kmSQR(pSphere->radius);
+}
+
+kmBool kmSphereIntersectsPlane(const kmSphere* pSphere, const kmPlane* pPlane) {
+    return fabs(kmPlaneDotCoord(pPlane, &pSphere->centre)) <= pSphere->radius;
+}
+
+kmInt kmSphereClassifyPlane(const kmSphere* pSphere, const kmPlane* pPlane) {
+    kmScalar dist = kmPlaneDotCoord(pPlane, &pSphere->centre);
+
+    if(dist > pSphere->radius) return POINT_INFRONT_OF_PLANE;
+    if(dist < -pSphere->radius) return POINT_BEHIND_PLANE;
+
+    return POINT_ON_PLANE;
+}
+
+/* Closest point to p on the triangle a, b, c (Ericson 5.1.5) */
+static void closest_on_triangle(kmVec3* pOut, const kmVec3* p, const kmVec3* a, const kmVec3* b, const kmVec3* c) {
+    kmVec3 ab, ac, ap, bp, cp;
+    kmScalar d1, d2, d3, d4, d5, d6, va, vb, vc, v, w, denom;
+
+    kmVec3Subtract(&ab, b, a);
+    kmVec3Subtract(&ac, c, a);
+    kmVec3Subtract(&ap, p, a);
+    d1 = kmVec3Dot(&ab, &ap);
+    d2 = kmVec3Dot(&ac, &ap);
+    if(d1 <= 0 && d2 <= 0) {
+        kmVec3Assign(pOut, a);
+        return;
+    }
+
+    kmVec3Subtract(&bp, p, b);
+    d3 = kmVec3Dot(&ab, &bp);
+    d4 = kmVec3Dot(&ac, &bp);
+    if(d3 >= 0 && d4 <= d3) {
+        kmVec3Assign(pOut, b);
+        return;
+    }
+
+    vc = d1 * d4 - d3 * d2;
+    if(vc <= 0 && d1 >= 0 && d3 <= 0) {
+        kmVec3Scale(pOut, &ab, d1 / (d1 - d3));
+        kmVec3Add(pOut, pOut, a);
+        return;
+    }
+
+    kmVec3Subtract(&cp, p, c);
+    d5 = kmVec3Dot(&ab, &cp);
+    d6 = kmVec3Dot(&ac, &cp);
+    if(d6 >= 0 && d5 <= d6) {
+        kmVec3Assign(pOut, c);
+        return;
+    }
+
+    vb = d5 * d2 - d1 * d6;
+    if(vb <= 0 && d2 >= 0 && d6 <= 0) {
+        kmVec3Scale(pOut, &ac, d2 / (d2 - d6));
+        kmVec3Add(pOut, pOut, a);
+        return;
+    }
+
+    va = d3 * d6 - d5 * d4;
+    if(va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+        kmVec3 bc;
+        kmVec3Subtract(&bc, c, b);
+        kmVec3Scale(pOut, &bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        kmVec3Add(pOut, pOut, b);
+        return;
+    }
+
+    denom = 1 / (va + vb + vc);
+    v = vb * denom;
+    w = vc * denom;
+    pOut->x = a->x + ab.x * v + ac.x * w;
+    pOut->y = a->y + ab.y * v + ac.y * w;
+    pOut->z = a->z + ab.z * v + ac.z * w;
+}
+
+/* Smallest root of a t^2 + b t + c = 0 in [0, max], stored in pRoot */
+static kmBool lowest_root(kmScalar a, kmScalar b, kmScalar c, kmScalar max, kmScalar* pRoot) {
+    kmScalar det = b * b - 4 * a * c, sqrt_det, r1, r2, tmp;
+
+    if(a == 0 || det < 0) return KM_FALSE;
+
+    sqrt_det = sqrt(det);
+    r1 = (-b - sqrt_det) / (2 * a);
+    r2 = (-b + sqrt_det) / (2 * a);
+    if(r1 > r2) {
+        tmp = r1;
+        r1 = r2;
+        r2 = tmp;
+    }
+
+    if(r1 >= 0 && r1 <= max) {
+        *pRoot = r1;
+        return KM_TRUE;
+    }
+    if(r2 >= 0 && r2 <= max) {
+        *pRoot = r2;
+        return KM_TRUE;
+    }
+
+    return KM_FALSE;
+}
+
+/* Normal from contact towards the sphere centre at time t */
+static void contact_normal(kmVec3* pOut, const kmVec3* centre, const kmVec3* displacement,
+                           kmScalar t, const kmVec3* contact, const kmVec3* fallback) {
+    kmVec3 at;
+
+    kmVec3Scale(&at, displacement, t);
+    kmVec3Add(&at, &at, centre);
+    kmVec3Subtract(pOut, &at, contact);
+    if(kmVec3LengthSq(pOut) > 0) kmVec3Normalize(pOut, pOut);
+    else kmVec3Assign(pOut, fallback);
+}
+
+/*
+ * Swept sphere against triangle after Fauerby, "Improved Collision
+ * detection and Response": the face is tried first, and only if the
+ * sphere would touch the plane outside the triangle are the vertices and
+ * edges solved as quadratics.
+ */
+kmBool kmSphereSweepTriangle(const kmSphere* pSphere, const kmVec3* displacement,
+                             const kmVec3* p1, const kmVec3* p2, const kmVec3* p3,
+                             kmScalar* pTime, kmVec3* pNormal) {
+    const kmVec3* centre = &pSphere->centre;
+    const kmVec3* vertices[3];
+    kmScalar r = pSphere->radius, r_sq = r * r;
+    kmVec3 e1, e2, n, closest, contact, diff;
+    kmScalar dist, n_dot_d, t0, t1, t, vel_sq;
+    kmBool found = KM_FALSE;
+    int i;
+
+    if(r < 0) return KM_FALSE;
+
+    vertices[0] = p1;
+    vertices[1] = p2;
+    vertices[2] = p3;
+
+    kmVec3Subtract(&e1, p2, p1);
+    kmVec3Subtract(&e2, p3, p1);
+    kmVec3Cross(&n, &e1, &e2);
+    if(kmVec3LengthSq(&n) <= 0) return KM_FALSE;
+    kmVec3Normalize(&n, &n);
+
+    /* Face the triangle towards the sphere */
+    kmVec3Subtract(&diff, centre, p1);
+    dist = kmVec3Dot(&n, &diff);
+    if(dist < 0) {
+        kmVec3Scale(&n, &n, -1);
+        dist = -dist;
+    }
+
+    closest_on_triangle(&closest, centre, p1, p2, p3);
+    kmVec3Subtract(&diff, centre, &closest);
+    if(kmVec3LengthSq(&diff) <= r_sq) {
+        if(pTime) *pTime = 0;
+        if(pNormal) contact_normal(pNormal, centre, displacement, 0, &closest, &n);
+        return KM_TRUE;
+    }
+
+    n_dot_d = kmVec3Dot(&n, displacement);
+    if(n_dot_d >= 0) {
+        /* Moving parallel to or away from the plane, only contact if already within r */
+        if(dist > r) return KM_FALSE;
+        t0 = 0;
+        t1 = 1;
+    } else {
+        t0 = (r - dist) / n_dot_d;
+        t1 = (-r - dist) / n_dot_d;
+        if(t0 > t1) {
+            t = t0;
+            t0 = t1;
+            t1 = t;
+        }
+        if(t0 > 1 || t1 < 0) return KM_FALSE;
+        if(t0 < 0) t0 = 0;
+
+        /* Where the sphere first touches the plane, if inside the triangle that's the contact */
+        kmVec3Scale(&contact, displacement, t0);
+        kmVec3Add(&contact, &contact, centre);
+        kmVec3Scale(&diff, &n, r);
+        kmVec3Subtract(&contact, &contact, &diff);
+
+        closest_on_triangle(&closest, &contact, p1, p2, p3);
+        kmVec3Subtract(&diff, &contact, &closest);
+        if(kmVec3LengthSq(&diff) <= kmEpsilon * r_sq) {
+            if(pTime) *pTime = t0;
+            if(pNormal) kmVec3Assign(pNormal, &n);
+            return KM_TRUE;
+        }
+    }
+
+    t = t1 < 1 ? t1 : 1;
+    vel_sq = kmVec3LengthSq(displacement);
+
+    for(i = 0; i < 3; ++i) {
+        const kmVec3* v = vertices[i];
+        kmScalar root;
+
+        kmVec3Subtract(&diff, centre, v);
+        if(lowest_root(vel_sq, 2 * kmVec3Dot(displacement, &diff), kmVec3LengthSq(&diff) - r_sq, t, &root)) {
+            t = root;
+            found = KM_TRUE;
+            kmVec3Assign(&contact, v);
+        }
+    }
+
+    for(i = 0; i < 3; ++i) {
+        const kmVec3* a = vertices[i];
+        const kmVec3* b = vertices[(i + 1) % 3];
+        kmVec3 edge, to_vertex;
+        kmScalar edge_sq, edge_dot_vel, edge_dot_to_vertex, root;
+
+        kmVec3Subtract(&edge, b, a);
+        kmVec3Subtract(&to_vertex, a, centre);
+        edge_sq = kmVec3LengthSq(&edge);
+        edge_dot_vel = kmVec3Dot(&edge, displacement);
+        edge_dot_to_vertex = kmVec3Dot(&edge, &to_vertex);
+
+        if(lowest_root(edge_sq * -vel_sq + edge_dot_vel * edge_dot_vel,
+                       edge_sq * 2 * kmVec3Dot(displacement, &to_vertex) - 2 * edge_dot_vel * edge_dot_to_vertex,
+                       edge_sq * (r_sq - kmVec3LengthSq(&to_vertex)) + edge_dot_to_vertex * edge_dot_to_vertex,
+                       t, &root)) {
+            kmScalar f = (edge_dot_vel * root - edge_dot_to_vertex) / edge_sq;
+            if(f >= 0 && f <= 1) {
+                t = root;
+                found = KM_TRUE;
+                kmVec3Scale(&contact, &edge, f);
+                kmVec3Add(&contact, &contact, a);
+            }
+        }
+    }
+
+    if(!found) return KM_FALSE;
+
+    if(pTime) *pTime = t;
+    if(pNormal) contact_normal(pNormal, centre, displacement, t, &contact, &n);
+
+    return KM_TRUE;
+}
+
+kmUint kmSphereSweepTriangles(const kmSphere* pSphere, const kmVec3* displacement,
+                              const kmVec3* p1, const kmVec3* p2, const kmVec3* p3,
+                              kmUint count, kmBool* pResults, kmScalar* pTimes,
+                              kmVec3* pNormals) {
+    kmUint i, hits = 0;
+
+    for(i = 0; i < count; ++i) {
+        kmBool hit = kmSphereSweepTriangle(pSphere, displacement, &p1[i], &p2[i], &p3[i],
+                                           pTimes ? &pTimes[i] : NULL,
+                                           pNormals ? &pNormals[i] : NULL);
+        pResults[i] = hit;
+        hits += hit;
+    }
+
+    return hits;
+}
+
+kmUint kmSphereIntersectsPlaneArray(const kmSphere* spheres, kmUint count, const kmPlane* pPlane, kmBool* pResults) {
+    kmUint i, hits = 0;
+    const kmScalar a = pPlane->a, b = pPlane->b, c = pPlane->c, d = pPlane->d;
+
+    for(i = 0; i < count; ++i) {
+        const kmSphere* s = &spheres[i];
+        kmScalar dist = a * s->centre.x + b * s->centre.y + c * s->centre.z + d;
+        kmBool hit = fabs(dist) <= s->radius;
+        pResults[i] = hit;
+        hits += hit;
+    }
+
+    return hits;
+}
+
+kmUint kmSphereIntersectsAABB3Array(const kmSphere* spheres, kmUint count, const kmAABB3* pBox, kmBool* pResults) {
+    kmUint i, hits = 0;
+
+    for(i = 0; i < count; ++i) {
+        kmBool hit = spheres[i].radius >= 0 &&
+                     aabb3_distance_sq(pBox, &spheres[i].centre) <= kmSQR(spheres[i].radius);
+        pResults[i] = hit;
+        hits += hit;
+    }
+
+    return hits;
+}
+
+kmUint kmSphereIntersectsSphereArray(const kmSphere* spheres, kmUint count, const kmSphere* pOther, kmBool* pResults) {
+    kmUint i, hits = 0;
+    const kmScalar ox = pOther->centre.x, oy = pOther->centre.y, oz = pOther->centre.z;
+
+    if(pOther->radius < 0) {
+        for(i = 0; i < count; ++i) pResults[i] = KM_FALSE;
+        return 0;
+    }
+
+    for(i = 0; i < count; ++i) {
+        const kmSphere* s = &spheres[i];
+        kmScalar dx = s->centre.x - ox, dy = s->centre.y - oy, dz = s->centre.z - oz;
+        kmScalar r = s->radius + pOther->radius;
+        kmBool hit = s->radius >= 0 && (dx * dx + dy * dy + dz * dz) <= r * r;
+        pResults[i] = hit;
+        hits += hit;
+    }
+
+    return hits;
+}
+
+kmUint kmSphereIntersectsRay3Array(const kmSphere* spheres, kmUint count, const kmRay3* pRay, kmBool* pResults, kmScalar* pDistances) {
+    kmUint i, hits = 0;
+    kmVec3 dir;
+
+    /* Normalize once rather than per sphere */
+    kmVec3Normalize(&dir, &pRay->dir);
+
+    for(i = 0; i < count; ++i) {
+        const kmSphere* s = &spheres[i];
+        kmScalar mx = pRay->start.x - s->centre.x;
+        kmScalar my = pRay->start.y - s->centre.y;
+        kmScalar mz = pRay->start.z - s->centre.z;
+        kmScalar b = mx * dir.x + my * dir.y + mz * dir.z;
+        kmScalar c = mx * mx + my * my + mz * mz - s->radius * s->radius;
+        kmScalar disc = b * b - c;
+        kmBool hit = s->radius >= 0 && !(c > 0 && b > 0) && disc >= 0;
+
+        pResults[i] = hit;
+        hits += hit;
+
+        if(pDistances) {
+            kmScalar t = hit ? -b - sqrt(disc) : 0;
+            pDistances[i] = t < 0 ? 0 : t;
+        }
+    }
+
+    return hits;
+}
@@ -0,0 +1,169 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KAZMATH_SPHERE_H_INCLUDED
+#define KAZMATH_SPHERE_H_INCLUDED
+
+#include "vec3.h"
+#include "utility.h"
+
+struct kmMat4;
+struct kmPlane;
+struct kmAABB3;
+struct kmRay3;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A structure that represents a bounding sphere. A negative radius marks
+ * an empty sphere, which contains and intersects nothing.
+ */
+typedef struct kmSphere {
+    kmVec3 centre;
+    kmScalar radius;
+} kmSphere;
+
+kmSphere* kmSphereFill(kmSphere* pOut, const kmVec3* centre, kmScalar radius);
+kmSphere* kmSphereAssign(kmSphere* pOut, const kmSphere* pIn);
+
+/**
+ * Returns KM_TRUE if point is inside (or on the surface of) the sphere
+ */
+kmBool kmSphereContainsPoint(const kmSphere* pSphere, const kmVec3* pPoint);
+
+/**
+ * Fits a sphere around count points using Ritter's algorithm: the
+ * initial sphere spans the most distant pair of axis extremes and is
+ * then grown to enclose any outliers. Fast, but typically 5-20% larger
+ * than the optimal sphere. Returns pOut.
+ */
+kmSphere* kmSphereFromPointsRitter(kmSphere* pOut, const kmVec3* points,
+                                   kmUint count);
+
+/**
+ * Fits a sphere around count points using the EPOS-14 algorithm
+ * (Larsson 2008). The extreme points along 7 directions are found, the
+ * exact minimum sphere of those is computed, and the result is grown to
+ * enclose any outliers. Usually within a couple of percent of optimal.
+ * Returns pOut.
+ */
+kmSphere* kmSphereFromPointsEPOS(kmSphere* pOut, const kmVec3* points,
+                                 kmUint count);
+
+/**
+ * Grows pIn just enough to contain point, stores the result in pOut.
+ * An empty sphere becomes a zero radius sphere at point.
+ */
+kmSphere* kmSphereExpandToContainPoint(kmSphere* pOut, const kmSphere* pIn,
+                                       const kmVec3* point);
+
+/**
+ * Stores the smallest sphere enclosing both s1 and s2 in pOut. This is
+ * the reduction step for fitting in parallel: fit a sphere per chunk of
+ * points, then merge the partial results. If one input is empty the
+ * other is returned unchanged.
+ */
+kmSphere* kmSphereMerge(kmSphere* pOut, const kmSphere* s1, const kmSphere* s2);
+
+/**
+ * Transforms pIn by pM. The radius is scaled by the largest axis scale
+ * in the matrix so the result still bounds the transformed volume.
+ */
+kmSphere* kmSphereTransform(kmSphere* pOut, const kmSphere* pIn,
+                            const struct kmMat4* pM);
+
+kmBool kmSphereIntersectsSphere(const kmSphere* s1, const kmSphere* s2);
+kmBool kmSphereIntersectsAABB3(const kmSphere* pSphere,
+                               const struct kmAABB3* pBox);
+
+/**
+ * Returns KM_TRUE if the sphere touches or straddles the plane. The
+ * plane is expected to be normalized.
+ */
+kmBool kmSphereIntersectsPlane(const kmSphere* pSphere,
+                               const struct kmPlane* pPlane);
+
+/**
+ * Returns POINT_INFRONT_OF_PLANE or POINT_BEHIND_PLANE if the sphere is
+ * entirely on one side of the (normalized) plane, POINT_ON_PLANE if it
+ * straddles it.
+ */
+kmInt kmSphereClassifyPlane(const kmSphere* pSphere,
+                            const struct kmPlane* pPlane);
+
+/**
+ * Moves the sphere by displacement and finds the first time it touches
+ * the (two sided) triangle p1, p2, p3, checking its face, then its
+ * vertices and edges. Returns KM_TRUE on contact, with the time as a
+ * fraction (0 to 1) of the displacement in pTime and the unit normal
+ * from the contact point towards the sphere's centre in pNormal (either
+ * may be NULL). A sphere that already touches the triangle gives a time
+ * of 0.
+ */
+kmBool kmSphereSweepTriangle(const kmSphere* pSphere, const kmVec3* displacement,
+                             const kmVec3* p1, const kmVec3* p2, const kmVec3* p3,
+                             kmScalar* pTime, kmVec3* pNormal);
+
+/**
+ * Sweeps a single sphere against count triangles stored as three parallel
+ * vertex arrays (triangle i is p1[i], p2[i], p3[i]). Writes KM_TRUE or
+ * KM_FALSE per triangle into pResults, the contact times and normals into
+ * pTimes and pNormals (which may be NULL) and returns the number of hits.
+ */
+kmUint kmSphereSweepTriangles(const kmSphere* pSphere, const kmVec3* displacement,
+                              const kmVec3* p1, const kmVec3* p2, const kmVec3* p3,
+                              kmUint count, kmBool* pResults, kmScalar* pTimes,
+                              kmVec3* pNormals);
+
+/*
+ * Batch versions. Each tests count spheres against a single primitive,
+ * writes KM_TRUE/KM_FALSE per sphere into pResults and returns the
+ * number of hits.
+ */
+kmUint kmSphereIntersectsPlaneArray(const kmSphere* spheres, kmUint count,
+                                    const struct kmPlane* pPlane,
+                                    kmBool* pResults);
+kmUint kmSphereIntersectsAABB3Array(const kmSphere* spheres, kmUint count,
+                                    const struct kmAABB3* pBox,
+                                    kmBool* pResults);
+kmUint kmSphereIntersectsSphereArray(const kmSphere* spheres, kmUint count,
+                                     const kmSphere* pOther,
+                                     kmBool* pResults);
+
+/**
+ * As above, but also stores the hit distance along the ray for each
+ * sphere in pDistances (which may be NULL).
+ */
+kmUint kmSphereIntersectsRay3Array(const kmSphere* spheres, kmUint count,
+                                   const struct kmRay3* pRay,
+                                   kmBool* pResults, kmScalar* pDistances);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
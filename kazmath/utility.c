@@ -23,6 +23,8 @@ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <stddef.h>
+
 #include "utility.h"
 
 kmScalar kmSQR(kmScalar s) {
@@ -58,3 +60,102 @@ kmScalar kmLerp(kmScalar x, kmScalar y, kmScalar t )
 {
     return x + t * ( y - x );
 }
+
+static kmEnum precision_mode = KM_PRECISION_ACCURATE;
+
+void kmSetPrecisionMode(kmEnum mode) {
+    precision_mode = mode;
+}
+
+kmEnum kmGetPrecisionMode(void) {
+    return precision_mode;
+}
+
+#ifdef USE_DOUBLE_PRECISION
+#define KM_LITERAL(x) x
+#define KM_FLOOR floor
+#else
+#define KM_LITERAL(x) x##f
+#define KM_FLOOR floorf
+#endif
+
+/*
+ * Cody-Waite reduction into [-pi/4, pi/4] followed by the minimax
+ * polynomials from Cephes' sinf/cosf. Everything stays in kmScalar and
+ * the quadrant is applied with selects and sign multiplies rather than
+ * branches, so loops over it vectorize.
+ */
+void kmFastSinCos(kmScalar radians, kmScalar* pSin, kmScalar* pCos) {
+    const kmScalar PIO2_1 = KM_LITERAL(1.5703125);
+    const kmScalar PIO2_2 = KM_LITERAL(4.837512969970703125e-4);
+    const kmScalar PIO2_3 = KM_LITERAL(7.54978995489188216e-8);
+    const kmScalar TWO_OVER_PI = KM_LITERAL(0.636619772367581343);
+
+    kmScalar k = KM_FLOOR(radians * TWO_OVER_PI + KM_LITERAL(0.5));
+    kmScalar r = ((radians - k * PIO2_1) - k * PIO2_2) - k * PIO2_3;
+    kmScalar r2 = r * r;
+
+    /* k mod 4, taken in floating point so huge or non-finite input
+     * never reaches an out of range integer conversion */
+    kmScalar q = k - KM_LITERAL(4.0) * KM_FLOOR(k * KM_LITERAL(0.25));
+    kmInt quadrant = (q >= KM_LITERAL(1.0)) + (q >= KM_LITERAL(2.0)) + (q >= KM_LITERAL(3.0));
+
+    kmScalar s = r + r * r2 * (KM_LITERAL(-1.6666654611e-1) + r2 * (KM_LITERAL(8.3321608736e-3) + r2 * KM_LITERAL(-1.9515295891e-4)));
+    kmScalar c = 1 - KM_LITERAL(0.5) * r2 + r2 * r2 * (KM_LITERAL(4.166664568298827e-2) + r2 * (KM_LITERAL(-1.388731625493765e-3) + r2 * KM_LITERAL(2.443315711809948e-5)));
+
+    /* Quadrants 1 and 3 swap sin and cos, 2 and 3 negate sin, 1 and 2 negate cos */
+    kmInt swapped = quadrant & 1;
+    kmScalar sin_sign = (kmScalar) (1 - (quadrant & 2));
+    kmScalar cos_sign = (kmScalar) (1 - ((quadrant + 1) & 2));
+    kmScalar rs = sin_sign * (swapped ? c : s);
+    kmScalar rc = cos_sign * (swapped ? s : c);
+
+    if(pSin) *pSin = rs;
+    if(pCos) *pCos = rc;
+}
+
+#undef KM_LITERAL
+#undef KM_FLOOR
+
+kmScalar kmFastSin(kmScalar radians) {
+    kmScalar s;
+    kmFastSinCos(radians, &s, NULL);
+    return s;
+}
+
+kmScalar kmFastCos(kmScalar radians) {
+    kmScalar c;
+    kmFastSinCos(radians, NULL, &c);
+    return c;
+}
+
+void kmSinCos(kmScalar radians, kmScalar* pSin, kmScalar* pCos) {
+    if(precision_mode == KM_PRECISION_FAST) {
+        kmFastSinCos(radians, pSin, pCos);
+        return;
+    }
+
+    /* Written side by side so the compiler can fuse these into sincos */
+#ifdef USE_DOUBLE_PRECISION
+    if(pSin) *pSin = sin(radians);
+    if(pCos) *pCos = cos(radians);
+#else
+    if(pSin) *pSin = sinf(radians);
+    if(pCos) *pCos = cosf(radians);
+#endif
+}
+
+void kmSinCosArray(const kmScalar* radians, kmScalar* pSin, kmScalar* pCos,
+                   kmUint count) {
+    kmUint i;
+
+    if(precision_mode == KM_PRECISION_FAST) {
+        for(i = 0; i < count; ++i) {
+            kmFastSinCos(radians[i], &pSin[i], &pCos[i]);
+        }
+    } else {
+        for(i = 0; i < count; ++i) {
+            kmSinCos(radians[i], &pSin[i], &pCos[i]);
+        }
+    }
+}
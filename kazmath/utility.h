@@ -40,6 +40,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #endif
 
+/* libm calls matching kmScalar, so double builds never round through float */
+#ifdef USE_DOUBLE_PRECISION
+#define kmSqrt sqrt
+#define kmAcos acos
+#else
+#define kmSqrt sqrtf
+#define kmAcos acosf
+#endif
+
 #ifndef kmBool
 #define kmBool unsigned char
 #endif
@@ -76,6 +85,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define KM_CONTAINS_PARTIAL (kmEnum)1
 #define KM_CONTAINS_ALL (kmEnum)2
 
+/* Precision modes used by kmSinCos and the rotation builders */
+#define KM_PRECISION_ACCURATE (kmEnum)0
+#define KM_PRECISION_FAST (kmEnum)1
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -102,6 +115,39 @@ extern kmBool kmAlmostEqual(kmScalar lhs, kmScalar rhs);
 extern kmScalar kmClamp(kmScalar x, kmScalar min, kmScalar max);
 extern kmScalar kmLerp(kmScalar x, kmScalar y, kmScalar factor);
 
+/**
+ * Sets the precision mode used by kmSinCos (and so by all of the
+ * rotation builders). KM_PRECISION_ACCURATE (the default) uses the C
+ * library, KM_PRECISION_FAST uses minimax polynomial approximations
+ * which are accurate to a few float ULP. The mode is a plain global
+ * read by every call without synchronisation, so set it at start up
+ * and don't change it while other threads may be using kazmath.
+ */
+extern void kmSetPrecisionMode(kmEnum mode);
+extern kmEnum kmGetPrecisionMode(void);
+
+/**
+ * Calculates the sine and cosine of radians in one call, using the
+ * current precision mode. Either output may be NULL.
+ */
+extern void kmSinCos(kmScalar radians, kmScalar* pSin, kmScalar* pCos);
+
+/**
+ * Polynomial approximations of sin/cos, regardless of the precision
+ * mode. Accuracy degrades as |radians| grows and the results are
+ * meaningless beyond roughly 1e6; non-finite input gives NaN.
+ */
+extern void kmFastSinCos(kmScalar radians, kmScalar* pSin, kmScalar* pCos);
+extern kmScalar kmFastSin(kmScalar radians);
+extern kmScalar kmFastCos(kmScalar radians);
+
+/**
+ * Calculates the sine and cosine of count angles using the current
+ * precision mode. pSin and pCos must each hold count elements.
+ */
+extern void kmSinCosArray(const kmScalar* radians, kmScalar* pSin,
+                          kmScalar* pCos, kmUint count);
+
 #ifdef __cplusplus
 }
 #endif
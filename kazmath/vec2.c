@@ -45,7 +45,7 @@ kmVec2* kmVec2Fill(kmVec2* pOut, kmScalar x, kmScalar y)
 
 kmScalar kmVec2Length(const kmVec2* pIn)
 {
-    return sqrtf(kmSQR(pIn->x) + kmSQR(pIn->y));
+    return kmSqrt(kmSQR(pIn->x) + kmSQR(pIn->y));
 }
 
 kmScalar kmVec2LengthSq(const kmVec2* pIn)
@@ -170,10 +170,8 @@ kmVec2* kmVec2Assign(kmVec2* pOut, const kmVec2* pIn) {
 kmVec2* kmVec2RotateBy(kmVec2* pOut, const kmVec2* pIn,
       const kmScalar degrees, const kmVec2* center)
 {
-   kmScalar x, y;
-   const kmScalar radians = kmDegreesToRadians(degrees);
-   const kmScalar cs = cosf(radians);
-   const kmScalar sn = sinf(radians);
+   kmScalar x, y, cs, sn;
+   kmSinCos(kmDegreesToRadians(degrees), &sn, &cs);
 
    pOut->x = pIn->x - center->x;
    pOut->y = pIn->y - center->y;
@@ -37,6 +37,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "vec3.h"
 #include "plane.h"
 #include "ray3.h"
+#include "profile.h"
 
 const kmVec3 KM_VEC3_POS_Z = { 0, 0, 1 };
 const kmVec3 KM_VEC3_NEG_Z = { 0, 0, -1 };
@@ -57,7 +58,7 @@ kmVec3* kmVec3Fill(kmVec3* pOut, kmScalar x, kmScalar y, kmScalar z)
 
 kmScalar kmVec3Length(const kmVec3* pIn)
 {
-	return sqrtf(kmSQR(pIn->x) + kmSQR(pIn->y) + kmSQR(pIn->z));
+	return kmSqrt(kmSQR(pIn->x) + kmSQR(pIn->y) + kmSQR(pIn->z));
 }
 
 kmScalar kmVec3LengthSq(const kmVec3* pIn)
@@ -76,8 +77,12 @@ kmVec3* kmVec3Normalize(kmVec3* pOut, const kmVec3* pIn)
 {
 	kmVec3 v;
         kmScalar l;
-        if (!pIn->x && !pIn->y && !pIn->z)
+        KM_PROFILE_BEGIN(KM_PROFILE_VEC3_NORMALIZE);
+
+        if (!pIn->x && !pIn->y && !pIn->z) {
+                KM_PROFILE_END(KM_PROFILE_VEC3_NORMALIZE);
                 return kmVec3Assign(pOut, pIn);
+        }
 
         l = 1.0f / kmVec3Length(pIn);
 
@@ -89,6 +94,7 @@ kmVec3* kmVec3Normalize(kmVec3* pOut, const kmVec3* pIn)
 	pOut->y = v.y;
 	pOut->z = v.z;
 
+	KM_PROFILE_END(KM_PROFILE_VEC3_NORMALIZE);
 	return pOut;
 }
 
@@ -243,6 +249,8 @@ kmVec3* kmVec3TransformCoord(kmVec3* pOut, const kmVec3* pV, const kmMat4* pM)
 
     kmVec4 v;
     kmVec4 inV;
+    KM_PROFILE_BEGIN(KM_PROFILE_VEC3_TRANSFORM_COORD);
+
     kmVec4Fill(&inV, pV->x, pV->y, pV->z, 1.0);
 
     kmVec4Transform(&v, &inV,pM);
@@ -251,6 +259,7 @@ kmVec3* kmVec3TransformCoord(kmVec3* pOut, const kmVec3* pV, const kmMat4* pM)
 	pOut->y = v.y / v.w;
 	pOut->z = v.z / v.w;
 
+	KM_PROFILE_END(KM_PROFILE_VEC3_TRANSFORM_COORD);
 	return pOut;
 }
 
@@ -340,21 +349,14 @@ kmVec3* kmVec3GetHorizontalAngle(kmVec3* pOut, const kmVec3 *pIn) {
  */
 kmVec3* kmVec3RotationToDirection(kmVec3* pOut, const kmVec3* pIn, const kmVec3* forwards)
 {
-   const kmScalar xr = kmDegreesToRadians(pIn->x);
-   const kmScalar yr = kmDegreesToRadians(pIn->y);
-   const kmScalar zr = kmDegreesToRadians(pIn->z);
-
-   const kmScalar cr = cos(xr);
-   const kmScalar sr = sin(xr);
-
-   const kmScalar cp = cos(yr);
-   const kmScalar sp = sin(yr);
+   kmScalar cr, sr, cp, sp, cy, sy, srsp, crsp;
 
-   const kmScalar cy = cos(zr);
-   const kmScalar sy = sin(zr);
+   kmSinCos(kmDegreesToRadians(pIn->x), &sr, &cr);
+   kmSinCos(kmDegreesToRadians(pIn->y), &sp, &cp);
+   kmSinCos(kmDegreesToRadians(pIn->z), &sy, &cy);
 
-   const kmScalar srsp = sr*sp;
-   const kmScalar crsp = cr*sp;
+   srsp = sr*sp;
+   crsp = cr*sp;
 
    const kmScalar pseudoMatrix[] = {
       (cp*cy), (cp*sy), (-sp),
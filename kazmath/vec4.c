@@ -58,7 +58,7 @@ kmScalar kmVec4Dot(const kmVec4* pV1, const kmVec4* pV2) {
 }
 
 kmScalar kmVec4Length(const kmVec4* pIn) {
-	return sqrtf(kmSQR(pIn->x) + kmSQR(pIn->y) + kmSQR(pIn->z) + kmSQR(pIn->w));
+	return kmSqrt(kmSQR(pIn->x) + kmSQR(pIn->y) + kmSQR(pIn->z) + kmSQR(pIn->w));
 }
 
 kmScalar kmVec4LengthSq(const kmVec4* pIn) {
@@ -0,0 +1,197 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _KAZMATHXX_BASIC_MAT3_H
+#define _KAZMATHXX_BASIC_MAT3_H
+
+#include <cstring>
+#include <kazmath/mat3.h>
+#include "basic_utility.h"
+#include "basic_vec3.h"
+#include "basic_quaternion.h"
+
+namespace km
+{
+	///< A column major 3x3 matrix, laid out like kmMat3
+	template<typename T>
+	class basic_mat3
+	{
+	public:
+		T mat[9];
+
+		/// Constructors, the default is the identity
+		basic_mat3()
+		{
+			identity();
+		}
+
+		explicit basic_mat3(const T* pIn)
+		{
+			std::memcpy(mat, pIn, sizeof(mat));
+		}
+
+		///< Converts from another precision
+		template<typename U>
+		explicit basic_mat3(const basic_mat3<U>& m)
+		{
+			for(int i = 0; i < 9; ++i) mat[i] = T(m.mat[i]);
+		}
+
+		///< Converts from the C struct, in whatever precision kmScalar is
+		explicit basic_mat3(const kmMat3& m)
+		{
+			for(int i = 0; i < 9; ++i) mat[i] = T(m.mat[i]);
+		}
+
+		const kmMat3 toKmMat3() const
+		{
+			kmMat3 result;
+			for(int i = 0; i < 9; ++i) result.mat[i] = kmScalar(mat[i]);
+			return result;
+		}
+
+		void identity()
+		{
+			for(int i = 0; i < 9; ++i) mat[i] = (i % 4 == 0) ? T(1) : T(0);
+		}
+
+		const bool isIdentity() const
+		{
+			return *this == basic_mat3();
+		}
+
+		const T determinant() const
+		{
+			return mat[0] * (mat[4] * mat[8] - mat[5] * mat[7])
+			     - mat[3] * (mat[1] * mat[8] - mat[2] * mat[7])
+			     + mat[6] * (mat[1] * mat[5] - mat[2] * mat[4]);
+		}
+
+		///< Like km::mat3, a singular matrix is returned unchanged
+		const basic_mat3 inverse() const
+		{
+			const T det = determinant();
+			basic_mat3 result;
+
+			if(det == 0) {
+				return *this;
+			}
+
+			result.mat[0] = mat[4] * mat[8] - mat[5] * mat[7];
+			result.mat[1] = mat[2] * mat[7] - mat[1] * mat[8];
+			result.mat[2] = mat[1] * mat[5] - mat[2] * mat[4];
+			result.mat[3] = mat[5] * mat[6] - mat[3] * mat[8];
+			result.mat[4] = mat[0] * mat[8] - mat[2] * mat[6];
+			result.mat[5] = mat[2] * mat[3] - mat[0] * mat[5];
+			result.mat[6] = mat[3] * mat[7] - mat[4] * mat[6];
+			result.mat[7] = mat[1] * mat[6] - mat[0] * mat[7];
+			result.mat[8] = mat[0] * mat[4] - mat[1] * mat[3];
+
+			for(int i = 0; i < 9; ++i) result.mat[i] /= det;
+			return result;
+		}
+
+		const basic_mat3 transpose() const
+		{
+			basic_mat3 result;
+			for(int c = 0; c < 3; ++c) {
+				for(int r = 0; r < 3; ++r) {
+					result.mat[c * 3 + r] = mat[r * 3 + c];
+				}
+			}
+			return result;
+		}
+
+		///< The same rotation as the upper 3x3 of basic_mat4::rotationQuaternion
+		static const basic_mat3 rotationQuaternion(const basic_quaternion<T>& q)
+		{
+			basic_mat3 result;
+			result.mat[0] = 1 - 2 * (q.y * q.y + q.z * q.z);
+			result.mat[1] = 2 * (q.x * q.y + q.z * q.w);
+			result.mat[2] = 2 * (q.x * q.z - q.y * q.w);
+			result.mat[3] = 2 * (q.x * q.y - q.z * q.w);
+			result.mat[4] = 1 - 2 * (q.x * q.x + q.z * q.z);
+			result.mat[5] = 2 * (q.y * q.z + q.x * q.w);
+			result.mat[6] = 2 * (q.x * q.z + q.y * q.w);
+			result.mat[7] = 2 * (q.y * q.z - q.x * q.w);
+			result.mat[8] = 1 - 2 * (q.x * q.x + q.y * q.y);
+			return result;
+		}
+
+		static const basic_mat3 rotationAxisAngle(const basic_vec3<T>& axis, const T radians)
+		{
+			return rotationQuaternion(basic_quaternion<T>::rotationAxisAngle(axis, radians));
+		}
+
+		static const basic_mat3 scaling(const T x, const T y, const T z)
+		{
+			basic_mat3 result;
+			result.mat[0] = x;
+			result.mat[4] = y;
+			result.mat[8] = z;
+			return result;
+		}
+	};
+
+	///< Matrix multiplication
+	template<typename T>
+	inline const basic_mat3<T> operator*(const basic_mat3<T>& lhs, const basic_mat3<T>& rhs)
+	{
+		basic_mat3<T> result;
+		for(int c = 0; c < 3; ++c) {
+			for(int r = 0; r < 3; ++r) {
+				result.mat[c * 3 + r] = lhs.mat[r] * rhs.mat[c * 3] + lhs.mat[3 + r] * rhs.mat[c * 3 + 1] +
+				                        lhs.mat[6 + r] * rhs.mat[c * 3 + 2];
+			}
+		}
+		return result;
+	}
+
+	///< Transforms a vector, as kmVec3MultiplyMat3
+	template<typename T>
+	inline const basic_vec3<T> operator*(const basic_mat3<T>& lhs, const basic_vec3<T>& rhs)
+	{
+		return basic_vec3<T>(
+			rhs.x * lhs.mat[0] + rhs.y * lhs.mat[3] + rhs.z * lhs.mat[6],
+			rhs.x * lhs.mat[1] + rhs.y * lhs.mat[4] + rhs.z * lhs.mat[7],
+			rhs.x * lhs.mat[2] + rhs.y * lhs.mat[5] + rhs.z * lhs.mat[8]
+		);
+	}
+
+	///< Checks for equality (with a small threshold epsilon)
+	template<typename T>
+	inline const bool operator==(const basic_mat3<T>& lhs, const basic_mat3<T>& rhs)
+	{
+		for(int i = 0; i < 9; ++i) {
+			if(!almostEqual(lhs.mat[i], rhs.mat[i])) return false;
+		}
+		return true;
+	}
+
+	typedef basic_mat3<float> mat3f;
+	typedef basic_mat3<double> mat3d;
+}
+
+#endif
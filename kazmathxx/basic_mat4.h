@@ -0,0 +1,416 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _KAZMATHXX_BASIC_MAT4_H
+#define _KAZMATHXX_BASIC_MAT4_H
+
+#include <cstring>
+#include <kazmath/mat4.h>
+#include "basic_utility.h"
+#include "basic_vec3.h"
+#include "basic_vec4.h"
+#include "basic_mat3.h"
+#include "basic_quaternion.h"
+
+namespace km
+{
+	///< A column major 4x4 matrix, laid out like kmMat4
+	template<typename T>
+	class basic_mat4
+	{
+	public:
+		T mat[16];
+
+		/// Constructors, the default is the identity
+		basic_mat4()
+		{
+			identity();
+		}
+
+		explicit basic_mat4(const T* pIn)
+		{
+			std::memcpy(mat, pIn, sizeof(mat));
+		}
+
+		///< Converts from another precision
+		template<typename U>
+		explicit basic_mat4(const basic_mat4<U>& m)
+		{
+			for(int i = 0; i < 16; ++i) mat[i] = T(m.mat[i]);
+		}
+
+		///< Converts from the C struct, in whatever precision kmScalar is
+		explicit basic_mat4(const kmMat4& m)
+		{
+			for(int i = 0; i < 16; ++i) mat[i] = T(m.mat[i]);
+		}
+
+		const kmMat4 toKmMat4() const
+		{
+			kmMat4 result;
+			for(int i = 0; i < 16; ++i) result.mat[i] = kmScalar(mat[i]);
+			return result;
+		}
+
+		void identity()
+		{
+			for(int i = 0; i < 16; ++i) mat[i] = (i % 5 == 0) ? T(1) : T(0);
+		}
+
+		const bool isIdentity() const
+		{
+			return *this == basic_mat4();
+		}
+
+		///< Like km::mat4, a singular matrix is returned unchanged
+		const basic_mat4 inverse() const
+		{
+			basic_mat4 inv;
+			T det;
+
+			inv.mat[0] = mat[5]  * mat[10] * mat[15] -
+				mat[5]  * mat[11] * mat[14] -
+				mat[9]  * mat[6]  * mat[15] +
+				mat[9]  * mat[7]  * mat[14] +
+				mat[13] * mat[6]  * mat[11] -
+				mat[13] * mat[7]  * mat[10];
+
+			inv.mat[4] = -mat[4]  * mat[10] * mat[15] +
+				mat[4]  * mat[11] * mat[14] +
+				mat[8]  * mat[6]  * mat[15] -
+				mat[8]  * mat[7]  * mat[14] -
+				mat[12] * mat[6]  * mat[11] +
+				mat[12] * mat[7]  * mat[10];
+
+			inv.mat[8] = mat[4]  * mat[9] * mat[15] -
+				mat[4]  * mat[11] * mat[13] -
+				mat[8]  * mat[5] * mat[15] +
+				mat[8]  * mat[7] * mat[13] +
+				mat[12] * mat[5] * mat[11] -
+				mat[12] * mat[7] * mat[9];
+
+			inv.mat[12] = -mat[4]  * mat[9] * mat[14] +
+				mat[4]  * mat[10] * mat[13] +
+				mat[8]  * mat[5] * mat[14] -
+				mat[8]  * mat[6] * mat[13] -
+				mat[12] * mat[5] * mat[10] +
+				mat[12] * mat[6] * mat[9];
+
+			inv.mat[1] = -mat[1]  * mat[10] * mat[15] +
+				mat[1]  * mat[11] * mat[14] +
+				mat[9]  * mat[2] * mat[15] -
+				mat[9]  * mat[3] * mat[14] -
+				mat[13] * mat[2] * mat[11] +
+				mat[13] * mat[3] * mat[10];
+
+			inv.mat[5] = mat[0]  * mat[10] * mat[15] -
+				mat[0]  * mat[11] * mat[14] -
+				mat[8]  * mat[2] * mat[15] +
+				mat[8]  * mat[3] * mat[14] +
+				mat[12] * mat[2] * mat[11] -
+				mat[12] * mat[3] * mat[10];
+
+			inv.mat[9] = -mat[0]  * mat[9] * mat[15] +
+				mat[0]  * mat[11] * mat[13] +
+				mat[8]  * mat[1] * mat[15] -
+				mat[8]  * mat[3] * mat[13] -
+				mat[12] * mat[1] * mat[11] +
+				mat[12] * mat[3] * mat[9];
+
+			inv.mat[13] = mat[0]  * mat[9] * mat[14] -
+				mat[0]  * mat[10] * mat[13] -
+				mat[8]  * mat[1] * mat[14] +
+				mat[8]  * mat[2] * mat[13] +
+				mat[12] * mat[1] * mat[10] -
+				mat[12] * mat[2] * mat[9];
+
+			inv.mat[2] = mat[1]  * mat[6] * mat[15] -
+				mat[1]  * mat[7] * mat[14] -
+				mat[5]  * mat[2] * mat[15] +
+				mat[5]  * mat[3] * mat[14] +
+				mat[13] * mat[2] * mat[7] -
+				mat[13] * mat[3] * mat[6];
+
+			inv.mat[6] = -mat[0]  * mat[6] * mat[15] +
+				mat[0]  * mat[7] * mat[14] +
+				mat[4]  * mat[2] * mat[15] -
+				mat[4]  * mat[3] * mat[14] -
+				mat[12] * mat[2] * mat[7] +
+				mat[12] * mat[3] * mat[6];
+
+			inv.mat[10] = mat[0]  * mat[5] * mat[15] -
+				mat[0]  * mat[7] * mat[13] -
+				mat[4]  * mat[1] * mat[15] +
+				mat[4]  * mat[3] * mat[13] +
+				mat[12] * mat[1] * mat[7] -
+				mat[12] * mat[3] * mat[5];
+
+			inv.mat[14] = -mat[0]  * mat[5] * mat[14] +
+				mat[0]  * mat[6] * mat[13] +
+				mat[4]  * mat[1] * mat[14] -
+				mat[4]  * mat[2] * mat[13] -
+				mat[12] * mat[1] * mat[6] +
+				mat[12] * mat[2] * mat[5];
+
+			inv.mat[3] = -mat[1] * mat[6] * mat[11] +
+				mat[1] * mat[7] * mat[10] +
+				mat[5] * mat[2] * mat[11] -
+				mat[5] * mat[3] * mat[10] -
+				mat[9] * mat[2] * mat[7] +
+				mat[9] * mat[3] * mat[6];
+
+			inv.mat[7] = mat[0] * mat[6] * mat[11] -
+				mat[0] * mat[7] * mat[10] -
+				mat[4] * mat[2] * mat[11] +
+				mat[4] * mat[3] * mat[10] +
+				mat[8] * mat[2] * mat[7] -
+				mat[8] * mat[3] * mat[6];
+
+			inv.mat[11] = -mat[0] * mat[5] * mat[11] +
+				mat[0] * mat[7] * mat[9] +
+				mat[4] * mat[1] * mat[11] -
+				mat[4] * mat[3] * mat[9] -
+				mat[8] * mat[1] * mat[7] +
+				mat[8] * mat[3] * mat[5];
+
+			inv.mat[15] = mat[0] * mat[5] * mat[10] -
+				mat[0] * mat[6] * mat[9] -
+				mat[4] * mat[1] * mat[10] +
+				mat[4] * mat[2] * mat[9] +
+				mat[8] * mat[1] * mat[6] -
+				mat[8] * mat[2] * mat[5];
+
+
+			det = mat[0] * inv.mat[0] + mat[1] * inv.mat[4] + mat[2] * inv.mat[8] + mat[3] * inv.mat[12];
+			if(det == 0) {
+				return *this;
+			}
+
+			for(int i = 0; i < 16; ++i) inv.mat[i] /= det;
+			return inv;
+		}
+
+		const basic_mat4 transpose() const
+		{
+			basic_mat4 result;
+			for(int c = 0; c < 4; ++c) {
+				for(int r = 0; r < 4; ++r) {
+					result.mat[c * 4 + r] = mat[r * 4 + c];
+				}
+			}
+			return result;
+		}
+
+		///< The upper 3x3, as kmMat4ExtractRotationMat3
+		const basic_mat3<T> extractRotation() const
+		{
+			basic_mat3<T> result;
+			for(int c = 0; c < 3; ++c) {
+				for(int r = 0; r < 3; ++r) {
+					result.mat[c * 3 + r] = mat[c * 4 + r];
+				}
+			}
+			return result;
+		}
+
+		///< Transforms a point, projecting the result back into w = 1
+		const basic_vec3<T> transformCoord(const basic_vec3<T>& v) const
+		{
+			const basic_vec4<T> result = *this * basic_vec4<T>(v.x, v.y, v.z, 1);
+			return basic_vec3<T>(result.x / result.w, result.y / result.w, result.z / result.w);
+		}
+
+		///< Transforms a direction, ignoring the translation
+		const basic_vec3<T> transformNormal(const basic_vec3<T>& v) const
+		{
+			return basic_vec3<T>(
+				v.x * mat[0] + v.y * mat[4] + v.z * mat[8],
+				v.x * mat[1] + v.y * mat[5] + v.z * mat[9],
+				v.x * mat[2] + v.y * mat[6] + v.z * mat[10]
+			);
+		}
+
+		static const basic_mat4 translation(const T x, const T y, const T z)
+		{
+			basic_mat4 result;
+			result.mat[12] = x;
+			result.mat[13] = y;
+			result.mat[14] = z;
+			return result;
+		}
+
+		static const basic_mat4 scaling(const T x, const T y, const T z)
+		{
+			basic_mat4 result;
+			result.mat[0] = x;
+			result.mat[5] = y;
+			result.mat[10] = z;
+			return result;
+		}
+
+		static const basic_mat4 rotationX(const T radians)
+		{
+			basic_mat4 result;
+			const T s = std::sin(radians), c = std::cos(radians);
+			result.mat[5] = c;
+			result.mat[6] = s;
+			result.mat[9] = -s;
+			result.mat[10] = c;
+			return result;
+		}
+
+		static const basic_mat4 rotationY(const T radians)
+		{
+			basic_mat4 result;
+			const T s = std::sin(radians), c = std::cos(radians);
+			result.mat[0] = c;
+			result.mat[2] = -s;
+			result.mat[8] = s;
+			result.mat[10] = c;
+			return result;
+		}
+
+		static const basic_mat4 rotationZ(const T radians)
+		{
+			basic_mat4 result;
+			const T s = std::sin(radians), c = std::cos(radians);
+			result.mat[0] = c;
+			result.mat[1] = s;
+			result.mat[4] = -s;
+			result.mat[5] = c;
+			return result;
+		}
+
+		static const basic_mat4 rotationQuaternion(const basic_quaternion<T>& q)
+		{
+			const basic_mat3<T> rotation = basic_mat3<T>::rotationQuaternion(q);
+			basic_mat4 result;
+			for(int c = 0; c < 3; ++c) {
+				for(int r = 0; r < 3; ++r) {
+					result.mat[c * 4 + r] = rotation.mat[c * 3 + r];
+				}
+			}
+			return result;
+		}
+
+		static const basic_mat4 rotationAxisAngle(const basic_vec3<T>& axis, const T radians)
+		{
+			return rotationQuaternion(basic_quaternion<T>::rotationAxisAngle(axis, radians));
+		}
+
+		///< As kmMat4PerspectiveProjection, fovY is in degrees
+		static const basic_mat4 perspectiveProjection(const T fovY, const T aspect, const T zNear, const T zFar)
+		{
+			const T r = degreesToRadians(fovY / 2);
+			const T cotangent = std::cos(r) / std::sin(r);
+			const T deltaZ = zNear - zFar;
+			basic_mat4 result;
+
+			result.mat[0] = cotangent / aspect;
+			result.mat[5] = cotangent;
+			result.mat[10] = (zFar + zNear) / deltaZ;
+			result.mat[11] = -1;
+			result.mat[14] = (2 * zFar * zNear) / deltaZ;
+			result.mat[15] = 0;
+			return result;
+		}
+
+		static const basic_mat4 orthographicProjection(const T left, const T right, const T bottom, const T top,
+		                                              const T nearVal, const T farVal)
+		{
+			basic_mat4 result;
+			result.mat[0] = 2 / (right - left);
+			result.mat[5] = 2 / (top - bottom);
+			result.mat[10] = -2 / (farVal - nearVal);
+			result.mat[12] = -((right + left) / (right - left));
+			result.mat[13] = -((top + bottom) / (top - bottom));
+			result.mat[14] = -((farVal + nearVal) / (farVal - nearVal));
+			return result;
+		}
+
+		static const basic_mat4 lookAt(const basic_vec3<T>& eye, const basic_vec3<T>& center, const basic_vec3<T>& up)
+		{
+			const basic_vec3<T> f = (center - eye).normalize();
+			const basic_vec3<T> s = f.cross(up).normalize();
+			const basic_vec3<T> u = s.cross(f);
+			basic_mat4 result;
+
+			result.mat[0] = s.x;
+			result.mat[1] = u.x;
+			result.mat[2] = -f.x;
+			result.mat[4] = s.y;
+			result.mat[5] = u.y;
+			result.mat[6] = -f.y;
+			result.mat[8] = s.z;
+			result.mat[9] = u.z;
+			result.mat[10] = -f.z;
+			result.mat[12] = -s.dot(eye);
+			result.mat[13] = -u.dot(eye);
+			result.mat[14] = f.dot(eye);
+			return result;
+		}
+	};
+
+	///< Matrix multiplication
+	template<typename T>
+	inline const basic_mat4<T> operator*(const basic_mat4<T>& lhs, const basic_mat4<T>& rhs)
+	{
+		basic_mat4<T> result;
+		for(int c = 0; c < 4; ++c) {
+			for(int r = 0; r < 4; ++r) {
+				result.mat[c * 4 + r] = lhs.mat[r] * rhs.mat[c * 4] + lhs.mat[4 + r] * rhs.mat[c * 4 + 1] +
+				                        lhs.mat[8 + r] * rhs.mat[c * 4 + 2] + lhs.mat[12 + r] * rhs.mat[c * 4 + 3];
+			}
+		}
+		return result;
+	}
+
+	///< Transforms a vector, as kmVec4MultiplyMat4
+	template<typename T>
+	inline const basic_vec4<T> operator*(const basic_mat4<T>& lhs, const basic_vec4<T>& rhs)
+	{
+		return basic_vec4<T>(
+			rhs.x * lhs.mat[0] + rhs.y * lhs.mat[4] + rhs.z * lhs.mat[8] + rhs.w * lhs.mat[12],
+			rhs.x * lhs.mat[1] + rhs.y * lhs.mat[5] + rhs.z * lhs.mat[9] + rhs.w * lhs.mat[13],
+			rhs.x * lhs.mat[2] + rhs.y * lhs.mat[6] + rhs.z * lhs.mat[10] + rhs.w * lhs.mat[14],
+			rhs.x * lhs.mat[3] + rhs.y * lhs.mat[7] + rhs.z * lhs.mat[11] + rhs.w * lhs.mat[15]
+		);
+	}
+
+	///< Checks for equality (with a small threshold epsilon)
+	template<typename T>
+	inline const bool operator==(const basic_mat4<T>& lhs, const basic_mat4<T>& rhs)
+	{
+		for(int i = 0; i < 16; ++i) {
+			if(!almostEqual(lhs.mat[i], rhs.mat[i])) return false;
+		}
+		return true;
+	}
+
+	typedef basic_mat4<float> mat4f;
+	typedef basic_mat4<double> mat4d;
+}
+
+#endif
@@ -0,0 +1,179 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _KAZMATHXX_BASIC_QUATERNION_H
+#define _KAZMATHXX_BASIC_QUATERNION_H
+
+#include <kazmath/quaternion.h>
+#include "basic_utility.h"
+#include "basic_vec3.h"
+
+namespace km
+{
+	template<typename T>
+	class basic_quaternion
+	{
+		public:
+			T x, y, z, w;
+
+			///< Constructors, the default is the identity
+			basic_quaternion() : x(0), y(0), z(0), w(1) {}
+			basic_quaternion(const T _x, const T _y, const T _z, const T _w) : x(_x), y(_y), z(_z), w(_w) {}
+
+			///< Converts from another precision
+			template<typename U>
+			explicit basic_quaternion(const basic_quaternion<U>& q) : x(T(q.x)), y(T(q.y)), z(T(q.z)), w(T(q.w)) {}
+
+			///< Converts from the C struct, in whatever precision kmScalar is
+			explicit basic_quaternion(const kmQuaternion& q) : x(T(q.x)), y(T(q.y)), z(T(q.z)), w(T(q.w)) {}
+
+			const kmQuaternion toKmQuaternion() const
+			{
+				kmQuaternion result;
+				result.x = kmScalar(x);
+				result.y = kmScalar(y);
+				result.z = kmScalar(z);
+				result.w = kmScalar(w);
+				return result;
+			}
+
+			///< Like kmQuaternionRotationAxisAngle, normalizes the result rather than the axis
+			static const basic_quaternion rotationAxisAngle(const basic_vec3<T>& axis, const T radians)
+			{
+				const T s = std::sin(radians / 2);
+				return basic_quaternion(axis.x * s, axis.y * s, axis.z * s, std::cos(radians / 2)).normalize();
+			}
+
+			const T dot(const basic_quaternion& rhs) const
+			{
+				return x * rhs.x + y * rhs.y + z * rhs.z + w * rhs.w;
+			}
+
+			const T lengthSq() const
+			{
+				return dot(*this);
+			}
+
+			const T length() const
+			{
+				return std::sqrt(lengthSq());
+			}
+
+			///< Returns the quaternion set to unit length, a (nearly) zero one becomes zero
+			const basic_quaternion normalize() const
+			{
+				const T l = length();
+				if(l < std::numeric_limits<T>::epsilon()) {
+					return basic_quaternion(0, 0, 0, 0);
+				}
+				return *this * (T(1) / l);
+			}
+
+			const basic_quaternion conjugate() const
+			{
+				return basic_quaternion(-x, -y, -z, w);
+			}
+
+			///< As kmQuaternionInverse, the conjugate, or zero for a zero quaternion
+			const basic_quaternion inverse() const
+			{
+				if(length() < std::numeric_limits<T>::epsilon()) {
+					return basic_quaternion(0, 0, 0, 0);
+				}
+				return conjugate();
+			}
+
+			///< Spherical interpolation, falling back to a normalized lerp for close rotations
+			static const basic_quaternion slerp(const basic_quaternion& q1, const basic_quaternion& q2, const T t)
+			{
+				T dot = q1.dot(q2);
+
+				if(dot > T(0.9995)) {
+					return (q1 + (q2 - q1) * t).normalize();
+				}
+
+				dot = std::min(T(1), std::max(T(-1), dot));
+
+				const T theta = std::acos(dot) * t;
+				const basic_quaternion tmp = (q2 - q1 * dot).normalize();
+				return q1 * std::cos(theta) + tmp * std::sin(theta);
+			}
+
+			inline bool operator==(const basic_quaternion& rhs) const
+			{
+				return almostEqual(x, rhs.x) && almostEqual(y, rhs.y) && almostEqual(z, rhs.z) && almostEqual(w, rhs.w);
+			}
+
+			inline bool operator!=(const basic_quaternion& rhs) const
+			{
+				return !(*this == rhs);
+			}
+
+			inline basic_quaternion operator+(const basic_quaternion& rhs) const
+			{
+				return basic_quaternion(x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w);
+			}
+
+			inline basic_quaternion operator-(const basic_quaternion& rhs) const
+			{
+				return basic_quaternion(x - rhs.x, y - rhs.y, z - rhs.z, w - rhs.w);
+			}
+
+			inline basic_quaternion operator*(const T rhs) const
+			{
+				return basic_quaternion(x * rhs, y * rhs, z * rhs, w * rhs);
+			}
+
+			///< Concatenates rotations, as kmQuaternionMultiply
+			inline basic_quaternion operator*(const basic_quaternion& rhs) const
+			{
+				return basic_quaternion(
+					w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+					w * rhs.y + y * rhs.w + z * rhs.x - x * rhs.z,
+					w * rhs.z + z * rhs.w + x * rhs.y - y * rhs.x,
+					w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z
+				);
+			}
+
+			inline basic_quaternion& operator*=(const basic_quaternion& rhs)
+			{
+				return *this = *this * rhs;
+			}
+
+			///< Rotates a vector, as kmQuaternionMultiplyVec3
+			inline basic_vec3<T> operator*(const basic_vec3<T>& v) const
+			{
+				const basic_vec3<T> q(x, y, z);
+				const basic_vec3<T> uv = q.cross(v);
+				const basic_vec3<T> uuv = q.cross(uv);
+				return v + uv * (2 * w) + uuv * T(2);
+			}
+	};
+
+	typedef basic_quaternion<float> quaternionf;
+	typedef basic_quaternion<double> quaterniond;
+}
+
+#endif
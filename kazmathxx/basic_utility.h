@@ -0,0 +1,64 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _KAZMATHXX_BASIC_UTILITY_H
+#define _KAZMATHXX_BASIC_UTILITY_H
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+/*
+ * The basic_* templates are header only and don't depend on kmScalar, so
+ * float and double versions can be used side by side in one build. Their
+ * conventions (column major matrices, x y z w quaternions, angles in
+ * radians unless stated otherwise) and formulas follow the C library.
+ * Conversions between precisions, and to and from the C structs, are
+ * always explicit.
+ */
+
+namespace km
+{
+	///< The same comparison as kmAlmostEqual, with the epsilon of T
+	template<typename T>
+	inline bool almostEqual(const T lhs, const T rhs)
+	{
+		return std::fabs(lhs - rhs) <= std::numeric_limits<T>::epsilon() * std::max(T(1), std::max(lhs, rhs));
+	}
+
+	template<typename T>
+	inline T pi()
+	{
+		return T(3.14159265358979323846);
+	}
+
+	template<typename T>
+	inline T degreesToRadians(const T degrees)
+	{
+		return degrees * pi<T>() / T(180);
+	}
+}
+
+#endif
@@ -0,0 +1,199 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _KAZMATHXX_BASIC_VEC2_H
+#define _KAZMATHXX_BASIC_VEC2_H
+
+#include <kazmath/vec2.h>
+#include "basic_utility.h"
+
+namespace km
+{
+	template<typename T>
+	class basic_vec2
+	{
+		public:
+			T x, y;
+
+			///< Constructors
+			basic_vec2() : x(0), y(0) {}
+			basic_vec2(const T _x, const T _y) : x(_x), y(_y) {}
+
+			///< Converts from another precision
+			template<typename U>
+			explicit basic_vec2(const basic_vec2<U>& v) : x(T(v.x)), y(T(v.y)) {}
+
+			///< Converts from the C struct, in whatever precision kmScalar is
+			explicit basic_vec2(const kmVec2& v) : x(T(v.x)), y(T(v.y)) {}
+
+			const kmVec2 toKmVec2() const
+			{
+				kmVec2 result;
+				result.x = kmScalar(x);
+				result.y = kmScalar(y);
+				return result;
+			}
+
+			///< Returns the length of the vector
+			const T length() const
+			{
+				return std::sqrt(lengthSq());
+			}
+
+			///< Returns the square of the length of the vector
+			const T lengthSq() const
+			{
+				return dot(*this);
+			}
+
+			///< Returns the vector set to unit length, a zero vector stays zero
+			const basic_vec2 normalize() const
+			{
+				const T l = length();
+				return l ? *this * (T(1) / l) : *this;
+			}
+
+			const T dot(const basic_vec2& rhs) const
+			{
+				return x * rhs.x + y * rhs.y;
+			}
+
+			inline bool operator==(const basic_vec2& rhs) const
+			{
+				return almostEqual(x, rhs.x) && almostEqual(y, rhs.y);
+			}
+
+			inline bool operator!=(const basic_vec2& rhs) const
+			{
+				return !(*this == rhs);
+			}
+
+			inline basic_vec2 operator+(const basic_vec2& rhs) const
+			{
+				return basic_vec2(x + rhs.x, y + rhs.y);
+			}
+
+			inline basic_vec2 operator+(const T rhs) const
+			{
+				return basic_vec2(x + rhs, y + rhs);
+			}
+
+			inline basic_vec2& operator+=(const basic_vec2& rhs)
+			{
+				return *this = *this + rhs;
+			}
+
+			inline basic_vec2& operator+=(const T rhs)
+			{
+				return *this = *this + rhs;
+			}
+
+			inline basic_vec2 operator-(const basic_vec2& rhs) const
+			{
+				return basic_vec2(x - rhs.x, y - rhs.y);
+			}
+
+			inline basic_vec2 operator-(const T rhs) const
+			{
+				return basic_vec2(x - rhs, y - rhs);
+			}
+
+			inline basic_vec2& operator-=(const basic_vec2& rhs)
+			{
+				return *this = *this - rhs;
+			}
+
+			inline basic_vec2& operator-=(const T rhs)
+			{
+				return *this = *this - rhs;
+			}
+
+			inline basic_vec2 operator*(const basic_vec2& rhs) const
+			{
+				return basic_vec2(x * rhs.x, y * rhs.y);
+			}
+
+			inline basic_vec2 operator*(const T rhs) const
+			{
+				return basic_vec2(x * rhs, y * rhs);
+			}
+
+			inline basic_vec2& operator*=(const basic_vec2& rhs)
+			{
+				return *this = *this * rhs;
+			}
+
+			inline basic_vec2& operator*=(const T rhs)
+			{
+				return *this = *this * rhs;
+			}
+
+			///< Like km::vec2, dividing by zero leaves the vector unchanged
+			inline basic_vec2 operator/(const basic_vec2& rhs) const
+			{
+				if(rhs.x && rhs.y) {
+					return basic_vec2(x / rhs.x, y / rhs.y);
+				}
+				return *this;
+			}
+
+			inline basic_vec2 operator/(const T rhs) const
+			{
+				return rhs ? *this * (T(1) / rhs) : *this;
+			}
+
+			inline basic_vec2& operator/=(const basic_vec2& rhs)
+			{
+				return *this = *this / rhs;
+			}
+
+			inline basic_vec2& operator/=(const T rhs)
+			{
+				return *this = *this / rhs;
+			}
+
+			inline basic_vec2 operator-() const
+			{
+				return basic_vec2(-x, -y);
+			}
+
+			const T cross(const basic_vec2& rhs) const
+			{
+				return x * rhs.y - y * rhs.x;
+			}
+	};
+
+	///< Multiply with scalar
+	template<typename T>
+	inline const basic_vec2<T> operator*(const T lhs, const basic_vec2<T>& rhs)
+	{
+		return rhs * lhs;
+	}
+
+	typedef basic_vec2<float> vec2f;
+	typedef basic_vec2<double> vec2d;
+}
+
+#endif
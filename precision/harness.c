@@ -0,0 +1,470 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Differential accuracy harness. This file is built twice, once against
+ * kazmath and once against kazmath_double (the same sources built with
+ * USE_DOUBLE_PRECISION). The double build is the reference: it prints the
+ * output of every kernel for every sample. The float build runs it, runs
+ * the same kernels itself in each precision mode and prints a table of the
+ * worst errors.
+ *
+ * The inputs are generated from a fixed seed and rounded to float in both
+ * builds, so only the error of the kernel itself is measured. Errors are
+ * normwise: the largest difference of any output element, in ulps of
+ * (and relative to) the largest reference output element. Element-wise
+ * ulps blow up wherever the exact result is close to zero.
+ *
+ * The first samples of each kernel are adversarial (nearly singular,
+ * huge, tiny...) and are only reported. The random samples after them
+ * must stay within the kernel's ulp budget for each mode and must all be
+ * finite, otherwise the harness exits with 1, which fails the ctest.
+ *
+ *   kazmath_precision path/to/kazmath_precision_reference
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../kazmath/kazmath.h"
+
+#define SAMPLE_COUNT 2000
+#define MAX_INPUTS 32
+#define MAX_OUTPUTS 16
+
+typedef struct km_rng {
+    unsigned long long state;
+} km_rng;
+
+typedef struct km_precision_kernel {
+    const char* name;
+    kmUint input_count;
+    kmUint output_count;
+    kmBool uses_precision_mode; /* Whether KM_PRECISION_FAST changes it */
+    kmUint adversarial_count;   /* Leading samples which are only reported */
+    double accurate_budget;     /* Max ulps allowed on the random samples */
+    double fast_budget;
+    void (*generate)(km_rng* rng, kmUint sample, float* in);
+    void (*run)(const float* in, kmScalar* out);
+} km_precision_kernel;
+
+/* xorshift64*, the same sequence in both builds */
+static double rng_next(km_rng* rng) {
+    rng->state ^= rng->state >> 12;
+    rng->state ^= rng->state << 25;
+    rng->state ^= rng->state >> 27;
+    return (double) ((rng->state * 2685821657736338717ULL) >> 11) / 9007199254740992.0;
+}
+
+static double rng_range(km_rng* rng, double lo, double hi) {
+    return lo + (hi - lo) * rng_next(rng);
+}
+
+static void random_unit_quaternion(km_rng* rng, float* q) {
+    double x, y, z, w, l;
+    do {
+        x = rng_range(rng, -1, 1);
+        y = rng_range(rng, -1, 1);
+        z = rng_range(rng, -1, 1);
+        w = rng_range(rng, -1, 1);
+        l = x * x + y * y + z * z + w * w;
+    } while(l < 0.01 || l > 1);
+
+    l = sqrt(l);
+    q[0] = x / l;
+    q[1] = y / l;
+    q[2] = z / l;
+    q[3] = w / l;
+}
+
+static kmMat4* load_mat4(kmMat4* pOut, const float* in) {
+    kmUint i;
+    for(i = 0; i < 16; ++i) {
+        pOut->mat[i] = in[i];
+    }
+    return pOut;
+}
+
+static void store_mat4(kmScalar* out, const kmMat4* pIn) {
+    memcpy(out, pIn->mat, sizeof(kmScalar) * 16);
+}
+
+/* Adversarial cases come first, then random ones */
+
+static void generate_mat4_inverse(km_rng* rng, kmUint sample, float* in) {
+    kmUint i;
+
+    for(i = 0; i < 16; ++i) {
+        in[i] = rng_range(rng, -1, 1);
+    }
+
+    if(sample < 200) {
+        /* Nearly singular: the last column almost the sum of two others */
+        double eps = pow(10, -(double) (sample % 8));
+        for(i = 0; i < 4; ++i) {
+            in[12 + i] = in[i] + in[4 + i] + eps * in[12 + i];
+        }
+    } else if(sample < 400) {
+        /* Badly scaled: a diagonal spanning six orders of magnitude */
+        for(i = 0; i < 4; ++i) {
+            in[i * 5] = pow(10, rng_range(rng, -3, 3));
+        }
+    }
+}
+
+static void run_mat4_inverse(const float* in, kmScalar* out) {
+    kmMat4 m;
+    kmUint i;
+
+    if(!kmMat4Inverse(&m, load_mat4(&m, in))) {
+        for(i = 0; i < 16; ++i) out[i] = NAN;
+        return;
+    }
+    store_mat4(out, &m);
+}
+
+static void generate_mat4_multiply(km_rng* rng, kmUint sample, float* in) {
+    double scale = sample < 200 ? pow(10, rng_range(rng, -4, 4)) : 1;
+    kmUint i;
+
+    for(i = 0; i < 32; ++i) {
+        in[i] = rng_range(rng, -scale, scale);
+    }
+}
+
+static void run_mat4_multiply(const float* in, kmScalar* out) {
+    kmMat4 a, b;
+    load_mat4(&a, in);
+    load_mat4(&b, in + 16);
+    store_mat4(out, kmMat4Multiply(&a, &a, &b));
+}
+
+static void generate_vec3_normalize(km_rng* rng, kmUint sample, float* in) {
+    /* Lengths from 1e-30 to 1e30, where squaring under/overflows floats */
+    double scale = sample < 400 ? pow(10, -30 + 60.0 * sample / 399) : rng_range(rng, 0.1, 100);
+
+    in[0] = rng_range(rng, -scale, scale);
+    in[1] = rng_range(rng, -scale, scale);
+    in[2] = rng_range(rng, -scale, scale);
+}
+
+static void run_vec3_normalize(const float* in, kmScalar* out) {
+    kmVec3 v;
+    kmVec3Normalize(&v, kmVec3Fill(&v, in[0], in[1], in[2]));
+    out[0] = v.x;
+    out[1] = v.y;
+    out[2] = v.z;
+}
+
+static void generate_quaternion_slerp(km_rng* rng, kmUint sample, float* in) {
+    kmUint i;
+
+    random_unit_quaternion(rng, in);
+    random_unit_quaternion(rng, in + 4);
+    in[8] = rng_range(rng, 0, 1);
+
+    if(sample < 200) {
+        /* Around the lerp threshold, a cos(angle) of 0.9995 */
+        double angle = rng_range(rng, 0.02, 0.05);
+        double axis[3], l;
+        axis[0] = rng_range(rng, -1, 1);
+        axis[1] = rng_range(rng, -1, 1);
+        axis[2] = rng_range(rng, -1, 1);
+        l = sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+        /* q2 = q1 rotated by angle about axis (w last) */
+        {
+            double s = sin(angle / 2) / l, c = cos(angle / 2);
+            double x = axis[0] * s, y = axis[1] * s, z = axis[2] * s;
+            double q1[4];
+            for(i = 0; i < 4; ++i) q1[i] = in[i];
+            in[4] = c * q1[0] + x * q1[3] + y * q1[2] - z * q1[1];
+            in[5] = c * q1[1] + y * q1[3] + z * q1[0] - x * q1[2];
+            in[6] = c * q1[2] + z * q1[3] + x * q1[1] - y * q1[0];
+            in[7] = c * q1[3] - x * q1[0] - y * q1[1] - z * q1[2];
+        }
+    } else if(sample < 300) {
+        /* Nearly opposite */
+        for(i = 0; i < 4; ++i) {
+            in[4 + i] = -in[i] + rng_range(rng, -1e-4, 1e-4);
+        }
+    } else if(sample < 320) {
+        in[8] = (sample & 1) ? 1 : 0;
+    }
+}
+
+static void run_quaternion_slerp(const float* in, kmScalar* out) {
+    kmQuaternion a, b, q;
+    kmQuaternionFill(&a, in[0], in[1], in[2], in[3]);
+    kmQuaternionFill(&b, in[4], in[5], in[6], in[7]);
+    kmQuaternionSlerp(&q, &a, &b, in[8]);
+    out[0] = q.x;
+    out[1] = q.y;
+    out[2] = q.z;
+    out[3] = q.w;
+}
+
+static void generate_sin_cos(km_rng* rng, kmUint sample, float* in) {
+    if(sample < 200) {
+        /* Multiples of pi / 2, where one result is nearly zero */
+        in[0] = (int) rng_range(rng, -64, 64) * kmPI / 2 + rng_range(rng, -1e-3, 1e-3);
+    } else if(sample < 400) {
+        /* Large arguments, where the range reduction loses bits */
+        in[0] = rng_range(rng, -1, 1) * pow(10, rng_range(rng, 2, 5));
+    } else {
+        in[0] = rng_range(rng, -2 * kmPI, 2 * kmPI);
+    }
+}
+
+static void run_sin_cos(const float* in, kmScalar* out) {
+    kmSinCos(in[0], &out[0], &out[1]);
+}
+
+static void generate_rotation_axis_angle(km_rng* rng, kmUint sample, float* in) {
+    double l;
+
+    do {
+        in[0] = rng_range(rng, -1, 1);
+        in[1] = rng_range(rng, -1, 1);
+        in[2] = rng_range(rng, -1, 1);
+        l = in[0] * in[0] + in[1] * in[1] + in[2] * in[2];
+    } while(l < 0.01);
+
+    in[3] = sample < 200 ? rng_range(rng, -1e-4, 1e-4) : rng_range(rng, -2 * kmPI, 2 * kmPI);
+}
+
+static void run_rotation_axis_angle(const float* in, kmScalar* out) {
+    kmMat4 m;
+    kmVec3 axis;
+    kmMat4RotationAxisAngle(&m, kmVec3Fill(&axis, in[0], in[1], in[2]), in[3]);
+    store_mat4(out, &m);
+}
+
+static void generate_pitch_yaw_roll(km_rng* rng, kmUint sample, float* in) {
+    kmUint i;
+
+    for(i = 0; i < 3; ++i) {
+        if(sample < 200) {
+            /* Close to the +-2 pi limit the function accepts */
+            in[i] = (rng_next(rng) < 0.5 ? -1 : 1) * (2 * kmPI - rng_range(rng, 1e-5, 1e-2));
+        } else {
+            in[i] = rng_range(rng, -kmPI, kmPI);
+        }
+    }
+}
+
+static void run_pitch_yaw_roll(const float* in, kmScalar* out) {
+    kmQuaternion q;
+    kmQuaternionRotationPitchYawRoll(&q, in[0], in[1], in[2]);
+    out[0] = q.x;
+    out[1] = q.y;
+    out[2] = q.z;
+    out[3] = q.w;
+}
+
+/* Budgets are roughly twice the error measured when they were set */
+static const km_precision_kernel kernels[] = {
+    { "kmMat4Inverse", 16, 16, KM_FALSE, 400, 2000, 0, generate_mat4_inverse, run_mat4_inverse },
+    { "kmMat4Multiply", 32, 16, KM_FALSE, 200, 6, 0, generate_mat4_multiply, run_mat4_multiply },
+    { "kmVec3Normalize", 3, 3, KM_FALSE, 400, 4, 0, generate_vec3_normalize, run_vec3_normalize },
+    { "kmQuaternionSlerp", 9, 4, KM_FALSE, 320, 6, 0, generate_quaternion_slerp, run_quaternion_slerp },
+    { "kmSinCos", 1, 2, KM_TRUE, 400, 1, 3, generate_sin_cos, run_sin_cos },
+    { "kmMat4RotationAxisAngle", 4, 16, KM_TRUE, 200, 8, 8, generate_rotation_axis_angle, run_rotation_axis_angle },
+    { "kmQuaternionRotationPitchYawRoll", 3, 4, KM_TRUE, 200, 4, 8, generate_pitch_yaw_roll, run_pitch_yaw_roll }
+};
+
+#define KERNEL_COUNT (sizeof(kernels) / sizeof(kernels[0]))
+
+/* Every kernel gets its own stream so adding one doesn't change the others */
+static void generate_inputs(kmUint kernel, float* inputs) {
+    km_rng rng;
+    kmUint s;
+
+    rng.state = 0x9E3779B97F4A7C15ULL * (kernel + 1);
+    for(s = 0; s < SAMPLE_COUNT; ++s) {
+        kernels[kernel].generate(&rng, s, inputs + s * MAX_INPUTS);
+    }
+}
+
+#ifdef USE_DOUBLE_PRECISION
+
+int main(void) {
+    float* inputs = (float*) malloc(sizeof(float) * MAX_INPUTS * SAMPLE_COUNT);
+    kmScalar out[MAX_OUTPUTS];
+    kmUint k, s, i;
+
+    for(k = 0; k < KERNEL_COUNT; ++k) {
+        generate_inputs(k, inputs);
+        for(s = 0; s < SAMPLE_COUNT; ++s) {
+            kernels[k].run(inputs + s * MAX_INPUTS, out);
+            for(i = 0; i < kernels[k].output_count; ++i) {
+                printf("%.17g ", out[i]);
+            }
+            printf("\n");
+        }
+    }
+
+    free(inputs);
+    return 0;
+}
+
+#else
+
+typedef struct km_precision_error {
+    double max_ulps;
+    double max_relative;
+    kmUint worst_sample;
+    kmUint non_finite;          /* Results that should have been finite */
+    kmUint compared;
+
+    /* The same over the random samples only, which the budget applies to */
+    double random_max_ulps;
+    kmUint random_non_finite;
+} km_precision_error;
+
+/* The spacing of floats around x */
+static double float_ulp(double x) {
+    int exponent;
+
+    x = fabs(x);
+    if(x < FLT_MIN) return ldexp(1, -149);
+    frexp(x, &exponent);
+    return ldexp(1, exponent - 24);
+}
+
+static void compare(km_precision_error* error, kmUint sample, kmBool random, const kmScalar* out,
+                    const double* reference, kmUint count) {
+    double magnitude = 0, difference = 0, ulps;
+    kmUint i;
+
+    for(i = 0; i < count; ++i) {
+        /* No reference result (a singular matrix), nothing to compare */
+        if(!isfinite(reference[i])) return;
+        if(fabs(reference[i]) > magnitude) magnitude = fabs(reference[i]);
+    }
+
+    for(i = 0; i < count; ++i) {
+        if(!isfinite(out[i])) {
+            error->non_finite++;
+            if(random) error->random_non_finite++;
+            return;
+        }
+        if(fabs(out[i] - reference[i]) > difference) difference = fabs(out[i] - reference[i]);
+    }
+
+    error->compared++;
+    ulps = difference / float_ulp(magnitude);
+    if(ulps > error->max_ulps) {
+        error->max_ulps = ulps;
+        error->worst_sample = sample;
+    }
+    if(random && ulps > error->random_max_ulps) {
+        error->random_max_ulps = ulps;
+    }
+    if(magnitude > 0 && difference / magnitude > error->max_relative) {
+        error->max_relative = difference / magnitude;
+    }
+}
+
+/* Prints a row of the table, returns KM_FALSE if the random samples broke the budget */
+static kmBool print_row(const char* name, const char* mode, const km_precision_error* error, double budget) {
+    kmBool passed = error->random_max_ulps <= budget && !error->random_non_finite;
+
+    printf("%-34s %-9s %8u %12.1f %12.3g %8u %10u %10.1f %8.1f  %s\n", name, mode, error->compared,
+           error->max_ulps, error->max_relative, error->worst_sample, error->non_finite,
+           error->random_max_ulps, budget, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+int main(int argc, char** argv) {
+    float* inputs = (float*) malloc(sizeof(float) * MAX_INPUTS * SAMPLE_COUNT);
+    double* reference = (double*) malloc(sizeof(double) * MAX_OUTPUTS * SAMPLE_COUNT);
+    kmScalar out[MAX_OUTPUTS];
+    FILE* pipe;
+    kmUint k, s;
+    kmBool passed = KM_TRUE;
+
+    if(argc < 2) {
+        fprintf(stderr, "usage: %s path/to/kazmath_precision_reference\n", argv[0]);
+        return 1;
+    }
+
+    pipe = popen(argv[1], "r");
+    if(!pipe) {
+        fprintf(stderr, "couldn't run %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%-34s %-9s %8s %12s %12s %8s %10s %10s %8s\n", "kernel", "mode", "samples", "max ulp", "max rel",
+           "worst", "non-finite", "random ulp", "budget");
+
+    for(k = 0; k < KERNEL_COUNT; ++k) {
+        const km_precision_kernel* kernel = &kernels[k];
+        km_precision_error accurate, fast;
+
+        for(s = 0; s < SAMPLE_COUNT * kernel->output_count; ++s) {
+            if(fscanf(pipe, "%lf", &reference[s]) != 1) {
+                fprintf(stderr, "short read from %s\n", argv[1]);
+                pclose(pipe);
+                return 1;
+            }
+        }
+
+        generate_inputs(k, inputs);
+        memset(&accurate, 0, sizeof(accurate));
+        memset(&fast, 0, sizeof(fast));
+
+        for(s = 0; s < SAMPLE_COUNT; ++s) {
+            const float* in = inputs + s * MAX_INPUTS;
+            const double* ref = reference + s * kernel->output_count;
+            kmBool random = s >= kernel->adversarial_count;
+
+            kmSetPrecisionMode(KM_PRECISION_ACCURATE);
+            kernel->run(in, out);
+            compare(&accurate, s, random, out, ref, kernel->output_count);
+
+            if(kernel->uses_precision_mode) {
+                kmSetPrecisionMode(KM_PRECISION_FAST);
+                kernel->run(in, out);
+                compare(&fast, s, random, out, ref, kernel->output_count);
+            }
+        }
+
+        kmSetPrecisionMode(KM_PRECISION_ACCURATE);
+        passed &= print_row(kernel->name, "accurate", &accurate, kernel->accurate_budget);
+        if(kernel->uses_precision_mode) {
+            passed &= print_row(kernel->name, "fast", &fast, kernel->fast_budget);
+        }
+    }
+
+    pclose(pipe);
+    free(inputs);
+    free(reference);
+    return passed ? 0 : 1;
+}
+
+#endif
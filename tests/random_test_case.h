@@ -0,0 +1,29 @@
+#ifndef RANDOM_TEST_CASE_H
+#define RANDOM_TEST_CASE_H
+
+#include <cstdlib>
+#include "kaztest/kaztest.h"
+
+#include "../kazmath/utility.h"
+
+/* Base for the test cases that check a structure against a brute force
+ * answer on random input. Each case passes its own seed, which is applied
+ * before every test so a failure reproduces on every run. */
+class RandomTestCase : public TestCase {
+public:
+    explicit RandomTestCase(unsigned seed = 1):
+        seed_(seed) {}
+
+    void set_up() {
+        srand(seed_);
+    }
+
+    kmScalar random(kmScalar lo, kmScalar hi) {
+        return lo + (rand() / (kmScalar) RAND_MAX) * (hi - lo);
+    }
+
+private:
+    unsigned seed_;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #include <limits>
 
 #include "../kazmath/aabb3.h"
+#include "../kazmath/mat4.h"
 
 class TestAABB : public TestCase {
 public:
@@ -51,17 +52,83 @@ public:
         assert_equal(KM_CONTAINS_PARTIAL, kmAABB3ContainsAABB(&box, &partial));
     }
 
-    /*
-    void XXX_test_aabb_triangle_intersection() {
+    void test_aabb_transform_matches_corners() {
+        kmAABB3 box, result, expected;
+        kmVec3Fill(&box.min, -1, -2, 0.5);
+        kmVec3Fill(&box.max, 3, 1, 2);
+
+        kmMat4 rot, scale, trans, m;
+        kmMat4RotationYawPitchRoll(&rot, 0.3, 1.1, -0.7);
+        kmMat4Scaling(&scale, 2, 0.5, 1.5);
+        kmMat4Translation(&trans, 4, -3, 10);
+        kmMat4Multiply(&m, &rot, &scale);
+        kmMat4Multiply(&m, &trans, &m);
+
+        kmAABB3Transform(&result, &box, &m);
+
+        for(int i = 0; i < 8; ++i) {
+            kmVec3 corner;
+            kmVec3Fill(&corner,
+                (i & 1) ? box.max.x : box.min.x,
+                (i & 2) ? box.max.y : box.min.y,
+                (i & 4) ? box.max.z : box.min.z);
+            kmVec3MultiplyMat4(&corner, &corner, &m);
+
+            if(i == 0) {
+                expected.min = expected.max = corner;
+            } else {
+                expected.min.x = std::min(expected.min.x, corner.x);
+                expected.min.y = std::min(expected.min.y, corner.y);
+                expected.min.z = std::min(expected.min.z, corner.z);
+                expected.max.x = std::max(expected.max.x, corner.x);
+                expected.max.y = std::max(expected.max.y, corner.y);
+                expected.max.z = std::max(expected.max.z, corner.z);
+            }
+        }
+
+        assert_close(expected.min.x, result.min.x, 0.0001);
+        assert_close(expected.min.y, result.min.y, 0.0001);
+        assert_close(expected.min.z, result.min.z, 0.0001);
+        assert_close(expected.max.x, result.max.x, 0.0001);
+        assert_close(expected.max.y, result.max.y, 0.0001);
+        assert_close(expected.max.z, result.max.z, 0.0001);
+
+        /* In place */
+        kmAABB3Transform(&box, &box, &m);
+        assert_close(result.min.x, box.min.x, 0.0001);
+        assert_close(result.max.z, box.max.z, 0.0001);
+    }
+
+    void test_aabb_transform_array() {
+        kmAABB3 local[3], world[3];
+        kmMat4 matrices[3];
+
+        for(int i = 0; i < 3; ++i) {
+            kmAABB3Initialize(&local[i], NULL, 2, 2, 2);
+            kmMat4Translation(&matrices[i], i * 10, 0, 0);
+        }
+        kmMat4RotationZ(&matrices[2], kmPI / 4);
+
+        kmAABB3TransformArray(world, local, matrices, 3);
+
+        assert_close(-1, world[0].min.x, 0.0001);
+        assert_close(9, world[1].min.x, 0.0001);
+        assert_close(11, world[1].max.x, 0.0001);
+        assert_close(-sqrt(2.0), world[2].min.x, 0.0001);
+        assert_close(sqrt(2.0), world[2].max.y, 0.0001);
+        assert_close(1, world[2].max.z, 0.0001);
+    }
+
+    void test_aabb_triangle_intersection() {
 
         kmAABB3 box;
         box.min.x = -5.0f;
         box.min.y = -5.0f;
-        box.min.z = std::numeric_limits<kmScalar>::min();
+        box.min.z = -5.0f;
 
         box.max.x = 5.0f;
         box.max.y = 5.0f;
-        box.max.z = std::numeric_limits<kmScalar>::max();
+        box.max.z = 5.0f;
 
         //Triangle that is entirely within the bounds of the box
         kmVec3 tri1 [] = {
@@ -98,5 +165,145 @@ public:
         };
 
         assert_true(kmAABB3IntersectsTriangle(&box, &tri4[0], &tri4[1], &tri4[2]));
-    }*/
+
+        //Vertical triangle whose bounds overlap the box but whose plane (x + y = 10.5) misses it
+        kmVec3 tri5 [] = {
+            {  6.0f, 4.5f, -10.0f },
+            {  6.0f, 4.5f,  10.0f },
+            {  4.5f, 6.0f,   0.0f },
+        };
+
+        assert_true(!kmAABB3IntersectsTriangle(&box, &tri5[0], &tri5[1], &tri5[2]));
+
+        //Tilted triangle whose plane misses the box corner
+        kmVec3 tri6 [] = {
+            {  8.0f, 0.0f, 8.0f },
+            {  0.0f, 8.0f, 8.0f },
+            {  8.0f, 8.0f, 0.0f },
+        };
+
+        assert_true(!kmAABB3IntersectsTriangle(&box, &tri6[0], &tri6[1], &tri6[2]));
+
+        //Passes the box face and triangle normal tests, only the axis z x (v1 - v0) separates
+        kmVec3 tri7 [] = {
+            {  6.0f, 4.5f, -10.0f },
+            {  4.5f, 6.0f,  10.0f },
+            {  6.0f, 6.0f,   0.0f },
+        };
+
+        assert_true(!kmAABB3IntersectsTriangle(&box, &tri7[0], &tri7[1], &tri7[2]));
+    }
+
+    void test_aabb_triangle_batch() {
+        kmAABB3 box;
+        kmAABB3Initialize(&box, NULL, 2, 2, 2);
+
+        kmVec3 a[] = { { -2, 0, 0 }, { 5, 0, 0 }, { 2.0, 0.5, -1 } };
+        kmVec3 b[] = { {  2, 0, 0 }, { 6, 0, 0 }, { 0.5, 2.0, -1 } };
+        kmVec3 c[] = { {  0, 2, 0 }, { 5, 1, 0 }, { 2.0, 2.0,  1 } };
+
+        kmBool results[3];
+        assert_equal(1, (int) kmAABB3IntersectsTriangles(&box, a, b, c, 3, results));
+        assert_true(results[0]);
+        assert_false(results[1]);
+        assert_false(results[2]);
+
+        /* Voxelize a triangle against a row of unit cells */
+        kmAABB3 cells[6];
+        for(int i = 0; i < 6; ++i) {
+            kmVec3Fill(&cells[i].min, i, 0, 0);
+            kmVec3Fill(&cells[i].max, i + 1, 1, 1);
+        }
+
+        kmVec3 p1 = { 0.5, 0.5, 0.5 };
+        kmVec3 p2 = { 3.5, 0.5, 0.5 };
+        kmVec3 p3 = { 0.5, 0.9, 0.5 };
+
+        kmBool covered[6];
+        assert_equal(4, (int) kmAABB3IntersectsTriangleArray(cells, 6, &p1, &p2, &p3, covered));
+        assert_true(covered[0]);
+        assert_true(covered[3]);
+        assert_false(covered[4]);
+        assert_false(covered[5]);
+    }
+
+    void test_aabb_scale() {
+        kmAABB3 box, out;
+        kmVec3Fill(&box.min, -1, 0, 1);
+        kmVec3Fill(&box.max, 1, 2, 3);
+
+        kmAABB3Scale(&out, &box, 2);
+        assert_close(-2, out.min.x, 0.0001);
+        assert_close(6, out.max.z, 0.0001);
+
+        kmAABB3Scale(&out, &box, -1);
+        assert_close(-2, out.min.y, 0.0001);
+        assert_close(0, out.max.y, 0.0001);
+        assert_close(-3, out.min.z, 0.0001);
+    }
+
+    void test_aabb_sweep() {
+        kmAABB3 moving, wall;
+        kmVec3 d, normal;
+        kmScalar t;
+
+        kmVec3Fill(&moving.min, 0, 0, 0);
+        kmVec3Fill(&moving.max, 1, 1, 1);
+        kmVec3Fill(&wall.min, 5, -2, -2);
+        kmVec3Fill(&wall.max, 5.1, 2, 2);
+
+        /* Far enough to tunnel through the thin wall in one step */
+        kmVec3Fill(&d, 10, 0, 0);
+        assert_true(kmAABB3SweepAABB3(&moving, &d, &wall, &t, &normal));
+        assert_close(0.4, t, 0.0001);
+        assert_close(-1.0, normal.x, 0.0001);
+        assert_close(0.0, normal.y, 0.0001);
+
+        kmVec3Fill(&d, 3, 0, 0);
+        assert_false(kmAABB3SweepAABB3(&moving, &d, &wall, &t, &normal));
+
+        /* Passing over the top misses */
+        kmVec3Fill(&d, 10, 0, 0);
+        moving.min.y = 2.5;
+        moving.max.y = 3.5;
+        assert_false(kmAABB3SweepAABB3(&moving, &d, &wall, NULL, NULL));
+
+        /* Falling onto it diagonally hits the top face */
+        kmVec3Fill(&moving.min, 4.5, 3, 0);
+        kmVec3Fill(&moving.max, 5.5, 4, 1);
+        kmVec3Fill(&d, 0.2, -4, 0);
+        assert_true(kmAABB3SweepAABB3(&moving, &d, &wall, &t, &normal));
+        assert_close(0.25, t, 0.0001);
+        assert_close(1.0, normal.y, 0.0001);
+
+        /* Already overlapping */
+        kmVec3Fill(&moving.min, 4.8, 0, 0);
+        kmVec3Fill(&moving.max, 5.8, 1, 1);
+        assert_true(kmAABB3SweepAABB3(&moving, &d, &wall, &t, &normal));
+        assert_close(0.0, t, 0.0001);
+        assert_close(0.0, kmVec3LengthSq(&normal), 0.0001);
+
+        kmAABB3 walls[3];
+        walls[0] = wall;
+        walls[1] = wall;
+        walls[2] = wall;
+        walls[1].min.x = walls[0].min.x + 2;
+        walls[1].max.x = walls[0].max.x + 2;
+        walls[2].min.y = 10;
+        walls[2].max.y = 11;
+
+        kmVec3Fill(&moving.min, 0, 0, 0);
+        kmVec3Fill(&moving.max, 1, 1, 1);
+        kmVec3Fill(&d, 10, 0, 0);
+
+        kmBool results[3];
+        kmScalar times[3];
+        kmVec3 normals[3];
+        assert_equal(2u, kmAABB3SweepAABB3Array(walls, 3, &moving, &d, results, times, normals));
+        assert_true(results[0]);
+        assert_true(results[1]);
+        assert_false(results[2]);
+        assert_close(0.4, times[0], 0.0001);
+        assert_close(0.6, times[1], 0.0001);
+    }
 };
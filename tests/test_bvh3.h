@@ -0,0 +1,232 @@
+#include <vector>
+#include <algorithm>
+#include "random_test_case.h"
+
+#include "../kazmath/bvh3.h"
+#include "../kazmath/aabb3.h"
+#include "../kazmath/ray3.h"
+
+class TestBVH3 : public RandomTestCase {
+public:
+    TestBVH3():
+        RandomTestCase(1357) {}
+
+    std::vector<kmAABB3> random_boxes(unsigned count) {
+        std::vector<kmAABB3> boxes(count);
+        for(unsigned i = 0; i < count; ++i) {
+            kmVec3 centre;
+            kmVec3Fill(&centre, random(-100, 100), random(-100, 100), random(-100, 100));
+            kmScalar size = random(0.5, 6);
+            kmAABB3Initialize(&boxes[i], &centre, size, size, size * 0.5);
+        }
+        /* Duplicate centroids must still give a valid tree */
+        for(unsigned i = 0; i < count / 20; ++i) {
+            boxes[i * 2 + 1] = boxes[i * 2];
+        }
+        return boxes;
+    }
+
+    std::vector<kmUint> sorted(const kmUint* indices, kmUint count) {
+        std::vector<kmUint> result(indices, indices + count);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    kmBool contains(const kmAABB3& outer, const kmAABB3& inner) {
+        return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+               outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+    }
+
+    /* Every primitive is reachable exactly once and parents enclose children */
+    void check_tree(const kmBVH3& bvh, unsigned count) {
+        std::vector<int> seen(count, 0);
+        std::vector<kmInt> stack(1, bvh.root);
+        while(!stack.empty()) {
+            kmInt index = stack.back();
+            stack.pop_back();
+            const kmBVH3Node& node = bvh.nodes[index];
+            if(node.left == KM_BVH3_INVALID) {
+                ++seen[node.primitive];
+            } else {
+                assert_equal(index, bvh.nodes[node.left].parent);
+                assert_equal(index, bvh.nodes[node.right].parent);
+                assert_true(contains(node.bounds, bvh.nodes[node.left].bounds));
+                assert_true(contains(node.bounds, bvh.nodes[node.right].bounds));
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+            }
+        }
+        for(unsigned i = 0; i < count; ++i) {
+            assert_equal(1, seen[i]);
+        }
+    }
+
+    void test_bvh_morton_code() {
+        kmAABB3 scene;
+        kmAABB3Initialize(&scene, NULL, 2, 2, 2);
+
+        kmVec3 p;
+        kmVec3Fill(&p, -1, -1, -1);
+        assert_true(kmBVH3MortonCode(&p, &scene, KM_BVH3_MORTON_30) == 0);
+
+        kmVec3Fill(&p, 1, 1, 1);
+        assert_true(kmBVH3MortonCode(&p, &scene, KM_BVH3_MORTON_30) == 0x3FFFFFFFULL);
+        assert_true(kmBVH3MortonCode(&p, &scene, KM_BVH3_MORTON_63) == 0x7FFFFFFFFFFFFFFFULL);
+
+        /* x is the most significant bit of each triple */
+        kmVec3Fill(&p, 1, -1, -1);
+        assert_true(kmBVH3MortonCode(&p, &scene, KM_BVH3_MORTON_30) == 0x24924924ULL);
+    }
+
+    void test_bvh_build_single_and_parallel() {
+        std::vector<kmAABB3> boxes = random_boxes(2000);
+
+        kmBVH3 serial, parallel;
+        kmBVH3Initialize(&serial);
+        kmBVH3Initialize(&parallel);
+
+        kmBVH3Build(&serial, &boxes[0], boxes.size(), NULL, KM_BVH3_MORTON_30, 1);
+        kmBVH3Build(&parallel, &boxes[0], boxes.size(), NULL, KM_BVH3_MORTON_30, 4);
+
+        assert_equal(3999u, serial.node_count);
+        check_tree(serial, boxes.size());
+        check_tree(parallel, boxes.size());
+
+        /* The sort is stable so both builds give the same tree */
+        for(kmUint i = 0; i < serial.node_count; ++i) {
+            assert_equal(serial.nodes[i].left, parallel.nodes[i].left);
+            assert_equal(serial.nodes[i].right, parallel.nodes[i].right);
+        }
+
+        kmBVH3Build(&parallel, &boxes[0], boxes.size(), NULL, KM_BVH3_MORTON_63, 3);
+        check_tree(parallel, boxes.size());
+
+        /* A single primitive is a leaf at the root */
+        kmBVH3Build(&serial, &boxes[0], 1, NULL, KM_BVH3_MORTON_30, 4);
+        assert_equal(1u, serial.node_count);
+        assert_equal(KM_BVH3_INVALID, serial.nodes[0].left);
+
+        kmBVH3Free(&serial);
+        kmBVH3Free(&parallel);
+    }
+
+    void test_bvh_queries_match_linear_scan() {
+        std::vector<kmAABB3> boxes = random_boxes(1000);
+
+        kmBVH3 bvh;
+        kmBVH3Initialize(&bvh);
+        kmBVH3Build(&bvh, &boxes[0], boxes.size(), NULL, KM_BVH3_MORTON_63, 2);
+
+        std::vector<kmUint> out(boxes.size()), masks(boxes.size());
+
+        for(int q = 0; q < 10; ++q) {
+            kmAABB3 query;
+            kmVec3 centre;
+            kmVec3Fill(&centre, random(-100, 100), random(-100, 100), random(-100, 100));
+            kmAABB3Initialize(&query, &centre, 30, 30, 30);
+
+            std::vector<kmUint> expected;
+            for(unsigned i = 0; i < boxes.size(); ++i) {
+                if(boxes[i].min.x <= query.max.x && boxes[i].max.x >= query.min.x &&
+                   boxes[i].min.y <= query.max.y && boxes[i].max.y >= query.min.y &&
+                   boxes[i].min.z <= query.max.z && boxes[i].max.z >= query.min.z) {
+                    expected.push_back(i);
+                }
+            }
+
+            kmUint found = kmBVH3QueryAABB3(&bvh, &query, &out[0], out.size());
+            assert_true(expected == sorted(&out[0], found));
+        }
+
+        kmRay3 rays[4];
+        for(int r = 0; r < 4; ++r) {
+            kmRay3Fill(&rays[r], -150, random(-10, 10), random(-10, 10), 1, random(-0.05, 0.05), random(-0.05, 0.05));
+
+            std::vector<kmUint> expected;
+            for(unsigned i = 0; i < boxes.size(); ++i) {
+                if(kmRay3IntersectAABB3(&rays[r], &boxes[i], NULL, NULL)) expected.push_back(i);
+            }
+
+            kmUint found = kmBVH3QueryRay3(&bvh, &rays[r], &out[0], out.size());
+            assert_true(expected == sorted(&out[0], found));
+        }
+
+        kmRay3Packet packet;
+        kmRay3PacketFill(&packet, rays, 4);
+        kmUint found = kmBVH3QueryRay3Packet(&bvh, &packet, &out[0], &masks[0], out.size());
+        for(kmUint i = 0; i < found; ++i) {
+            for(int r = 0; r < 4; ++r) {
+                assert_equal(kmRay3IntersectAABB3(&rays[r], &boxes[out[i]], NULL, NULL) != 0,
+                             (masks[i] & (1u << r)) != 0);
+            }
+        }
+
+        kmBVH3Free(&bvh);
+    }
+
+    kmScalar internal_area(const kmBVH3& bvh) {
+        kmScalar total = 0;
+        for(kmUint i = 0; i < bvh.leaf_count - 1; ++i) {
+            const kmAABB3& b = bvh.nodes[i].bounds;
+            kmScalar x = b.max.x - b.min.x, y = b.max.y - b.min.y, z = b.max.z - b.min.z;
+            total += 2 * (x * y + y * z + z * x);
+        }
+        return total;
+    }
+
+    void test_bvh_refit() {
+        std::vector<kmAABB3> boxes = random_boxes(2000);
+
+        kmBVH3 plain, rotated;
+        kmBVH3Initialize(&plain);
+        kmBVH3Initialize(&rotated);
+        kmBVH3Build(&plain, &boxes[0], boxes.size(), NULL, KM_BVH3_MORTON_30, 1);
+        kmBVH3Build(&rotated, &boxes[0], boxes.size(), NULL, KM_BVH3_MORTON_30, 1);
+
+        /* Scatter the boxes so the old hierarchy no longer matches */
+        for(unsigned i = 0; i < boxes.size(); ++i) {
+            kmVec3 offset;
+            kmVec3Fill(&offset, random(-40, 40), random(-40, 40), random(-40, 40));
+            kmVec3Add(&boxes[i].min, &boxes[i].min, &offset);
+            kmVec3Add(&boxes[i].max, &boxes[i].max, &offset);
+        }
+
+        kmBVH3Refit(&plain, &boxes[0], 4, KM_FALSE);
+        check_tree(plain, boxes.size());
+
+        /* Leaves are exact and the root is the union of everything */
+        for(kmUint i = plain.leaf_count - 1; i < plain.node_count; ++i) {
+            assert_true(kmAABB3ContainsAABB(&plain.nodes[i].bounds, &boxes[plain.nodes[i].primitive]) == KM_CONTAINS_ALL);
+            assert_true(kmAABB3ContainsAABB(&boxes[plain.nodes[i].primitive], &plain.nodes[i].bounds) == KM_CONTAINS_ALL);
+        }
+
+        for(int pass = 0; pass < 3; ++pass) {
+            kmBVH3Refit(&rotated, &boxes[0], pass + 1, KM_TRUE);
+            check_tree(rotated, boxes.size());
+        }
+        assert_true(internal_area(rotated) < internal_area(plain));
+
+        std::vector<kmUint> out(boxes.size());
+        kmAABB3 query;
+        kmVec3 centre;
+        kmVec3Fill(&centre, 10, -5, 20);
+        kmAABB3Initialize(&query, &centre, 40, 40, 40);
+
+        std::vector<kmUint> expected;
+        for(unsigned i = 0; i < boxes.size(); ++i) {
+            if(boxes[i].min.x <= query.max.x && boxes[i].max.x >= query.min.x &&
+               boxes[i].min.y <= query.max.y && boxes[i].max.y >= query.min.y &&
+               boxes[i].min.z <= query.max.z && boxes[i].max.z >= query.min.z) {
+                expected.push_back(i);
+            }
+        }
+
+        kmUint found = kmBVH3QueryAABB3(&plain, &query, &out[0], out.size());
+        assert_true(expected == sorted(&out[0], found));
+        found = kmBVH3QueryAABB3(&rotated, &query, &out[0], out.size());
+        assert_true(expected == sorted(&out[0], found));
+
+        kmBVH3Free(&plain);
+        kmBVH3Free(&rotated);
+    }
+};
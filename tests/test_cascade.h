@@ -0,0 +1,97 @@
+#include <cmath>
+#include "kaztest/kaztest.h"
+
+#include "../kazmath/cascade.h"
+
+class TestCascade : public TestCase {
+public:
+    void camera(kmMat4* view, kmMat4* projection, kmScalar x, kmScalar yaw) {
+        kmVec3 eye, centre, up;
+        kmVec3Fill(&eye, x, 2, 5);
+        kmVec3Fill(&centre, x + sin(yaw), 2, 5 - cos(yaw));
+        kmVec3Fill(&up, 0, 1, 0);
+        kmMat4LookAt(view, &eye, &centre, &up);
+        kmMat4PerspectiveProjection(projection, 60, 16.0 / 9.0, 0.1, 100);
+    }
+
+    void test_cascade_splits() {
+        kmScalar splits[5];
+        kmShadowCascadeSplits(splits, 1, 100, 4, 0);
+        assert_close(25.75, splits[1], 0.001);
+        assert_close(100.0, splits[4], 0.0001);
+
+        kmShadowCascadeSplits(splits, 1, 100, 4, 1);
+        assert_close(1.0, splits[0], 0.0001);
+        assert_close(10.0, splits[2], 0.001);
+
+        kmShadowCascadeSplits(splits, 1, 100, 4, 0.75);
+        for(int i = 0; i < 4; ++i) {
+            assert_true(splits[i] < splits[i + 1]);
+        }
+    }
+
+    void test_cascade_fits_the_slices() {
+        kmMat4 view, projection;
+        camera(&view, &projection, 0, 0.3);
+
+        kmScalar splits[4] = { 0.1, 5, 20, 100 };
+        kmVec3 light;
+        kmVec3Fill(&light, 1, -2, 0.5);
+
+        kmShadowCascade cascades[3];
+        kmShadowCascadeCompute(cascades, &view, &projection, &light, splits, 3, 1024);
+
+        for(int c = 0; c < 3; ++c) {
+            const kmShadowCascade& cascade = cascades[c];
+            assert_close(splits[c], cascade.split_near, 0.0001);
+            assert_close(splits[c + 1], cascade.split_far, 0.0001);
+
+            for(int i = 0; i < 8; ++i) {
+                kmVec3 in_view, in_shadow;
+
+                /* Each corner sits at its split distance */
+                kmVec3MultiplyMat4(&in_view, &cascade.corners[i], &view);
+                assert_close(i < 4 ? splits[c] : splits[c + 1], -in_view.z, 0.01 * splits[c + 1]);
+
+                assert_true(kmSphereContainsPoint(&cascade.bounds, &cascade.corners[i]));
+
+                /* And lands inside the cascade's shadow map */
+                kmVec3TransformCoord(&in_shadow, &cascade.corners[i], &cascade.view_projection);
+                assert_true(fabs(in_shadow.x) <= 1.0001);
+                assert_true(fabs(in_shadow.y) <= 1.0001);
+                assert_true(fabs(in_shadow.z) <= 1.0001);
+            }
+        }
+
+        /* Cascades further out are bigger */
+        assert_true(cascades[0].bounds.radius < cascades[1].bounds.radius);
+        assert_true(cascades[1].bounds.radius < cascades[2].bounds.radius);
+    }
+
+    void test_cascade_is_stable_as_the_camera_moves() {
+        kmScalar splits[3] = { 0.1, 10, 40 };
+        kmVec3 light;
+        kmVec3Fill(&light, 0.3, -1, 0.2);
+
+        kmMat4 view, projection;
+        kmShadowCascade before[2], after[2];
+
+        camera(&view, &projection, 0, 0.0);
+        kmShadowCascadeCompute(before, &view, &projection, &light, splits, 2, 512);
+        camera(&view, &projection, 0.37, 0.7);
+        kmShadowCascadeCompute(after, &view, &projection, &light, splits, 2, 512);
+
+        for(int c = 0; c < 2; ++c) {
+            /* Turning doesn't change the size */
+            assert_close(before[c].bounds.radius, after[c].bounds.radius, 0.0001);
+
+            /* The world origin stays on a texel corner */
+            kmVec3 origin;
+            kmVec3Zero(&origin);
+            kmVec3MultiplyMat4(&origin, &origin, &after[c].view_projection);
+            kmScalar x = origin.x * 256, y = origin.y * 256;
+            assert_close(floor(x + 0.5), x, 0.01);
+            assert_close(floor(y + 0.5), y, 0.01);
+        }
+    }
+};
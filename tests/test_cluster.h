@@ -0,0 +1,141 @@
+#include <cmath>
+#include <vector>
+#include "random_test_case.h"
+
+#include "../kazmath/cluster.h"
+
+class TestCluster : public RandomTestCase {
+public:
+    TestCluster():
+        RandomTestCase(1123) {}
+
+    void test_cluster_bounds_cover_the_frustum() {
+        kmClusterGrid grid;
+        kmClusterGridInitialize(&grid, 16, 9, 24);
+
+        kmMat4 projection;
+        kmMat4PerspectiveProjection(&projection, 60, 16.0 / 9.0, 0.5, 200);
+        assert_true(kmClusterGridSetProjection(&grid, &projection));
+        assert_false(kmClusterGridSetProjection(&grid, &projection));
+        assert_close(0.5, grid.z_near, 0.001);
+        assert_close(200.0, grid.z_far, 0.1);
+
+        assert_equal(0u, kmClusterGridSlice(&grid, 0.5));
+        assert_equal(23u, kmClusterGridSlice(&grid, 199.0));
+        assert_equal(12u, kmClusterGridSlice(&grid, sqrt(0.5 * 200) * 1.01));
+
+        kmMat4 inverse;
+        kmMat4Inverse(&inverse, &projection);
+
+        /* Points inside the frustum lie in the cluster found from their screen position and depth */
+        for(int i = 0; i < 500; ++i) {
+            kmScalar nx = random(-0.999, 0.999), ny = random(-0.999, 0.999), depth = random(0.6, 190);
+            kmVec3 ndc, p;
+            kmVec3Fill(&ndc, nx, ny, -1);
+            kmVec3TransformCoord(&p, &ndc, &inverse);
+            kmVec3Scale(&p, &p, depth / 0.5);
+
+            kmUint x = (kmUint) ((nx * 0.5 + 0.5) * 16);
+            kmUint y = (kmUint) ((ny * 0.5 + 0.5) * 9);
+            kmUint z = kmClusterGridSlice(&grid, depth);
+            const kmAABB3& box = grid.bounds[(z * 9 + y) * 16 + x];
+
+            assert_true(p.x >= box.min.x - 0.001 && p.x <= box.max.x + 0.001);
+            assert_true(p.y >= box.min.y - 0.001 && p.y <= box.max.y + 0.001);
+            assert_true(p.z >= box.min.z - 0.001 && p.z <= box.max.z + 0.001);
+        }
+
+        kmMat4PerspectiveProjection(&projection, 70, 16.0 / 9.0, 0.5, 200);
+        assert_true(kmClusterGridSetProjection(&grid, &projection));
+
+        kmClusterGridFree(&grid);
+    }
+
+    void test_cluster_light_assignment() {
+        kmClusterGrid grid;
+        kmClusterGridInitialize(&grid, 8, 6, 12);
+
+        kmMat4 projection;
+        kmMat4PerspectiveProjection(&projection, 60, 4.0 / 3.0, 1, 100);
+        kmClusterGridSetProjection(&grid, &projection);
+
+        std::vector<kmSphere> lights(100);
+        std::vector<kmClusterCone> cones(lights.size());
+        for(unsigned i = 0; i < lights.size(); ++i) {
+            kmVec3 centre;
+            kmVec3Fill(&centre, random(-30, 30), random(-20, 20), random(-90, 5));
+            kmSphereFill(&lights[i], &centre, random(1, 10));
+
+            kmVec3Fill(&cones[i].direction, random(-1, 1), random(-1, 1), random(-1, 1));
+            kmVec3Normalize(&cones[i].direction, &cones[i].direction);
+            cones[i].angle = (i % 2) ? random(0.2, 1.0) : kmPI;
+        }
+
+        kmUint total = kmClusterGridAssignLights(&grid, &lights[0], NULL, lights.size(), 1);
+        assert_equal(total, grid.offsets[8 * 6 * 12]);
+        assert_true(total > 0);
+
+        /* The same lists with the work split over threads */
+        std::vector<kmUint> serial(grid.indices, grid.indices + total);
+        assert_equal(total, kmClusterGridAssignLights(&grid, &lights[0], NULL, lights.size(), 5));
+        assert_true(serial == std::vector<kmUint>(grid.indices, grid.indices + total));
+
+        /* Every list matches a direct sphere against box test */
+        for(kmUint z = 0; z < 12; ++z) {
+            for(kmUint y = 0; y < 6; ++y) {
+                for(kmUint x = 0; x < 8; ++x) {
+                    const kmAABB3& box = grid.bounds[(z * 6 + y) * 8 + x];
+                    std::vector<kmUint> expected;
+                    for(unsigned i = 0; i < lights.size(); ++i) {
+                        if(kmSphereIntersectsAABB3(&lights[i], &box)) expected.push_back(i);
+                    }
+
+                    kmUint count;
+                    const kmUint* list = kmClusterGridLights(&grid, x, y, z, &count);
+                    assert_true(expected == std::vector<kmUint>(list, list + count));
+                }
+            }
+        }
+
+        /* Cones only ever remove clusters, and only from the spot lights */
+        kmUint with_cones = kmClusterGridAssignLights(&grid, &lights[0], &cones[0], lights.size(), 3);
+        assert_true(with_cones < total);
+
+        kmClusterGridFree(&grid);
+    }
+
+    void test_cluster_spot_light() {
+        kmClusterGrid grid;
+        kmClusterGridInitialize(&grid, 4, 4, 8);
+
+        kmMat4 projection;
+        kmMat4PerspectiveProjection(&projection, 90, 1, 1, 50);
+        kmClusterGridSetProjection(&grid, &projection);
+
+        /* A narrow spot in the middle of the view pointing away from the camera */
+        kmSphere light;
+        kmVec3 centre;
+        kmSphereFill(&light, kmVec3Fill(&centre, 0, 0, -10), 20);
+        kmClusterCone cone;
+        kmVec3Fill(&cone.direction, 0, 0, -1);
+        cone.angle = 0.1;
+
+        kmClusterGridAssignLights(&grid, &light, &cone, 1, 2);
+
+        kmUint count;
+        kmUint near_slice = kmClusterGridSlice(&grid, 5);
+        kmUint far_slice = kmClusterGridSlice(&grid, 20);
+
+        /* Behind the light's apex is culled, ahead of it in the centre is lit */
+        kmClusterGridLights(&grid, 1, 1, near_slice, &count);
+        assert_equal(0u, count);
+        kmClusterGridLights(&grid, 1, 1, far_slice, &count);
+        assert_equal(1u, count);
+
+        kmClusterGridAssignLights(&grid, &light, NULL, 1, 2);
+        kmClusterGridLights(&grid, 1, 1, near_slice, &count);
+        assert_equal(1u, count);
+
+        kmClusterGridFree(&grid);
+    }
+};
@@ -0,0 +1,147 @@
+#include <cmath>
+#include "random_test_case.h"
+
+#include "../kazmath/gjk3.h"
+#include "../kazmath/aabb3.h"
+#include "../kazmath/sphere.h"
+#include "../kazmath/obb3.h"
+#include "../kazmath/mat4.h"
+
+class TestGJK3 : public RandomTestCase {
+public:
+    TestGJK3():
+        RandomTestCase(97531) {}
+
+    void test_gjk_spheres() {
+        kmSphere s1, s2;
+        kmVec3 c1, c2, pa, pb;
+        kmConvex3 a, b;
+        kmGJK3Result result;
+
+        kmVec3Fill(&c1, 0, 0, 0);
+        kmVec3Fill(&c2, 3, 4, 0);
+        kmSphereFill(&s1, &c1, 1);
+        kmSphereFill(&s2, &c2, 2);
+        kmConvex3Fill(&a, kmSupport3Sphere, &s1);
+        kmConvex3Fill(&b, kmSupport3Sphere, &s2);
+
+        assert_false(kmGJK3Intersects(&a, &b));
+        assert_close(2.0, kmGJK3Distance(&a, &b, &pa, &pb), 0.01);
+        assert_close(0.6, pa.x, 0.02);
+        assert_close(0.8, pa.y, 0.02);
+        assert_close(1.8, pb.x, 0.02);
+        assert_close(2.4, pb.y, 0.02);
+
+        s2.radius = 4.5;
+        assert_true(kmGJK3Intersects(&a, &b));
+        assert_true(kmGJK3Collide(&result, &a, &b));
+        assert_close(0.5, result.depth, 0.01);
+        assert_close(0.6, result.normal.x, 0.01);
+        assert_close(0.8, result.normal.y, 0.01);
+        assert_close(0.0, result.normal.z, 0.01);
+    }
+
+    void test_gjk_boxes() {
+        kmAABB3 b1, b2;
+        kmConvex3 a, b;
+        kmGJK3Result result;
+
+        kmVec3Fill(&b1.min, 0, 0, 0);
+        kmVec3Fill(&b1.max, 2, 2, 2);
+        kmVec3Fill(&b2.min, 1.5, 0.5, 0.5);
+        kmVec3Fill(&b2.max, 3.5, 1.5, 1.5);
+        kmConvex3Fill(&a, kmSupport3AABB3, &b1);
+        kmConvex3Fill(&b, kmSupport3AABB3, &b2);
+
+        assert_true(kmGJK3Collide(&result, &a, &b));
+        assert_close(0.5, result.depth, 0.001);
+        assert_close(1.0, result.normal.x, 0.001);
+        assert_close(0.0, result.distance, 0.0001);
+
+        /* Deep overlap along z only */
+        kmVec3Fill(&b2.min, 0, 0, 0.2);
+        kmVec3Fill(&b2.max, 2, 2, 2.2);
+        assert_true(kmGJK3Collide(&result, &a, &b));
+        assert_close(1.8, result.depth, 0.001);
+        assert_close(1.0, result.normal.z, 0.001);
+
+        kmVec3Fill(&b2.min, 3, 4, 0.5);
+        kmVec3Fill(&b2.max, 5, 5, 1.5);
+        assert_false(kmGJK3Collide(&result, &a, &b));
+        assert_close(sqrt(5.0), result.distance, 0.001);
+        assert_close(0.0, result.depth, 0.0001);
+        assert_close(1.0 / sqrt(5.0), result.normal.x, 0.001);
+    }
+
+    void test_gjk_matches_obb_separating_axis() {
+        for(int i = 0; i < 200; ++i) {
+            kmAABB3 box;
+            kmVec3 centre;
+            kmMat4 rotation;
+            kmOBB3 o1, o2;
+
+            kmVec3Fill(&centre, 0, 0, 0);
+            kmAABB3Initialize(&box, &centre, random(0.5, 3), random(0.5, 3), random(0.5, 3));
+            kmMat4RotationYawPitchRoll(&rotation, random(0, 3), random(0, 3), random(0, 3));
+            kmOBB3FromAABB3(&o1, &box, &rotation);
+
+            kmVec3Fill(&centre, random(-3, 3), random(-3, 3), random(-3, 3));
+            kmAABB3Initialize(&box, &centre, random(0.5, 3), random(0.5, 3), random(0.5, 3));
+            kmMat4RotationYawPitchRoll(&rotation, random(0, 3), random(0, 3), random(0, 3));
+            kmOBB3FromAABB3(&o2, &box, &rotation);
+
+            kmConvex3 a, b;
+            kmConvex3Fill(&a, kmSupport3OBB3, &o1);
+            kmConvex3Fill(&b, kmSupport3OBB3, &o2);
+
+            kmGJK3Result result;
+            kmBool hit = kmGJK3Collide(&result, &a, &b);
+            assert_equal(kmOBB3IntersectsOBB3(&o1, &o2), hit);
+            assert_equal(hit, kmGJK3Intersects(&a, &b));
+
+            if(hit) {
+                /* Pushing b out along the normal separates the boxes */
+                kmVec3 push;
+                kmVec3Scale(&push, &result.normal, result.depth * 1.01 + 0.001);
+                kmVec3Add(&o2.centre, &o2.centre, &push);
+                assert_false(kmOBB3IntersectsOBB3(&o1, &o2));
+            } else {
+                assert_close(result.distance, kmGJK3Distance(&a, &b, NULL, NULL), 0.0001);
+            }
+        }
+    }
+
+    void test_gjk_hull_pairs() {
+        kmVec3 corners[8];
+        for(int i = 0; i < 8; ++i) {
+            kmVec3Fill(&corners[i], (i & 1) ? 1 : -1, (i & 2) ? 1 : -1, (i & 4) ? 1 : -1);
+        }
+        kmConvexHull3 hull = { corners, 8 };
+
+        kmSphere near_sphere, far_sphere;
+        kmVec3 c;
+        kmVec3Fill(&c, 0, 0, 1.5);
+        kmSphereFill(&near_sphere, &c, 1);
+        kmVec3Fill(&c, 0, 0, 5);
+        kmSphereFill(&far_sphere, &c, 1);
+
+        kmConvex3 shapes[3];
+        kmConvex3Fill(&shapes[0], kmSupport3Hull, &hull);
+        kmConvex3Fill(&shapes[1], kmSupport3Sphere, &near_sphere);
+        kmConvex3Fill(&shapes[2], kmSupport3Sphere, &far_sphere);
+
+        kmUint pairs[] = { 0, 1, 0, 2, 1, 2 };
+        kmGJK3Result results[3];
+        assert_equal(1u, kmGJK3CollidePairs(shapes, pairs, 3, results));
+
+        assert_true(results[0].intersecting);
+        assert_close(0.5, results[0].depth, 0.01);
+        assert_close(1.0, results[0].normal.z, 0.01);
+
+        assert_false(results[1].intersecting);
+        assert_close(3.0, results[1].distance, 0.01);
+
+        assert_false(results[2].intersecting);
+        assert_close(1.5, results[2].distance, 0.01);
+    }
+};
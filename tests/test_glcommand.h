@@ -0,0 +1,126 @@
+#include "kaztest/kaztest.h"
+
+#include "../kazmath/GL/command.h"
+#include "../kazmath/GL/matrix.h"
+
+class TestGLCommand : public TestCase {
+public:
+    kmGLCommandBuffer buffer;
+
+    void set_up() {
+        kmGLCommandBufferInitialize(&buffer);
+    }
+
+    void tear_down() {
+        kmGLCommandBufferFree(&buffer);
+    }
+
+    void record_scene(kmGLCommandBuffer* pBuffer, kmScalar offset) {
+        kmMat4 view;
+        kmMat4Translation(&view, 0, 0, -10);
+
+        kmGLCommandBufferLoadMatrix(pBuffer, &view);
+        kmGLCommandBufferPushMatrix(pBuffer);
+        kmGLCommandBufferTranslatef(pBuffer, offset, 2, 3);
+        kmGLCommandBufferRotatef(pBuffer, 45, 0, 1, 0);
+        kmGLCommandBufferEmit(pBuffer);
+        kmGLCommandBufferPushMatrix(pBuffer);
+        kmGLCommandBufferScalef(pBuffer, 2, 2, 2);
+        kmGLCommandBufferEmit(pBuffer);
+        kmGLCommandBufferPopMatrix(pBuffer);
+        kmGLCommandBufferPopMatrix(pBuffer);
+        kmGLCommandBufferMultMatrix(pBuffer, &view);
+        kmGLCommandBufferEmit(pBuffer);
+    }
+
+    void test_evaluate() {
+        kmMat4 out[3], expected, step;
+        kmVec3 axis;
+
+        record_scene(&buffer, 1);
+        assert_equal(3, buffer.emit_count);
+        assert_equal(0, buffer.depth);
+        assert_equal(2, buffer.max_depth);
+        assert_equal(3, kmGLCommandBufferEvaluate(&buffer, NULL, out));
+
+        kmMat4Translation(&expected, 0, 0, -10);
+        kmMat4Multiply(&expected, &expected, kmMat4Translation(&step, 1, 2, 3));
+        kmVec3Fill(&axis, 0, 1, 0);
+        kmMat4Multiply(&expected, &expected, kmMat4RotationAxisAngle(&step, &axis, kmDegreesToRadians(45)));
+        assert_true(kmMat4AreEqual(&expected, &out[0]));
+
+        kmMat4Multiply(&expected, &expected, kmMat4Scaling(&step, 2, 2, 2));
+        assert_true(kmMat4AreEqual(&expected, &out[1]));
+
+        kmMat4Translation(&expected, 0, 0, -20);
+        assert_true(kmMat4AreEqual(&expected, &out[2]));
+    }
+
+    void test_replay_matches_evaluate() {
+        static int context;
+        kmMat4 out[3];
+
+        kmGLCommandBufferLoadIdentity(&buffer);
+        kmGLCommandBufferTranslatef(&buffer, 1, 2, 3);
+        kmGLCommandBufferRotatef(&buffer, 30, 1, 0, 0);
+        kmGLCommandBufferScalef(&buffer, 1, 2, 3);
+        kmGLCommandBufferEmit(&buffer);
+
+        kmGLSetCurrentContext(&context);
+        kmGLMatrixMode(KM_GL_MODELVIEW);
+        kmGLLoadMatrix(kmMat4Translation(&out[1], 5, 5, 5));
+        kmGLCommandBufferReplay(&buffer);
+
+        kmGLCommandBufferEvaluate(&buffer, NULL, out);
+        assert_true(kmMat4AreEqual(&out[0], kmGLGetMatrixPointer(KM_GL_MODELVIEW)));
+    }
+
+    void test_evaluate_array() {
+        kmGLCommandBuffer buffers[10];
+        kmMat4 single[3], out[30], base;
+        kmMat4Translation(&base, 0, 1, 0);
+
+        for(int i = 0; i < 10; ++i) {
+            kmGLCommandBufferInitialize(&buffers[i]);
+            /* Vary the number of emits per buffer */
+            for(int j = 0; j < i % 3 + 1; ++j) {
+                kmGLCommandBufferTranslatef(&buffers[i], i, j, 0);
+                kmGLCommandBufferEmit(&buffers[i]);
+            }
+        }
+
+        assert_equal(19, kmGLCommandBufferEvaluateArray(buffers, 10, &base, out, 4));
+
+        int written = 0;
+        for(int i = 0; i < 10; ++i) {
+            kmUint count = kmGLCommandBufferEvaluate(&buffers[i], &base, single);
+            for(kmUint j = 0; j < count; ++j) {
+                assert_true(kmMat4AreEqual(&single[j], &out[written + j]));
+            }
+            written += count;
+            kmGLCommandBufferFree(&buffers[i]);
+        }
+        assert_equal(19, written);
+    }
+
+    void test_deep_stack() {
+        kmMat4 out;
+
+        for(int i = 0; i < 100; ++i) {
+            kmGLCommandBufferPushMatrix(&buffer);
+            kmGLCommandBufferTranslatef(&buffer, 1, 0, 0);
+        }
+        kmGLCommandBufferEmit(&buffer);
+        for(int i = 0; i < 100; ++i) {
+            kmGLCommandBufferPopMatrix(&buffer);
+        }
+
+        assert_equal(100, buffer.max_depth);
+        kmGLCommandBufferEvaluate(&buffer, NULL, &out);
+        assert_close(100, out.mat[12], 0.0001);
+
+        kmGLCommandBufferClear(&buffer);
+        assert_equal(0, buffer.op_count);
+        assert_equal(0, kmGLCommandBufferEvaluate(&buffer, NULL, &out));
+    }
+};
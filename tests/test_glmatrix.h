@@ -0,0 +1,127 @@
+#include <cstring>
+#include "kaztest/kaztest.h"
+
+#include "../kazmath/GL/matrix.h"
+
+class TestGLMatrix : public TestCase {
+public:
+    void set_up() {
+        static int context;
+        kmGLSetCurrentContext(&context);
+
+        kmGLMatrixMode(KM_GL_PROJECTION);
+        kmGLLoadIdentity();
+        kmGLMatrixMode(KM_GL_MODELVIEW);
+        kmGLLoadIdentity();
+    }
+
+    void test_matrix_pointer() {
+        kmGLTranslatef(1, 2, 3);
+
+        const kmMat4* modelview = kmGLGetMatrixPointer(KM_GL_MODELVIEW);
+        assert_close(1, modelview->mat[12], kmEpsilon);
+        assert_close(2, modelview->mat[13], kmEpsilon);
+        assert_close(3, modelview->mat[14], kmEpsilon);
+        assert_true(kmMat4IsIdentity(kmGLGetMatrixPointer(KM_GL_PROJECTION)));
+    }
+
+    void test_modelview_projection() {
+        kmMat4 projection, expected;
+        kmMat4PerspectiveProjection(&projection, 60, 1.5, 0.1, 100);
+
+        kmGLTranslatef(1, 2, 3);
+        kmGLRotatef(30, 0, 1, 0);
+        kmGLMatrixMode(KM_GL_PROJECTION);
+        kmGLLoadMatrix(&projection);
+
+        kmMat4Multiply(&expected, &projection, kmGLGetMatrixPointer(KM_GL_MODELVIEW));
+        assert_true(kmMat4AreEqual(&expected, kmGLGetModelviewProjection()));
+
+        /* Changing the texture matrix must leave the cache alone */
+        kmGLMatrixMode(KM_GL_TEXTURE);
+        kmGLScalef(2, 2, 2);
+        assert_true(kmMat4AreEqual(&expected, kmGLGetModelviewProjection()));
+
+        kmGLMatrixMode(KM_GL_MODELVIEW);
+        kmGLPushMatrix();
+        kmGLScalef(2, 2, 2);
+        assert_false(kmMat4AreEqual(&expected, kmGLGetModelviewProjection()));
+        kmGLPopMatrix();
+        assert_true(kmMat4AreEqual(&expected, kmGLGetModelviewProjection()));
+    }
+
+    void test_inverse_modelview() {
+        kmMat4 product;
+
+        kmGLTranslatef(1, 2, 3);
+        kmGLRotatef(45, 1, 0, 0);
+        kmGLScalef(2, 3, 4);
+
+        kmMat4Multiply(&product, kmGLGetMatrixPointer(KM_GL_MODELVIEW), kmGLGetInverseModelview());
+        for(int i = 0; i < 16; ++i) {
+            assert_close((i % 5 == 0) ? 1 : 0, product.mat[i], 0.0001);
+        }
+
+        kmGLScalef(0, 1, 1);
+        assert_true(kmMat4IsIdentity(kmGLGetInverseModelview()));
+    }
+
+    void test_normal_matrix() {
+        kmVec3 normal;
+        kmMat3 expected;
+
+        /* A rotation is its own normal matrix */
+        kmGLRotatef(90, 0, 0, 1);
+        kmMat4ExtractRotationMat3(kmGLGetMatrixPointer(KM_GL_MODELVIEW), &expected);
+        for(int i = 0; i < 9; ++i) {
+            assert_close(expected.mat[i], kmGLGetNormalMatrix()->mat[i], 0.0001);
+        }
+
+        /* Non-uniform scale: a normal of the plane x + y = 0 must stay
+         * perpendicular to it after scaling x by 2 */
+        kmGLLoadIdentity();
+        kmGLScalef(2, 1, 1);
+        kmVec3Fill(&normal, 1, 1, 0);
+        kmVec3MultiplyMat3(&normal, &normal, kmGLGetNormalMatrix());
+        assert_close(0.5, normal.x, kmEpsilon);
+        assert_close(1, normal.y, kmEpsilon);
+    }
+
+    void test_stats() {
+        kmGLContextStats stats;
+        char json[512];
+
+#ifdef KAZMATH_GL_STATS
+        kmGLResetStats();
+        for(int i = 0; i < 40; ++i) {
+            kmGLPushMatrix();
+        }
+        for(int i = 0; i < 39; ++i) {
+            kmGLPopMatrix();
+        }
+
+        assert_true(kmGLGetStats(&stats));
+        assert_equal(2, stats.modelview.depth);
+        assert_equal(41, stats.modelview.high_water);
+        assert_equal(40, stats.modelview.pushes);
+        assert_equal(39, stats.modelview.pops);
+        assert_equal(1, stats.modelview.reallocations);
+        assert_equal(1, stats.projection.depth);
+        assert_equal(0, stats.projection.pushes);
+        kmGLPopMatrix();
+#else
+        assert_false(kmGLGetStats(&stats));
+        assert_equal(0, stats.modelview.pushes);
+#endif
+
+        int length = kmGLStatsToJSON(&stats, json, sizeof(json));
+        assert_true(length > 0 && length < (int) sizeof(json));
+        assert_equal(length, (int) strlen(json));
+        assert_true(strstr(json, "\"modelview\":{") != NULL);
+        assert_equal('}', json[length - 1]);
+
+        /* A short buffer still reports the full length */
+        assert_equal(length, kmGLStatsToJSON(&stats, json, 10));
+        assert_equal(9, (int) strlen(json));
+    }
+};
@@ -0,0 +1,171 @@
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include "random_test_case.h"
+
+#include "../kazmath/grid2.h"
+#include "../kazmath/aabb2.h"
+#include "../kazmath/ray2.h"
+
+class TestGrid2 : public RandomTestCase {
+public:
+    TestGrid2():
+        RandomTestCase(4321) {}
+
+    std::vector<kmAABB2> random_boxes(unsigned count) {
+        std::vector<kmAABB2> boxes(count);
+        for(unsigned i = 0; i < count; ++i) {
+            kmVec2 centre;
+            kmVec2Fill(&centre, random(-110, 110), random(-100, 100));
+            kmScalar size = (i % 10 == 0) ? random(5, 30) : random(0.5, 4);
+            kmAABB2Initialize(&boxes[i], &centre, size, size * 0.75, 0);
+        }
+        return boxes;
+    }
+
+    std::vector<kmUint> sorted(const kmUint* handles, kmUint count) {
+        std::vector<kmUint> result(handles, handles + count);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    void test_grid_queries_match_linear_scan() {
+        std::vector<kmAABB2> boxes = random_boxes(400);
+
+        kmGrid2 tree;
+        kmGrid2Initialize(&tree, 8, 256);
+        for(unsigned i = 0; i < boxes.size(); ++i) kmGrid2Insert(&tree, &boxes[i]);
+
+        std::vector<kmAABB2> queries(10);
+        for(unsigned q = 0; q < queries.size(); ++q) {
+            kmVec2 centre;
+            kmVec2Fill(&centre, random(-100, 100), random(-100, 100));
+            kmAABB2Initialize(&queries[q], &centre, 25, 25, 0);
+        }
+
+        std::vector<kmUint> offsets(queries.size() + 1), out(boxes.size() * queries.size());
+        kmGrid2QueryAABB2Array(&tree, &queries[0], queries.size(), &offsets[0], &out[0], out.size());
+
+        for(unsigned q = 0; q < queries.size(); ++q) {
+            std::vector<kmUint> expected;
+            for(unsigned i = 0; i < boxes.size(); ++i) {
+                if(kmAABB2IntersectsAABB(&boxes[i], &queries[q])) expected.push_back(i);
+            }
+
+            assert_equal((kmUint) expected.size(), offsets[q + 1] - offsets[q]);
+            assert_true(expected == sorted(&out[offsets[q]], offsets[q + 1] - offsets[q]));
+
+            std::vector<kmUint> single(boxes.size());
+            kmUint found = kmGrid2QueryAABB2(&tree, &queries[q], &single[0], single.size());
+            assert_true(expected == sorted(&single[0], found));
+        }
+
+        /* Pairs against the all-pairs loop they replace */
+        std::vector<std::pair<kmUint, kmUint> > expected_pairs;
+        for(unsigned i = 0; i < boxes.size(); ++i) {
+            for(unsigned j = i + 1; j < boxes.size(); ++j) {
+                if(kmAABB2IntersectsAABB(&boxes[i], &boxes[j])) expected_pairs.push_back(std::make_pair(i, j));
+            }
+        }
+
+        std::vector<kmUint> pairs(boxes.size() * 20);
+        kmUint pair_count = kmGrid2QueryPairs(&tree, &pairs[0], pairs.size() / 2);
+        assert_equal((kmUint) expected_pairs.size(), pair_count);
+
+        std::vector<std::pair<kmUint, kmUint> > found_pairs;
+        for(kmUint i = 0; i < pair_count; ++i) {
+            found_pairs.push_back(std::make_pair(pairs[i * 2], pairs[i * 2 + 1]));
+        }
+        std::sort(found_pairs.begin(), found_pairs.end());
+        assert_true(expected_pairs == found_pairs);
+
+        /* Rays */
+        for(int r = 0; r < 10; ++r) {
+            kmRay2 ray;
+            kmRay2Fill(&ray, -150, random(-90, 90), 1, random(-0.3, 0.3));
+
+            std::vector<kmUint> expected;
+            for(unsigned i = 0; i < boxes.size(); ++i) {
+                if(kmRay2IntersectAABB2(&ray, &boxes[i], NULL, NULL)) expected.push_back(i);
+            }
+
+            std::vector<kmUint> hits(boxes.size());
+            kmUint found = kmGrid2QueryRay2(&tree, &ray, &hits[0], hits.size());
+            assert_true(expected == sorted(&hits[0], found));
+        }
+
+        kmGrid2Free(&tree);
+    }
+
+    void test_grid_axis_aligned_ray_on_boundary() {
+        kmGrid2 tree;
+        kmGrid2Initialize(&tree, 8, 64);
+
+        /* Occupies exactly cells [0, 1] x [0, 1] */
+        kmAABB2 box;
+        kmVec2 centre;
+        kmVec2Fill(&centre, 8, 8);
+        kmAABB2Initialize(&box, &centre, 16, 16, 0);
+        kmUint handle = kmGrid2Insert(&tree, &box);
+
+        /* Each ray has a zero component and starts on the edge of the occupied range */
+        kmRay2 rays[4];
+        kmRay2Fill(&rays[0], -10, 0, 40, 0);
+        kmRay2Fill(&rays[1], -10, 16, 40, 0);
+        kmRay2Fill(&rays[2], 0, 30, 0, -40);
+        kmRay2Fill(&rays[3], 16, 30, 0, -40);
+
+        for(int r = 0; r < 4; ++r) {
+            kmUint out[2];
+            assert_true(kmRay2IntersectAABB2(&rays[r], &box, NULL, NULL));
+            assert_equal(1u, kmGrid2QueryRay2(&tree, &rays[r], out, 2));
+            assert_equal(handle, out[0]);
+        }
+
+        /* Parallel and outside the occupied range */
+        kmRay2 miss;
+        kmRay2Fill(&miss, -10, 30, 40, 0);
+        kmUint out[2];
+        assert_equal(0u, kmGrid2QueryRay2(&tree, &miss, out, 2));
+
+        kmGrid2Free(&tree);
+    }
+
+    void test_grid_moving_entities() {
+        kmGrid2 tree;
+        kmGrid2Initialize(&tree, 4, 64);
+
+        kmAABB2 box;
+        kmVec2 centre;
+        kmVec2Fill(&centre, -40, -40);
+        kmAABB2Initialize(&box, &centre, 2, 2, 0);
+        kmUint handle = kmGrid2Insert(&tree, &box);
+
+        kmAABB2 query;
+        kmVec2Fill(&centre, 40, 40);
+        kmAABB2Initialize(&query, &centre, 5, 5, 0);
+
+        kmUint out[2];
+        assert_equal(0u, kmGrid2QueryAABB2(&tree, &query, out, 2));
+
+        /* Walk the entity across the world */
+        for(int step = 0; step <= 80; ++step) {
+            kmVec2Fill(&centre, -40 + step, -40 + step);
+            kmAABB2Initialize(&box, &centre, 2, 2, 0);
+            kmGrid2Update(&tree, handle, &box);
+        }
+
+        assert_equal(1u, kmGrid2QueryAABB2(&tree, &query, out, 2));
+        assert_equal(handle, out[0]);
+
+        kmGrid2Remove(&tree, handle);
+        assert_equal(0u, kmGrid2QueryAABB2(&tree, &query, out, 2));
+
+        /* Cell entries and handles are recycled */
+        kmUint entry_count = tree.entry_count;
+        assert_equal(handle, kmGrid2Insert(&tree, &box));
+        assert_equal(entry_count, tree.entry_count);
+
+        kmGrid2Free(&tree);
+    }
+};
@@ -0,0 +1,113 @@
+#include <vector>
+#include <algorithm>
+#include "random_test_case.h"
+
+#include "../kazmath/hashgrid3.h"
+
+class TestHashGrid3 : public RandomTestCase {
+public:
+    TestHashGrid3():
+        RandomTestCase(2468) {}
+
+    std::vector<kmVec3> random_points(unsigned count) {
+        std::vector<kmVec3> points(count);
+        for(unsigned i = 0; i < count; ++i) {
+            kmVec3Fill(&points[i], random(-10, 10), random(-10, 10), random(-10, 10));
+        }
+        return points;
+    }
+
+    void test_hashgrid_radius_query_matches_linear_scan() {
+        std::vector<kmVec3> points = random_points(3000);
+
+        /* A small table forces plenty of cells to share buckets */
+        kmHashGrid3 grid;
+        kmHashGrid3Initialize(&grid, 1.0, 64);
+        kmHashGrid3Build(&grid, &points[0], points.size());
+
+        assert_equal(64u, grid.table_size);
+        assert_equal((kmUint) points.size(), grid.cell_start[grid.table_size]);
+
+        for(int q = 0; q < 50; ++q) {
+            kmVec3 centre;
+            kmVec3Fill(&centre, random(-10, 10), random(-10, 10), random(-10, 10));
+            kmScalar radius = (q % 5 == 0) ? 2.5 : 1.0;
+
+            std::vector<kmUint> expected;
+            for(unsigned i = 0; i < points.size(); ++i) {
+                kmVec3 d;
+                kmVec3Subtract(&d, &points[i], &centre);
+                if(kmVec3LengthSq(&d) <= radius * radius) expected.push_back(i);
+            }
+
+            std::vector<kmUint> out(points.size());
+            kmUint found = kmHashGrid3QueryRadius(&grid, &centre, radius, &out[0], out.size());
+            out.resize(found);
+            std::sort(out.begin(), out.end());
+
+            assert_equal((kmUint) expected.size(), found);
+            assert_true(expected == out);
+        }
+
+        kmHashGrid3Free(&grid);
+    }
+
+    void test_hashgrid_iterator() {
+        kmVec3 points[4];
+        kmVec3Fill(&points[0], 0.1, 0.1, 0.1);
+        kmVec3Fill(&points[1], 0.9, 0.1, 0.1);
+        kmVec3Fill(&points[2], 1.6, 0.1, 0.1);
+        kmVec3Fill(&points[3], -0.5, 0.5, 0.1);
+
+        kmHashGrid3 grid;
+        kmHashGrid3Initialize(&grid, 1.0, 16);
+        kmHashGrid3Build(&grid, points, 4);
+
+        kmHashGrid3Iterator it;
+        kmUint index, count = 0, mask = 0;
+        kmScalar dist_sq;
+
+        kmHashGrid3IteratorBegin(&it, &grid, &points[0], 1.0);
+        while(kmHashGrid3IteratorNext(&it, &index, &dist_sq)) {
+            ++count;
+            mask |= 1u << index;
+            assert_true(dist_sq <= 1.0);
+        }
+
+        assert_equal(3u, count);
+        assert_equal(1u | 2u | 8u, mask);
+        assert_false(kmHashGrid3IteratorNext(&it, &index, NULL));
+
+        kmInt x, y, z;
+        kmHashGrid3CellOf(&grid, &points[3], &x, &y, &z);
+        assert_equal(-1, x);
+        assert_equal(0, y);
+
+        kmUint bucket_count;
+        const kmUint* bucket = kmHashGrid3Bucket(&grid, x, y, z, &bucket_count);
+        assert_true(std::find(bucket, bucket + bucket_count, 3u) != bucket + bucket_count);
+
+        kmHashGrid3Free(&grid);
+    }
+
+    void test_hashgrid_parallel_build_matches_serial() {
+        std::vector<kmVec3> points = random_points(10001);
+
+        kmHashGrid3 serial, parallel;
+        kmHashGrid3Initialize(&serial, 0.5, 4096);
+        kmHashGrid3Initialize(&parallel, 0.5, 4096);
+
+        kmHashGrid3Build(&serial, &points[0], points.size());
+        kmHashGrid3BuildParallel(&parallel, &points[0], points.size(), 4);
+
+        for(kmUint i = 0; i <= serial.table_size; ++i) {
+            assert_equal(serial.cell_start[i], parallel.cell_start[i]);
+        }
+        for(kmUint i = 0; i < points.size(); ++i) {
+            assert_equal(serial.indices[i], parallel.indices[i]);
+        }
+
+        kmHashGrid3Free(&serial);
+        kmHashGrid3Free(&parallel);
+    }
+};
@@ -0,0 +1,138 @@
+#include "kaztest/kaztest.h"
+
+#include "../kazmath/kazmath.h"
+#include "../kazmathxx/basic_mat4.h"
+
+class TestKazmathxx : public TestCase {
+public:
+    void assert_mat4_close(const kmMat4& expected, const km::mat4f& actual, kmScalar tolerance) {
+        for(int i = 0; i < 16; ++i) {
+            assert_close(expected.mat[i], actual.mat[i], tolerance);
+        }
+    }
+
+    void test_vec3() {
+        km::vec3f a(1, 2, 3), b(4, 5, 6);
+        kmVec3 ka, kb, kc;
+        kmVec3Fill(&ka, 1, 2, 3);
+        kmVec3Fill(&kb, 4, 5, 6);
+
+        assert_true(km::vec3f(*kmVec3Cross(&kc, &ka, &kb)) == a.cross(b));
+        assert_close(kmVec3Dot(&ka, &kb), a.dot(b), 0.0001);
+        assert_close(1, a.normalize().length(), 0.0001);
+        assert_true(km::vec3f() == km::vec3f().normalize());
+        assert_true(km::vec3f(5, 7, 9) == a + b);
+        assert_true(km::vec3f(2, 4, 6) == 2.0f * a);
+        assert_true(a == a / 0.0f);
+        assert_true(km::vec3f(-1, -2, -3) == -a);
+
+        kmVec3 back = a.toKmVec3();
+        assert_true(kmVec3AreEqual(&back, &ka));
+    }
+
+    void test_precision_conversion() {
+        /* A world position that float can't hold to the millimetre */
+        km::vec3d position(10000000.001, 0, 0);
+        km::vec3f rounded(position);
+
+        assert_true(position.x != double(rounded.x));
+        assert_close(10000000.001, km::vec3d(rounded).x, 1.0);
+
+        km::mat4d translation = km::mat4d::translation(position.x, position.y, position.z);
+        km::vec3d origin = translation.inverse().transformCoord(position);
+        assert_close(0, origin.x, 1e-8);
+
+        km::mat4f single(translation);
+        assert_close(10000000, single.mat[12], 1);
+    }
+
+    void test_mat4_matches_c() {
+        kmMat4 expected, a, b;
+        kmVec3 axis, eye, centre, up;
+
+        kmVec3Fill(&axis, 1, 2, 3);
+        kmVec3Normalize(&axis, &axis);
+        kmMat4RotationAxisAngle(&a, &axis, 0.7);
+        kmMat4Translation(&b, 1, -2, 3);
+        kmMat4Multiply(&expected, &a, &b);
+
+        km::mat4f product = km::mat4f::rotationAxisAngle(km::vec3f(axis), 0.7f) * km::mat4f::translation(1, -2, 3);
+        assert_mat4_close(expected, product, 0.0001);
+
+        kmMat4Inverse(&expected, &expected);
+        assert_mat4_close(expected, product.inverse(), 0.0001);
+        assert_mat4_close(*kmMat4Identity(&a), product * product.inverse(), 0.0001);
+
+        kmMat4PerspectiveProjection(&expected, 60, 1.5, 0.1, 100);
+        assert_mat4_close(expected, km::mat4f::perspectiveProjection(60, 1.5, 0.1, 100), 0.0001);
+
+        kmMat4OrthographicProjection(&expected, -2, 2, -1, 1, 0.5, 50);
+        assert_mat4_close(expected, km::mat4f::orthographicProjection(-2, 2, -1, 1, 0.5, 50), 0.0001);
+
+        kmVec3Fill(&eye, 1, 2, 3);
+        kmVec3Fill(&centre, -1, 0, 2);
+        kmVec3Fill(&up, 0, 1, 0);
+        kmMat4LookAt(&expected, &eye, &centre, &up);
+        assert_mat4_close(expected, km::mat4f::lookAt(km::vec3f(eye), km::vec3f(centre), km::vec3f(up)), 0.0001);
+
+        kmMat4RotationX(&expected, 0.3);
+        assert_mat4_close(expected, km::mat4f::rotationX(0.3f), 0.0001);
+        kmMat4RotationY(&expected, 0.3);
+        assert_mat4_close(expected, km::mat4f::rotationY(0.3f), 0.0001);
+        kmMat4RotationZ(&expected, 0.3);
+        assert_mat4_close(expected, km::mat4f::rotationZ(0.3f), 0.0001);
+
+        /* A singular matrix comes back unchanged */
+        km::mat4f flat = km::mat4f::scaling(1, 0, 1);
+        assert_true(flat == flat.inverse());
+    }
+
+    void test_mat3() {
+        km::mat3d rotation = km::mat3d::rotationAxisAngle(km::vec3d(0, 0, 1), km::pi<double>() / 2);
+        km::vec3d v = rotation * km::vec3d(1, 0, 0);
+        assert_close(0, v.x, 1e-12);
+        assert_close(1, v.y, 1e-12);
+
+        km::mat4d full = km::mat4d::rotationAxisAngle(km::vec3d(0, 0, 1), km::pi<double>() / 2);
+        assert_true(rotation == full.extractRotation());
+
+        km::mat3d scaled = km::mat3d::scaling(2, 4, 8) * rotation;
+        assert_close(64, scaled.determinant(), 1e-9);
+        assert_true((scaled * scaled.inverse()).isIdentity());
+        assert_true(scaled.transpose().transpose() == scaled);
+    }
+
+    void test_quaternion() {
+        kmQuaternion a, b, expected;
+        kmVec3 axis;
+
+        kmVec3Fill(&axis, 0, 1, 0);
+        kmQuaternionRotationAxisAngle(&a, &axis, 0.2);
+        kmVec3Fill(&axis, 1, 0, 0);
+        kmQuaternionRotationAxisAngle(&b, &axis, 1.3);
+
+        km::quaternionf qa(a), qb(b);
+        kmQuaternionSlerp(&expected, &a, &b, 0.25);
+        km::quaternionf slerped = km::quaternionf::slerp(qa, qb, 0.25f);
+        assert_close(expected.x, slerped.x, 0.0001);
+        assert_close(expected.y, slerped.y, 0.0001);
+        assert_close(expected.z, slerped.z, 0.0001);
+        assert_close(expected.w, slerped.w, 0.0001);
+
+        kmQuaternionMultiply(&expected, &a, &b);
+        km::quaternionf product = qa * qb;
+        assert_close(expected.x, product.x, 0.0001);
+        assert_close(expected.w, product.w, 0.0001);
+
+        /* Rotating a vector agrees with the rotation matrix */
+        km::vec3f v(1, 2, 3);
+        km::vec3f rotated = qa * v;
+        km::vec3f transformed = km::mat4f::rotationQuaternion(qa).transformCoord(v);
+        assert_close(transformed.x, rotated.x, 0.0001);
+        assert_close(transformed.y, rotated.y, 0.0001);
+        assert_close(transformed.z, rotated.z, 0.0001);
+
+        km::quaterniond precise(qa);
+        assert_close(1, (precise * precise.inverse()).w, 1e-6);
+    }
+};
@@ -0,0 +1,128 @@
+#include <vector>
+#include <algorithm>
+#include "random_test_case.h"
+
+#include "../kazmath/kdtree3.h"
+
+class TestKDTree3 : public RandomTestCase {
+public:
+    TestKDTree3():
+        RandomTestCase(2468) {}
+
+    std::vector<kmVec3> random_points(unsigned count) {
+        std::vector<kmVec3> points(count);
+        for(unsigned i = 0; i < count; ++i) {
+            kmVec3Fill(&points[i], random(-50, 50), random(-50, 50), random(-10, 10));
+        }
+        /* Repeated points and coordinates must not upset the median split */
+        for(unsigned i = 0; i < count / 10; ++i) {
+            points[i * 3 + 1] = points[i * 3];
+            points[i * 3 + 2].x = points[i * 3].x;
+        }
+        return points;
+    }
+
+    kmScalar distance_sq(const kmVec3& a, const kmVec3& b) {
+        return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z);
+    }
+
+    void test_kdtree_build_is_a_valid_tree() {
+        std::vector<kmVec3> points = random_points(5000);
+
+        kmKDTree3 tree;
+        kmKDTree3Initialize(&tree);
+        kmKDTree3Build(&tree, &points[0], points.size(), 4);
+        assert_equal(5000u, tree.count);
+
+        /* Every index appears once, and each node splits its range */
+        std::vector<int> seen(points.size(), 0);
+        for(kmUint i = 0; i < tree.count; ++i) {
+            ++seen[tree.indices[i]];
+            assert_equal(points[tree.indices[i]].x, tree.points[i].x);
+        }
+        for(unsigned i = 0; i < points.size(); ++i) {
+            assert_equal(1, seen[i]);
+        }
+
+        std::vector<std::pair<kmUint, kmUint> > ranges(1, std::make_pair(0u, tree.count));
+        while(!ranges.empty()) {
+            kmUint lo = ranges.back().first, hi = ranges.back().second;
+            ranges.pop_back();
+            if(lo >= hi) continue;
+
+            kmUint mid = lo + (hi - lo) / 2;
+            int axis = tree.axes[mid];
+            kmScalar split = (&tree.points[mid].x)[axis];
+            for(kmUint i = lo; i < mid; ++i) assert_true((&tree.points[i].x)[axis] <= split);
+            for(kmUint i = mid + 1; i < hi; ++i) assert_true((&tree.points[i].x)[axis] >= split);
+
+            ranges.push_back(std::make_pair(lo, mid));
+            ranges.push_back(std::make_pair(mid + 1, hi));
+        }
+
+        kmKDTree3Build(&tree, &points[0], 1, 1);
+        kmUint out;
+        assert_equal(1u, kmKDTree3QueryNearest(&tree, &points[5], 3, &out, NULL));
+        assert_equal(0u, out);
+
+        kmKDTree3Free(&tree);
+    }
+
+    void test_kdtree_queries_match_linear_scan() {
+        std::vector<kmVec3> points = random_points(3000);
+
+        kmKDTree3 tree;
+        kmKDTree3Initialize(&tree);
+        kmKDTree3Build(&tree, &points[0], points.size(), 3);
+
+        const kmUint k = 8;
+        std::vector<kmVec3> queries(200);
+        for(unsigned q = 0; q < queries.size(); ++q) {
+            kmVec3Fill(&queries[q], random(-60, 60), random(-60, 60), random(-12, 12));
+        }
+
+        std::vector<kmUint> nearest(queries.size() * k);
+        std::vector<kmScalar> distances(queries.size() * k);
+        assert_equal(k, kmKDTree3QueryNearestArray(&tree, &queries[0], queries.size(), k,
+                                                   &nearest[0], &distances[0], 4));
+
+        std::vector<kmUint> offsets(queries.size() + 1), within(points.size() * 4);
+        kmUint total = kmKDTree3QueryRadiusArray(&tree, &queries[0], queries.size(), 6,
+                                                 &offsets[0], &within[0], within.size(), 4);
+        assert_equal(total, offsets[queries.size()]);
+        assert_true(total <= within.size());
+
+        for(unsigned q = 0; q < queries.size(); ++q) {
+            std::vector<kmScalar> expected_dist;
+            std::vector<kmUint> expected_within;
+            for(unsigned i = 0; i < points.size(); ++i) {
+                kmScalar d = distance_sq(points[i], queries[q]);
+                expected_dist.push_back(d);
+                if(d <= 36) expected_within.push_back(i);
+            }
+            std::sort(expected_dist.begin(), expected_dist.end());
+
+            for(kmUint j = 0; j < k; ++j) {
+                assert_close(expected_dist[j], distances[q * k + j], 0.0001);
+                assert_close(distances[q * k + j], distance_sq(points[nearest[q * k + j]], queries[q]), 0.0001);
+            }
+
+            std::vector<kmUint> found(within.begin() + offsets[q], within.begin() + offsets[q + 1]);
+            std::sort(found.begin(), found.end());
+            assert_true(expected_within == found);
+
+            kmUint single[k];
+            assert_equal(k, kmKDTree3QueryNearest(&tree, &queries[q], k, single, NULL));
+            for(kmUint j = 0; j < k; ++j) {
+                assert_close(distances[q * k + j], distance_sq(points[single[j]], queries[q]), 0.0001);
+            }
+        }
+
+        /* Truncated output still reports every match */
+        std::vector<kmUint> small(5);
+        assert_equal(total, kmKDTree3QueryRadiusArray(&tree, &queries[0], queries.size(), 6,
+                                                      &offsets[0], &small[0], small.size(), 2));
+
+        kmKDTree3Free(&tree);
+    }
+};
@@ -156,4 +156,22 @@ public:
         assert_close(0, up.z, 0.0001);
     }
 
+    void test_mat4_yaw_pitch_roll_matches_axis_product() {
+        kmScalar pitch = 0.3, yaw = -1.2, roll = 2.1;
+
+        kmMat4 x, y, z, expected;
+        kmMat4RotationX(&x, pitch);
+        kmMat4RotationY(&y, yaw);
+        kmMat4RotationZ(&z, roll);
+        kmMat4Multiply(&expected, &x, &z);
+        kmMat4Multiply(&expected, &y, &expected);
+
+        kmMat4 result;
+        kmMat4RotationYawPitchRoll(&result, pitch, yaw, roll);
+
+        for(int i = 0; i < 16; ++i) {
+            assert_close(expected.mat[i], result.mat[i], 0.00001);
+        }
+    }
+
 };
@@ -0,0 +1,141 @@
+#include <cstdlib>
+#include <vector>
+#include "kaztest/kaztest.h"
+
+#include "../kazmath/obb3.h"
+#include "../kazmath/aabb3.h"
+#include "../kazmath/mat4.h"
+#include "../kazmath/plane.h"
+#include "../kazmath/ray3.h"
+
+class TestOBB3 : public TestCase {
+public:
+    kmOBB3 make_box(kmScalar x, kmScalar y, kmScalar z, kmScalar radians_y, kmScalar half) {
+        kmOBB3 box;
+        kmVec3 centre, extents;
+        kmMat3 axes;
+        kmMat3FromRotationY(&axes, radians_y);
+        kmVec3Fill(&centre, x, y, z);
+        kmVec3Fill(&extents, half, half, half);
+        kmOBB3Fill(&box, &centre, &axes, &extents);
+        return box;
+    }
+
+    void test_obb_obb_overlap() {
+        kmOBB3 a = make_box(0, 0, 0, 0, 1);
+        kmOBB3 b = make_box(2.2, 0, 0, 0, 1);
+
+        /* Axis aligned and separated along x */
+        assert_false(kmOBB3IntersectsOBB3(&a, &b));
+
+        /* Rotated by 45 degrees the corner reaches sqrt(2) */
+        b = make_box(2.2, 0, 0, kmPI / 4, 1);
+        assert_true(kmOBB3IntersectsOBB3(&a, &b));
+
+        b = make_box(2.5, 0, 0, kmPI / 4, 1);
+        assert_false(kmOBB3IntersectsOBB3(&a, &b));
+
+        /* Tilted about two axes, c reaches up to y = 1 + sqrt(0.5) */
+        kmOBB3 c = make_box(0, 0, 0, kmPI / 4, 1);
+        kmMat3 tilt;
+        kmMat3FromRotationX(&tilt, kmPI / 4);
+        kmMat3MultiplyMat3(&c.axes, &tilt, &c.axes);
+
+        kmOBB3 d = make_box(0, 2.6, 0, 0, 1);
+        assert_true(kmOBB3IntersectsOBB3(&c, &d));
+        assert_true(kmOBB3IntersectsOBB3(&d, &c));
+
+        d = make_box(0, 2.8, 0, 0, 1);
+        assert_false(kmOBB3IntersectsOBB3(&c, &d));
+        assert_false(kmOBB3IntersectsOBB3(&d, &c));
+    }
+
+    void test_obb_aabb_conversion() {
+        kmAABB3 aabb;
+        kmAABB3Initialize(&aabb, NULL, 2, 4, 6);
+
+        kmMat4 rot, trans, m;
+        kmMat4RotationZ(&rot, kmPI / 2);
+        kmMat4Translation(&trans, 10, 0, 0);
+        kmMat4Multiply(&m, &trans, &rot);
+
+        kmOBB3 obb;
+        kmOBB3FromAABB3(&obb, &aabb, &m);
+        assert_close(10.0, obb.centre.x, 0.0001);
+        assert_close(1.0, obb.extents.x, 0.0001);
+        assert_close(3.0, obb.extents.z, 0.0001);
+
+        kmAABB3 back;
+        kmAABB3FromOBB3(&back, &obb, NULL);
+        assert_close(8.0, back.min.x, 0.0001);
+        assert_close(12.0, back.max.x, 0.0001);
+        assert_close(-1.0, back.min.y, 0.0001);
+        assert_close(1.0, back.max.y, 0.0001);
+        assert_close(-3.0, back.min.z, 0.0001);
+    }
+
+    void test_obb_from_points_pca() {
+        /* A long thin cloud along the (1, 1, 0) diagonal */
+        std::vector<kmVec3> points;
+        srand(99);
+        for(int i = 0; i < 500; ++i) {
+            kmScalar t = (rand() / (kmScalar) RAND_MAX) * 20 - 10;
+            kmScalar n = (rand() / (kmScalar) RAND_MAX) * 0.2 - 0.1;
+            kmScalar z = (rand() / (kmScalar) RAND_MAX) * 0.4 - 0.2;
+            kmVec3 p;
+            kmVec3Fill(&p, t + n, t - n, z);
+            points.push_back(p);
+        }
+
+        kmOBB3 box;
+        kmOBB3FromPointsPCA(&box, &points[0], points.size());
+
+        for(const kmVec3& p: points) {
+            kmOBB3 loose = box;
+            kmVec3 pad;
+            kmVec3Fill(&pad, 0.0001, 0.0001, 0.0001);
+            kmVec3Add(&loose.extents, &loose.extents, &pad);
+            assert_true(kmOBB3ContainsPoint(&loose, &p));
+        }
+
+        /* Much tighter than the enclosing AABB */
+        kmScalar volume = box.extents.x * box.extents.y * box.extents.z * 8;
+        assert_true(volume < 20.0 * 20.0 * 0.4 * 0.1);
+    }
+
+    void test_obb_ray() {
+        kmOBB3 box = make_box(5, 0, 0, kmPI / 4, 1);
+        kmRay3 ray;
+        kmRay3Fill(&ray, 0, 0, 0, 1, 0, 0);
+
+        kmScalar dist;
+        kmVec3 hit;
+        assert_true(kmRay3IntersectOBB3(&ray, &box, &hit, &dist));
+        assert_close(5.0 - sqrt(2.0), dist, 0.0001);
+
+        kmRay3Fill(&ray, 0, 2, 0, 1, 0, 0);
+        assert_false(kmRay3IntersectOBB3(&ray, &box, &hit, &dist));
+    }
+
+    void test_obb_frustum_batch() {
+        kmMat4 proj;
+        kmMat4PerspectiveProjection(&proj, 60, 1, 1, 100);
+
+        kmPlane planes[6];
+        for(int i = 0; i < 6; ++i) {
+            kmMat4ExtractPlane(&planes[i], &proj, i);
+        }
+
+        kmOBB3 boxes[3] = {
+            make_box(0, 0, -10, 0.3, 1), /* In front of the camera */
+            make_box(0, 0, 10, 0.3, 1),  /* Behind */
+            make_box(0, 0, -200, 0, 1)   /* Past the far plane */
+        };
+
+        kmBool results[3];
+        assert_equal(1u, kmOBB3IntersectsPlanesArray(boxes, 3, planes, 6, results));
+        assert_true(results[0]);
+        assert_false(results[1]);
+        assert_false(results[2]);
+    }
+};
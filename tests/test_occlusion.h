@@ -0,0 +1,147 @@
+#include <vector>
+#include "random_test_case.h"
+
+#include "../kazmath/occlusion.h"
+#include "../kazmath/mat4.h"
+#include "../kazmath/aabb3.h"
+
+class TestOcclusion : public RandomTestCase {
+public:
+    TestOcclusion():
+        RandomTestCase(8642) {}
+
+    kmMat4 projection;
+
+    /* A square wall facing the camera, as two triangles */
+    void wall(kmVec3* out, kmScalar x, kmScalar y, kmScalar half, kmScalar z) {
+        kmVec3Fill(&out[0], x - half, y - half, z);
+        kmVec3Fill(&out[1], x + half, y - half, z);
+        kmVec3Fill(&out[2], x + half, y + half, z);
+        kmVec3Fill(&out[3], x - half, y - half, z);
+        kmVec3Fill(&out[4], x + half, y + half, z);
+        kmVec3Fill(&out[5], x - half, y + half, z);
+    }
+
+    kmAABB3 box(kmScalar x, kmScalar y, kmScalar z, kmScalar size) {
+        kmAABB3 result;
+        kmVec3 centre;
+        kmVec3Fill(&centre, x, y, z);
+        kmAABB3Initialize(&result, &centre, size, size, size);
+        return result;
+    }
+
+    void set_up() {
+        RandomTestCase::set_up();
+        kmMat4PerspectiveProjection(&projection, 60, 1, 1, 100);
+    }
+
+    void test_occlusion_wall_hides_boxes_behind_it() {
+        kmOcclusionBuffer buffer;
+        kmOcclusionBufferInitialize(&buffer, 60, 60);
+        assert_equal(64u, buffer.width);
+
+        kmVec3 vertices[6];
+        wall(vertices, 0, 0, 2, -5);
+        kmOcclusionBufferRasterize(&buffer, &projection, vertices, 6, NULL, 2, 1);
+
+        /* The middle of the screen is the wall */
+        assert_true(kmOcclusionBufferDepth(&buffer, 32, 32) < 1);
+        assert_equal(1.0, kmOcclusionBufferDepth(&buffer, 0, 0));
+
+        kmAABB3 behind = box(0, 0, -20, 1);
+        kmAABB3 in_front = box(0, 0, -3, 0.5);
+        kmAABB3 beside = box(8, 0, -20, 1);
+        kmAABB3 straddling = box(0, 0, -1, 2);
+        kmAABB3 off_screen = box(0, 0, 20, 1);
+
+        assert_false(kmOcclusionBufferTestAABB3(&buffer, &projection, &behind));
+        assert_true(kmOcclusionBufferTestAABB3(&buffer, &projection, &in_front));
+        assert_true(kmOcclusionBufferTestAABB3(&buffer, &projection, &beside));
+        assert_true(kmOcclusionBufferTestAABB3(&buffer, &projection, &straddling));
+        assert_false(kmOcclusionBufferTestAABB3(&buffer, &projection, &off_screen));
+
+        kmOcclusionBufferClear(&buffer);
+        assert_true(kmOcclusionBufferTestAABB3(&buffer, &projection, &behind));
+
+        kmOcclusionBufferFree(&buffer);
+    }
+
+    void test_occlusion_near_plane_clipping() {
+        kmOcclusionBuffer buffer;
+        kmOcclusionBufferInitialize(&buffer, 32, 32);
+
+        /* A floor running from behind the camera into the distance */
+        kmVec3 vertices[4];
+        kmVec3Fill(&vertices[0], -50, -1, 10);
+        kmVec3Fill(&vertices[1], 50, -1, 10);
+        kmVec3Fill(&vertices[2], 50, -1, -90);
+        kmVec3Fill(&vertices[3], -50, -1, -90);
+        kmUint indices[] = { 0, 1, 2, 0, 2, 3 };
+        kmOcclusionBufferRasterize(&buffer, &projection, vertices, 4, indices, 2, 2);
+
+        /* The bottom half is covered, the top half is sky */
+        assert_true(kmOcclusionBufferDepth(&buffer, 16, 2) < 1);
+        assert_equal(1.0, kmOcclusionBufferDepth(&buffer, 16, 30));
+
+        kmAABB3 under_floor = box(0, -3, -10, 0.5);
+        kmAABB3 above_floor = box(0, 1, -10, 0.5);
+        assert_false(kmOcclusionBufferTestAABB3(&buffer, &projection, &under_floor));
+        assert_true(kmOcclusionBufferTestAABB3(&buffer, &projection, &above_floor));
+
+        kmOcclusionBufferFree(&buffer);
+    }
+
+    void test_occlusion_threads_and_batch() {
+        std::vector<kmVec3> vertices(6 * 40);
+        for(unsigned i = 0; i < 40; ++i) {
+            wall(&vertices[i * 6], random(-10, 10), random(-10, 10), random(0.5, 3), random(-30, -5));
+        }
+
+        kmOcclusionBuffer serial, parallel;
+        kmOcclusionBufferInitialize(&serial, 128, 96);
+        kmOcclusionBufferInitialize(&parallel, 128, 96);
+        kmOcclusionBufferRasterize(&serial, &projection, &vertices[0], vertices.size(), NULL, 40, 1);
+        kmOcclusionBufferRasterize(&parallel, &projection, &vertices[0], vertices.size(), NULL, 40, 5);
+
+        for(kmUint y = 0; y < serial.height; ++y) {
+            for(kmUint x = 0; x < serial.width; ++x) {
+                assert_equal(kmOcclusionBufferDepth(&serial, x, y), kmOcclusionBufferDepth(&parallel, x, y));
+            }
+        }
+
+        std::vector<kmAABB3> boxes;
+        for(unsigned i = 0; i < 300; ++i) {
+            boxes.push_back(box(random(-15, 15), random(-15, 15), random(-60, -2), random(0.2, 2)));
+        }
+
+        std::vector<kmBool> results(boxes.size());
+        kmUint visible = kmOcclusionBufferTestAABB3Array(&parallel, &projection, &boxes[0], boxes.size(), &results[0], 3);
+
+        kmUint expected = 0;
+        for(unsigned i = 0; i < boxes.size(); ++i) {
+            kmBool single = kmOcclusionBufferTestAABB3(&serial, &projection, &boxes[i]);
+            assert_equal(single, results[i]);
+            expected += single;
+        }
+        assert_equal(expected, visible);
+        assert_true(visible > 0 && visible < boxes.size());
+
+        kmOcclusionBufferFree(&serial);
+        kmOcclusionBufferFree(&parallel);
+    }
+
+    void test_occlusion_empty_buffer() {
+        kmOcclusionBuffer buffer;
+        kmOcclusionBufferInitialize(&buffer, 0, 0);
+        assert_equal(0u, buffer.tiles_y);
+
+        kmVec3 vertices[6];
+        wall(vertices, 0, 0, 2, -5);
+        kmOcclusionBufferRasterize(&buffer, &projection, vertices, 6, NULL, 2, 4);
+
+        kmAABB3 behind = box(0, 0, -20, 1);
+        assert_false(kmOcclusionBufferTestAABB3(&buffer, &projection, &behind));
+
+        kmOcclusionBufferFree(&buffer);
+    }
+};
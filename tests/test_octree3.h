@@ -0,0 +1,256 @@
+#include <vector>
+#include <algorithm>
+#include "random_test_case.h"
+
+#include "../kazmath/octree3.h"
+#include "../kazmath/aabb3.h"
+#include "../kazmath/mat4.h"
+#include "../kazmath/plane.h"
+#include "../kazmath/ray3.h"
+
+class TestOctree3 : public RandomTestCase {
+public:
+    TestOctree3():
+        RandomTestCase(1234) {}
+
+    std::vector<kmAABB3> random_boxes(unsigned count) {
+        std::vector<kmAABB3> boxes(count);
+        for(unsigned i = 0; i < count; ++i) {
+            kmVec3 centre;
+            kmVec3Fill(&centre, random(-110, 110), random(-100, 100), random(-100, 100));
+            kmScalar size = (i % 10 == 0) ? random(5, 40) : random(0.1, 3);
+            kmAABB3Initialize(&boxes[i], &centre, size, size * 0.5, size);
+        }
+        return boxes;
+    }
+
+    std::vector<kmUint> sorted(const kmUint* handles, kmUint count) {
+        std::vector<kmUint> result(handles, handles + count);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    kmBool overlaps(const kmAABB3& a, const kmAABB3& b) {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+               a.min.y <= b.max.y && a.max.y >= b.min.y &&
+               a.min.z <= b.max.z && a.max.z >= b.min.z;
+    }
+
+    void test_octree_aabb_query_matches_linear_scan() {
+        std::vector<kmAABB3> boxes = random_boxes(500);
+
+        kmAABB3 world;
+        kmAABB3Initialize(&world, NULL, 200, 200, 200);
+
+        kmOctree3 tree;
+        kmOctree3Initialize(&tree, &world, 6);
+
+        std::vector<kmUint> handles(boxes.size());
+        kmOctree3BulkLoad(&tree, &boxes[0], boxes.size(), &handles[0]);
+
+        for(int q = 0; q < 20; ++q) {
+            kmAABB3 query;
+            kmVec3 centre;
+            kmVec3Fill(&centre, random(-100, 100), random(-100, 100), random(-100, 100));
+            kmAABB3Initialize(&query, &centre, 30, 30, 30);
+
+            std::vector<kmUint> expected;
+            for(unsigned i = 0; i < boxes.size(); ++i) {
+                if(overlaps(boxes[i], query)) expected.push_back(handles[i]);
+            }
+            std::sort(expected.begin(), expected.end());
+
+            std::vector<kmUint> out(boxes.size());
+            kmUint found = kmOctree3QueryAABB3(&tree, &query, &out[0], out.size());
+            assert_equal((kmUint) expected.size(), found);
+            assert_true(expected == sorted(&out[0], found));
+        }
+
+        /* A short output buffer still reports the total */
+        kmAABB3 everything;
+        kmAABB3Initialize(&everything, NULL, 1000, 1000, 1000);
+        kmUint one;
+        assert_equal((kmUint) boxes.size(), kmOctree3QueryAABB3(&tree, &everything, &one, 1));
+
+        kmOctree3Free(&tree);
+    }
+
+    void test_octree_update_and_remove() {
+        kmAABB3 world;
+        kmAABB3Initialize(&world, NULL, 100, 100, 100);
+
+        kmOctree3 tree;
+        kmOctree3Initialize(&tree, &world, 5);
+
+        kmAABB3 a, b;
+        kmVec3 centre;
+        kmVec3Fill(&centre, 10, 10, 10);
+        kmAABB3Initialize(&a, &centre, 1, 1, 1);
+        kmVec3Fill(&centre, -10, -10, -10);
+        kmAABB3Initialize(&b, &centre, 1, 1, 1);
+
+        kmUint ha = kmOctree3Insert(&tree, &a);
+        kmUint hb = kmOctree3Insert(&tree, &b);
+
+        kmAABB3 query;
+        kmVec3Fill(&centre, -10, -10, -10);
+        kmAABB3Initialize(&query, &centre, 4, 4, 4);
+
+        kmUint out[4];
+        assert_equal(1u, kmOctree3QueryAABB3(&tree, &query, out, 4));
+        assert_equal(hb, out[0]);
+
+        /* Move a next to b */
+        kmVec3Fill(&centre, -9, -10, -10);
+        kmAABB3Initialize(&a, &centre, 1, 1, 1);
+        kmOctree3Update(&tree, ha, &a);
+        assert_equal(2u, kmOctree3QueryAABB3(&tree, &query, out, 4));
+
+        kmOctree3Remove(&tree, hb);
+        assert_equal(1u, kmOctree3QueryAABB3(&tree, &query, out, 4));
+        assert_equal(ha, out[0]);
+
+        /* Removed slots and nodes are recycled */
+        kmUint node_count = tree.node_count;
+        kmUint hc = kmOctree3Insert(&tree, &b);
+        assert_equal(hb, hc);
+        assert_equal(node_count, tree.node_count);
+
+        /* Objects outside the root cell are still found */
+        kmVec3Fill(&centre, 500, 0, 0);
+        kmAABB3Initialize(&a, &centre, 1, 1, 1);
+        kmOctree3Update(&tree, ha, &a);
+        kmAABB3Initialize(&query, &centre, 2, 2, 2);
+        assert_equal(1u, kmOctree3QueryAABB3(&tree, &query, out, 4));
+
+        kmOctree3Free(&tree);
+    }
+
+    void test_octree_frustum_query_matches_linear_scan() {
+        std::vector<kmAABB3> boxes = random_boxes(500);
+
+        kmAABB3 world;
+        kmAABB3Initialize(&world, NULL, 200, 200, 200);
+
+        kmOctree3 tree;
+        kmOctree3Initialize(&tree, &world, 6);
+        kmOctree3BulkLoad(&tree, &boxes[0], boxes.size(), NULL);
+
+        kmMat4 proj, view, view_proj;
+        kmVec3 eye, centre, up;
+        kmVec3Fill(&eye, 0, 0, 0);
+        kmVec3Fill(&centre, 1, 0.2, 0.5);
+        kmVec3Fill(&up, 0, 1, 0);
+        kmMat4PerspectiveProjection(&proj, 60, 1.5, 1, 150);
+        kmMat4LookAt(&view, &eye, &centre, &up);
+        kmMat4Multiply(&view_proj, &proj, &view);
+
+        kmPlane planes[6];
+        for(int i = 0; i < 6; ++i) {
+            kmMat4ExtractPlane(&planes[i], &view_proj, i);
+        }
+
+        std::vector<kmUint> expected;
+        for(unsigned i = 0; i < boxes.size(); ++i) {
+            bool visible = true;
+            for(int p = 0; p < 6 && visible; ++p) {
+                const kmPlane& pl = planes[p];
+                kmScalar d = pl.a * (pl.a >= 0 ? boxes[i].max.x : boxes[i].min.x) +
+                             pl.b * (pl.b >= 0 ? boxes[i].max.y : boxes[i].min.y) +
+                             pl.c * (pl.c >= 0 ? boxes[i].max.z : boxes[i].min.z) + pl.d;
+                visible = d >= 0;
+            }
+            if(visible) expected.push_back(i);
+        }
+
+        assert_true(expected.size() > 0);
+        assert_true(expected.size() < boxes.size());
+
+        std::vector<kmUint> out(boxes.size());
+        kmUint found = kmOctree3QueryPlanes(&tree, planes, 6, &out[0], out.size());
+        assert_equal((kmUint) expected.size(), found);
+        assert_true(expected == sorted(&out[0], found));
+
+        kmOctree3Free(&tree);
+    }
+
+    void test_octree_ray_queries_match_linear_scan() {
+        std::vector<kmAABB3> boxes = random_boxes(500);
+
+        kmAABB3 world;
+        kmAABB3Initialize(&world, NULL, 200, 200, 200);
+
+        kmOctree3 tree;
+        kmOctree3Initialize(&tree, &world, 6);
+        kmOctree3BulkLoad(&tree, &boxes[0], boxes.size(), NULL);
+
+        kmRay3 rays[8];
+        for(int r = 0; r < 8; ++r) {
+            kmRay3Fill(&rays[r], -120, random(-5, 5), random(-5, 5), 1, random(-0.1, 0.1), random(-0.1, 0.1));
+        }
+
+        kmRay3Packet packet;
+        kmRay3PacketFill(&packet, rays, 8);
+
+        std::vector<kmUint> out(boxes.size()), masks(boxes.size());
+        kmUint packet_found = kmOctree3QueryRay3Packet(&tree, &packet, &out[0], &masks[0], out.size());
+
+        std::vector<kmUint> expected_lanes(boxes.size(), 0);
+        for(kmUint i = 0; i < packet_found; ++i) {
+            expected_lanes[out[i]] = masks[i];
+        }
+
+        for(int r = 0; r < 8; ++r) {
+            std::vector<kmUint> expected;
+            for(unsigned i = 0; i < boxes.size(); ++i) {
+                if(kmRay3IntersectAABB3(&rays[r], &boxes[i], NULL, NULL)) expected.push_back(i);
+            }
+
+            kmUint found = kmOctree3QueryRay3(&tree, &rays[r], &out[0], out.size());
+            assert_equal((kmUint) expected.size(), found);
+            assert_true(expected == sorted(&out[0], found));
+
+            for(unsigned i = 0; i < boxes.size(); ++i) {
+                bool in_expected = std::binary_search(expected.begin(), expected.end(), i);
+                assert_equal(in_expected, (expected_lanes[i] & (1u << r)) != 0);
+            }
+        }
+
+        kmOctree3Free(&tree);
+    }
+
+    void test_octree_nearest_matches_linear_scan() {
+        std::vector<kmAABB3> boxes = random_boxes(300);
+
+        kmAABB3 world;
+        kmAABB3Initialize(&world, NULL, 200, 200, 200);
+
+        kmOctree3 tree;
+        kmOctree3Initialize(&tree, &world, 6);
+        kmOctree3BulkLoad(&tree, &boxes[0], boxes.size(), NULL);
+
+        for(int q = 0; q < 10; ++q) {
+            kmVec3 p;
+            kmVec3Fill(&p, random(-100, 100), random(-100, 100), random(-100, 100));
+
+            std::vector<kmScalar> all;
+            for(unsigned i = 0; i < boxes.size(); ++i) {
+                kmScalar d = 0, v;
+                v = std::max(std::max(boxes[i].min.x - p.x, p.x - boxes[i].max.x), (kmScalar) 0); d += v * v;
+                v = std::max(std::max(boxes[i].min.y - p.y, p.y - boxes[i].max.y), (kmScalar) 0); d += v * v;
+                v = std::max(std::max(boxes[i].min.z - p.z, p.z - boxes[i].max.z), (kmScalar) 0); d += v * v;
+                all.push_back(d);
+            }
+            std::sort(all.begin(), all.end());
+
+            kmUint out[5];
+            kmScalar dist[5];
+            assert_equal(5u, kmOctree3QueryNearest(&tree, &p, 5, out, dist));
+            for(int i = 0; i < 5; ++i) {
+                assert_close(all[i], dist[i], 0.001);
+            }
+        }
+
+        kmOctree3Free(&tree);
+    }
+};
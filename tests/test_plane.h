@@ -51,4 +51,114 @@ public:
         assert_equal(-1.0, p.z);
 
     }
+
+    void test_plane_batch_classify() {
+        kmPlane plane;
+        kmPlaneFill(&plane, 0, 1, 0, -1); /* y = 1, facing +y */
+
+        kmVec3 points[4];
+        kmVec3Fill(&points[0], 0, 3, 0);
+        kmVec3Fill(&points[1], 5, 1, 2);
+        kmVec3Fill(&points[2], 0, -2, 0);
+        kmVec3Fill(&points[3], 1, 2, 1);
+
+        kmScalar distances[4];
+        kmPlaneDotCoordArray(&plane, points, 4, distances);
+        for(int i = 0; i < 4; ++i) {
+            assert_close(kmPlaneDotCoord(&plane, &points[i]), distances[i], 0.0001);
+        }
+
+        unsigned char masks[4];
+        assert_equal((kmUint) (KM_PLANE_MASK_FRONT | KM_PLANE_MASK_BEHIND),
+                     kmPlaneClassifyPointArray(&plane, points, 4, masks));
+        assert_equal(KM_PLANE_MASK_FRONT, (int) masks[0]);
+        assert_equal(0, (int) masks[1]);
+        assert_equal(KM_PLANE_MASK_BEHIND, (int) masks[2]);
+        assert_equal((kmUint) KM_PLANE_MASK_FRONT, kmPlaneClassifyPointArray(&plane, points, 2, NULL) | 0u);
+
+        /* Bit 1 is the x = 4 plane facing -x, every point but one is behind it */
+        kmPlane planes[2];
+        planes[0] = plane;
+        kmPlaneFill(&planes[1], -1, 0, 0, 4);
+        kmUint outcodes[4];
+        assert_equal(0u, kmPlaneOutcodeArray(planes, 2, points, 4, outcodes));
+        assert_equal(0u, outcodes[0]);
+        assert_equal(2u, outcodes[1]);
+        assert_equal(1u, outcodes[2]);
+        assert_equal(1u, kmPlaneOutcodeArray(planes, 2, &points[2], 1, NULL));
+    }
+
+    void test_plane_clip_polygon() {
+        kmVec3 square[4];
+        kmVec3Fill(&square[0], -1, -1, 0);
+        kmVec3Fill(&square[1], 1, -1, 0);
+        kmVec3Fill(&square[2], 1, 1, 0);
+        kmVec3Fill(&square[3], -1, 1, 0);
+
+        /* Keep x >= 0.5 */
+        kmPlane plane;
+        kmPlaneFill(&plane, 1, 0, 0, -0.5);
+
+        kmVec3 out[8], scratch[8];
+        kmUint count = kmPlaneClipPolygon(&plane, square, 4, out);
+        assert_equal(4u, count);
+        for(kmUint i = 0; i < count; ++i) {
+            assert_true(out[i].x >= 0.5 - 0.0001);
+        }
+
+        /* Clipping a corner off adds a vertex */
+        kmPlaneFill(&plane, -1, -1, 0, 1.5);
+        assert_equal(5u, kmPlaneClipPolygon(&plane, square, 4, out));
+
+        kmPlaneFill(&plane, 1, 0, 0, -5);
+        assert_equal(0u, kmPlaneClipPolygon(&plane, square, 4, out));
+
+        /* Against a set: the quarter x >= 0, y >= 0 */
+        kmPlane planes[2];
+        kmPlaneFill(&planes[0], 1, 0, 0, 0);
+        kmPlaneFill(&planes[1], 0, 1, 0, 0);
+        count = kmPlaneClipPolygonPlanes(planes, 2, square, 4, out, scratch);
+        assert_equal(4u, count);
+        kmScalar area = 0;
+        for(kmUint i = 0; i < count; ++i) {
+            const kmVec3& a = out[i];
+            const kmVec3& b = out[(i + 1) % count];
+            area += a.x * b.y - b.x * a.y;
+        }
+        assert_close(2.0, area, 0.0001); /* Twice the signed area of the unit square, still counter clockwise */
+
+        assert_equal(4u, kmPlaneClipPolygonPlanes(planes, 1, square, 3, out, scratch));
+        kmPlaneFill(&planes[1], 0, 1, 0, -3);
+        assert_equal(0u, kmPlaneClipPolygonPlanes(planes, 2, square, 4, out, scratch));
+    }
+
+    void test_plane_clip_triangle() {
+        kmVec3 p1, p2, p3, out[6];
+        kmVec3Fill(&p1, 0, 0, 0);
+        kmVec3Fill(&p2, 2, 0, 0);
+        kmVec3Fill(&p3, 0, 2, 0);
+
+        kmPlane plane;
+        kmPlaneFill(&plane, 0, 1, 0, -1); /* Keep the tip */
+        assert_equal(1u, kmPlaneClipTriangle(&plane, &p1, &p2, &p3, out));
+
+        kmPlaneFill(&plane, 0, -1, 0, 1); /* Keep the base, a quad */
+        assert_equal(2u, kmPlaneClipTriangle(&plane, &p1, &p2, &p3, out));
+        for(int i = 0; i < 6; ++i) {
+            assert_true(out[i].y <= 1.0001);
+        }
+
+        kmPlaneFill(&plane, 0, 0, 1, -1);
+        assert_equal(0u, kmPlaneClipTriangle(&plane, &p1, &p2, &p3, out));
+
+        /* Only a vertex touches the kept side, nothing is left */
+        kmVec3 touching[3], polygon[4], scratch[4];
+        kmVec3Fill(&touching[0], 0, 0, 0);
+        kmVec3Fill(&touching[1], 1, -1, 0);
+        kmVec3Fill(&touching[2], -1, -1, 0);
+        kmPlaneFill(&plane, 0, 1, 0, 0);
+        assert_equal(0u, kmPlaneClipTriangle(&plane, &touching[0], &touching[1], &touching[2], out));
+        assert_equal(1u, kmPlaneClipPolygon(&plane, touching, 3, polygon));
+        assert_equal(0u, kmPlaneClipPolygonPlanes(&plane, 1, touching, 3, polygon, scratch));
+    }
 };
@@ -0,0 +1,90 @@
+#include <cstdio>
+#include <cstring>
+#include "kaztest/kaztest.h"
+
+#include "../kazmath/kazmath.h"
+
+class TestProfile : public TestCase {
+public:
+    void set_up() {
+        kmProfileReset();
+    }
+
+    void tear_down() {
+        kmProfileSetTimersEnabled(KM_FALSE);
+    }
+
+    void test_snapshot() {
+        kmMat4 m, inverse;
+        kmVec3 v;
+        kmProfileSnapshot snapshot;
+
+        kmMat4Translation(&m, 1, 2, 3);
+        for(int i = 0; i < 5; ++i) {
+            kmMat4Inverse(&inverse, &m);
+        }
+        kmVec3Normalize(kmVec3Fill(&v, 0, 0, 0), &v);
+
+#ifdef KAZMATH_PROFILE
+        assert_true(kmProfileTakeSnapshot(&snapshot));
+        assert_equal(5, snapshot.functions[KM_PROFILE_MAT4_INVERSE].calls);
+        assert_equal(1, snapshot.functions[KM_PROFILE_VEC3_NORMALIZE].calls);
+        assert_equal(0, snapshot.functions[KM_PROFILE_QUATERNION_SLERP].calls);
+        assert_close(0, snapshot.functions[KM_PROFILE_MAT4_INVERSE].seconds, 0.000001);
+        assert_true(snapshot.threads >= 1);
+
+        kmProfileReset();
+        kmProfileTakeSnapshot(&snapshot);
+        assert_equal(0, snapshot.functions[KM_PROFILE_MAT4_INVERSE].calls);
+#else
+        assert_false(kmProfileTakeSnapshot(&snapshot));
+        assert_equal(0, snapshot.functions[KM_PROFILE_MAT4_INVERSE].calls);
+#endif
+        assert_equal(std::string("kmMat4Inverse"), std::string(snapshot.functions[KM_PROFILE_MAT4_INVERSE].name));
+    }
+
+    void test_json() {
+        kmProfileSnapshot snapshot;
+        char json[1024];
+
+        kmProfileTakeSnapshot(&snapshot);
+        int length = kmProfileSnapshotToJSON(&snapshot, json, sizeof(json));
+        assert_true(length > 0 && length < (int) sizeof(json));
+        assert_equal(length, (int) strlen(json));
+        assert_true(strstr(json, "\"kmQuaternionSlerp\":{\"calls\":") != NULL);
+
+        assert_equal(length, kmProfileSnapshotToJSON(&snapshot, json, 16));
+        assert_equal(15, (int) strlen(json));
+    }
+
+    void test_chrome_trace() {
+        kmQuaternion a, b, out;
+        char trace[4096];
+
+        kmQuaternionIdentity(&a);
+        kmQuaternionRotationPitchYawRoll(&b, 0, 1, 0);
+
+        kmProfileSetTimersEnabled(KM_TRUE);
+        kmQuaternionSlerp(&out, &a, &b, 0.5);
+
+        FILE* file = tmpfile();
+        kmUint events = kmProfileWriteChromeTrace(file);
+        rewind(file);
+        size_t length = fread(trace, 1, sizeof(trace) - 1, file);
+        trace[length] = '\0';
+        fclose(file);
+
+        assert_true(strncmp(trace, "{\"traceEvents\":[", 16) == 0);
+#ifdef KAZMATH_PROFILE
+        /* Slerp and the normalize it calls */
+        assert_equal(2, events);
+        assert_true(strstr(trace, "\"name\":\"kmQuaternionSlerp\",\"ph\":\"X\"") != NULL);
+
+        kmProfileSnapshot snapshot;
+        kmProfileTakeSnapshot(&snapshot);
+        assert_true(snapshot.functions[KM_PROFILE_QUATERNION_SLERP].seconds > 0);
+#else
+        assert_equal(0, events);
+#endif
+    }
+};
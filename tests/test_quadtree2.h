@@ -0,0 +1,147 @@
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include "random_test_case.h"
+
+#include "../kazmath/quadtree2.h"
+#include "../kazmath/aabb2.h"
+#include "../kazmath/ray2.h"
+
+class TestQuadtree2 : public RandomTestCase {
+public:
+    TestQuadtree2():
+        RandomTestCase(4321) {}
+
+    std::vector<kmAABB2> random_boxes(unsigned count) {
+        std::vector<kmAABB2> boxes(count);
+        for(unsigned i = 0; i < count; ++i) {
+            kmVec2 centre;
+            kmVec2Fill(&centre, random(-110, 110), random(-100, 100));
+            kmScalar size = (i % 10 == 0) ? random(5, 30) : random(0.5, 4);
+            kmAABB2Initialize(&boxes[i], &centre, size, size * 0.75, 0);
+        }
+        return boxes;
+    }
+
+    std::vector<kmUint> sorted(const kmUint* handles, kmUint count) {
+        std::vector<kmUint> result(handles, handles + count);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    void test_quadtree_queries_match_linear_scan() {
+        std::vector<kmAABB2> boxes = random_boxes(400);
+
+        kmAABB2 world;
+        kmAABB2Initialize(&world, NULL, 200, 200, 0);
+
+        kmQuadtree2 tree;
+        kmQuadtree2Initialize(&tree, &world, 6);
+        kmQuadtree2BulkLoad(&tree, &boxes[0], boxes.size(), NULL);
+
+        std::vector<kmAABB2> queries(10);
+        for(unsigned q = 0; q < queries.size(); ++q) {
+            kmVec2 centre;
+            kmVec2Fill(&centre, random(-100, 100), random(-100, 100));
+            kmAABB2Initialize(&queries[q], &centre, 25, 25, 0);
+        }
+
+        std::vector<kmUint> offsets(queries.size() + 1), out(boxes.size() * queries.size());
+        kmQuadtree2QueryAABB2Array(&tree, &queries[0], queries.size(), &offsets[0], &out[0], out.size());
+
+        for(unsigned q = 0; q < queries.size(); ++q) {
+            std::vector<kmUint> expected;
+            for(unsigned i = 0; i < boxes.size(); ++i) {
+                if(kmAABB2IntersectsAABB(&boxes[i], &queries[q])) expected.push_back(i);
+            }
+
+            assert_equal((kmUint) expected.size(), offsets[q + 1] - offsets[q]);
+            assert_true(expected == sorted(&out[offsets[q]], offsets[q + 1] - offsets[q]));
+
+            std::vector<kmUint> single(boxes.size());
+            kmUint found = kmQuadtree2QueryAABB2(&tree, &queries[q], &single[0], single.size());
+            assert_true(expected == sorted(&single[0], found));
+        }
+
+        /* Pairs against the all-pairs loop they replace */
+        std::vector<std::pair<kmUint, kmUint> > expected_pairs;
+        for(unsigned i = 0; i < boxes.size(); ++i) {
+            for(unsigned j = i + 1; j < boxes.size(); ++j) {
+                if(kmAABB2IntersectsAABB(&boxes[i], &boxes[j])) expected_pairs.push_back(std::make_pair(i, j));
+            }
+        }
+
+        std::vector<kmUint> pairs(boxes.size() * 20);
+        kmUint pair_count = kmQuadtree2QueryPairs(&tree, &pairs[0], pairs.size() / 2);
+        assert_equal((kmUint) expected_pairs.size(), pair_count);
+
+        std::vector<std::pair<kmUint, kmUint> > found_pairs;
+        for(kmUint i = 0; i < pair_count; ++i) {
+            found_pairs.push_back(std::make_pair(pairs[i * 2], pairs[i * 2 + 1]));
+        }
+        std::sort(found_pairs.begin(), found_pairs.end());
+        assert_true(expected_pairs == found_pairs);
+
+        /* Rays */
+        for(int r = 0; r < 10; ++r) {
+            kmRay2 ray;
+            kmRay2Fill(&ray, -150, random(-90, 90), 1, random(-0.3, 0.3));
+
+            std::vector<kmUint> expected;
+            for(unsigned i = 0; i < boxes.size(); ++i) {
+                if(kmRay2IntersectAABB2(&ray, &boxes[i], NULL, NULL)) expected.push_back(i);
+            }
+
+            std::vector<kmUint> hits(boxes.size());
+            kmUint found = kmQuadtree2QueryRay2(&tree, &ray, &hits[0], hits.size());
+            assert_true(expected == sorted(&hits[0], found));
+        }
+
+        kmQuadtree2Free(&tree);
+    }
+
+    void test_quadtree_moving_entities() {
+        kmAABB2 world;
+        kmAABB2Initialize(&world, NULL, 100, 100, 0);
+
+        kmQuadtree2 tree;
+        kmQuadtree2Initialize(&tree, &world, 5);
+
+        kmAABB2 box;
+        kmVec2 centre;
+        kmVec2Fill(&centre, -40, -40);
+        kmAABB2Initialize(&box, &centre, 2, 2, 0);
+        kmUint handle = kmQuadtree2Insert(&tree, &box);
+
+        kmAABB2 query;
+        kmVec2Fill(&centre, 40, 40);
+        kmAABB2Initialize(&query, &centre, 5, 5, 0);
+
+        kmUint out[2];
+        assert_equal(0u, kmQuadtree2QueryAABB2(&tree, &query, out, 2));
+
+        /* Walk the entity across the world */
+        for(int step = 0; step <= 80; ++step) {
+            kmVec2Fill(&centre, -40 + step, -40 + step);
+            kmAABB2Initialize(&box, &centre, 2, 2, 0);
+            kmQuadtree2Update(&tree, handle, &box);
+        }
+
+        assert_equal(1u, kmQuadtree2QueryAABB2(&tree, &query, out, 2));
+        assert_equal(handle, out[0]);
+
+        kmQuadtree2Remove(&tree, handle);
+        assert_equal(0u, kmQuadtree2QueryAABB2(&tree, &query, out, 2));
+
+        /* Only the root is left once the entity is gone */
+        kmQuadtree2Insert(&tree, &box);
+        kmQuadtree2Remove(&tree, handle);
+        kmUint live = 0;
+        for(kmUint i = 0; i < 4; ++i) {
+            live += tree.nodes[0].children[i] != KM_QUADTREE2_INVALID;
+        }
+        assert_equal(0u, live);
+
+        kmQuadtree2Free(&tree);
+    }
+};
@@ -109,4 +109,106 @@ public:
         ret = kmRay3IntersectTriangle(&ray, &v0, &v1, &v2, &intersect, &normal, &dist);
         assert_true(ret);
     }
+
+    void test_ray_packet_matches_single_aabb() {
+        kmAABB3 aabb;
+        kmAABB3Initialize(&aabb, &KM_VEC3_ZERO, 2, 2, 2);
+
+        kmRay3 rays[8];
+        kmRay3Fill(&rays[0], 0, 0, -5, 0, 0, 1);       // Axis aligned hit
+        kmRay3Fill(&rays[1], 0.5, 0.5, -5, 0, 0, 3);   // Unnormalized hit
+        kmRay3Fill(&rays[2], 3, 0, -5, 0, 0, 1);       // Parallel miss
+        kmRay3Fill(&rays[3], 0, 0, 5, 0, 0, 1);        // Box is behind
+        kmRay3Fill(&rays[4], -5, -5, -5, 1, 1, 1);     // Diagonal hit
+        kmRay3Fill(&rays[5], -5, 5, 0, 1, 0.2, 0);     // Passes above
+        kmRay3Fill(&rays[6], 0, 0, 0, 1, 0, 0);        // Starts inside
+        kmRay3Fill(&rays[7], 5, 0.5, 0.5, -1, 0, 0);   // Hit from +x
+
+        kmRay3Packet packet;
+        kmRay3PacketFill(&packet, rays, 8);
+        assert_equal(0xFFu, kmRay3PacketMask(&packet));
+
+        kmScalar distances[KM_RAY3_PACKET_SIZE];
+        kmUint hits = kmRay3PacketIntersectAABB3(&packet, kmRay3PacketMask(&packet), &aabb, distances);
+        assert_equal((1u | 2u | 16u | 64u | 128u), hits);
+
+        assert_close(4, distances[0], 0.0001);
+        assert_close(4, distances[1], 0.0001);
+        assert_close(sqrt(48.0), distances[4], 0.0001);
+        assert_close(0, distances[6], 0.0001);
+        assert_close(4, distances[7], 0.0001);
+
+        /* Lanes outside the mask never report hits */
+        assert_equal(16u, kmRay3PacketIntersectAABB3(&packet, 16u | 4u, &aabb, NULL));
+
+        /* tmax culls hits further than the closest found so far */
+        packet.tmax[0] = 3.5;
+        assert_equal(0u, kmRay3PacketIntersectAABB3(&packet, 1u, &aabb, NULL));
+    }
+
+    void test_ray_packet_partial() {
+        kmAABB3 aabb;
+        kmAABB3Initialize(&aabb, &KM_VEC3_ZERO, 2, 2, 2);
+
+        kmRay3 rays[3];
+        kmRay3Fill(&rays[0], 0, 0, -5, 0, 0, 1);
+        kmRay3Fill(&rays[1], 5, 5, -5, 0, 0, 1);
+        kmRay3Fill(&rays[2], 0, -5, 0, 0, 1, 0);
+
+        kmRay3Packet packet;
+        kmRay3PacketFill(&packet, rays, 3);
+        assert_equal(7u, kmRay3PacketMask(&packet));
+        assert_equal(5u, kmRay3PacketIntersectAABB3(&packet, kmRay3PacketMask(&packet), &aabb, NULL));
+
+        /* An empty packet must not read the ray array at all */
+        kmRay3PacketFill(&packet, NULL, 0);
+        assert_equal(0u, packet.count);
+        assert_equal(0u, kmRay3PacketMask(&packet));
+        assert_equal(0u, kmRay3PacketIntersectAABB3(&packet, kmRay3PacketMask(&packet), &aabb, NULL));
+    }
+
+    void test_ray_prepared_aabb_array() {
+        kmAABB3 boxes[4];
+        kmAABB3Initialize(&boxes[0], &KM_VEC3_ZERO, 2, 2, 2);
+
+        kmVec3 centre;
+        kmVec3Fill(&centre, 10, 0, 0);
+        kmAABB3Initialize(&boxes[1], &centre, 2, 2, 2);
+        kmVec3Fill(&centre, 5, 5, 0);
+        kmAABB3Initialize(&boxes[2], &centre, 2, 2, 2);
+        kmVec3Fill(&centre, -10, 0, 0);
+        kmAABB3Initialize(&boxes[3], &centre, 2, 2, 2);
+
+        kmRay3 ray;
+        kmRay3Fill(&ray, -5, 0, 0, 4, 0, 0);
+
+        kmRay3Prepared prepared;
+        kmRay3Prepare(&prepared, &ray);
+        assert_close(1, prepared.dir.x, 0.0001);
+        assert_equal(0u, prepared.sign[0]);
+
+        kmBool results[4];
+        kmScalar distances[4];
+        assert_equal(2u, kmRay3PreparedIntersectAABB3Array(&prepared, boxes, 4, results, distances));
+        assert_true(results[0]);
+        assert_true(results[1]);
+        assert_false(results[2]);
+        assert_false(results[3]);
+        assert_close(4, distances[0], 0.0001);
+        assert_close(14, distances[1], 0.0001);
+
+        /* The prepared form agrees with the plain one from any direction */
+        kmRay3Fill(&ray, 3, 2, -4, -1, -0.5, 1.1);
+        kmRay3Prepare(&prepared, &ray);
+        assert_equal(1u, prepared.sign[0]);
+
+        kmScalar d1 = 0, d2 = 0;
+        kmVec3 p1, p2;
+        kmBool r1 = kmRay3IntersectAABB3(&ray, &boxes[0], &p1, &d1);
+        kmBool r2 = kmRay3PreparedIntersectAABB3(&prepared, &boxes[0], &p2, &d2);
+        assert_equal(r1, r2);
+        assert_true(r2);
+        assert_close(d1, d2, 0.0001);
+        assert_close(p1.z, p2.z, 0.0001);
+    }
 };
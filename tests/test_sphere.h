@@ -0,0 +1,267 @@
+#include <cstdlib>
+#include <vector>
+#include "kaztest/kaztest.h"
+
+#include "../kazmath/sphere.h"
+#include "../kazmath/mat4.h"
+#include "../kazmath/plane.h"
+#include "../kazmath/aabb3.h"
+#include "../kazmath/ray3.h"
+
+class TestSphere : public TestCase {
+public:
+    void random_points(std::vector<kmVec3>& points, int count) {
+        srand(1234);
+        points.resize(count);
+        for(int i = 0; i < count; ++i) {
+            kmVec3Fill(&points[i],
+                (rand() / (kmScalar) RAND_MAX) * 10 - 5,
+                (rand() / (kmScalar) RAND_MAX) * 4 - 2,
+                (rand() / (kmScalar) RAND_MAX) * 6 + 1
+            );
+        }
+    }
+
+    void assert_contains_all(const kmSphere& s, const std::vector<kmVec3>& points) {
+        kmSphere loose = s;
+        loose.radius += 0.0001;
+        for(const kmVec3& p: points) {
+            assert_true(kmSphereContainsPoint(&loose, &p));
+        }
+    }
+
+    void test_sphere_from_points() {
+        std::vector<kmVec3> points;
+        random_points(points, 1000);
+
+        kmSphere ritter, epos;
+        kmSphereFromPointsRitter(&ritter, &points[0], points.size());
+        kmSphereFromPointsEPOS(&epos, &points[0], points.size());
+
+        assert_contains_all(ritter, points);
+        assert_contains_all(epos, points);
+
+        /* Half the spread along x is a lower bound */
+        assert_true(epos.radius >= 4.9);
+        assert_true(epos.radius <= ritter.radius + 0.0001);
+    }
+
+    void test_sphere_from_two_points() {
+        kmVec3 points[2];
+        kmVec3Fill(&points[0], -1, 0, 0);
+        kmVec3Fill(&points[1], 3, 0, 0);
+
+        kmSphere s;
+        kmSphereFromPointsEPOS(&s, points, 2);
+
+        assert_close(1.0, s.centre.x, 0.0001);
+        assert_close(2.0, s.radius, 0.0001);
+    }
+
+    void test_sphere_expand_empty() {
+        kmSphere empty, out;
+        kmVec3 point;
+
+        kmVec3Zero(&empty.centre);
+        empty.radius = -1;
+        kmVec3Fill(&point, 0.5, 0, 0);
+
+        /* The sentinel must not act like a unit sphere */
+        assert_false(kmSphereContainsPoint(&empty, &point));
+
+        kmSphereExpandToContainPoint(&out, &empty, &point);
+        assert_close(0.5, out.centre.x, 0.0001);
+        assert_close(0.0, out.radius, 0.0001);
+
+        /* Merging keeps the other sphere as it is */
+        kmSphere other;
+        kmSphereFill(&other, &point, 0.5);
+        kmSphereMerge(&out, &empty, &other);
+        assert_close(0.5, out.centre.x, 0.0001);
+        assert_close(0.5, out.radius, 0.0001);
+        kmSphereMerge(&out, &other, &empty);
+        assert_close(0.5, out.radius, 0.0001);
+
+        /* Nothing intersects it, even where the radii would add up */
+        kmAABB3 box;
+        kmAABB3Initialize(&box, &point, 1, 1, 1);
+        kmRay3 ray;
+        kmRay3Fill(&ray, -5, 0, 0, 1, 0, 0);
+        kmBool results[1];
+
+        assert_false(kmSphereIntersectsSphere(&empty, &other));
+        assert_false(kmSphereIntersectsAABB3(&empty, &box));
+        assert_false(kmRay3IntersectSphere(&ray, &empty, NULL, NULL));
+        assert_equal(0u, kmSphereIntersectsSphereArray(&empty, 1, &other, results));
+        assert_equal(0u, kmSphereIntersectsSphereArray(&other, 1, &empty, results));
+        assert_equal(0u, kmSphereIntersectsAABB3Array(&empty, 1, &box, results));
+        assert_equal(0u, kmSphereIntersectsRay3Array(&empty, 1, &ray, results, NULL));
+    }
+
+    void test_sphere_merge_is_a_reduction() {
+        std::vector<kmVec3> points;
+        random_points(points, 400);
+
+        kmSphere a, b, merged;
+        kmSphereFromPointsRitter(&a, &points[0], 200);
+        kmSphereFromPointsRitter(&b, &points[200], 200);
+        kmSphereMerge(&merged, &a, &b);
+
+        assert_contains_all(merged, points);
+
+        /* Merging with a contained sphere is a no-op */
+        kmSphere small;
+        kmSphereFill(&small, &a.centre, 0.1);
+        kmSphereMerge(&merged, &a, &small);
+        assert_close(a.radius, merged.radius, 0.0001);
+    }
+
+    void test_sphere_transform() {
+        kmSphere s, out;
+        kmVec3 centre;
+        kmSphereFill(&s, kmVec3Fill(&centre, 1, 0, 0), 2);
+
+        kmMat4 scale, translate, m;
+        kmMat4Scaling(&scale, 1, 3, 2);
+        kmMat4Translation(&translate, 0, 5, 0);
+        kmMat4Multiply(&m, &translate, &scale);
+
+        kmSphereTransform(&out, &s, &m);
+        assert_close(1.0, out.centre.x, 0.0001);
+        assert_close(5.0, out.centre.y, 0.0001);
+        assert_close(6.0, out.radius, 0.0001);
+    }
+
+    void test_sphere_intersections() {
+        kmSphere s;
+        kmSphereFill(&s, &KM_VEC3_ZERO, 1);
+
+        kmPlane p;
+        kmPlaneFill(&p, 0, 1, 0, -0.5);
+        assert_true(kmSphereIntersectsPlane(&s, &p));
+        assert_equal(POINT_ON_PLANE, kmSphereClassifyPlane(&s, &p));
+
+        kmPlaneFill(&p, 0, 1, 0, -2);
+        assert_false(kmSphereIntersectsPlane(&s, &p));
+        assert_equal(POINT_BEHIND_PLANE, kmSphereClassifyPlane(&s, &p));
+
+        kmAABB3 box;
+        kmVec3Fill(&box.min, 0.75, 0.75, -1);
+        kmVec3Fill(&box.max, 2, 2, 1);
+        assert_false(kmSphereIntersectsAABB3(&s, &box)); /* Closest edge is sqrt(1.125) away */
+        box.min.x = 0.5;
+        assert_true(kmSphereIntersectsAABB3(&s, &box));
+
+        kmRay3 ray;
+        kmRay3Fill(&ray, -5, 0, 0, 2, 0, 0);
+        kmScalar dist;
+        kmVec3 hit;
+        assert_true(kmRay3IntersectSphere(&ray, &s, &hit, &dist));
+        assert_close(4.0, dist, 0.0001);
+        assert_close(-1.0, hit.x, 0.0001);
+
+        kmRay3Fill(&ray, -5, 0, 0, -1, 0, 0);
+        assert_false(kmRay3IntersectSphere(&ray, &s, &hit, &dist));
+    }
+
+    void test_sphere_batch_intersections() {
+        kmSphere spheres[3];
+        kmVec3 c;
+        kmSphereFill(&spheres[0], kmVec3Fill(&c, 0, 0, 0), 1);
+        kmSphereFill(&spheres[1], kmVec3Fill(&c, 5, 0, 0), 1);
+        kmSphereFill(&spheres[2], kmVec3Fill(&c, 0, 5, 0), 1);
+
+        kmBool results[3];
+        kmScalar distances[3];
+
+        kmPlane p;
+        kmPlaneFill(&p, 1, 0, 0, -5);
+        assert_equal(1u, kmSphereIntersectsPlaneArray(spheres, 3, &p, results));
+        assert_true(results[1]);
+
+        kmRay3 ray;
+        kmRay3Fill(&ray, -5, 0, 0, 1, 0, 0);
+        assert_equal(2u, kmSphereIntersectsRay3Array(spheres, 3, &ray, results, distances));
+        assert_true(results[0] && results[1] && !results[2]);
+        assert_close(4.0, distances[0], 0.0001);
+        assert_close(9.0, distances[1], 0.0001);
+
+        kmAABB3 box;
+        kmAABB3Initialize(&box, kmVec3Fill(&c, 0, 4, 0), 1, 1, 1);
+        assert_equal(1u, kmSphereIntersectsAABB3Array(spheres, 3, &box, results));
+        assert_true(results[2]);
+
+        kmSphere other;
+        kmSphereFill(&other, kmVec3Fill(&c, 2.5, 0, 0), 1.5);
+        assert_equal(2u, kmSphereIntersectsSphereArray(spheres, 3, &other, results));
+        assert_false(results[2]);
+    }
+
+    void test_sphere_sweep_triangle() {
+        kmSphere sphere;
+        kmVec3 c, d, normal, p1, p2, p3;
+        kmScalar t;
+
+        /* A triangle in the z = 0 plane */
+        kmVec3Fill(&p1, -1, -1, 0);
+        kmVec3Fill(&p2, 3, -1, 0);
+        kmVec3Fill(&p3, -1, 3, 0);
+
+        /* Straight down onto the face, fast enough to tunnel */
+        kmSphereFill(&sphere, kmVec3Fill(&c, 0, 0, 5), 1);
+        kmVec3Fill(&d, 0, 0, -20);
+        assert_true(kmSphereSweepTriangle(&sphere, &d, &p1, &p2, &p3, &t, &normal));
+        assert_close(0.2, t, 0.0001);
+        assert_close(1.0, normal.z, 0.0001);
+
+        /* From below the normal faces the other way */
+        kmSphereFill(&sphere, kmVec3Fill(&c, 0, 0, -5), 1);
+        kmVec3Fill(&d, 0, 0, 20);
+        assert_true(kmSphereSweepTriangle(&sphere, &d, &p1, &p2, &p3, &t, &normal));
+        assert_close(0.2, t, 0.0001);
+        assert_close(-1.0, normal.z, 0.0001);
+
+        /* Sliding sideways into the vertex at p1 */
+        kmSphereFill(&sphere, kmVec3Fill(&c, -5, -1, 0), 1);
+        kmVec3Fill(&d, 8, 0, 0);
+        assert_true(kmSphereSweepTriangle(&sphere, &d, &p1, &p2, &p3, &t, &normal));
+        assert_close(0.375, t, 0.0001);
+        assert_close(-1.0, normal.x, 0.0001);
+
+        /* Dropping onto the edge p1-p2 from just outside it */
+        kmSphereFill(&sphere, kmVec3Fill(&c, 1, -1.6, 5), 1);
+        kmVec3Fill(&d, 0, 0, -10);
+        assert_true(kmSphereSweepTriangle(&sphere, &d, &p1, &p2, &p3, &t, &normal));
+        assert_close(0.42, t, 0.0001);
+        assert_close(-0.6, normal.y, 0.0001);
+        assert_close(0.8, normal.z, 0.0001);
+
+        /* Passing beside it */
+        kmSphereFill(&sphere, kmVec3Fill(&c, 5, 5, 5), 1);
+        assert_false(kmSphereSweepTriangle(&sphere, &d, &p1, &p2, &p3, &t, &normal));
+
+        /* Stopping short */
+        kmSphereFill(&sphere, kmVec3Fill(&c, 0, 0, 5), 1);
+        kmVec3Fill(&d, 0, 0, -3);
+        assert_false(kmSphereSweepTriangle(&sphere, &d, &p1, &p2, &p3, &t, &normal));
+
+        /* Already touching */
+        kmSphereFill(&sphere, kmVec3Fill(&c, 0, 0, 0.5), 1);
+        assert_true(kmSphereSweepTriangle(&sphere, &d, &p1, &p2, &p3, &t, &normal));
+        assert_close(0.0, t, 0.0001);
+
+        kmVec3 a[2] = { p1, p1 };
+        kmVec3 b[2] = { p2, p2 };
+        kmVec3 e[2] = { p3, p3 };
+        a[1].z = b[1].z = e[1].z = -10;
+
+        kmBool results[2];
+        kmScalar times[2];
+        kmSphereFill(&sphere, kmVec3Fill(&c, 0, 0, 5), 1);
+        kmVec3Fill(&d, 0, 0, -10);
+        assert_equal(1u, kmSphereSweepTriangles(&sphere, &d, a, b, e, 2, results, times, NULL));
+        assert_true(results[0]);
+        assert_false(results[1]);
+        assert_close(0.4, times[0], 0.0001);
+    }
+};
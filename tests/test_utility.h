@@ -0,0 +1,61 @@
+#include <cmath>
+#include "kaztest/kaztest.h"
+
+#include "../kazmath/utility.h"
+#include "../kazmath/mat4.h"
+
+class TestUtility : public TestCase {
+public:
+    void tear_down() {
+        kmSetPrecisionMode(KM_PRECISION_ACCURATE);
+    }
+
+    void test_sin_cos() {
+        kmScalar s, c;
+        kmSinCos(kmPI / 6, &s, &c);
+
+        assert_close(0.5, s, 0.00001);
+        assert_close(std::sqrt(3.0) / 2, c, 0.00001);
+
+        /* Either output can be skipped */
+        kmSinCos(kmPI / 2, NULL, &c);
+        assert_close(0.0, c, 0.00001);
+    }
+
+    void test_fast_sin_cos_accuracy() {
+        kmScalar s, c;
+
+        for(kmScalar a = -100.0; a < 100.0; a += 0.01) {
+            kmFastSinCos(a, &s, &c);
+            assert_close(std::sin((double) a), s, 0.000002);
+            assert_close(std::cos((double) a), c, 0.000002);
+        }
+    }
+
+    void test_sin_cos_array() {
+        kmScalar angles[5] = { 0.0, 0.5, -1.0, 3.0, 10.0 };
+        kmScalar s[5], c[5];
+
+        kmSetPrecisionMode(KM_PRECISION_FAST);
+        assert_equal(KM_PRECISION_FAST, kmGetPrecisionMode());
+
+        kmSinCosArray(angles, s, c, 5);
+
+        for(int i = 0; i < 5; ++i) {
+            assert_close(std::sin((double) angles[i]), s[i], 0.000002);
+            assert_close(std::cos((double) angles[i]), c[i], 0.000002);
+        }
+    }
+
+    void test_fast_mode_rotation() {
+        kmMat4 accurate, fast;
+        kmMat4RotationYawPitchRoll(&accurate, 0.4, 1.1, -0.7);
+
+        kmSetPrecisionMode(KM_PRECISION_FAST);
+        kmMat4RotationYawPitchRoll(&fast, 0.4, 1.1, -0.7);
+
+        for(int i = 0; i < 16; ++i) {
+            assert_close(accurate.mat[i], fast.mat[i], 0.00001);
+        }
+    }
+};